@@ -0,0 +1,575 @@
+/**
+ * @file memory_bench.c
+ * @brief Microbenchmark de my_malloc(), my_free() y my_realloc() frente a glibc.
+ *
+ * Para cada política de set_method(), y para malloc() de glibc como
+ * referencia, recorre las escalas (bloques vivos por hilo) y cantidades de
+ * hilos indicadas. Cada hilo trabaja sobre su propio heap de mem_heap_create():
+ * llena sus casillas y después ejecuta operaciones al azar sobre ellas; una
+ * casilla vacía recibe un malloc y una ocupada un free o un realloc. Se mide
+ * cada llamada por separado para obtener los percentiles p50 y p99 de cada
+ * operación, y el tiempo total de la fase aleatoria para las operaciones por
+ * segundo. El resultado se escribe como JSON en la salida estándar.
+ *
+ * Antes de los casos mide la cabecera de bloque con la que se compiló la
+ * biblioteca: cuántos bytes ocupa un bloque de cada tamaño pedido y cuánto
+ * tarda find_block() por bloque examinado. memory_bench_compact es el mismo
+ * programa sobre la cabecera compacta, ver MEMORY_COMPACT_HEADER en memory.h.
+ *
+ * Uso: memory_bench [operaciones_por_hilo] [escalas] [hilos]
+ *
+ * Las escalas y los hilos son listas separadas por comas, por ejemplo
+ * "memory_bench 100000 1000,10000 1,2,4".
+ */
+
+#include "mem_hist.h"
+#include "mem_trace.h"
+#include "memory.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/** Operaciones aleatorias por hilo por defecto. */
+#define DEFAULT_OPERATIONS 50000
+
+/** Escalas por defecto, en bloques vivos por hilo. */
+#define DEFAULT_SCALES "100,1000,10000"
+
+/** Cantidades de hilos por defecto. */
+#define DEFAULT_THREADS "1,2,4"
+
+/** Máximo de valores en las listas de escalas e hilos. */
+#define MAX_LIST 16
+
+/** Menor tamaño pedido. */
+#define MIN_REQUEST 16
+
+/** Mayor tamaño pedido. */
+#define MAX_REQUEST 4096
+
+/** Bloques que se asignan seguidos para medir cuánto ocupa cada uno. */
+#define LAYOUT_BLOCKS 1024
+
+/** Bloques ocupados, alternados con otros tantos libres, que recorre find_block() en la medición de búsqueda. */
+#define SCAN_BLOCKS 10000
+
+/** Datos de cada bloque de la medición de búsqueda. */
+#define SCAN_PAYLOAD 32
+
+/** Búsquedas completas de la lista en la medición de búsqueda. */
+#define SCAN_ROUNDS 200
+
+/** Asignador que no pertenece a lib/memory: malloc() de glibc. */
+#define ALLOC_GLIBC (SEGREGATED_FIT + 1)
+
+/**
+ * @brief Nombres de los asignadores, en el orden de set_method() y luego glibc.
+ */
+static const char* const alloc_names[] = {"first_fit", "best_fit", "worst_fit", "segregated_fit", "glibc"};
+
+/**
+ * @brief Operaciones medidas.
+ */
+enum bench_op
+{
+    OP_MALLOC,  /**< my_malloc() o malloc(). */
+    OP_FREE,    /**< my_free() o free(). */
+    OP_REALLOC, /**< my_realloc() o realloc(). */
+    OP_COUNT    /**< Cantidad de operaciones. */
+};
+
+/**
+ * @brief Nombres de las operaciones en el JSON.
+ */
+static const char* const op_names[] = {"malloc", "free", "realloc"};
+
+/**
+ * @brief Latencias de una operación, en nanosegundos.
+ */
+struct sample_set
+{
+    uint32_t* ns; /**< Una muestra por llamada. */
+    size_t count; /**< Muestras guardadas. */
+};
+
+/**
+ * @brief Arranque simultáneo de los hilos de un caso.
+ */
+struct start_gate
+{
+    pthread_mutex_t lock; /**< Protege los campos siguientes. */
+    pthread_cond_t cond;  /**< Se señala al abrir la compuerta. */
+    int open;             /**< Distinto de 0 cuando los hilos pueden comenzar. */
+    int aborted;          /**< Distinto de 0 si el caso se canceló antes de empezar. */
+};
+
+/**
+ * @brief Trabajo y resultados de un hilo.
+ */
+struct bench_thread
+{
+    pthread_t thread;                    /**< Hilo que ejecuta el trabajo. */
+    int allocator;                       /**< Índice en @ref alloc_names. */
+    size_t blocks;                       /**< Casillas del hilo. */
+    unsigned long long operations;       /**< Operaciones aleatorias. */
+    uint64_t seed;                       /**< Estado del generador. */
+    struct start_gate* gate;             /**< Arranque simultáneo de todos los hilos. */
+    struct sample_set samples[OP_COUNT]; /**< Latencias por operación. */
+    unsigned long long failed;           /**< Asignaciones que devolvieron NULL. */
+    double start_ns;                     /**< Comienzo de la fase aleatoria. */
+    double end_ns;                       /**< Fin de la fase aleatoria. */
+    int error;                           /**< Distinto de 0 si el hilo no pudo ejecutar. */
+};
+
+/**
+ * @brief Devuelve el tiempo de CLOCK_MONOTONIC en nanosegundos.
+ */
+static double now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+/**
+ * @brief Siguiente número del generador xorshift64*.
+ */
+static uint64_t bench_rand(uint64_t* state)
+{
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+/**
+ * @brief Tamaño de pedido uniforme entre @ref MIN_REQUEST y @ref MAX_REQUEST.
+ */
+static size_t request_size(uint64_t* state)
+{
+    return MIN_REQUEST + (size_t)(bench_rand(state) % (MAX_REQUEST - MIN_REQUEST + 1));
+}
+
+/**
+ * @brief Asigna con el asignador del hilo.
+ */
+static void* bench_malloc(int allocator, size_t size)
+{
+    return allocator == ALLOC_GLIBC ? malloc(size) : my_malloc(size);
+}
+
+/**
+ * @brief Libera con el asignador del hilo.
+ */
+static void bench_free(int allocator, void* p)
+{
+    if (allocator == ALLOC_GLIBC)
+        free(p);
+    else
+        my_free(p);
+}
+
+/**
+ * @brief Redimensiona con el asignador del hilo.
+ */
+static void* bench_realloc(int allocator, void* p, size_t size)
+{
+    return allocator == ALLOC_GLIBC ? realloc(p, size) : my_realloc(p, size);
+}
+
+/**
+ * @brief Guarda una latencia, saturando en UINT32_MAX nanosegundos.
+ */
+static void record(struct sample_set* set, double ns)
+{
+    set->ns[set->count++] = ns < (double)UINT32_MAX ? (uint32_t)ns : UINT32_MAX;
+}
+
+/**
+ * @brief Cuerpo de cada hilo: llena sus casillas y ejecuta las operaciones aleatorias.
+ *
+ * Las casillas y las muestras se guardan con malloc() de glibc para no
+ * mezclarlas con el heap medido.
+ */
+static void* bench_worker(void* arg)
+{
+    struct bench_thread* t = arg;
+    struct mem_heap* heap = NULL;
+    struct mem_heap* previous = NULL;
+    void** slots = calloc(t->blocks, sizeof(*slots));
+
+    mem_trace_mute(1);
+    for (int op = 0; op < OP_COUNT; op++)
+    {
+        t->samples[op].ns = malloc(t->operations * sizeof(uint32_t));
+        if (t->samples[op].ns == NULL)
+            t->error = 1;
+    }
+    if (t->allocator != ALLOC_GLIBC)
+    {
+        heap = mem_heap_create(t->allocator);
+        if (heap == NULL)
+            t->error = 1;
+        else
+            previous = mem_heap_use(heap);
+    }
+    if (slots == NULL)
+        t->error = 1;
+
+    pthread_mutex_lock(&t->gate->lock);
+    while (!t->gate->open)
+        pthread_cond_wait(&t->gate->cond, &t->gate->lock);
+    int aborted = t->gate->aborted;
+    pthread_mutex_unlock(&t->gate->lock);
+    if (t->error || aborted)
+        goto out;
+
+    for (size_t i = 0; i < t->blocks; i++)
+        slots[i] = bench_malloc(t->allocator, request_size(&t->seed));
+
+    t->start_ns = now_ns();
+    for (unsigned long long n = 0; n < t->operations; n++)
+    {
+        size_t i = (size_t)(bench_rand(&t->seed) % t->blocks);
+        size_t size = request_size(&t->seed);
+        double start;
+
+        if (slots[i] == NULL)
+        {
+            start = now_ns();
+            slots[i] = bench_malloc(t->allocator, size);
+            record(&t->samples[OP_MALLOC], now_ns() - start);
+            t->failed += slots[i] == NULL;
+        }
+        else if (bench_rand(&t->seed) & 1)
+        {
+            start = now_ns();
+            bench_free(t->allocator, slots[i]);
+            record(&t->samples[OP_FREE], now_ns() - start);
+            slots[i] = NULL;
+        }
+        else
+        {
+            start = now_ns();
+            void* p = bench_realloc(t->allocator, slots[i], size);
+            record(&t->samples[OP_REALLOC], now_ns() - start);
+            if (p != NULL)
+                slots[i] = p;
+            else
+                t->failed++;
+        }
+    }
+    t->end_ns = now_ns();
+
+    for (size_t i = 0; i < t->blocks; i++)
+        bench_free(t->allocator, slots[i]);
+
+out:
+    if (heap != NULL)
+    {
+        mem_heap_use(previous);
+        mem_heap_destroy(heap);
+    }
+    free(slots);
+    return NULL;
+}
+
+/**
+ * @brief Compara dos latencias para qsort().
+ */
+static int compare_ns(const void* a, const void* b)
+{
+    uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Percentil de un conjunto ordenado de muestras, por el método del rango más cercano.
+ */
+static uint32_t percentile(const uint32_t* sorted, size_t count, double p)
+{
+    if (count == 0)
+        return 0;
+    size_t rank = (size_t)(p * (double)count + 0.5);
+    return sorted[rank == 0 ? 0 : (rank > count ? count : rank) - 1];
+}
+
+/**
+ * @brief Tamaños pedidos en la medición del espacio por bloque.
+ */
+static const size_t layout_sizes[] = {8, 16, 32, 64, 128, 256};
+
+/**
+ * @brief Mide los bytes que ocupa cada bloque de un tamaño pedido, cabecera incluida.
+ *
+ * En la arena los bloques nuevos se recortan uno detrás del otro del mismo
+ * chunk, así que la distancia entre el primero y el último dividida por la
+ * cantidad es lo que ocupa cada uno.
+ *
+ * @return Bytes por bloque, o 0 si no se pudo medir.
+ */
+static double layout_stride(size_t size)
+{
+    void* blocks[LAYOUT_BLOCKS];
+    struct mem_heap* h = mem_heap_create(FIRST_FIT);
+    if (h == NULL)
+        return 0;
+    struct mem_heap* previous = mem_heap_use(h);
+
+    for (int i = 0; i < LAYOUT_BLOCKS; i++)
+        blocks[i] = my_malloc(size);
+    double stride = (double)((char*)blocks[LAYOUT_BLOCKS - 1] - (char*)blocks[0]) / (LAYOUT_BLOCKS - 1);
+    for (int i = 0; i < LAYOUT_BLOCKS; i++)
+        my_free(blocks[i]);
+
+    mem_heap_use(previous);
+    mem_heap_destroy(h);
+    return stride;
+}
+
+/**
+ * @brief Mide cuánto tarda find_block() en examinar cada bloque de la lista.
+ *
+ * Arma una lista de 2 * @ref SCAN_BLOCKS bloques alternando ocupados y libres,
+ * que no se pueden fusionar, y pide un chunk entero, que no cabe ni en el resto
+ * libre del chunk, para que cada búsqueda recorra la lista completa.
+ *
+ * @return Nanosegundos por bloque examinado, o -1 si no se pudo medir.
+ */
+static double scan_ns_per_block()
+{
+    void** blocks = malloc(2 * SCAN_BLOCKS * sizeof(*blocks));
+    struct mem_heap* h = mem_heap_create(FIRST_FIT);
+    if (blocks == NULL || h == NULL)
+    {
+        free(blocks);
+        if (h != NULL)
+            mem_heap_destroy(h);
+        return -1;
+    }
+    struct mem_heap* previous = mem_heap_use(h);
+
+    for (int i = 0; i < 2 * SCAN_BLOCKS; i++)
+        blocks[i] = my_malloc(SCAN_PAYLOAD);
+    for (int i = 0; i < 2 * SCAN_BLOCKS; i += 2)
+        my_free(blocks[i]);
+    // Los bloques que quedaron en la caché del hilo cuentan como ocupados
+    mem_cache_flush();
+
+    pthread_mutex_lock(&h->lock);
+    size_t visited = 0;
+    for (t_block b = h->base; b; b = b->next)
+        visited++;
+    double start = now_ns();
+    for (int r = 0; r < SCAN_ROUNDS; r++)
+    {
+        t_block last = NULL;
+        if (find_block(&last, ARENA_CHUNK_SIZE) != NULL)
+            visited = 0;
+    }
+    double elapsed = now_ns() - start;
+    pthread_mutex_unlock(&h->lock);
+
+    for (int i = 1; i < 2 * SCAN_BLOCKS; i += 2)
+        my_free(blocks[i]);
+    mem_heap_use(previous);
+    mem_heap_destroy(h);
+    free(blocks);
+    return visited > 0 ? elapsed / ((double)SCAN_ROUNDS * (double)visited) : -1;
+}
+
+/**
+ * @brief Escribe las mediciones de la cabecera de bloque como campos JSON.
+ */
+static void report_layout()
+{
+#ifdef MEMORY_COMPACT_HEADER
+    const char* header = "compact";
+#else
+    const char* header = "classic";
+#endif
+    printf("  \"header\": \"%s\",\n  \"header_bytes\": %d,\n  \"layout\": [", header, BLOCK_SIZE);
+    for (size_t i = 0; i < sizeof(layout_sizes) / sizeof(layout_sizes[0]); i++)
+    {
+        double stride = layout_stride(layout_sizes[i]);
+        printf("%s\n    {\"request\": %zu, \"bytes_per_block\": %.1f, \"overhead\": %.3f}", i == 0 ? "" : ",",
+               layout_sizes[i], stride, stride > 0 ? (stride - (double)layout_sizes[i]) / stride : 0.0);
+    }
+    printf("\n  ],\n  \"scan\": {\"blocks\": %d, \"ns_per_block\": %.3f},\n", 2 * SCAN_BLOCKS,
+           scan_ns_per_block());
+}
+
+/**
+ * @brief Ejecuta un caso y escribe su objeto JSON.
+ *
+ * @return 0 si el caso terminó, -1 si algún hilo no pudo ejecutar.
+ */
+static int run_case(int allocator, size_t blocks, int threads, unsigned long long operations, int first)
+{
+    struct bench_thread* t = calloc((size_t)threads, sizeof(*t));
+    struct start_gate gate = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, 0, 0};
+    int status = 0;
+
+    if (t == NULL)
+        return -1;
+
+    for (int i = 0; i < threads; i++)
+    {
+        t[i].allocator = allocator;
+        t[i].blocks = blocks;
+        t[i].operations = operations;
+        t[i].seed = 0x9E3779B97F4A7C15ULL * (uint64_t)(i + 1);
+        t[i].gate = &gate;
+        if (pthread_create(&t[i].thread, NULL, bench_worker, &t[i]) != 0)
+        {
+            fprintf(stderr, "No se pudo crear el hilo %d\n", i);
+            threads = i;
+            status = -1;
+            break;
+        }
+    }
+
+    // Todos los hilos ya prepararon su heap; la medición empieza a la vez
+    pthread_mutex_lock(&gate.lock);
+    gate.open = 1;
+    gate.aborted = status != 0;
+    pthread_cond_broadcast(&gate.cond);
+    pthread_mutex_unlock(&gate.lock);
+
+    double start = 0, end = 0;
+    unsigned long long failed = 0;
+    for (int i = 0; i < threads; i++)
+    {
+        pthread_join(t[i].thread, NULL);
+        if (t[i].error)
+            status = -1;
+        if (i == 0 || t[i].start_ns < start)
+            start = t[i].start_ns;
+        if (t[i].end_ns > end)
+            end = t[i].end_ns;
+        failed += t[i].failed;
+    }
+
+    if (status == 0)
+    {
+        double seconds = (end - start) / 1e9;
+        unsigned long long total = operations * (unsigned long long)threads;
+
+        printf("%s    {\"allocator\": \"%s\", \"blocks\": %zu, \"threads\": %d, \"ops\": %llu, \"failed\": %llu, "
+               "\"ops_per_sec\": %.0f",
+               first ? "" : ",\n", alloc_names[allocator], blocks, threads, total, failed,
+               seconds > 0 ? (double)total / seconds : 0.0);
+
+        for (int op = 0; op < OP_COUNT; op++)
+        {
+            size_t count = 0;
+            for (int i = 0; i < threads; i++)
+                count += t[i].samples[op].count;
+
+            uint32_t* all = malloc((count > 0 ? count : 1) * sizeof(uint32_t));
+            if (all == NULL)
+            {
+                status = -1;
+                break;
+            }
+            size_t n = 0;
+            for (int i = 0; i < threads; i++)
+            {
+                memcpy(all + n, t[i].samples[op].ns, t[i].samples[op].count * sizeof(uint32_t));
+                n += t[i].samples[op].count;
+            }
+            qsort(all, count, sizeof(uint32_t), compare_ns);
+            printf(", \"%s\": {\"count\": %zu, \"p50_ns\": %u, \"p99_ns\": %u}", op_names[op], count,
+                   percentile(all, count, 0.50), percentile(all, count, 0.99));
+            free(all);
+        }
+        printf("}");
+        fflush(stdout);
+    }
+
+    for (int i = 0; i < threads; i++)
+    {
+        for (int op = 0; op < OP_COUNT; op++)
+            free(t[i].samples[op].ns);
+    }
+    free(t);
+    return status;
+}
+
+/**
+ * @brief Interpreta una lista de enteros positivos separados por comas.
+ *
+ * @return Cantidad de valores leídos, o -1 si la lista es inválida.
+ */
+static int parse_list(const char* spec, long values[MAX_LIST])
+{
+    char buf[256];
+    char* save = NULL;
+    int n = 0;
+
+    snprintf(buf, sizeof(buf), "%s", spec);
+    for (char* tok = strtok_r(buf, ",", &save); tok != NULL; tok = strtok_r(NULL, ",", &save))
+    {
+        char* end;
+        long v = strtol(tok, &end, 10);
+        if (*end != '\0' || v <= 0 || n == MAX_LIST)
+            return -1;
+        values[n++] = v;
+    }
+    return n > 0 ? n : -1;
+}
+
+/**
+ * @brief Punto de entrada del benchmark.
+ *
+ * @param argc Número de argumentos.
+ * @param argv Operaciones por hilo, escalas e hilos, todos opcionales.
+ * @return EXIT_SUCCESS, o EXIT_FAILURE si algún argumento es inválido o falló un caso.
+ */
+int main(int argc, char* argv[])
+{
+    long operations = argc > 1 ? atol(argv[1]) : DEFAULT_OPERATIONS;
+    long scales[MAX_LIST], threads[MAX_LIST];
+    int n_scales = parse_list(argc > 2 ? argv[2] : DEFAULT_SCALES, scales);
+    int n_threads = parse_list(argc > 3 ? argv[3] : DEFAULT_THREADS, threads);
+
+    if (operations <= 0 || n_scales < 0 || n_threads < 0)
+    {
+        fprintf(stderr, "Uso: %s [operaciones_por_hilo] [escalas] [hilos]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // La traza registraría cada llamada medida; los histogramas se pueden medir pidiéndolos explícitamente
+    setenv(MEM_TRACE_FILE_ENV, "", 1);
+    setenv(MEM_HIST_ENV, "0", 0);
+
+    printf("{\n  \"benchmark\": \"memory_bench\",\n");
+    report_layout();
+    printf("  \"ops_per_thread\": %ld,\n  \"request_size\": [%d, %d],\n  \"results\": [\n", operations,
+           MIN_REQUEST, MAX_REQUEST);
+
+    int status = EXIT_SUCCESS, first = 1;
+    for (int a = FIRST_FIT; a <= ALLOC_GLIBC; a++)
+    {
+        for (int s = 0; s < n_scales; s++)
+        {
+            for (int th = 0; th < n_threads; th++)
+            {
+                if (run_case(a, (size_t)scales[s], (int)threads[th], (unsigned long long)operations, first) != 0)
+                {
+                    fprintf(stderr, "Falló %s con %ld bloques y %ld hilos\n", alloc_names[a], scales[s], threads[th]);
+                    status = EXIT_FAILURE;
+                    continue;
+                }
+                first = 0;
+            }
+        }
+    }
+    printf("\n  ]\n}\n");
+    return status;
+}
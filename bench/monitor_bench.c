@@ -0,0 +1,368 @@
+/**
+ * @file monitor_bench.c
+ * @brief Benchmark de punta a punta del camino de recolección y del endpoint HTTP.
+ *
+ * La primera fase reproduce archivos de /proc grabados: apunta las fuentes de
+ * metrics.c al directorio de fixtures con set_proc_root() y ejecuta muchas
+ * veces un tick completo, es decir update_proc_snapshot() seguido de todas las
+ * funciones get_* que usan los colectores. Mide los nanosegundos, las
+ * reservas de memoria y las llamadas al sistema de cada tick. Las reservas se
+ * cuentan envolviendo malloc, calloc y realloc al enlazar (-Wl,--wrap) y las
+ * llamadas al sistema con los contadores de proc_reader.h.
+ *
+ * La segunda fase, opcional, carga el /metrics de un agente en ejecución con
+ * varios hilos que hacen scrapes seguidos, cada uno en su propia conexión, y
+ * reporta los percentiles p50 y p99 de la latencia. El resultado se escribe
+ * como JSON en la salida estándar para compararlo con una corrida base.
+ *
+ * Uso: monitor_bench [directorio_fixtures] [ticks] [host:puerto|-] [scrapers] [scrapes_por_scraper]
+ */
+
+#include "metrics.h"
+#include "proc_reader.h"
+#include <netdb.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+/** Ticks medidos por defecto. */
+#define DEFAULT_TICKS 200000
+
+/** Ticks previos a la medición, para abrir las fuentes y agrandar los buffers. */
+#define WARMUP_TICKS 100
+
+/** Agente a cargar por defecto; "-" saltea la fase HTTP. */
+#define DEFAULT_TARGET "127.0.0.1:8000"
+
+/** Hilos de scrape por defecto. */
+#define DEFAULT_SCRAPERS 4
+
+/** Scrapes por hilo por defecto. */
+#define DEFAULT_SCRAPES 200
+
+/** Máximo de hilos de scrape. */
+#define MAX_SCRAPERS 64
+
+/**
+ * @brief Reservas hechas desde el programa, sin contar las internas de libc.
+ */
+static atomic_ullong allocations;
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+
+/**
+ * @brief malloc() envuelto con -Wl,--wrap=malloc.
+ */
+void* __wrap_malloc(size_t size)
+{
+    atomic_fetch_add_explicit(&allocations, 1, memory_order_relaxed);
+    return __real_malloc(size);
+}
+
+/**
+ * @brief calloc() envuelto con -Wl,--wrap=calloc.
+ */
+void* __wrap_calloc(size_t count, size_t size)
+{
+    atomic_fetch_add_explicit(&allocations, 1, memory_order_relaxed);
+    return __real_calloc(count, size);
+}
+
+/**
+ * @brief realloc() envuelto con -Wl,--wrap=realloc.
+ */
+void* __wrap_realloc(void* ptr, size_t size)
+{
+    atomic_fetch_add_explicit(&allocations, 1, memory_order_relaxed);
+    return __real_realloc(ptr, size);
+}
+
+/**
+ * @brief Acumulador para que el compilador no descarte los valores de los colectores.
+ */
+static volatile double sink;
+
+/**
+ * @brief Devuelve el tiempo de CLOCK_MONOTONIC en nanosegundos.
+ */
+static double now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+/**
+ * @brief Ejecuta un tick completo de los colectores de metrics.c.
+ *
+ * @return 0 si se leyeron todas las fuentes, -1 si alguna falló.
+ */
+static int run_tick()
+{
+    const struct disk_rate* disks;
+    const struct net_rate* nets;
+
+    int status = update_proc_snapshot();
+    double acc = get_cpu_usage();
+    acc += (double)get_percpu_usage()->count;
+    acc += get_memory_usage() + get_memory_total() + get_memory_avalible() + get_memory_usage_2();
+    acc += (double)get_change_context() + (double)get_total_processes();
+    acc += (double)get_major_page_faults() + (double)get_minor_page_faults();
+    acc += get_disk_usage() + get_disk_stats() + (double)get_disk_device_rates(&disks);
+    acc += get_network_usage() + get_average_bandwidth() + (double)get_net_interface_rates(&nets);
+    sink += acc;
+    return status;
+}
+
+/**
+ * @brief Mide la fase de recolección y escribe su objeto JSON.
+ *
+ * @return 0 si todos los ticks leyeron sus fuentes, -1 si no.
+ */
+static int bench_collection(const char* fixtures, long ticks)
+{
+    set_proc_root(fixtures);
+    if (init_proc_sources() != 0)
+    {
+        fprintf(stderr, "No se pudieron abrir las fuentes en %s\n", fixtures);
+        return -1;
+    }
+
+    int failed = 0;
+    for (int i = 0; i < WARMUP_TICKS; i++)
+    {
+        failed |= run_tick();
+    }
+
+    struct proc_reader_stats before, after;
+    proc_reader_get_stats(&before);
+    unsigned long long allocs_before = atomic_load(&allocations);
+    double start = now_ns();
+    for (long i = 0; i < ticks; i++)
+    {
+        failed |= run_tick();
+    }
+    double elapsed = now_ns() - start;
+    unsigned long long allocs = atomic_load(&allocations) - allocs_before;
+    proc_reader_get_stats(&after);
+
+    printf("  \"collection\": {\"fixtures\": \"%s\", \"ticks\": %ld, \"ns_per_tick\": %.1f, "
+           "\"allocations_per_tick\": %.3f, \"syscalls_per_tick\": %.3f, \"bytes_per_tick\": %.1f},\n",
+           fixtures, ticks, elapsed / (double)ticks, (double)allocs / (double)ticks,
+           (double)(after.syscalls - before.syscalls) / (double)ticks,
+           (double)(after.bytes - before.bytes) / (double)ticks);
+    close_proc_sources();
+    return failed ? -1 : 0;
+}
+
+/**
+ * @brief Estado de un hilo de scrape.
+ */
+struct scraper
+{
+    pthread_t thread;            /**< Hilo. */
+    const struct addrinfo* addr; /**< Dirección del agente. */
+    const char* request;         /**< Petición HTTP completa. */
+    long scrapes;                /**< Scrapes a hacer. */
+    uint64_t* latency_ns;        /**< Latencia de cada scrape exitoso. */
+    long ok;                     /**< Scrapes exitosos en `latency_ns`. */
+    long errors;                 /**< Scrapes que fallaron. */
+    unsigned long long bytes;    /**< Bytes recibidos, encabezados incluidos. */
+};
+
+/**
+ * @brief Hace un scrape en una conexión nueva y la lee hasta que el agente la cierra.
+ *
+ * @return Bytes recibidos, o -1 si falló la conexión o la respuesta no es 200.
+ */
+static long scrape_once(const struct scraper* s)
+{
+    static __thread char buf[65536];
+
+    int fd = socket(s->addr->ai_family, s->addr->ai_socktype, s->addr->ai_protocol);
+    if (fd < 0)
+    {
+        return -1;
+    }
+    if (connect(fd, s->addr->ai_addr, s->addr->ai_addrlen) != 0 ||
+        send(fd, s->request, strlen(s->request), MSG_NOSIGNAL) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+
+    long total = 0;
+    int ok = 0;
+    ssize_t n;
+    while ((n = recv(fd, buf, sizeof(buf), 0)) > 0)
+    {
+        // La línea de estado llega en la primera lectura: "HTTP/1.1 200 OK"
+        if (total == 0)
+        {
+            ok = n >= 12 && memcmp(buf + 9, "200", 3) == 0;
+        }
+        total += n;
+    }
+    close(fd);
+    return n == 0 && ok ? total : -1;
+}
+
+/**
+ * @brief Hilo de scrape: hace sus scrapes seguidos y guarda cada latencia.
+ */
+static void* scraper_main(void* arg)
+{
+    struct scraper* s = arg;
+    for (long i = 0; i < s->scrapes; i++)
+    {
+        double start = now_ns();
+        long bytes = scrape_once(s);
+        if (bytes < 0)
+        {
+            s->errors++;
+            continue;
+        }
+        s->latency_ns[s->ok++] = (uint64_t)(now_ns() - start);
+        s->bytes += (unsigned long long)bytes;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Compara dos latencias para qsort().
+ */
+static int compare_ns(const void* a, const void* b)
+{
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Percentil de un conjunto ordenado de muestras, por el método del rango más cercano.
+ */
+static uint64_t percentile(const uint64_t* sorted, size_t count, double p)
+{
+    if (count == 0)
+        return 0;
+    size_t rank = (size_t)(p * (double)count + 0.5);
+    return sorted[rank == 0 ? 0 : (rank > count ? count : rank) - 1];
+}
+
+/**
+ * @brief Carga el /metrics del agente y escribe el objeto JSON de la fase HTTP.
+ *
+ * @return 0 si se midió, -1 si el agente no respondió.
+ */
+static int bench_scrape(const char* target, int threads, long scrapes)
+{
+    char host[256];
+    char request[512];
+    const char* colon = strrchr(target, ':');
+    if (colon == NULL || (size_t)(colon - target) >= sizeof(host))
+    {
+        fprintf(stderr, "Destino inválido: %s\n", target);
+        return -1;
+    }
+    memcpy(host, target, (size_t)(colon - target));
+    host[colon - target] = '\0';
+
+    struct addrinfo hints = {.ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM};
+    struct addrinfo* addr;
+    if (getaddrinfo(host, colon + 1, &hints, &addr) != 0)
+    {
+        fprintf(stderr, "No se pudo resolver %s\n", target);
+        return -1;
+    }
+    snprintf(request, sizeof(request), "GET /metrics HTTP/1.1\r\nHost: %s\r\nConnection: close\r\n\r\n", target);
+
+    // Un primer scrape confirma que hay un agente antes de lanzar los hilos
+    struct scraper probe = {.addr = addr, .request = request};
+    if (scrape_once(&probe) < 0)
+    {
+        fprintf(stderr, "El agente en %s no respondió a /metrics\n", target);
+        freeaddrinfo(addr);
+        return -1;
+    }
+
+    struct scraper scrapers[MAX_SCRAPERS];
+    double start = now_ns();
+    for (int i = 0; i < threads; i++)
+    {
+        scrapers[i] = (struct scraper){.addr = addr, .request = request, .scrapes = scrapes};
+        scrapers[i].latency_ns = malloc((size_t)scrapes * sizeof(uint64_t));
+        if (scrapers[i].latency_ns == NULL ||
+            pthread_create(&scrapers[i].thread, NULL, scraper_main, &scrapers[i]) != 0)
+        {
+            fprintf(stderr, "No se pudo crear el hilo de scrape %d\n", i);
+            threads = i;
+            break;
+        }
+    }
+
+    uint64_t* all = malloc((size_t)threads * (size_t)scrapes * sizeof(uint64_t));
+    size_t count = 0;
+    long errors = 0;
+    unsigned long long bytes = 0;
+    for (int i = 0; i < threads; i++)
+    {
+        pthread_join(scrapers[i].thread, NULL);
+        if (all != NULL)
+        {
+            memcpy(all + count, scrapers[i].latency_ns, (size_t)scrapers[i].ok * sizeof(uint64_t));
+        }
+        count += (size_t)scrapers[i].ok;
+        errors += scrapers[i].errors;
+        bytes += scrapers[i].bytes;
+        free(scrapers[i].latency_ns);
+    }
+    double elapsed = now_ns() - start;
+    freeaddrinfo(addr);
+    if (all == NULL)
+    {
+        fprintf(stderr, "Error al reservar las latencias\n");
+        return -1;
+    }
+
+    qsort(all, count, sizeof(uint64_t), compare_ns);
+    printf("  \"scrape\": {\"target\": \"%s\", \"scrapers\": %d, \"scrapes\": %zu, \"errors\": %ld, "
+           "\"scrapes_per_second\": %.1f, \"bytes_per_scrape\": %.0f, \"p50_ns\": %llu, \"p99_ns\": %llu}\n",
+           target, threads, count, errors, (double)count / (elapsed / 1e9),
+           count > 0 ? (double)bytes / (double)count : 0.0, (unsigned long long)percentile(all, count, 0.50),
+           (unsigned long long)percentile(all, count, 0.99));
+    free(all);
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    const char* fixtures = argc > 1 ? argv[1] : PROC_FIXTURES_DIR;
+    long ticks = argc > 2 ? atol(argv[2]) : DEFAULT_TICKS;
+    const char* target = argc > 3 ? argv[3] : DEFAULT_TARGET;
+    int scrapers = argc > 4 ? atoi(argv[4]) : DEFAULT_SCRAPERS;
+    long scrapes = argc > 5 ? atol(argv[5]) : DEFAULT_SCRAPES;
+
+    if (ticks <= 0 || scrapers <= 0 || scrapers > MAX_SCRAPERS || scrapes <= 0)
+    {
+        fprintf(stderr, "Uso: %s [directorio_fixtures] [ticks] [host:puerto|-] [scrapers] [scrapes_por_scraper]\n",
+                argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    printf("{\n  \"benchmark\": \"monitor_bench\",\n");
+    int status = bench_collection(fixtures, ticks) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    // Sin agente en ejecución solo se reporta la recolección
+    if (strcmp(target, "-") == 0 || bench_scrape(target, scrapers, scrapes) != 0)
+    {
+        printf("  \"scrape\": null\n");
+    }
+    printf("}\n");
+    return status;
+}
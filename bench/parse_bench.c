@@ -0,0 +1,256 @@
+/**
+ * @file parse_bench.c
+ * @brief Microbenchmark del tokenizador de /proc frente al camino con sscanf.
+ *
+ * Carga archivos de /proc grabados en un directorio de fixtures y mide los
+ * nanosegundos por línea que tarda cada parser. El camino "sscanf" reproduce
+ * los formatos que usaban los colectores antes de proc_parse: cada línea se
+ * copia a un buffer de @ref BUFFER_SIZE bytes (como hacía fgets) y se prueba
+ * con sscanf. El camino "proc_parse" es parse_proc_source() de metrics.c.
+ *
+ * Uso: parse_bench [directorio_fixtures] [iteraciones]
+ */
+
+#include "metrics.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/** Iteraciones por defecto sobre cada archivo. */
+#define DEFAULT_ITERATIONS 20000
+
+/**
+ * @brief Acumulador para que el compilador no descarte el trabajo del camino sscanf.
+ */
+static volatile unsigned long long sink;
+
+/**
+ * @brief Parser de referencia para una línea con sscanf.
+ *
+ * @return Cantidad de campos buscados que se encontraron en la línea.
+ */
+typedef int (*line_parser)(const char* line);
+
+/**
+ * @brief Describe un archivo de fixture y sus dos parsers.
+ */
+struct bench_case
+{
+    const char* file;        /**< Ruta relativa al directorio de fixtures. */
+    enum proc_source source; /**< Fuente para parse_proc_source(). */
+    line_parser legacy;      /**< Parser con sscanf, aplicado línea por línea. */
+    int header_lines;        /**< Líneas de encabezado que el parser saltea. */
+    int expected;            /**< Campos tras los que se deja de leer, o 0 para leer todo. */
+};
+
+/**
+ * @brief Camino sscanf para /proc/stat.
+ */
+static int legacy_stat(const char* line)
+{
+    unsigned long long v[8], ctxt = 0, processes = 0;
+    if (strncmp(line, "cpu ", 4) == 0)
+    {
+        return sscanf(line, "cpu  %llu %llu %llu %llu %llu %llu %llu %llu", &v[0], &v[1], &v[2], &v[3], &v[4], &v[5],
+                      &v[6], &v[7]) == 8;
+    }
+    if (sscanf(line, "ctxt %llu", &ctxt) == 1 || sscanf(line, "processes %llu", &processes) == 1)
+    {
+        sink += ctxt + processes;
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Camino sscanf para /proc/meminfo (dos sscanf por línea).
+ */
+static int legacy_meminfo(const char* line)
+{
+    unsigned long long total = 0, available = 0;
+    if (sscanf(line, "MemTotal: %llu kB", &total) == 1 || sscanf(line, "MemAvailable: %llu kB", &available) == 1)
+    {
+        sink += total + available;
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Camino sscanf para /proc/vmstat.
+ */
+static int legacy_vmstat(const char* line)
+{
+    unsigned long long minor = 0, major = 0;
+    if (sscanf(line, "pgfault %llu", &minor) == 1 || sscanf(line, "pgmajfault %llu", &major) == 1)
+    {
+        sink += minor + major;
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Camino sscanf para /proc/diskstats.
+ */
+static int legacy_diskstats(const char* line)
+{
+    unsigned int major, minor;
+    char device_name[32];
+    unsigned long reads, writes;
+    if (sscanf(line, "%u %u %31s %*u %*u %lu %*u %*u %*u %lu", &major, &minor, device_name, &reads, &writes) == 5)
+    {
+        sink += reads + writes;
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Camino sscanf para /proc/net/dev.
+ */
+static int legacy_net_dev(const char* line)
+{
+    char interface[32];
+    unsigned long long rx, tx;
+    if (sscanf(line, "%31s %llu %*u %*u %*u %*u %*u %*u %*u %llu", interface, &rx, &tx) == 3)
+    {
+        sink += rx + tx;
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Lee un archivo completo en memoria.
+ *
+ * @return Buffer terminado en '\0' que debe liberarse con free(), o NULL.
+ */
+static char* load_file(const char* dir, const char* file)
+{
+    char path[BUFFER_SIZE * 4];
+    snprintf(path, sizeof(path), "%s/%s", dir, file);
+
+    FILE* fp = fopen(path, "r");
+    if (fp == NULL)
+    {
+        perror(path);
+        return NULL;
+    }
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    rewind(fp);
+
+    char* buf = malloc((size_t)size + 1);
+    if (buf != NULL)
+    {
+        size_t n = fread(buf, 1, (size_t)size, fp);
+        buf[n] = '\0';
+    }
+    fclose(fp);
+    return buf;
+}
+
+/**
+ * @brief Devuelve el tiempo de CLOCK_MONOTONIC en nanosegundos.
+ */
+static double now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+/**
+ * @brief Aplica el parser sscanf a cada línea, copiándola antes como fgets.
+ *
+ * Igual que los colectores originales, deja de leer cuando encontró
+ * `expected` campos.
+ */
+static void run_legacy(const struct bench_case* c, const char* buf)
+{
+    char line[BUFFER_SIZE];
+    const char* p = buf;
+    int n = 0, found = 0;
+
+    while (*p != '\0' && (c->expected == 0 || found < c->expected))
+    {
+        const char* nl = strchr(p, '\n');
+        size_t len = nl != NULL ? (size_t)(nl - p) : strlen(p);
+        size_t copy = len < sizeof(line) - 1 ? len : sizeof(line) - 1;
+
+        memcpy(line, p, copy);
+        line[copy] = '\0';
+        if (n++ >= c->header_lines)
+        {
+            found += c->legacy(line);
+        }
+        p += len + (nl != NULL);
+    }
+}
+
+/**
+ * @brief Cuenta las líneas de un buffer.
+ */
+static size_t count_lines(const char* buf)
+{
+    size_t lines = 0;
+    for (const char* p = buf; *p != '\0'; p++)
+    {
+        lines += *p == '\n';
+    }
+    return lines;
+}
+
+/**
+ * @brief Punto de entrada del benchmark.
+ *
+ * @param argc Número de argumentos.
+ * @param argv Directorio de fixtures e iteraciones, ambos opcionales.
+ * @return EXIT_SUCCESS, o EXIT_FAILURE si falta algún fixture.
+ */
+int main(int argc, char* argv[])
+{
+    const char* dir = argc > 1 ? argv[1] : PROC_FIXTURES_DIR;
+    int iterations = argc > 2 ? atoi(argv[2]) : DEFAULT_ITERATIONS;
+
+    const struct bench_case cases[] = {
+        {"stat", PROC_STAT, legacy_stat, 0, 0},
+        {"meminfo", PROC_MEMINFO, legacy_meminfo, 0, 2},
+        {"vmstat", PROC_VMSTAT, legacy_vmstat, 0, 2},
+        {"diskstats", PROC_DISKSTATS, legacy_diskstats, 0, 0},
+        {"net/dev", PROC_NET_DEV, legacy_net_dev, 2, 0},
+    };
+
+    printf("%-10s %6s %14s %14s %8s\n", "file", "lines", "sscanf ns/ln", "parse ns/ln", "speedup");
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+    {
+        char* buf = load_file(dir, cases[i].file);
+        if (buf == NULL)
+        {
+            return EXIT_FAILURE;
+        }
+        size_t lines = count_lines(buf);
+
+        double start = now_ns();
+        for (int it = 0; it < iterations; it++)
+        {
+            run_legacy(&cases[i], buf);
+        }
+        double legacy = (now_ns() - start) / ((double)iterations * (double)lines);
+
+        start = now_ns();
+        for (int it = 0; it < iterations; it++)
+        {
+            parse_proc_source(cases[i].source, buf);
+        }
+        double fast = (now_ns() - start) / ((double)iterations * (double)lines);
+
+        printf("%-10s %6zu %14.1f %14.1f %7.1fx\n", cases[i].file, lines, legacy, fast, legacy / fast);
+        free(buf);
+    }
+
+    return EXIT_SUCCESS;
+}
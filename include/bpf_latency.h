@@ -0,0 +1,96 @@
+/**
+ * @file bpf_latency.h
+ * @brief Histogramas de latencia de la cola de ejecución y de los fallos de página, medidos con eBPF.
+ *
+ * Un programa eBPF (src/bpf/latency.bpf.c, CO-RE con libbpf) mide cada espera
+ * en la cola de ejecución, desde que una tarea queda lista hasta que sched_switch
+ * la elige, y la duración de cada fallo de página. Los cuenta en histogramas
+ * por CPU dentro del kernel; el agente solo los suma una vez por tick, sin
+ * recorrer /proc ni recibir un evento por cada cambio de contexto.
+ *
+ * Es opcional: se compila con la opción de CMake MONITOR_WITH_BPF y, sin ella,
+ * bpf_latency_init() falla y el colector queda desactivado. Este archivo lo
+ * incluye también el programa eBPF, así que no depende de otros encabezados.
+ */
+
+#pragma once
+
+/**
+ * @brief Cubetas de cada histograma.
+ *
+ * La cubeta `i` cuenta latencias menores a 2^(i+1) microsegundos y la última
+ * todas las mayores, unos 33 segundos.
+ */
+#define BPF_LATENCY_SLOTS 26
+
+/**
+ * @brief Latencias medidas.
+ */
+enum bpf_latency_kind
+{
+    BPF_LATENCY_RUNQUEUE,   /**< Espera de una tarea lista hasta que se ejecuta. */
+    BPF_LATENCY_PAGE_FAULT, /**< Duración del manejo de un fallo de página. */
+    BPF_LATENCY_KIND_COUNT  /**< Cantidad de histogramas. */
+};
+
+/**
+ * @brief Histograma de una CPU tal como lo guarda el programa eBPF.
+ */
+struct bpf_latency_slots
+{
+    unsigned long long slots[BPF_LATENCY_SLOTS]; /**< Eventos por cubeta, no acumulados. */
+    unsigned long long sum_ns;                   /**< Suma de las latencias en nanosegundos. */
+};
+
+/**
+ * @brief Histograma sumado entre todas las CPUs.
+ */
+struct bpf_latency_histogram
+{
+    unsigned long long buckets[BPF_LATENCY_SLOTS]; /**< Eventos por cubeta desde el inicio, no acumulados. */
+    unsigned long long count;                      /**< Eventos desde el inicio. */
+    double sum;                                    /**< Suma de las latencias en segundos. */
+};
+
+/**
+ * @brief Histogramas de todas las latencias.
+ */
+struct bpf_latency
+{
+    struct bpf_latency_histogram hist[BPF_LATENCY_KIND_COUNT]; /**< Indexados por @ref bpf_latency_kind. */
+};
+
+/**
+ * @brief Carga el programa eBPF y lo engancha a los eventos del kernel.
+ *
+ * @return 0 si quedó listo, -1 si no se compiló con MONITOR_WITH_BPF o el kernel no lo aceptó.
+ */
+int bpf_latency_init();
+
+/**
+ * @brief Indica si bpf_latency_init() cargó el programa.
+ *
+ * @return Distinto de 0 si el colector está activo.
+ */
+int bpf_latency_enabled();
+
+/**
+ * @brief Suma los histogramas por CPU del kernel.
+ *
+ * @param out Recibe los histogramas.
+ * @return 0 si se leyó, -1 si el colector no está activo o falló la lectura.
+ */
+int bpf_latency_update(struct bpf_latency* out);
+
+/**
+ * @brief Desengancha y descarga el programa eBPF.
+ */
+void bpf_latency_close();
+
+/**
+ * @brief Límite superior de una cubeta en segundos.
+ *
+ * @param slot Cubeta, menor que @ref BPF_LATENCY_SLOTS - 1.
+ * @return 2^(slot+1) microsegundos expresados en segundos.
+ */
+double bpf_latency_bound(int slot);
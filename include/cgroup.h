@@ -0,0 +1,119 @@
+/**
+ * @file cgroup.h
+ * @brief Métricas de CPU, memoria y E/S de cada cgroup v2.
+ *
+ * El árbol de cgroups se recorre solo al iniciar y cuando cambia: inotify
+ * avisa cuando se crea o borra un directorio, y si no está disponible el árbol
+ * se vuelve a recorrer cada @ref CGROUP_RESCAN_TICKS lecturas. Los archivos de
+ * cada cgroup quedan abiertos con los lectores de proc_reader.h, así que en
+ * cada tick solo se releen con pread().
+ */
+
+#pragma once
+#include <limits.h>
+#include <stddef.h>
+
+/**
+ * @brief Variable de entorno con la raíz de la jerarquía cgroup v2.
+ */
+#define CGROUP_ROOT_ENV "MONITOR_CGROUP_ROOT"
+
+/**
+ * @brief Raíz por defecto; si no es cgroup v2 se prueba @ref CGROUP_HYBRID_ROOT.
+ */
+#define CGROUP_DEFAULT_ROOT "/sys/fs/cgroup"
+
+/**
+ * @brief Raíz de cgroup v2 en los sistemas con jerarquía híbrida.
+ */
+#define CGROUP_HYBRID_ROOT "/sys/fs/cgroup/unified"
+
+/**
+ * @brief Mayor cantidad de cgroups seguidos; los que exceden se cuentan en `dropped` y no se exportan.
+ */
+#define CGROUP_MAX 128
+
+/**
+ * @brief Niveles del árbol que se recorren debajo de la raíz.
+ *
+ * Alcanza para los contenedores de Kubernetes, que quedan en
+ * kubepods.slice/kubepods-<qos>.slice/kubepods-<qos>-pod<uid>.slice/<runtime>-<id>.scope.
+ */
+#define CGROUP_MAX_DEPTH 5
+
+/**
+ * @brief Longitud de la ruta de un cgroup relativa a la raíz, incluyendo el '\0'.
+ *
+ * Es la ruta más larga que puede armar el recorrido: @ref CGROUP_MAX_DEPTH
+ * componentes de hasta NAME_MAX bytes, cada uno seguido de '/' o del '\0'.
+ * Un contenedor BestEffort de containerd con el driver de systemd ya ocupa 193.
+ */
+#define CGROUP_NAME_LEN (CGROUP_MAX_DEPTH * (NAME_MAX + 1))
+
+/**
+ * @brief Lecturas entre recorridos del árbol cuando no hay inotify.
+ */
+#define CGROUP_RESCAN_TICKS 30
+
+/**
+ * @brief Valores exportados de cada cgroup.
+ */
+enum cgroup_metric
+{
+    CGROUP_CPU_USAGE,     /**< Porcentaje de una CPU usado desde la lectura anterior, de cpu.stat. */
+    CGROUP_CPU_THROTTLED, /**< Porcentaje del tiempo en que el cgroup estuvo limitado por cpu.max. */
+    CGROUP_MEMORY_BYTES,  /**< Bytes en uso según memory.current. */
+    CGROUP_MEMORY_ANON,   /**< Bytes anónimos según memory.stat. */
+    CGROUP_MEMORY_FILE,   /**< Bytes de caché de archivos según memory.stat. */
+    CGROUP_IO_READ,       /**< Bytes leídos por segundo, sumando los dispositivos de io.stat. */
+    CGROUP_IO_WRITE,      /**< Bytes escritos por segundo, sumando los dispositivos de io.stat. */
+    CGROUP_METRIC_COUNT   /**< Cantidad de valores por cgroup. */
+};
+
+/**
+ * @brief Valores de un cgroup en una lectura.
+ */
+struct cgroup_sample
+{
+    char name[CGROUP_NAME_LEN];        /**< Ruta relativa a la raíz, por ejemplo "system.slice/docker.service". */
+    double value[CGROUP_METRIC_COUNT]; /**< Valores indexados por @ref cgroup_metric. */
+};
+
+/**
+ * @brief Valores de todos los cgroups seguidos.
+ */
+struct cgroup_stats
+{
+    struct cgroup_sample cgroups[CGROUP_MAX]; /**< Cgroups en el orden en que se recorrieron. */
+    size_t count;                             /**< Cgroups válidos en `cgroups`. */
+    size_t dropped;                           /**< Cgroups del último recorrido que no entraron en `cgroups`. */
+};
+
+/**
+ * @brief Busca la raíz de cgroup v2, recorre el árbol y empieza a vigilarlo.
+ *
+ * @return 0 si quedó listo, -1 si no hay una jerarquía cgroup v2.
+ */
+int cgroup_init();
+
+/**
+ * @brief Relee los archivos de cada cgroup, recorriendo antes el árbol si cambió.
+ *
+ * Las tasas de CPU y E/S de un cgroup nuevo valen 0 hasta la lectura siguiente.
+ *
+ * @param out Recibe los valores.
+ * @return 0 si se leyó, -1 si el colector no está iniciado.
+ */
+int cgroup_update(struct cgroup_stats* out);
+
+/**
+ * @brief Indica si cgroup_init() encontró una jerarquía cgroup v2.
+ *
+ * @return Distinto de 0 si el colector está activo.
+ */
+int cgroup_enabled();
+
+/**
+ * @brief Cierra los archivos de los cgroups y deja de vigilar el árbol.
+ */
+void cgroup_close();
@@ -8,15 +8,22 @@
  * Las métricas se exponen vía HTTP utilizando Prometheus.
  */
 
+#include "bpf_latency.h"
+#include "exposition.h"
+#include "history.h"
+#include "mem_hist.h"
+#include "metric_store.h"
 #include "metrics.h"
+#include "push.h"
 // #include "read_cpu_usage.h"
 #include <errno.h>
+#include <math.h>
+#include <microhttpd.h>
 #include <prom.h>
-#include <promhttp.h>
-#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h> // Para sleep
 
 /**
@@ -25,157 +32,143 @@
 #define BUFFER_SIZE 256
 
 /**
- * @brief Actualiza la métrica de fragmentación externa utilizando el método First Fit.
- *
- * Esta función recalcula y actualiza el valor de la fragmentación externa para el
- * algoritmo de asignación de memoria First Fit. La fragmentación externa se refiere
- * al espacio inutilizable entre bloques de memoria asignados.
- */
-void update_external_frag_first_fit();
-
-/**
- * @brief Actualiza la métrica de fragmentación externa utilizando el método Best Fit.
- *
- * Esta función recalcula y actualiza el valor de la fragmentación externa para el
- * algoritmo de asignación de memoria Best Fit. La fragmentación externa se refiere
- * al espacio inutilizable entre bloques de memoria asignados.
+ * @brief Colectores del planificador que actualizan métricas escalares.
  */
-void update_external_frag_best_fit();
+enum scalar_collector
+{
+    SCALAR_COLLECT_FRAGMENTATION, /**< Fragmentación de cada política del simulador. */
+    SCALAR_COLLECT_CPU,           /**< Uso de CPU, de /proc/stat. */
+    SCALAR_COLLECT_PROCESSES,     /**< Procesos y cambios de contexto, de /proc/stat. */
+    SCALAR_COLLECT_MEMORY,        /**< Memoria, de /proc/meminfo. */
+    SCALAR_COLLECT_PAGE_FAULTS,   /**< Fallos de página, de /proc/vmstat. */
+    SCALAR_COLLECT_DISK,          /**< Disco, de /proc/diskstats. */
+    SCALAR_COLLECT_NETWORK,       /**< Red, de /proc/net/dev. */
+    SCALAR_COLLECTOR_COUNT        /**< Cantidad de colectores. */
+};
 
 /**
- * @brief Actualiza la métrica de fragmentación externa utilizando el método Worst Fit.
+ * @brief Actualiza todas las métricas escalares de un colector.
  *
- * Esta función recalcula y actualiza el valor de la fragmentación externa para el
- * algoritmo de asignación de memoria Worst Fit. La fragmentación externa se refiere
- * al espacio inutilizable entre bloques de memoria asignados.
- */
-void update_external_frag_worst_fit();
-/**
- * @brief Actualiza la métrica de memoria disponible.
+ * Recorre las entradas del registro de expose_metrics.c que pertenecen al
+ * colector, de forma contigua, y guarda cada valor leído en la copia de
+ * trabajo; si una lectura falla, la métrica conserva su valor anterior.
  *
- * Lee el valor de memoria disponible desde /proc/meminfo y actualiza el gauge
- * correspondiente de Prometheus.
+ * @param collector Colector que corre en este tick.
  */
-void update_memory_avalible_gauge();
+void update_scalar_gauges(enum scalar_collector collector);
 
 /**
- * @brief Actualiza la métrica de memoria total.
- *
- * Lee el valor de memoria total desde /proc/meminfo y actualiza el gauge
- * correspondiente de Prometheus.
+ * @brief Actualiza la latencia de asignación de cada política del simulador.
  */
-void update_memory_total_gauge();
+void update_alloc_latency_gauge();
 
 /**
- * @brief Actualiza la métrica de memoria en uso (no expresada como porcentaje).
- *
- * Lee el valor de memoria en uso desde /proc/meminfo y actualiza el gauge
- * correspondiente de Prometheus.
+ * @brief Actualiza el rendimiento de asignación de cada política del simulador.
  */
-void update_memory_2_gauge();
+void update_alloc_throughput_gauge();
 
 /**
- * @brief Actualiza la métrica de estadística de disco.
+ * @brief Actualiza las métricas de sectores leídos y escritos por segundo de
+ * cada disco.
  *
- * Lee el valor total de lecturas y escrituras de disco desde /proc/diskstats y
- * actualiza el gauge correspondiente de Prometheus.
+ * Calcula las tasas de cada disco seguido en /proc/diskstats y actualiza los
+ * gauges etiquetados con el nombre del dispositivo.
  */
-void update_disk_stats_gauge();
+void update_disk_devices_gauge();
 
 /**
- * @brief Actualiza la métrica de la cantidad total de procesos del sistema.
+ * @brief Actualiza las métricas de bytes, paquetes, errores y descartes por
+ * segundo de cada interfaz de red.
  *
- * Lee el valor de procesos totales desde /proc/stat y actualiza el gauge
- * correspondiente de Prometheus.
+ * Calcula las tasas de cada interfaz seguida en /proc/net/dev, elegidas con
+ * @ref NET_INTERFACES_ENV, y actualiza los gauges etiquetados con el nombre de
+ * la interfaz y el sentido.
  */
-void update_total_processes_gauge();
+void update_network_interfaces_gauge();
 
 /**
- * @brief Actualiza la métrica de cambios de contexto del sistema.
+ * @brief Actualiza la métrica de uso de cada CPU por modo.
  *
- * Lee el valor de cambios de contexto desde /proc/stat y actualiza el gauge
- * correspondiente de Prometheus.
+ * Calcula el uso de cada CPU desglosado en user/system/iowait/steal desde
+ * /proc/stat y actualiza el gauge etiquetado con (cpu, mode).
  */
-void update_change_context_gauge();
+void update_percpu_gauge();
 
 /**
- * @brief Actualiza la métrica de uso de CPU.
+ * @brief Actualiza los rankings de los procesos que más CPU, memoria residente
+ * y fallos de página consumen.
  *
- * Lee el porcentaje de uso de CPU desde /proc/stat y actualiza el gauge
- * correspondiente de Prometheus.
+ * Recorre /proc/[pid]/stat con proc_top_update(); la cantidad de procesos de
+ * cada ranking se elige con @ref PROC_TOP_ENV.
  */
-void update_cpu_gauge();
+void update_process_top_gauge();
 
 /**
- * @brief Actualiza la métrica de uso de memoria.
+ * @brief Actualiza las métricas de CPU, memoria y E/S de cada cgroup v2.
  *
- * Lee el porcentaje de uso de memoria desde /proc/meminfo y actualiza el gauge
- * correspondiente de Prometheus.
+ * Relee cpu.stat, memory.current, memory.stat e io.stat de los cgroups
+ * seguidos con cgroup_update(); la raíz se elige con @ref CGROUP_ROOT_ENV.
  */
-void update_memory_gauge();
+void update_cgroup_gauge();
 
 /**
- * @brief Actualiza la métrica de uso de disco.
+ * @brief Actualiza los histogramas de latencia de la cola de ejecución y de los fallos de página.
  *
- * Lee el porcentaje de uso de disco desde /proc/diskstats y actualiza el gauge
- * correspondiente de Prometheus.
+ * Suma los histogramas por CPU del programa eBPF con bpf_latency_update();
+ * requiere compilar con la opción de CMake MONITOR_WITH_BPF.
  */
-void update_disk_gauge();
+void update_bpf_latency_gauge();
 
 /**
- * @brief Actualiza la métrica de uso de red.
+ * @brief Suma ticks salteados al contador del colector.
  *
- * Lee las estadísticas de red desde /proc/net/dev y actualiza el gauge
- * correspondiente de Prometheus.
- */
-void update_network_gauge();
-
-/**
- * @brief Actualiza la métrica de ancho de banda promedio.
+ * La llama el planificador cuando un colector tarda más que su intervalo y se
+ * pierden uno o más plazos.
  *
- * Calcula el ancho de banda en uso basado en /proc/net/dev y actualiza el gauge
- * correspondiente de Prometheus.
+ * @param collector Nombre del colector.
+ * @param ticks Cantidad de ticks salteados.
  */
-void update_bandwidth_gauge();
+void add_skipped_ticks(const char* collector, unsigned long long ticks);
 
 /**
- * @brief Actualiza la métrica de fallos de página mayores.
+ * @brief Registra la duración de la última ejecución de un colector.
  *
- * Lee el número de fallos de página mayores desde /proc/vmstat y actualiza el
- * gauge correspondiente de Prometheus.
+ * @param collector Nombre del colector.
+ * @param seconds Duración en segundos.
  */
-void update_major_page_faults_gauge();
+void set_collector_latency(const char* collector, double seconds);
 
 /**
- * @brief Actualiza la métrica de fallos de página menores.
+ * @brief Registra la duración de la última lectura de una fuente de /proc.
  *
- * Lee el número de fallos de página menores desde /proc/vmstat y actualiza el
- * gauge correspondiente de Prometheus.
+ * @param source Fuente leída.
+ * @param seconds Duración en segundos.
  */
-void update_minor_page_faults_gauge();
+void set_source_latency(enum proc_source source, double seconds);
 
 /**
  * @brief Función del hilo para exponer las métricas vía HTTP en el puerto 8000.
  *
  * Esta función es ejecutada por un hilo separado para exponer las métricas a
- * través de HTTP en el puerto 8000.
+ * través de HTTP en el puerto 8000. Las métricas de libprom solo se tocan desde
+ * este hilo, con la última publicación de publish_metrics().
  * @param arg Argumento no utilizado.
  * @return NULL
  */
 void* expose_metrics(void* arg);
 
 /**
- * @brief Inicializa los mutex y las métricas de Prometheus.
+ * @brief Inicializa las métricas de Prometheus.
  *
- * Esta función se encarga de inicializar los mutex necesarios y configurar las
+ * Esta función se encarga de abrir las fuentes de /proc y configurar las
  * métricas de Prometheus.
  */
 void init_metrics();
 
 /**
- * @brief Destructor de mutex.
+ * @brief Publica los valores actualizados en el tick para el servidor HTTP.
  *
- * Esta función destruye los mutex que fueron inicializados para evitar fugas de
- * memoria.
+ * Los update_* solo escriben en la copia de trabajo de metric_store.h; el
+ * servidor ve los nuevos valores recién cuando se llama a esta función.
  */
-void destroy_mutex();
+void publish_metrics();
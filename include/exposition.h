@@ -0,0 +1,153 @@
+/**
+ * @file exposition.h
+ * @brief Exposición de texto de Prometheus renderizada una vez por tick.
+ *
+ * El hilo de los colectores renderiza todas las métricas en un buffer
+ * reutilizable y lo publica como el buffer actual. El servidor HTTP entrega
+ * ese buffer tal cual, sin copiarlo ni volver a renderizarlo, junto con un
+ * ETag calculado sobre su contenido para que un scrape sin cambios se pueda
+ * responder con 304.
+ *
+ * Los buffers se cuentan por referencias: uno que todavía se está enviando no
+ * se reutiliza hasta que MHD lo libera. Hay @ref EXPO_BUFFER_COUNT buffers; si
+ * todos están en uso se conserva el contenido anterior durante ese tick.
+ */
+
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Variable de entorno que elige cómo se renderiza /metrics.
+ *
+ * "prerendered" usa este módulo; cualquier otro valor, o no definirla,
+ * renderiza el registro de libprom en cada scrape.
+ */
+#define EXPO_MODE_ENV "MONITOR_EXPOSITION"
+
+/**
+ * @brief Valor de @ref EXPO_MODE_ENV que activa la exposición pre-renderizada.
+ */
+#define EXPO_MODE_PRERENDERED "prerendered"
+
+/**
+ * @brief Cantidad de buffers que se rotan entre publicaciones.
+ */
+#define EXPO_BUFFER_COUNT 4
+
+/**
+ * @brief Capacidad inicial del texto de cada buffer en bytes.
+ */
+#define EXPO_INITIAL_SIZE 65536
+
+/**
+ * @brief Espacio para el ETag entre comillas y el '\0'.
+ */
+#define EXPO_ETAG_LEN 20
+
+/**
+ * @brief Buffer con el texto de una exposición.
+ *
+ * El texto se guarda a continuación de la cabecera para poder recuperar el
+ * buffer a partir del puntero que recibe el callback de liberación de MHD.
+ */
+struct expo_buffer
+{
+    size_t len;                /**< Bytes de texto válidos. */
+    size_t cap;                /**< Capacidad de `data`. */
+    int refs;                  /**< Referencias: el escritor, la publicación y cada respuesta. */
+    int slot;                  /**< Posición en el arreglo de buffers, o -1 si no rota. */
+    int failed;                /**< Distinto de 0 si no se pudo agrandar durante el render. */
+    uint64_t hash;             /**< FNV-1a del texto. */
+    char etag[EXPO_ETAG_LEN];  /**< Hash en hexadecimal entre comillas. */
+    char data[];               /**< Texto de la exposición, terminado en '\0'. */
+};
+
+/**
+ * @brief Toma un buffer libre para renderizar una nueva exposición.
+ *
+ * Solo debe llamarse desde el hilo de los colectores.
+ *
+ * @return Buffer vacío, o NULL si todos están en uso.
+ */
+struct expo_buffer* expo_begin();
+
+/**
+ * @brief Crea un buffer fuera de la rotación, para una sola respuesta.
+ *
+ * Se llena con las mismas funciones que los buffers rotativos, pero no se
+ * publica: se libera con free() o, si se entregó a MHD, con expo_free_data().
+ *
+ * @return Buffer vacío, o NULL si no hubo memoria.
+ */
+struct expo_buffer* expo_alloc();
+
+/**
+ * @brief Callback de liberación de MHD para respuestas creadas sobre el `data` de un buffer de expo_alloc().
+ *
+ * @param data Campo `data` del buffer.
+ */
+void expo_free_data(void* data);
+
+/**
+ * @brief Agrega texto con formato al buffer, agrandándolo si hace falta.
+ *
+ * @param b Buffer tomado con expo_begin(); puede cambiar de dirección.
+ * @param fmt Formato de printf.
+ */
+void expo_printf(struct expo_buffer** b, const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+
+/**
+ * @brief Agrega las líneas HELP y TYPE de una familia de métricas.
+ *
+ * @param b Buffer en construcción.
+ * @param name Nombre de la familia.
+ * @param help Texto de ayuda.
+ * @param type "gauge", "counter" o "histogram".
+ */
+void expo_family(struct expo_buffer** b, const char* name, const char* help, const char* type);
+
+/**
+ * @brief Agrega una muestra, escapando los valores de las etiquetas.
+ *
+ * @param b Buffer en construcción.
+ * @param name Nombre de la serie.
+ * @param keys Nombres de las etiquetas.
+ * @param values Valores de las etiquetas.
+ * @param count Cantidad de etiquetas; 0 si no tiene.
+ * @param value Valor de la muestra.
+ */
+void expo_sample(struct expo_buffer** b, const char* name, const char* const* keys, const char* const* values,
+                 size_t count, double value);
+
+/**
+ * @brief Termina el render y publica el buffer si su contenido cambió.
+ *
+ * Si el texto es idéntico al publicado, el buffer se descarta y el ETag actual
+ * sigue siendo válido.
+ *
+ * @param b Buffer tomado con expo_begin().
+ */
+void expo_commit(struct expo_buffer* b);
+
+/**
+ * @brief Toma una referencia al buffer publicado.
+ *
+ * @return Buffer actual, o NULL si todavía no se publicó ninguno. Debe
+ * liberarse con expo_release().
+ */
+struct expo_buffer* expo_acquire();
+
+/**
+ * @brief Suelta una referencia a un buffer.
+ *
+ * @param b Buffer obtenido con expo_acquire().
+ */
+void expo_release(struct expo_buffer* b);
+
+/**
+ * @brief Callback de liberación de MHD para respuestas creadas sobre `data`.
+ *
+ * @param data Campo `data` de un buffer obtenido con expo_acquire().
+ */
+void expo_release_data(void* data);
@@ -0,0 +1,70 @@
+/**
+ * @file history.h
+ * @brief Historial en memoria de las métricas escalares, comprimido como en Gorilla.
+ *
+ * Cada métrica tiene un anillo de @ref HISTORY_BLOCKS bloques de tamaño fijo.
+ * Un bloque guarda su primera muestra completa y las siguientes como la
+ * diferencia de la diferencia de los instantes y el XOR del valor con el
+ * anterior, empaquetados en bits. Cuando un bloque se llena se pasa al
+ * siguiente y el más viejo se pisa, así que la memoria no crece.
+ *
+ * Hay un único escritor, el hilo de los colectores, que agrega una muestra de
+ * cada métrica por tick. Cada bloque lleva un contador de secuencia como el de
+ * metric_store.h: una lectura nunca bloquea al escritor y se reintenta si el
+ * bloque cambió mientras se copiaba.
+ */
+
+#pragma once
+#include "metric_store.h"
+#include <stdint.h>
+
+/**
+ * @brief Bloques del anillo de cada métrica.
+ */
+#define HISTORY_BLOCKS 32
+
+/**
+ * @brief Palabras de 64 bits de cada bloque; con valores que cambian en cada tick entran unas 120 muestras.
+ */
+#define HISTORY_BLOCK_WORDS 128
+
+/**
+ * @brief Segundos que devuelve /history si no se indica `seconds`.
+ */
+#define HISTORY_DEFAULT_SECONDS 60
+
+/**
+ * @brief Función que recibe cada muestra de history_read().
+ *
+ * @param ctx Contexto de history_read().
+ * @param ts_ms Instante de la muestra en milisegundos desde la época Unix.
+ * @param value Valor de la muestra.
+ */
+typedef void (*history_visit)(void* ctx, uint64_t ts_ms, double value);
+
+/**
+ * @brief Agrega una muestra de cada métrica escalar con el instante actual.
+ *
+ * Solo debe llamarse desde el hilo de los colectores.
+ *
+ * @param values Valores indexados por @ref metric_id.
+ */
+void history_append(const double values[METRIC_SCALAR_COUNT]);
+
+/**
+ * @brief Recorre las muestras de una métrica desde un instante, de la más vieja a la más nueva.
+ *
+ * @param id Métrica a leer.
+ * @param since_ms Instante mínimo en milisegundos desde la época Unix.
+ * @param visit Función que recibe cada muestra.
+ * @param ctx Contexto para `visit`.
+ * @return Cantidad de muestras entregadas, o -1 si la métrica es inválida.
+ */
+int history_read(enum metric_id id, uint64_t since_ms, history_visit visit, void* ctx);
+
+/**
+ * @brief Instante actual en milisegundos desde la época Unix, en la misma escala que history_read().
+ *
+ * @return Milisegundos desde la época Unix.
+ */
+uint64_t history_now_ms();
@@ -0,0 +1,118 @@
+/**
+ * @file metric_store.h
+ * @brief Valores de las métricas publicados con un seqlock.
+ *
+ * Los colectores escriben los valores de un tick en una copia de trabajo
+ * propia y al terminar la publican completa con metric_store_publish(). El
+ * servidor HTTP lee la última publicación con metric_store_read(), que nunca
+ * bloquea al colector: si la copia cambia mientras se lee, la lectura se
+ * reintenta. Así un scrape lento no puede demorar el muestreo y siempre ve
+ * valores de un mismo tick.
+ *
+ * Hay un único publicador. Los colectores de un tick corren en paralelo en
+ * los hilos de worker_pool.h y todos escriben la copia de trabajo, pero cada
+ * uno solo sus propios campos; la barrera que los reúne termina antes de que
+ * el planificador llame a metric_store_publish().
+ */
+
+#pragma once
+#include "bpf_latency.h"
+#include "cgroup.h"
+#include "metrics.h"
+#include "proc_top.h"
+#include "self_stats.h"
+#include "sim_alloc.h"
+#include <stddef.h>
+
+/**
+ * @brief Cantidad máxima de colectores con estadísticas propias.
+ */
+#define METRIC_MAX_COLLECTORS 16
+
+/**
+ * @brief Cubetas con límite del histograma de duración de cada colector.
+ */
+#define COLLECTOR_DURATION_BUCKETS 12
+
+/**
+ * @brief Métricas escalares, sin etiquetas.
+ */
+enum metric_id
+{
+    METRIC_CPU_USAGE,           /**< Porcentaje de uso de CPU. */
+    METRIC_MEMORY_USAGE,        /**< Porcentaje de uso de memoria. */
+    METRIC_DISK_USAGE,          /**< MB por segundo de E/S de disco. */
+    METRIC_NETWORK_USAGE,       /**< MB transferidos por la red. */
+    METRIC_BANDWIDTH_USAGE,     /**< Ancho de banda en MB por segundo. */
+    METRIC_MAJOR_PAGE_FAULTS,   /**< Fallos de página mayores. */
+    METRIC_MINOR_PAGE_FAULTS,   /**< Fallos de página menores. */
+    METRIC_CHANGE_CONTEXT,      /**< Cambios de contexto. */
+    METRIC_TOTAL_PROCESSES,     /**< Procesos creados. */
+    METRIC_DISK_STATS,          /**< Lecturas y escrituras de disco completadas. */
+    METRIC_MEMORY_TOTAL,        /**< Memoria total. */
+    METRIC_MEMORY_AVALIBLE,     /**< Memoria disponible. */
+    METRIC_MEMORY_USAGE_2,      /**< Uso de memoria como fracción. */
+    METRIC_FRAG_FIRST_FIT,      /**< Fragmentación externa con First Fit. */
+    METRIC_FRAG_BEST_FIT,       /**< Fragmentación externa con Best Fit. */
+    METRIC_FRAG_WORST_FIT,      /**< Fragmentación externa con Worst Fit. */
+    METRIC_FRAG_SEGREGATED_FIT, /**< Fragmentación externa con listas segregadas. */
+    METRIC_SCALAR_COUNT         /**< Cantidad de métricas escalares. */
+};
+
+/**
+ * @brief Estadísticas del planificador para un colector.
+ */
+struct collector_stats
+{
+    const char* name;                                                /**< Nombre del colector; cadena estática. */
+    unsigned long long skipped;                                      /**< Ticks salteados desde el inicio. */
+    double latency;                                                  /**< Última duración en segundos. */
+    unsigned long long duration_buckets[COLLECTOR_DURATION_BUCKETS]; /**< Ejecuciones por cubeta, no acumuladas. */
+    unsigned long long duration_count;                               /**< Ejecuciones desde el inicio. */
+    double duration_sum;                                             /**< Suma de las duraciones en segundos. */
+};
+
+/**
+ * @brief Valores de todas las métricas en un tick.
+ */
+struct metric_values
+{
+    double scalar[METRIC_SCALAR_COUNT];                       /**< Métricas escalares, indexadas por @ref metric_id. */
+    struct percpu_usage percpu;                               /**< Uso de cada CPU por modo. */
+    struct disk_rate disks[MAX_DISK_DEVICES];                 /**< Tasas de cada disco seguido. */
+    size_t disk_count;                                        /**< Discos válidos en `disks`. */
+    struct net_rate nets[MAX_NET_INTERFACES];                 /**< Tasas de cada interfaz seguida. */
+    size_t net_count;                                         /**< Interfaces válidas en `nets`. */
+    struct collector_stats collectors[METRIC_MAX_COLLECTORS]; /**< Estadísticas de cada colector. */
+    size_t collector_count;                                   /**< Colectores válidos en `collectors`. */
+    double source_latency[PROC_SOURCE_COUNT];                 /**< Duración de la última lectura de cada fuente. */
+    double alloc_latency[SIM_METHOD_COUNT];                   /**< Nanosegundos por operación de cada política. */
+    double alloc_throughput[SIM_METHOD_COUNT];                /**< Operaciones por segundo de cada política. */
+    struct proc_top top;                                      /**< Procesos que más recursos consumen. */
+    struct cgroup_stats cgroups;                              /**< Valores de cada cgroup v2. */
+    struct bpf_latency latency;                               /**< Histogramas de latencia medidos con eBPF. */
+    struct self_stats self;                                   /**< Costo del propio agente. */
+};
+
+/**
+ * @brief Devuelve la copia de trabajo del escritor.
+ *
+ * Conserva los valores del tick anterior, de modo que un colector que no se
+ * ejecutó en este tick publica su último valor.
+ *
+ * @return Copia de trabajo; cada colector escribe solo sus propios campos y
+ * nadie la toca mientras se publica.
+ */
+struct metric_values* metric_store_stage();
+
+/**
+ * @brief Publica la copia de trabajo completa.
+ */
+void metric_store_publish();
+
+/**
+ * @brief Copia la última publicación sin bloquear al escritor.
+ *
+ * @param out Recibe los valores de un único tick.
+ */
+void metric_store_read(struct metric_values* out);
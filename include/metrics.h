@@ -20,6 +20,312 @@
  */
 #define SECTOR_SIZE 512 // para el get_disk
 
+/**
+ * @brief Cantidad máxima de CPUs seguidas individualmente en /proc/stat.
+ */
+#define MAX_CPUS 1024
+
+/**
+ * @brief Cantidad máxima de discos seguidos en /proc/diskstats.
+ */
+#define MAX_DISK_DEVICES 32
+
+/**
+ * @brief Longitud máxima del nombre de un dispositivo, incluyendo el '\0'.
+ */
+#define DISK_NAME_LEN 32
+
+/**
+ * @brief Variable de entorno con la lista de patrones de discos a seguir.
+ *
+ * Es una lista separada por comas de patrones fnmatch(3), por ejemplo
+ * "nvme*n?,sd?".
+ */
+#define DISK_DEVICES_ENV "MONITOR_DISK_DEVICES"
+
+/**
+ * @brief Patrones de discos usados si no se define @ref DISK_DEVICES_ENV.
+ *
+ * Coinciden con los discos completos y no con sus particiones.
+ */
+#define DISK_DEVICES_DEFAULT "sd?,vd?,xvd?,hd?,nvme*n?,mmcblk?"
+
+/**
+ * @brief Cantidad máxima de interfaces de red seguidas en /proc/net/dev.
+ */
+#define MAX_NET_INTERFACES 32
+
+/**
+ * @brief Longitud máxima del nombre de una interfaz, incluyendo el '\0'; coincide con IFNAMSIZ.
+ */
+#define NET_NAME_LEN 16
+
+/**
+ * @brief Variable de entorno con el directorio desde el que se leen las fuentes de /proc.
+ */
+#define PROC_ROOT_ENV "MONITOR_PROC_ROOT"
+
+/**
+ * @brief Raíz de las fuentes si no se define @ref PROC_ROOT_ENV.
+ */
+#define PROC_ROOT_DEFAULT "/proc"
+
+/**
+ * @brief Variable de entorno con la lista de patrones de interfaces a seguir.
+ *
+ * Es una lista separada por comas de patrones fnmatch(3); los que empiezan con
+ * '!' excluyen. Una interfaz se sigue si coincide con algún patrón que incluye
+ * (o si no hay ninguno) y con ninguno que excluye, por ejemplo "eth*,en*,!enp0s31f6".
+ */
+#define NET_INTERFACES_ENV "MONITOR_NET_INTERFACES"
+
+/**
+ * @brief Patrones de interfaces usados si no se define @ref NET_INTERFACES_ENV.
+ *
+ * Descartan el loopback y los extremos veth de los contenedores.
+ */
+#define NET_INTERFACES_DEFAULT "*,!lo,!veth*"
+
+/**
+ * @brief Fuentes de /proc que lee la capa de snapshot.
+ *
+ * Cada fuente se lee una sola vez por tick y todas las funciones get_* derivan
+ * su valor del snapshot resultante.
+ */
+enum proc_source
+{
+    PROC_STAT,        /**< /proc/stat */
+    PROC_MEMINFO,     /**< /proc/meminfo */
+    PROC_VMSTAT,      /**< /proc/vmstat */
+    PROC_DISKSTATS,   /**< /proc/diskstats */
+    PROC_NET_DEV,     /**< /proc/net/dev */
+    PROC_SOURCE_COUNT /**< Cantidad de fuentes. */
+};
+
+/**
+ * @brief Índices de los tiempos de CPU de la línea 'cpu' de /proc/stat.
+ */
+enum cpu_state
+{
+    CPU_USER,       /**< Tiempo en modo usuario. */
+    CPU_NICE,       /**< Tiempo en procesos con prioridad modificada. */
+    CPU_SYSTEM,     /**< Tiempo en modo kernel. */
+    CPU_IDLE,       /**< Tiempo inactivo. */
+    CPU_IOWAIT,     /**< Tiempo esperando E/S. */
+    CPU_IRQ,        /**< Tiempo atendiendo interrupciones. */
+    CPU_SOFTIRQ,    /**< Tiempo atendiendo softirqs. */
+    CPU_STEAL,      /**< Tiempo robado por el hipervisor. */
+    CPU_STATE_COUNT /**< Cantidad de estados. */
+};
+
+/**
+ * @brief Modos en los que se desglosa el uso de cada CPU.
+ */
+enum cpu_mode
+{
+    CPU_MODE_USER,   /**< user + nice. */
+    CPU_MODE_SYSTEM, /**< system + irq + softirq. */
+    CPU_MODE_IOWAIT, /**< iowait. */
+    CPU_MODE_STEAL,  /**< steal. */
+    CPU_MODE_COUNT   /**< Cantidad de modos. */
+};
+
+/**
+ * @brief Tiempos de cada CPU en formato estructura-de-arreglos.
+ *
+ * `times[estado][cpu]` guarda los jiffies de un estado para todas las CPUs de
+ * forma contigua, de modo que los deltas se calculen en un único bucle
+ * vectorizable.
+ */
+struct percpu_times
+{
+    unsigned long long times[CPU_STATE_COUNT][MAX_CPUS]; /**< Jiffies por estado y CPU. */
+    unsigned char online[MAX_CPUS];                      /**< 1 si la CPU apareció en /proc/stat. */
+    size_t count;                                        /**< Mayor índice de CPU visto más uno. */
+};
+
+/**
+ * @brief Porcentaje de uso por modo y CPU calculado entre dos snapshots.
+ */
+struct percpu_usage
+{
+    double percent[CPU_MODE_COUNT][MAX_CPUS]; /**< Porcentaje (0 a 100) por modo y CPU. */
+    unsigned char online[MAX_CPUS];           /**< 1 si la CPU tiene un valor válido. */
+    size_t count;                             /**< Cantidad de CPUs en los arreglos. */
+};
+
+/**
+ * @brief Contadores de un disco leídos de /proc/diskstats.
+ */
+struct disk_device
+{
+    char name[DISK_NAME_LEN];         /**< Nombre del dispositivo. */
+    unsigned long long reads;         /**< Lecturas completadas. */
+    unsigned long long writes;        /**< Escrituras completadas. */
+    unsigned long long read_sectors;  /**< Sectores leídos. */
+    unsigned long long write_sectors; /**< Sectores escritos. */
+};
+
+/**
+ * @brief Tasas de un disco calculadas entre dos snapshots.
+ */
+struct disk_rate
+{
+    char name[DISK_NAME_LEN];     /**< Nombre del dispositivo. */
+    double read_sectors_per_sec;  /**< Sectores leídos por segundo. */
+    double write_sectors_per_sec; /**< Sectores escritos por segundo. */
+};
+
+/**
+ * @brief Contadores de cada interfaz que se leen de /proc/net/dev.
+ */
+enum net_counter
+{
+    NET_RX_BYTES,     /**< Bytes recibidos. */
+    NET_RX_PACKETS,   /**< Paquetes recibidos. */
+    NET_RX_ERRORS,    /**< Errores de recepción. */
+    NET_RX_DROPS,     /**< Paquetes recibidos descartados. */
+    NET_TX_BYTES,     /**< Bytes transmitidos. */
+    NET_TX_PACKETS,   /**< Paquetes transmitidos. */
+    NET_TX_ERRORS,    /**< Errores de transmisión. */
+    NET_TX_DROPS,     /**< Paquetes a transmitir descartados. */
+    NET_COUNTER_COUNT /**< Cantidad de contadores. */
+};
+
+/**
+ * @brief Contadores de una interfaz leídos de /proc/net/dev.
+ */
+struct net_interface
+{
+    char name[NET_NAME_LEN];                        /**< Nombre de la interfaz. */
+    unsigned long long counters[NET_COUNTER_COUNT]; /**< Contadores indexados por @ref net_counter. */
+};
+
+/**
+ * @brief Tasas de una interfaz calculadas entre dos snapshots.
+ */
+struct net_rate
+{
+    char name[NET_NAME_LEN];           /**< Nombre de la interfaz. */
+    double per_sec[NET_COUNTER_COUNT]; /**< Tasas por segundo indexadas por @ref net_counter. */
+};
+
+/**
+ * @brief Bytes de una interfaz cualquiera de /proc/net/dev, siga o no los patrones.
+ */
+struct net_total
+{
+    char name[NET_NAME_LEN];     /**< Nombre de la interfaz. */
+    unsigned long long rx_bytes; /**< Bytes recibidos. */
+    unsigned long long tx_bytes; /**< Bytes transmitidos. */
+};
+
+/**
+ * @brief Valores crudos leídos de /proc en el último tick.
+ *
+ * El campo `valid` indica, por fuente, si la última lectura fue exitosa.
+ */
+struct proc_snapshot
+{
+    int valid[PROC_SOURCE_COUNT];                    /**< 1 si la fuente se leyó correctamente. */
+    unsigned long long ts_ns[PROC_SOURCE_COUNT];     /**< Instante de la lectura (CLOCK_MONOTONIC, ns). */
+    unsigned long long cpu[CPU_STATE_COUNT];         /**< Tiempos agregados de CPU (jiffies). */
+    struct percpu_times percpu;                      /**< Tiempos de cada CPU. */
+    unsigned long long ctxt;                         /**< Cambios de contexto acumulados. */
+    unsigned long long processes;                    /**< Procesos creados desde el arranque. */
+    unsigned long long mem_total;                    /**< MemTotal en kB. */
+    unsigned long long mem_available;                /**< MemAvailable en kB. */
+    unsigned long long pgfault;                      /**< Fallos de página menores acumulados. */
+    unsigned long long pgmajfault;                   /**< Fallos de página mayores acumulados. */
+    struct disk_device disks[MAX_DISK_DEVICES];      /**< Discos que coinciden con los patrones. */
+    size_t disk_count;                               /**< Cantidad de discos válidos en `disks`. */
+    unsigned long long net_rx_bytes;                 /**< Bytes recibidos sumando todas las interfaces. */
+    unsigned long long net_tx_bytes;                 /**< Bytes transmitidos sumando todas las interfaces. */
+    struct net_interface nets[MAX_NET_INTERFACES];   /**< Interfaces que coinciden con los patrones. */
+    size_t net_count;                                /**< Cantidad de interfaces válidas en `nets`. */
+    struct net_total net_totals[MAX_NET_INTERFACES]; /**< Primeras interfaces de /proc/net/dev, sin filtrar. */
+    size_t net_total_count;                          /**< Cantidad de interfaces válidas en `net_totals`. */
+};
+
+/**
+ * @brief Cambia el directorio desde el que se leen las fuentes de /proc.
+ *
+ * Cierra las fuentes abiertas, que se reabren desde la nueva raíz en la
+ * próxima lectura. Sirve para reproducir archivos grabados, como hace
+ * monitor_bench.
+ *
+ * @param root Directorio con la misma disposición que /proc, o NULL para @ref PROC_ROOT_DEFAULT.
+ */
+void set_proc_root(const char* root);
+
+/**
+ * @brief Abre de forma persistente todas las fuentes de /proc.
+ *
+ * Se llama una vez desde init_metrics(); las lecturas posteriores reutilizan
+ * los descriptores con pread(). Si no se llamó antes a set_proc_root(), la
+ * raíz sale de @ref PROC_ROOT_ENV.
+ *
+ * @return 0 si todas las fuentes se abrieron, -1 si alguna falló.
+ */
+int init_proc_sources();
+
+/**
+ * @brief Cierra los descriptores y libera los buffers de las fuentes.
+ */
+void close_proc_sources();
+
+/**
+ * @brief Configura qué discos de /proc/diskstats se siguen.
+ *
+ * @param patterns Lista de patrones fnmatch(3) separados por comas, o NULL
+ * para usar @ref DISK_DEVICES_DEFAULT.
+ */
+void set_disk_devices(const char* patterns);
+
+/**
+ * @brief Configura qué interfaces de /proc/net/dev se siguen.
+ *
+ * @param patterns Lista de patrones fnmatch(3) separados por comas, con '!'
+ * para excluir, o NULL para usar @ref NET_INTERFACES_DEFAULT.
+ */
+void set_net_interfaces(const char* patterns);
+
+/**
+ * @brief Parsea el contenido de una fuente y actualiza su parte del snapshot.
+ *
+ * update_proc_source() la usa tras cada lectura; también permite parsear
+ * contenido grabado, por ejemplo en los benchmarks.
+ *
+ * @param source Fuente a la que pertenece el contenido.
+ * @param buf Contenido completo del archivo, terminado en '\0'.
+ * @return 0 si se encontraron todos los campos esperados, -1 en caso contrario.
+ */
+int parse_proc_source(enum proc_source source, const char* buf);
+
+/**
+ * @brief Relee una fuente de /proc y actualiza su parte del snapshot.
+ *
+ * @param source Fuente a releer.
+ * @return 0 si la lectura fue exitosa, -1 en caso de error.
+ */
+int update_proc_source(enum proc_source source);
+
+/**
+ * @brief Relee todas las fuentes de /proc, una vez cada una.
+ *
+ * Debe llamarse una vez por tick antes de consultar las funciones get_*.
+ *
+ * @return 0 si todas las fuentes se leyeron, -1 si alguna falló.
+ */
+int update_proc_snapshot();
+
+/**
+ * @brief Devuelve el snapshot del último tick.
+ *
+ * @return Puntero de solo lectura al snapshot interno.
+ */
+const struct proc_snapshot* get_proc_snapshot();
+
 /**
  * @brief Obtiene la métrica de fragmentación externa utilizando el método First Fit.
  *
@@ -53,6 +359,32 @@ double get_external_frag_best_fit();
  */
 double get_external_frag_worst_fit();
 
+/**
+ * @brief Obtiene la métrica de fragmentación externa utilizando listas segregadas.
+ *
+ * Calcula la fragmentación externa para la política de listas libres segregadas
+ * por clase de tamaño, con los mismos datos que usan las otras tres políticas.
+ *
+ * @return El valor de la fragmentación externa calculada por el método Segregated Fit.
+ */
+double get_external_frag_segregated_fit();
+
+/**
+ * @brief Obtiene la latencia media de asignación medida por el simulador.
+ *
+ * @param method Política de asignación (0 First Fit, 1 Best Fit, 2 Worst Fit, 3 Segregated Fit).
+ * @return Nanosegundos por operación de malloc o free, o -1 si el método es inválido.
+ */
+double get_alloc_latency(int method);
+
+/**
+ * @brief Obtiene el rendimiento de asignación medido por el simulador.
+ *
+ * @param method Política de asignación (0 First Fit, 1 Best Fit, 2 Worst Fit, 3 Segregated Fit).
+ * @return Operaciones de malloc o free por segundo, o -1 si el método es inválido.
+ */
+double get_alloc_throughput(int method);
+
 /**
  * @brief Obtiene la cantidad de cambios de contexto del sistema desde
  * /proc/stat.
@@ -69,11 +401,10 @@ unsigned long long get_change_context();
 unsigned long long get_total_processes();
 
 /**
- * @brief Obtiene la suma total de lecturas y escrituras en el disco desde
- * /proc/diskstats.
+ * @brief Obtiene la suma total de lecturas y escrituras en los discos seguidos
+ * desde /proc/diskstats.
  *
- * @return Suma de lecturas y escrituras del disco en bytes, o -1.0 en caso de
- * error.
+ * @return Suma de lecturas y escrituras completadas, o -1.0 en caso de error.
  */
 double get_disk_stats();
 
@@ -121,16 +452,52 @@ double get_memory_usage();
 double get_cpu_usage();
 
 /**
- * @brief Obtiene el porcentaje de uso de disco desde /proc/diskstats.
+ * @brief Calcula el porcentaje de uso de cada CPU desglosado por modo.
  *
- * Esta función lee el estado del uso de discos desde /proc/diskstats, que
- * proporciona estadísticas detalladas de los discos en el sistema, y calcula el
- * uso total de lectura y escritura.
+ * Compara los tiempos por CPU del snapshot actual de /proc/stat con los de la
+ * llamada anterior. No reserva memoria: el resultado vive en un arreglo interno.
  *
- * @return Porcentaje de uso de disco, o -1.0 en caso de error.
+ * @return Puntero al resultado, válido hasta la siguiente llamada, o NULL en
+ * caso de error.
+ */
+const struct percpu_usage* get_percpu_usage();
+
+/**
+ * @brief Obtiene el volumen de E/S de disco desde /proc/diskstats.
+ *
+ * Suma los sectores leídos y escritos por los discos seguidos entre esta
+ * llamada y la anterior, comparando cada contador con su propia lectura previa,
+ * y calcula la tasa con el tiempo transcurrido.
+ *
+ * @return MB leídos y escritos por segundo, o -1.0 en caso de error.
  */
 double get_disk_usage();
 
+/**
+ * @brief Calcula las tasas de lectura y escritura de cada disco seguido.
+ *
+ * Compara el snapshot actual de /proc/diskstats con el de la llamada anterior.
+ * Un disco que aparece por primera vez reporta tasa 0.
+ *
+ * @param rates Recibe un puntero a un arreglo interno, válido hasta la
+ * siguiente llamada.
+ * @return Cantidad de discos en el arreglo, o 0 en caso de error.
+ */
+size_t get_disk_device_rates(const struct disk_rate** rates);
+
+/**
+ * @brief Calcula las tasas de cada interfaz de red seguida.
+ *
+ * Compara el snapshot actual de /proc/net/dev con el de la llamada anterior.
+ * Una interfaz que aparece por primera vez, o cuyos contadores se reiniciaron,
+ * reporta tasa 0.
+ *
+ * @param rates Recibe un puntero a un arreglo interno, válido hasta la
+ * siguiente llamada.
+ * @return Cantidad de interfaces en el arreglo, o 0 en caso de error.
+ */
+size_t get_net_interface_rates(const struct net_rate** rates);
+
 /**
  * @brief Obtiene el tráfico de red desde /proc/net/dev.
  *
@@ -144,8 +511,10 @@ double get_network_usage();
 /**
  * @brief Obtiene el ancho de banda promedio en uso desde /proc/net/dev.
  *
- * Lee los bytes transmitidos y recibidos desde /proc/net/dev y calcula el
- * ancho de banda promedio en uso basado en el intervalo de tiempo de muestreo.
+ * Suma los bytes transmitidos y recibidos por cada interfaz de /proc/net/dev
+ * desde la llamada anterior, comparando cada contador con su propia lectura
+ * previa, y calcula el ancho de banda promedio en uso con el tiempo real
+ * (CLOCK_MONOTONIC) transcurrido.
  *
  * @return Ancho de banda en uso en Megabytes por segundo, o -1.0 en caso de
  * error.
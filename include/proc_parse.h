@@ -0,0 +1,81 @@
+/**
+ * @file proc_parse.h
+ * @brief Tokenizador sin reservas de memoria para los formatos de /proc.
+ *
+ * Reemplaza a sscanf en los colectores: todas las funciones trabajan sobre un
+ * cursor dentro de un buffer terminado en '\0' y devuelven la posición
+ * siguiente, o NULL si el texto no tiene la forma esperada. Ninguna cruza el
+ * final de la línea actual salvo parse_next_line().
+ */
+
+#pragma once
+#include <stddef.h>
+
+/**
+ * @brief Compara el comienzo de una línea con una clave literal.
+ *
+ * @param line Comienzo de la línea.
+ * @param key Literal de cadena con la clave, por ejemplo "ctxt ".
+ */
+#define PARSE_KEY(line, key) parse_key((line), (key), sizeof(key) - 1)
+
+/**
+ * @brief Saltea espacios y tabulaciones, sin pasar al siguiente renglón.
+ *
+ * @param p Cursor actual.
+ * @return Primer carácter que no es espacio.
+ */
+const char* parse_skip_spaces(const char* p);
+
+/**
+ * @brief Lee un entero decimal sin signo, salteando los espacios previos.
+ *
+ * @param p Cursor actual.
+ * @param out Recibe el valor leído.
+ * @return Cursor tras el último dígito, o NULL si no había dígitos.
+ */
+const char* parse_u64(const char* p, unsigned long long* out);
+
+/**
+ * @brief Saltea campos separados por espacios.
+ *
+ * @param p Cursor actual.
+ * @param count Cantidad de campos a saltear.
+ * @return Cursor tras el último campo salteado, o NULL si la línea termina antes.
+ */
+const char* parse_skip_fields(const char* p, int count);
+
+/**
+ * @brief Verifica si la línea comienza con una clave.
+ *
+ * Compara primero el byte inicial para descartar rápido las líneas que no
+ * coinciden.
+ *
+ * @param line Comienzo de la línea.
+ * @param key Clave a buscar.
+ * @param key_len Longitud de la clave.
+ * @return Cursor tras la clave, o NULL si la línea no comienza con ella.
+ */
+const char* parse_key(const char* line, const char* key, size_t key_len);
+
+/**
+ * @brief Copia un nombre, salteando los espacios previos.
+ *
+ * El nombre termina en un espacio, en el fin de línea o en el carácter
+ * `stop` (que se consume). Si no entra en `out` se trunca.
+ *
+ * @param p Cursor actual.
+ * @param out Buffer de destino.
+ * @param out_len Tamaño de `out`, incluyendo el '\0'.
+ * @param stop Carácter separador adicional, o '\0' si no hay.
+ * @return Cursor tras el nombre, o NULL si estaba vacío.
+ */
+const char* parse_name(const char* p, char* out, size_t out_len, char stop);
+
+/**
+ * @brief Avanza al comienzo de la siguiente línea.
+ *
+ * @param p Cualquier posición dentro de la línea actual.
+ * @return Comienzo de la siguiente línea, o NULL si no quedan más.
+ */
+const char* parse_next_line(const char* p);
@@ -0,0 +1,86 @@
+/**
+ * @file proc_reader.h
+ * @brief Lector de archivos de /proc con descriptores persistentes.
+ *
+ * Cada lector abre su archivo una sola vez y lo relee completo con pread()
+ * desde el offset 0 en un buffer propio que crece según sea necesario. Así se
+ * evitan las llamadas a open/close y las estructuras FILE de libc en cada tick.
+ *
+ * Todos los lectores suman sus llamadas al sistema y los bytes leídos en
+ * contadores globales, para medir cuánto cuesta el propio agente.
+ */
+
+#pragma once
+#include <stddef.h>
+#include <sys/types.h>
+
+/**
+ * @brief Tamaño inicial del buffer de cada lector en bytes.
+ */
+#define PROC_READER_INITIAL_SIZE 16384
+
+/**
+ * @brief Estado de un archivo de /proc abierto de forma persistente.
+ */
+struct proc_reader
+{
+    const char* path; /**< Ruta del archivo. */
+    int fd;           /**< Descriptor abierto, o -1 si está cerrado. */
+    char* buf;        /**< Contenido de la última lectura, terminado en '\0'. */
+    size_t cap;       /**< Capacidad del buffer en bytes. */
+    size_t len;       /**< Bytes válidos de la última lectura. */
+};
+
+/**
+ * @brief Llamadas al sistema y bytes leídos de /proc y /sys desde el inicio.
+ */
+struct proc_reader_stats
+{
+    unsigned long long syscalls; /**< Llamadas a open, pread, read y close. */
+    unsigned long long bytes;    /**< Bytes leídos. */
+};
+
+/**
+ * @brief Abre el archivo y reserva el buffer inicial del lector.
+ *
+ * @param r Lector a inicializar.
+ * @param path Ruta del archivo; debe permanecer válida mientras el lector esté abierto.
+ * @return 0 si se abrió correctamente, -1 en caso de error.
+ */
+int proc_reader_open(struct proc_reader* r, const char* path);
+
+/**
+ * @brief Relee el archivo completo desde el offset 0.
+ *
+ * El buffer se duplica cada vez que el contenido no entra, por lo que tras las
+ * primeras lecturas no se vuelve a reservar memoria.
+ *
+ * @param r Lector abierto con proc_reader_open().
+ * @return Cantidad de bytes leídos, o -1 en caso de error.
+ */
+ssize_t proc_reader_read(struct proc_reader* r);
+
+/**
+ * @brief Cierra el descriptor y libera el buffer del lector.
+ *
+ * @param r Lector a cerrar.
+ */
+void proc_reader_close(struct proc_reader* r);
+
+/**
+ * @brief Suma a los contadores globales las lecturas hechas sin un lector.
+ *
+ * Es para quien abre y lee archivos de /proc por su cuenta, como proc_top.c; se
+ * puede llamar desde cualquier hilo.
+ *
+ * @param syscalls Llamadas al sistema hechas.
+ * @param bytes Bytes leídos.
+ */
+void proc_reader_account(unsigned long long syscalls, unsigned long long bytes);
+
+/**
+ * @brief Copia los contadores globales de todos los lectores.
+ *
+ * @param out Recibe los contadores.
+ */
+void proc_reader_get_stats(struct proc_reader_stats* out);
@@ -0,0 +1,101 @@
+/**
+ * @file proc_top.h
+ * @brief Procesos que más CPU, memoria residente y fallos de página consumen.
+ *
+ * Cada lectura recorre /proc con un descriptor del directorio abierto una sola
+ * vez y lee /proc/[pid]/stat con openat(). Las muestras anteriores se guardan
+ * en una tabla hash indexada por pid, así que las tasas salen de la diferencia
+ * con la lectura previa. De cada ranking solo se conservan los primeros
+ * @ref PROC_TOP_MAX como máximo, con un min-heap acotado: la cantidad de series
+ * exportadas no depende de cuántos procesos haya.
+ */
+
+#pragma once
+#include <stddef.h>
+
+/**
+ * @brief Variable de entorno con la cantidad de procesos de cada ranking; 0 desactiva el colector.
+ */
+#define PROC_TOP_ENV "MONITOR_PROC_TOP"
+
+/**
+ * @brief Procesos de cada ranking si no se define @ref PROC_TOP_ENV.
+ */
+#define PROC_TOP_DEFAULT 10
+
+/**
+ * @brief Mayor cantidad de procesos por ranking.
+ */
+#define PROC_TOP_MAX 64
+
+/**
+ * @brief Longitud del nombre de un proceso, incluyendo el '\0'; coincide con TASK_COMM_LEN.
+ */
+#define PROC_COMM_LEN 16
+
+/**
+ * @brief Capacidad inicial de la tabla de muestras; se duplica al llenarse a la mitad.
+ */
+#define PROC_TOP_TABLE_INITIAL 1024
+
+/**
+ * @brief Criterios por los que se ordenan los procesos.
+ */
+enum proc_top_rank
+{
+    PROC_TOP_CPU,       /**< Porcentaje de una CPU usado desde la lectura anterior. */
+    PROC_TOP_RSS,       /**< Bytes de memoria residente. */
+    PROC_TOP_FAULTS,    /**< Fallos de página, menores y mayores, por segundo. */
+    PROC_TOP_RANK_COUNT /**< Cantidad de rankings. */
+};
+
+/**
+ * @brief Un proceso dentro de un ranking.
+ */
+struct proc_top_entry
+{
+    char pid[12];             /**< Pid en decimal, listo para usar como etiqueta. */
+    char comm[PROC_COMM_LEN]; /**< Nombre del proceso según /proc/[pid]/stat. */
+    double value;             /**< Valor por el que se ordenó. */
+};
+
+/**
+ * @brief Rankings de una lectura, cada uno de mayor a menor.
+ */
+struct proc_top
+{
+    struct proc_top_entry entries[PROC_TOP_RANK_COUNT][PROC_TOP_MAX]; /**< Procesos de cada ranking. */
+    size_t count[PROC_TOP_RANK_COUNT];                                /**< Procesos válidos de cada ranking. */
+    size_t scanned;                                                   /**< Procesos leídos en /proc. */
+};
+
+/**
+ * @brief Abre /proc y lee @ref PROC_TOP_ENV.
+ *
+ * @return 0 si el colector quedó listo o está desactivado, -1 si no se pudo abrir /proc.
+ */
+int proc_top_init();
+
+/**
+ * @brief Indica si el colector está activo.
+ *
+ * @return Distinto de 0 si proc_top_init() lo dejó listo.
+ */
+int proc_top_enabled();
+
+/**
+ * @brief Recorre los procesos y calcula los rankings.
+ *
+ * Un proceso que aparece por primera vez, o cuyo pid se reutilizó, solo entra
+ * en el ranking de memoria hasta la lectura siguiente. Los valores en 0 no se
+ * incluyen.
+ *
+ * @param out Recibe los rankings; no cambia si el colector está desactivado.
+ * @return 0 si se leyó, -1 si el colector está desactivado o hubo un error.
+ */
+int proc_top_update(struct proc_top* out);
+
+/**
+ * @brief Cierra /proc y libera las tablas de muestras.
+ */
+void proc_top_close();
@@ -0,0 +1,102 @@
+/**
+ * @file push.h
+ * @brief Envío de las métricas a un colector remoto, como alternativa al scrape.
+ *
+ * En cada tick publish_metrics() encola los valores escalares de la misma
+ * publicación que lee el servidor HTTP. Un hilo propio junta
+ * @ref PUSH_BATCH_ENV ticks y los envía según el esquema de
+ * @ref PUSH_URL_ENV:
+ *
+ * - "statsd://host:puerto": gauges de StatsD por UDP.
+ * - "influx://host:puerto": protocolo de líneas de InfluxDB por UDP.
+ * - "http://host:puerto/ruta": remote-write de Prometheus, protobuf comprimido con snappy.
+ *
+ * La cola es acotada y encolar nunca bloquea al colector: si el envío se
+ * atrasa, los ticks que no entran se descartan y se cuentan.
+ */
+
+#pragma once
+#include "metric_store.h"
+#include <stdint.h>
+
+/**
+ * @brief Variable de entorno con el destino; sin definir, el envío está desactivado.
+ */
+#define PUSH_URL_ENV "MONITOR_PUSH_URL"
+
+/**
+ * @brief Variable de entorno con la cantidad de ticks de cada envío.
+ */
+#define PUSH_BATCH_ENV "MONITOR_PUSH_BATCH"
+
+/**
+ * @brief Ticks de cada envío si no se define @ref PUSH_BATCH_ENV.
+ */
+#define PUSH_BATCH_DEFAULT 10
+
+/**
+ * @brief Ticks que entran en la cola; también es el mayor valor de @ref PUSH_BATCH_ENV.
+ */
+#define PUSH_QUEUE_LEN 256
+
+/**
+ * @brief Milisegundos tras los que se envía un lote incompleto.
+ */
+#define PUSH_FLUSH_MS 5000
+
+/**
+ * @brief Milisegundos de espera para conectar, enviar y recibir la respuesta de remote-write.
+ */
+#define PUSH_TIMEOUT_MS 5000
+
+/**
+ * @brief Reintentos de un lote de remote-write antes de descartarlo.
+ */
+#define PUSH_RETRIES 3
+
+/**
+ * @brief Bytes de cada datagrama UDP; entra en una trama Ethernet sin fragmentar.
+ */
+#define PUSH_UDP_PAYLOAD 1400
+
+/**
+ * @brief Contadores del envío desde el inicio.
+ */
+struct push_stats
+{
+    unsigned long long sent;         /**< Ticks enviados. */
+    unsigned long long queue_full;   /**< Ticks descartados porque la cola estaba llena. */
+    unsigned long long send_failed;  /**< Ticks descartados porque su lote no se pudo enviar. */
+    unsigned long long queued;       /**< Ticks esperando en la cola. */
+};
+
+/**
+ * @brief Lee @ref PUSH_URL_ENV y, si está definida, arranca el hilo de envío.
+ *
+ * @param names Nombre de cada métrica escalar, indexado por @ref metric_id; debe permanecer válido.
+ * @return 0 si el envío quedó activo o está desactivado, -1 si el destino es inválido.
+ */
+int push_init(const char* const names[METRIC_SCALAR_COUNT]);
+
+/**
+ * @brief Indica si el envío está activo.
+ *
+ * @return Distinto de 0 si push_init() arrancó el hilo de envío.
+ */
+int push_enabled();
+
+/**
+ * @brief Encola los valores escalares de un tick sin bloquear.
+ *
+ * Solo debe llamarse desde el hilo de los colectores.
+ *
+ * @param v Publicación del tick.
+ */
+void push_enqueue(const struct metric_values* v);
+
+/**
+ * @brief Copia los contadores del envío.
+ *
+ * @param out Recibe los contadores.
+ */
+void push_get_stats(struct push_stats* out);
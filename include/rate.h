@@ -0,0 +1,68 @@
+/**
+ * @file rate.h
+ * @brief Muestras con marca de tiempo para calcular tasas por segundo.
+ *
+ * Los colectores de tipo tasa guardan la última lectura de cada contador junto
+ * con el instante en que se leyó (CLOCK_MONOTONIC, en nanosegundos). La tasa se
+ * calcula con el tiempo real transcurrido entre lecturas, por lo que es correcta
+ * con cualquier intervalo, incluso por debajo del segundo.
+ */
+
+#pragma once
+
+/**
+ * @brief Umbral a partir del cual una caída del contador se toma como vuelta de uno de 32 bits.
+ *
+ * Algunos contadores del kernel son de 32 bits. Si el valor anterior estaba en
+ * la mitad superior de ese rango y el nuevo es menor, se asume que dio la
+ * vuelta. Cualquier otra caída se trata como un reinicio del contador, por
+ * ejemplo una interfaz que se recreó.
+ */
+#define RATE_WRAP32_THRESHOLD 0x80000000ULL
+
+/**
+ * @brief Última lectura de un contador monótono.
+ */
+struct rate_sample
+{
+    unsigned long long value; /**< Valor del contador. */
+    unsigned long long ts_ns; /**< Instante de la lectura, o 0 si todavía no hay muestra. */
+};
+
+/**
+ * @brief Calcula el incremento de un contador, contemplando la vuelta de 32 bits.
+ *
+ * @param prev Valor anterior.
+ * @param cur Valor actual.
+ * @param delta Recibe el incremento.
+ * @return 0 si el incremento es válido, -1 si el contador se reinició.
+ */
+int rate_delta(unsigned long long prev, unsigned long long cur, unsigned long long* delta);
+
+/**
+ * @brief Registra una nueva lectura y calcula el incremento desde la anterior.
+ *
+ * La muestra se actualiza siempre, de modo que tras un reinicio la siguiente
+ * llamada vuelve a tener una base válida.
+ *
+ * @param sample Última lectura del contador; se reemplaza por la actual.
+ * @param value Valor actual del contador.
+ * @param ts_ns Instante de la lectura actual.
+ * @param delta Recibe el incremento.
+ * @param elapsed_ns Recibe el tiempo transcurrido en nanosegundos.
+ * @return 0 si hay un incremento válido, -1 si es la primera muestra, no pasó
+ * tiempo o el contador se reinició.
+ */
+int rate_sample_update(struct rate_sample* sample, unsigned long long value, unsigned long long ts_ns,
+                       unsigned long long* delta, unsigned long long* elapsed_ns);
+
+/**
+ * @brief Registra una nueva lectura y calcula la tasa por segundo.
+ *
+ * @param sample Última lectura del contador; se reemplaza por la actual.
+ * @param value Valor actual del contador.
+ * @param ts_ns Instante de la lectura actual.
+ * @param per_sec Recibe el incremento por segundo.
+ * @return 0 si la tasa es válida, -1 en los mismos casos que rate_sample_update().
+ */
+int rate_per_second(struct rate_sample* sample, unsigned long long value, unsigned long long ts_ns, double* per_sec);
@@ -0,0 +1,100 @@
+/**
+ * @file scheduler.h
+ * @brief Planificador de colectores con intervalos propios y plazos absolutos.
+ *
+ * Cada colector tiene su propio intervalo y un plazo absoluto sobre
+ * CLOCK_MONOTONIC. El planificador duerme con clock_nanosleep(TIMER_ABSTIME)
+ * hasta el plazo más próximo, relee una sola vez las fuentes de /proc que
+ * necesitan los colectores vencidos y los ejecuta. Los plazos avanzan de a un
+ * intervalo desde el plazo anterior, no desde el momento en que terminó la
+ * recolección, por lo que el periodo no deriva. Si un colector se atrasa más de
+ * un intervalo, los ticks perdidos se saltean y se informan.
+ */
+
+#pragma once
+#include "metrics.h"
+#include "worker_pool.h"
+#include <stddef.h>
+
+/**
+ * @brief Variable de entorno con los intervalos de cada colector.
+ *
+ * Lista separada por comas de pares nombre=milisegundos, por ejemplo
+ * "cpu=100,memory=30000". Los colectores no mencionados conservan su valor
+ * por defecto.
+ */
+#define SCHED_INTERVALS_ENV "MONITOR_INTERVALS"
+
+/**
+ * @brief Intervalo mínimo aceptado en milisegundos.
+ */
+#define SCHED_MIN_INTERVAL_MS 10
+
+/**
+ * @brief Cantidad máxima de colectores en la tabla.
+ */
+#define SCHED_MAX_TASKS 32
+
+/**
+ * @brief Máscara de una fuente de /proc para @ref sched_task::sources.
+ */
+#define SCHED_SOURCE(source) (1U << (source))
+
+/**
+ * @brief Colector planificado.
+ */
+struct sched_task
+{
+    const char* name;           /**< Nombre usado en la configuración y en las métricas. */
+    unsigned int interval_ms;   /**< Intervalo entre ejecuciones en milisegundos. */
+    unsigned int sources;       /**< Fuentes de /proc a releer antes de ejecutar, ver SCHED_SOURCE(). */
+    void (*collect)(void);      /**< Actualiza las métricas del colector. */
+    long long deadline_ns;      /**< Próximo plazo absoluto en CLOCK_MONOTONIC. */
+    unsigned long long skipped; /**< Ticks salteados por atraso desde el inicio. */
+    long long latency_ns;       /**< Duración de la última ejecución de `collect`. */
+};
+
+/**
+ * @brief Funciones opcionales que el planificador llama desde su propio hilo.
+ *
+ * Todas se llaman después de que terminaron los trabajos del tick, nunca desde
+ * los hilos del pool, por lo que pueden escribir en estado compartido sin
+ * sincronización.
+ */
+struct sched_hooks
+{
+    /** Se saltearon `ticks` plazos del colector por atraso. */
+    void (*on_skip)(const struct sched_task* task, unsigned long long ticks);
+    /** El colector se ejecutó; su duración está en @ref sched_task::latency_ns. */
+    void (*on_collected)(const struct sched_task* task);
+    /** Se releyó una fuente de /proc en `latency_ns` nanosegundos. */
+    void (*on_source_read)(enum proc_source source, long long latency_ns);
+    /** Terminó el tick y todos los valores están actualizados. */
+    void (*on_tick)(void);
+};
+
+/**
+ * @brief Aplica una configuración de intervalos a la tabla de colectores.
+ *
+ * @param tasks Tabla de colectores.
+ * @param count Cantidad de colectores.
+ * @param spec Lista con el formato de @ref SCHED_INTERVALS_ENV, o NULL.
+ * @return 0 si todas las entradas eran válidas, -1 si alguna se ignoró.
+ */
+int sched_configure(struct sched_task* tasks, size_t count, const char* spec);
+
+/**
+ * @brief Ejecuta los colectores para siempre.
+ *
+ * Todos los colectores se ejecutan una vez al inicio y luego cada uno en sus
+ * plazos. En cada tick primero se releen en paralelo las fuentes de /proc que
+ * necesitan los colectores vencidos y luego se ejecutan en paralelo los
+ * colectores; el pool los espera con una barrera antes de llamar a los hooks.
+ * Por eso dos colectores no deben escribir el mismo estado.
+ *
+ * @param tasks Tabla de colectores.
+ * @param count Cantidad de colectores.
+ * @param pool Pool de hilos inicializado.
+ * @param hooks Funciones a notificar; cualquiera puede ser NULL.
+ */
+void sched_run(struct sched_task* tasks, size_t count, struct worker_pool* pool, const struct sched_hooks* hooks);
@@ -0,0 +1,37 @@
+/**
+ * @file self_stats.h
+ * @brief Costo del propio agente: CPU, memoria residente y lecturas de /proc.
+ *
+ * Se actualiza una vez por tick, después de todos los colectores, así que las
+ * llamadas al sistema contadas por proc_reader.h entre dos actualizaciones son
+ * exactamente las de un tick.
+ */
+
+#pragma once
+
+/**
+ * @brief Valores del agente en un tick.
+ */
+struct self_stats
+{
+    double cpu_seconds;                 /**< Segundos de CPU de usuario y de sistema desde el inicio. */
+    double rss_bytes;                   /**< Memoria residente en bytes, de /proc/self/statm. */
+    double syscalls_per_tick;           /**< Llamadas al sistema de lectura de /proc y /sys en el último tick. */
+    unsigned long long proc_read_bytes; /**< Bytes leídos de /proc y /sys desde el inicio. */
+};
+
+/**
+ * @brief Abre /proc/self/statm.
+ *
+ * @return 0 si quedó listo, -1 si no se pudo abrir; la memoria residente queda en 0.
+ */
+int self_stats_init();
+
+/**
+ * @brief Lee el costo del agente desde la actualización anterior.
+ *
+ * Solo debe llamarse desde el hilo de los colectores.
+ *
+ * @param out Recibe los valores.
+ */
+void self_stats_update(struct self_stats* out);
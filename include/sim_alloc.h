@@ -3,12 +3,72 @@
 
 #include <stddef.h> // Para size_t
 
-// Definición de constantes
-#define SEMILLA_ALEATORIA 42
-#define NUM_ITERACIONES 5000
-#define TAMANO_MAXIMO_ASIGNACION 1024
-#define MAX_PUNTEROS_ACTIVOS 1000
-#define TIEMPO_ESPERA_SEGUNDOS 1
+/**
+ * @brief Cantidad de políticas que compara el simulador: First, Best, Worst y Segregated Fit.
+ */
+#define SIM_METHOD_COUNT 4
+
+/**
+ * @brief Variable de entorno con la configuración del simulador.
+ *
+ * Lista separada por comas de pares clave=valor, por ejemplo
+ * "ops=2000000,dist=lognormal,sigma=1.5,lifetime=5000". Las claves son:
+ * - ops: operaciones de cada ronda (malloc y free cuentan por separado).
+ * - live: máximo de bloques vivos a la vez.
+ * - dist: distribución de tamaños: uniform, lognormal o trace.
+ * - min, max: rango de tamaños en bytes; en lognormal recortan la muestra.
+ * - mu, sigma: media y desvío de ln(tamaño) en lognormal.
+ * - lifetime: vida media de un bloque, en asignaciones; 0 libera en orden de llegada al llenarse.
+ * - trace: traza escrita por la biblioteca de memoria, ver mem_trace.h; implica dist=trace.
+ * - seed: semilla de la carga.
+ * - interval: milisegundos entre rondas.
+ */
+#define SIM_CONFIG_ENV "MONITOR_SIM"
+
+/**
+ * @brief Longitud máxima de la ruta de la traza a reproducir.
+ */
+#define SIM_TRACE_PATH_MAX 256
+
+/**
+ * @brief Distribución de los tamaños pedidos.
+ */
+enum sim_distribution
+{
+    SIM_DIST_UNIFORM,   /**< Uniforme entre @ref sim_config::min_size y @ref sim_config::max_size. */
+    SIM_DIST_LOGNORMAL, /**< Log-normal con @ref sim_config::mu y @ref sim_config::sigma, recortada al rango. */
+    SIM_DIST_TRACE      /**< Reproduce la traza de @ref sim_config::trace_path. */
+};
+
+/**
+ * @brief Carga de trabajo del simulador.
+ */
+struct sim_config
+{
+    enum sim_distribution distribution;  /**< Distribución de los tamaños. */
+    unsigned long long operations;       /**< Operaciones por ronda. */
+    size_t max_live;                     /**< Máximo de bloques vivos. */
+    size_t min_size;                     /**< Menor tamaño pedido. */
+    size_t max_size;                     /**< Mayor tamaño pedido. */
+    double mu;                           /**< Media de ln(tamaño) en la log-normal. */
+    double sigma;                        /**< Desvío de ln(tamaño) en la log-normal. */
+    double mean_lifetime;                /**< Vida media exponencial de un bloque, en asignaciones. */
+    unsigned int seed;                   /**< Semilla; todas las políticas reciben la misma carga. */
+    unsigned int interval_ms;            /**< Pausa entre rondas. */
+    char trace_path[SIM_TRACE_PATH_MAX]; /**< Traza a reproducir con @ref SIM_DIST_TRACE. */
+};
+
+/**
+ * @brief Resultado de una ronda del simulador con una política.
+ */
+struct sim_result
+{
+    double frag;               /**< Fragmentación externa con los bloques vivos al final de la ronda. */
+    double ops_per_sec;        /**< Operaciones por segundo. */
+    double ns_per_op;          /**< Nanosegundos medios por operación. */
+    unsigned long long ops;    /**< Operaciones ejecutadas. */
+    unsigned long long failed; /**< Asignaciones que devolvieron NULL. */
+};
 
 /**
  * @brief Obtiene la métrica de fragmentación externa utilizando el método First Fit.
@@ -32,30 +92,71 @@ double get_frag_best_fit();
 double get_frag_worst_fit();
 
 /**
- * @brief Genera datos para las iteraciones del simulador.
+ * @brief Obtiene la métrica de fragmentación externa utilizando listas segregadas.
  *
- * Llena los arrays globales `acciones` y `tamanos` con valores aleatorios
- * para simular operaciones de asignación (malloc) y liberación (free).
+ * @return El valor de la fragmentación externa calculada por el método Segregated Fit.
  */
-void generar_datos(void);
+double get_frag_segregated_fit();
 
 /**
- * @brief Ejecuta el simulador con una política específica.
+ * @brief Obtiene la latencia media de una operación de asignación o liberación.
+ *
+ * @param metodo Política, entre 0 y @ref SIM_METHOD_COUNT - 1.
+ * @return Nanosegundos por operación de la última simulación, o -1 si el método es inválido.
+ */
+double get_alloc_latency_ns(int metodo);
+
+/**
+ * @brief Obtiene el rendimiento de una política en la última ronda.
+ *
+ * @param metodo Política, entre 0 y @ref SIM_METHOD_COUNT - 1.
+ * @return Operaciones por segundo, o -1 si el método es inválido.
+ */
+double get_alloc_throughput_ops(int metodo);
+
+/**
+ * @brief Carga la configuración por defecto del simulador.
+ *
+ * @param cfg Configuración a completar.
+ */
+void sim_default_config(struct sim_config* cfg);
+
+/**
+ * @brief Aplica una configuración con el formato de @ref SIM_CONFIG_ENV.
+ *
+ * @param cfg Configuración a modificar; las claves no mencionadas no cambian.
+ * @param spec Lista de pares clave=valor, o NULL.
+ * @return 0 si todas las entradas eran válidas, -1 si alguna se ignoró.
+ */
+int sim_configure(struct sim_config* cfg, const char* spec);
+
+/**
+ * @brief Ejecuta una ronda del simulador con una política específica.
+ *
+ * Usa el heap del hilo que la llama. Cada bloque vive una cantidad de
+ * asignaciones con distribución exponencial; cuando vence, o cuando hay
+ * @ref sim_config::max_live bloques vivos, se libera el que vence primero.
+ * La fragmentación se mide antes de liberar los bloques que quedaron vivos.
+ * Las operaciones del simulador no se registran en la traza de memoria.
  *
  * @param metodo Indica la política a utilizar:
  *               - 0: First Fit
  *               - 1: Best Fit
  *               - 2: Worst Fit
+ *               - 3: Segregated Fit
+ * @param cfg Carga de trabajo.
+ * @param res Resultado de la ronda.
+ * @return 0 si la ronda terminó, -1 si no se pudo ejecutar.
  */
-void simulador(int metodo);
+int simulador(int metodo, const struct sim_config* cfg, struct sim_result* res);
 
 /**
  * @brief Punto de entrada principal para el simulador.
  *
- * Inicializa los datos aleatorios y ejecuta iterativamente las simulaciones
- * para diferentes políticas de asignación de memoria.
+ * Lee @ref SIM_CONFIG_ENV y ejecuta rondas sin fin, las cuatro políticas en
+ * paralelo y cada una en su propio heap, publicando sus resultados.
  *
- * @return 0 si la ejecución es exitosa.
+ * @return Siempre NULL.
  */
 void* init_sim(void* arg);
 
@@ -0,0 +1,81 @@
+/**
+ * @file worker_pool.h
+ * @brief Pool de hilos para ejecutar en paralelo los trabajos de un tick.
+ *
+ * El hilo que llama a worker_pool_run() reparte un lote de trabajos entre los
+ * hilos del pool y participa él mismo. Los hilos toman los índices del lote
+ * con un contador atómico y se sincronizan con dos pthread_barrier: una para
+ * arrancar el lote y otra para esperar a que termine, de modo que al volver de
+ * worker_pool_run() todos los trabajos completaron.
+ */
+
+#pragma once
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+
+/**
+ * @brief Variable de entorno con la cantidad de hilos del pool, incluyendo al llamador.
+ */
+#define WORKER_POOL_SIZE_ENV "MONITOR_WORKERS"
+
+/**
+ * @brief Cantidad de hilos por defecto, incluyendo al llamador.
+ */
+#define WORKER_POOL_DEFAULT_SIZE 4
+
+/**
+ * @brief Cantidad máxima de hilos del pool.
+ */
+#define WORKER_POOL_MAX_SIZE 64
+
+/**
+ * @brief Trabajo a ejecutar para cada índice del lote.
+ *
+ * @param ctx Contexto pasado a worker_pool_run().
+ * @param index Índice del trabajo dentro del lote.
+ */
+typedef void (*worker_fn)(void* ctx, size_t index);
+
+/**
+ * @brief Estado del pool.
+ */
+struct worker_pool
+{
+    pthread_t threads[WORKER_POOL_MAX_SIZE]; /**< Hilos auxiliares. */
+    size_t thread_count;                     /**< Hilos auxiliares creados, sin contar al llamador. */
+    pthread_barrier_t start;                 /**< Libera a los hilos al comenzar un lote. */
+    pthread_barrier_t done;                  /**< Espera a que todos terminen el lote. */
+    worker_fn fn;                            /**< Trabajo del lote actual. */
+    void* ctx;                               /**< Contexto del lote actual. */
+    size_t count;                            /**< Cantidad de trabajos del lote actual. */
+    atomic_size_t next;                      /**< Próximo índice a tomar. */
+    int stop;                                /**< Indica a los hilos que terminen. */
+};
+
+/**
+ * @brief Crea los hilos del pool.
+ *
+ * @param pool Pool a inicializar.
+ * @param size Cantidad total de hilos, incluyendo al llamador; 1 ejecuta todo en serie.
+ * @return 0 si se creó correctamente, -1 en caso de error. Tras un error el
+ * pool no puede usarse ni destruirse.
+ */
+int worker_pool_init(struct worker_pool* pool, size_t size);
+
+/**
+ * @brief Ejecuta un lote de trabajos y espera a que terminen todos.
+ *
+ * @param pool Pool inicializado.
+ * @param fn Trabajo a ejecutar para cada índice.
+ * @param ctx Contexto para `fn`.
+ * @param count Cantidad de trabajos.
+ */
+void worker_pool_run(struct worker_pool* pool, worker_fn fn, void* ctx, size_t count);
+
+/**
+ * @brief Detiene los hilos y libera las barreras.
+ *
+ * @param pool Pool inicializado.
+ */
+void worker_pool_destroy(struct worker_pool* pool);
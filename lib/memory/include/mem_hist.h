@@ -0,0 +1,95 @@
+/**
+ * @file mem_hist.h
+ * @brief Histogramas por hilo de la latencia, el tamaño pedido y la búsqueda del asignador.
+ *
+ * my_malloc() y my_free() registran cada llamada en histogramas del hilo que
+ * las hace, con cubetas en potencias de dos, sin locks ni operaciones atómicas
+ * de lectura-modificación-escritura. mem_hist_snapshot() suma los de todos los
+ * hilos, vivos y terminados, en el momento de leerlos.
+ */
+
+#pragma once
+
+#include "memory.h"
+#include <stdint.h>
+
+/**
+ * @brief Variable de entorno que desactiva los histogramas si vale "0".
+ */
+#define MEM_HIST_ENV "MEMORY_HISTOGRAMS"
+
+/**
+ * @brief Cubetas con límite; la cubeta i cuenta los valores hasta 2^i. Hay una más para el resto.
+ */
+#define MEM_HIST_BUCKETS 32
+
+/**
+ * @brief Políticas con histogramas propios, como en set_method().
+ */
+#define MEM_HIST_METHODS (SEGREGATED_FIT + 1)
+
+/**
+ * @brief Magnitud que registra cada histograma.
+ */
+enum mem_hist_kind
+{
+    MEM_HIST_MALLOC_NS,    /**< Nanosegundos de cada my_malloc(). */
+    MEM_HIST_FREE_NS,      /**< Nanosegundos de cada my_free(). */
+    MEM_HIST_REQUEST_SIZE, /**< Bytes pedidos a my_malloc(). */
+    MEM_HIST_SEARCH_LEN,   /**< Bloques que recorrió find_block(); no se registra si el bloque vino de la caché. */
+    MEM_HIST_KINDS         /**< Cantidad de magnitudes. */
+};
+
+/**
+ * @brief Histograma con cubetas en potencias de dos.
+ */
+struct mem_histogram
+{
+    uint64_t buckets[MEM_HIST_BUCKETS + 1]; /**< Cuentas por cubeta, no acumuladas; la última no tiene límite. */
+    uint64_t count;                         /**< Cantidad de valores registrados. */
+    uint64_t sum;                           /**< Suma de los valores registrados. */
+};
+
+/**
+ * @brief Indica si los histogramas están activos, según @ref MEM_HIST_ENV.
+ *
+ * @return Distinto de 0 si se registran las llamadas.
+ */
+int mem_hist_enabled();
+
+/**
+ * @brief Instante actual para medir una llamada.
+ *
+ * @return Nanosegundos de CLOCK_MONOTONIC, o 0 si los histogramas están desactivados.
+ */
+uint64_t mem_hist_now();
+
+/**
+ * @brief Registra un valor en el histograma del hilo que llama.
+ *
+ * @param kind Magnitud, ver @ref mem_hist_kind.
+ * @param method Política del heap; si está fuera de rango no se registra.
+ * @param value Valor a registrar.
+ */
+void mem_hist_record(enum mem_hist_kind kind, int method, uint64_t value);
+
+/**
+ * @brief Límite superior de una cubeta.
+ *
+ * @param bucket Cubeta, menor que @ref MEM_HIST_BUCKETS.
+ * @return 2^bucket.
+ */
+uint64_t mem_hist_bound(int bucket);
+
+/**
+ * @brief Suma los histogramas de todos los hilos para una magnitud y una política.
+ *
+ * Los valores que un hilo registra mientras se leen pueden quedar para la
+ * próxima lectura, pero ninguno se cuenta dos veces.
+ *
+ * @param kind Magnitud, ver @ref mem_hist_kind.
+ * @param method Política, como en set_method().
+ * @param out Histograma resultante.
+ * @return 0 si se leyó, -1 si la magnitud o la política son inválidas.
+ */
+int mem_hist_snapshot(enum mem_hist_kind kind, int method, struct mem_histogram* out);
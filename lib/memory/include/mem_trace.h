@@ -0,0 +1,151 @@
+/**
+ * @file mem_trace.h
+ * @brief Traza binaria y asíncrona de las llamadas al asignador.
+ *
+ * Cada my_malloc(), my_calloc(), my_realloc() y my_free() deja un registro de
+ * tamaño fijo en un buffer circular sin locks. Un hilo escritor en segundo
+ * plano lo vacía al archivo de traza, así que el asignador nunca espera a la
+ * E/S: si el buffer está lleno el registro se descarta y se cuenta.
+ *
+ * El archivo empieza con una @ref mem_trace_header seguida de registros
+ * @ref mem_trace_record en el orden en que se reservaron en el buffer.
+ */
+
+#pragma once
+
+#include "memory.h"
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * @brief Variable de entorno con la ruta del archivo de traza.
+ */
+#define MEM_TRACE_FILE_ENV "MEMORY_TRACE_FILE"
+
+/**
+ * @brief Archivo de traza por defecto.
+ */
+#define MEM_TRACE_DEFAULT_FILE "log.bin"
+
+/**
+ * @brief Registros del buffer circular; debe ser potencia de dos.
+ */
+#define MEM_TRACE_RING_SIZE 65536
+
+/**
+ * @brief Espera del escritor cuando el buffer está vacío, en milisegundos.
+ */
+#define MEM_TRACE_WRITER_SLEEP_MS 10
+
+/**
+ * @brief Identificador al comienzo del archivo de traza.
+ */
+#define MEM_TRACE_MAGIC "MTRC"
+
+/**
+ * @brief Versión del formato del archivo de traza.
+ */
+#define MEM_TRACE_VERSION 1
+
+/**
+ * @brief Cabecera del archivo de traza.
+ */
+struct mem_trace_header
+{
+    char magic[4];        /**< @ref MEM_TRACE_MAGIC, sin '\0'. */
+    uint32_t version;     /**< @ref MEM_TRACE_VERSION. */
+    uint32_t record_size; /**< sizeof(struct mem_trace_record) del proceso que escribió. */
+    uint32_t reserved;    /**< Siempre 0. */
+};
+
+/**
+ * @brief Registro de una llamada al asignador.
+ */
+struct mem_trace_record
+{
+    uint64_t ts_ns;    /**< Instante de la llamada en CLOCK_MONOTONIC. */
+    uint64_t ptr;      /**< Puntero devuelto o liberado. */
+    uint64_t old_ptr;  /**< Puntero original en un realloc; 0 en las demás. */
+    uint64_t size;     /**< Bytes pedidos; 0 en un free. */
+    uint32_t thread;   /**< Número de hilo, asignado en orden de primera llamada. */
+    uint8_t op;        /**< Operación, ver @ref alloc_type. */
+    uint8_t method;    /**< Política del heap del hilo, ver set_method(). */
+    uint16_t reserved; /**< Siempre 0. */
+};
+
+/**
+ * @brief Resultado de reproducir una traza sobre el asignador.
+ */
+struct mem_trace_replay_stats
+{
+    unsigned long long ops;    /**< Operaciones reproducidas. */
+    unsigned long long failed; /**< Asignaciones que devolvieron NULL o liberaciones de punteros desconocidos. */
+    double ns_per_op;          /**< Nanosegundos medios por operación. */
+    double frag;               /**< Fragmentación externa al terminar, antes de liberar lo que quedó vivo. */
+};
+
+/**
+ * @brief Agrega un registro al buffer circular sin bloquear.
+ *
+ * El primer registro del proceso abre el archivo y arranca el escritor.
+ *
+ * @param op Operación.
+ * @param ptr Puntero devuelto o liberado.
+ * @param old_ptr Puntero original de un realloc, o NULL.
+ * @param size Bytes pedidos.
+ */
+void mem_trace_log(alloc_type op, void* ptr, void* old_ptr, size_t size);
+
+/**
+ * @brief Suspende o reanuda el registro de las llamadas del hilo.
+ *
+ * @param mute Distinto de 0 para dejar de registrar.
+ * @return Estado anterior.
+ */
+int mem_trace_mute(int mute);
+
+/**
+ * @brief Cantidad de registros descartados porque el buffer estaba lleno.
+ *
+ * @return Registros perdidos desde el inicio.
+ */
+unsigned long long mem_trace_dropped();
+
+/**
+ * @brief Detiene el escritor, vuelca lo pendiente y cierra el archivo.
+ *
+ * Después de llamarla los registros nuevos se descartan.
+ */
+void mem_trace_close();
+
+/**
+ * @brief Recorre los registros de un archivo de traza.
+ *
+ * @param path Archivo de traza.
+ * @param fn Función a llamar con cada registro; si devuelve distinto de 0 se corta el recorrido.
+ * @param ctx Contexto para `fn`.
+ * @return 0 si se leyó completo, -1 si el archivo no existe o no es una traza válida.
+ */
+int mem_trace_read(const char* path, int (*fn)(const struct mem_trace_record* record, void* ctx), void* ctx);
+
+/**
+ * @brief Escribe una traza como texto, un registro por línea.
+ *
+ * @param path Archivo de traza.
+ * @param out Destino del texto.
+ * @return 0 si se convirtió completa, -1 en caso de error.
+ */
+int mem_trace_print(const char* path, FILE* out);
+
+/**
+ * @brief Reproduce una traza sobre un heap nuevo con la política indicada.
+ *
+ * Los punteros de la traza se traducen a los del heap nuevo, de modo que un
+ * free o realloc se aplica al bloque que devolvió la asignación original.
+ *
+ * @param path Archivo de traza.
+ * @param method Política del heap donde se reproduce.
+ * @param stats Resultado de la reproducción.
+ * @return 0 si se reprodujo, -1 en caso de error.
+ */
+int mem_trace_replay(const char* path, int method, struct mem_trace_replay_stats* stats);
@@ -8,6 +8,7 @@
 
 #pragma once
 
+#include <pthread.h>
 #include <stdio.h>
 #include <string.h>
 #include <sys/types.h>
@@ -20,8 +21,12 @@
  */
 #define align(x) (((((x) - 1) >> 3) << 3) + 8)
 
-/** Tamaño mínimo de un bloque de memoria. */
+/** Tamaño mínimo de un bloque de memoria: bytes de la cabecera antes de los datos. */
+#ifdef MEMORY_COMPACT_HEADER
+#define BLOCK_SIZE 24
+#else
 #define BLOCK_SIZE 40
+#endif
 /** Tamaño de página en memoria. */
 #define PAGESIZE 4096
 /** Política de asignación First Fit. */
@@ -30,6 +35,28 @@
 #define BEST_FIT 1
 /** Política de asignación Worst Fit. */
 #define WORST_FIT 2
+/** Política de asignación con listas libres segregadas por clase de tamaño. */
+#define SEGREGATED_FIT 3
+/** Cantidad de clases de tamaño: la clase k guarda bloques de [2^k, 2^(k+1)) bytes. */
+#define SEG_CLASSES 32
+/** Tamaño mínimo de datos para que un bloque libre guarde sus enlaces de lista. */
+#define SEG_MIN_PAYLOAD 16
+/** Sin arena: cada extend_heap() hace su propio mmap. */
+#define ARENA_OFF 0
+/** Arena: los bloques se recortan de chunks grandes mapeados de una vez. */
+#define ARENA_ON 1
+/** Arena con huge pages transparentes pedidas con madvise(). */
+#define ARENA_HUGEPAGES 2
+/** Tamaño y alineación de cada chunk de la arena; coincide con una huge page de x86-64. */
+#define ARENA_CHUNK_SIZE (2UL * 1024 * 1024)
+/** Mayor tamaño de datos que guarda la caché de cada hilo. */
+#define TCACHE_MAX_SIZE 256
+/** Clases de la caché de cada hilo: una por múltiplo de 8 hasta @ref TCACHE_MAX_SIZE. */
+#define TCACHE_CLASSES (TCACHE_MAX_SIZE / 8)
+/** Bloques que guarda la caché de cada hilo por clase. */
+#define TCACHE_DEPTH 16
+/** Tamaño desde el que my_realloc() agranda con mremap() un bloque que ocupa todo su mapeo. */
+#define MREMAP_THRESHOLD (128 * 1024)
 /** Tamaño del bloque */
 #define DATA_START 1
 /** Dirección inválida */
@@ -41,7 +68,22 @@
  *
  * Contiene la información necesaria para gestionar la asignación y
  * liberación de un bloque de memoria.
+ *
+ * Con MEMORY_COMPACT_HEADER definida la cabecera ocupa 24 bytes en lugar de
+ * 40: el indicador de libre va en el bit bajo de la palabra del tamaño, que
+ * siempre es múltiplo de 8, y no hay campo ptr. Un recorrido de la lista toca
+ * menos líneas de caché y un pedido de 8 bytes ocupa 32 en lugar de 48.
  */
+#ifdef MEMORY_COMPACT_HEADER
+struct s_block
+{
+    size_t free : 1;       /**< Indicador de si el bloque está libre (1) o ocupado (0). */
+    size_t size : 63;      /**< Tamaño del bloque de datos. */
+    struct s_block* next;  /**< Puntero al siguiente bloque en la lista enlazada. */
+    struct s_block* prev;  /**< Puntero al bloque anterior en la lista enlazada. */
+    char data[DATA_START]; /**< Área donde comienzan los datos del bloque. */
+};
+#else
 struct s_block
 {
     size_t size;           /**< Tamaño del bloque de datos. */
@@ -51,10 +93,101 @@ struct s_block
     void* ptr;             /**< Puntero a la dirección de los datos almacenados. */
     char data[DATA_START]; /**< Área donde comienzan los datos del bloque. */
 };
+#endif
 
 /** Tipo de puntero para un bloque de memoria. */
 typedef struct s_block* t_block;
 
+/**
+ * @struct s_free_links
+ * @brief Enlaces de la lista libre de una clase de tamaño.
+ *
+ * Solo existen en los bloques libres con al menos @ref SEG_MIN_PAYLOAD bytes
+ * de datos y se guardan al comienzo de su área de datos, por lo que no agrandan
+ * la cabecera de los bloques ocupados. Se mantienen con cualquier política, de
+ * modo que se puede cambiar de método sin reconstruirlas.
+ */
+struct s_free_links
+{
+    t_block next_free; /**< Siguiente bloque libre de la misma clase. */
+    t_block prev_free; /**< Bloque libre anterior de la misma clase. */
+};
+
+/**
+ * @struct s_chunk
+ * @brief Cabecera de un chunk de la arena.
+ *
+ * Los chunks están alineados a @ref ARENA_CHUNK_SIZE, por lo que el chunk de
+ * cualquier bloque se obtiene enmascarando su dirección. El primer bloque
+ * empieza justo después de esta cabecera y los bloques de un mismo chunk son
+ * consecutivos en la lista de bloques.
+ */
+struct s_chunk
+{
+    size_t size;           /**< Bytes mapeados, múltiplo de @ref ARENA_CHUNK_SIZE. */
+    size_t used;           /**< Bloques ocupados; con 0 el chunk se devuelve al sistema. */
+    struct mem_heap* heap; /**< Heap dueño, para liberar desde cualquier hilo. */
+};
+
+/**
+ * @struct mem_stats
+ * @brief Contadores de bloques de un heap, mantenidos en cada operación.
+ *
+ * Se actualizan al insertar o quitar bloques libres de sus listas y al ocupar
+ * o devolver bloques, de modo que external_frag() y memory_usage() no recorren
+ * la lista de bloques. Las clases son las de las listas segregadas:
+ * floor(log2(size)). Los bloques de la caché de un hilo cuentan como ocupados.
+ */
+struct mem_stats
+{
+    size_t free_bytes;                    /**< Bytes de datos en bloques libres. */
+    size_t used_bytes;                    /**< Bytes de datos en bloques ocupados. */
+    size_t free_blocks;                   /**< Bloques libres. */
+    size_t used_blocks;                   /**< Bloques ocupados. */
+    size_t free_class_bytes[SEG_CLASSES]; /**< Bytes libres de cada clase. */
+    size_t free_class_count[SEG_CLASSES]; /**< Bloques libres de cada clase. */
+    size_t used_class_count[SEG_CLASSES]; /**< Bloques ocupados de cada clase. */
+};
+
+/**
+ * @struct mem_usage
+ * @brief Resumen del uso de un heap, ver memory_stats().
+ */
+struct mem_usage
+{
+    size_t free_bytes;      /**< Bytes de datos en bloques libres. */
+    size_t used_bytes;      /**< Bytes de datos en bloques ocupados. */
+    size_t free_blocks;     /**< Bloques libres. */
+    size_t used_blocks;     /**< Bloques ocupados. */
+    int largest_free_class; /**< Clase del bloque libre más grande, o -1 si no hay. */
+    int largest_used_class; /**< Clase del bloque ocupado más grande, o -1 si no hay. */
+};
+
+/**
+ * @struct mem_heap
+ * @brief Estado de un heap independiente.
+ *
+ * Cada heap tiene su propia lista de bloques, política, listas segregadas y
+ * lock, por lo que varios hilos pueden usar heaps distintos sin contención. Un
+ * hilo opera sobre el heap que eligió con mem_heap_use(); al comenzar es el heap
+ * por defecto, que conserva el comportamiento de un único heap global.
+ *
+ * Las funciones de bloques (find_block(), split_block(), fusion(),
+ * extend_heap(), valid_addr()) operan sobre el heap del hilo y suponen que su
+ * lock está tomado; las de asignación lo toman ellas mismas.
+ */
+struct mem_heap
+{
+    t_block base;                   /**< Primer bloque de la lista. */
+    t_block tail;                   /**< Último bloque de la lista, para extender el heap sin recorrerla. */
+    int method;                     /**< Política de find_block(), ver set_method(). */
+    int arena_mode;                 /**< Origen de la memoria, ver set_arena_mode(). */
+    int thread_cache;               /**< Distinto de 0 si los hilos cachean bloques chicos de este heap. */
+    t_block seg_heads[SEG_CLASSES]; /**< Primer bloque libre de cada clase de tamaño. */
+    struct mem_stats stats;         /**< Contadores de bloques libres y ocupados. */
+    pthread_mutex_t lock;           /**< Protege todo el estado del heap. */
+};
+
 /**
  * @enum alloc_type
  * @brief Enumeración que define los tipos de operaciones de memoria.
@@ -81,6 +214,10 @@ t_block get_block(void* p);
 /**
  * @brief Verifica si una dirección de memoria es válida.
  *
+ * En modo arena, el de todo heap que no elija @ref ARENA_OFF, es O(1): el chunk
+ * del bloque se busca en un índice hash. Sin arena se recorre la lista de
+ * bloques.
+ *
  * @param p Dirección de memoria a verificar.
  * @return int Retorna 1 si la dirección es válida, 0 en caso contrario.
  */
@@ -139,6 +276,9 @@ void* my_malloc(size_t size);
 /**
  * @brief Libera un bloque de memoria previamente asignado.
  *
+ * El bloque se fusiona con sus vecinos físicos libres en ambos sentidos; el
+ * anterior se obtiene de la lista doblemente enlazada, sin recorrerla.
+ *
  * @param p Puntero al área de datos a liberar.
  */
 void my_free(void* p);
@@ -164,14 +304,20 @@ void* my_realloc(void* p, size_t size);
 /**
  * @brief Verifica el estado del heap y detecta bloques libres consecutivos.
  *
+ * Siempre imprime la cabecera del bloque de `data`. En compilaciones de
+ * depuración (sin NDEBUG) además recorre todo el heap y comprueba los enlaces,
+ * que no queden vecinos libres sin fusionar, las listas segregadas y la
+ * cuenta de bloques ocupados y el registro en el índice de cada chunk.
+ *
  * @param data Información adicional para la verificación.
  */
 void check_heap(void* data);
 
 /**
- * @brief Configura el modo de asignación de memoria (First Fit o Best Fit).
+ * @brief Configura el modo de asignación de memoria.
  *
- * @param mode Modo de asignación (0 para First Fit, 1 para Best Fit).
+ * @param mode Modo de asignación (0 First Fit, 1 Best Fit, 2 Worst Fit, 3
+ * listas segregadas).
  */
 void malloc_control(int mode);
 
@@ -182,23 +328,92 @@ void malloc_control(int mode);
  * que se utilizará al buscar bloques libres. Los métodos disponibles son:
  * - 0: Primer ajuste (First Fit)
  * - 1: Mejor ajuste (Best Fit)
+ * - 2: Peor ajuste (Worst Fit)
+ * - 3: Listas libres segregadas por potencias de dos (Segregated Fit)
  *
  * @param m Un entero que representa el método de asignación deseado.
- *          Debe ser 0 o 1. Cualquier otro valor es inválido.
+ *          Debe estar entre 0 y 3. Cualquier otro valor es inválido.
  */
 void set_method(int m);
 
+/**
+ * @brief Obtiene el método de asignación del heap del hilo.
+ *
+ * @return Método actual, como en set_method().
+ */
+int get_method();
+
+/**
+ * @brief Elige de dónde saca memoria extend_heap().
+ *
+ * Con @ref ARENA_ON los bloques se recortan de chunks de @ref ARENA_CHUNK_SIZE
+ * bytes (o el múltiplo necesario para pedidos grandes) y un chunk se devuelve
+ * con munmap() en cuanto todos sus bloques quedan libres. @ref ARENA_HUGEPAGES
+ * además pide huge pages transparentes para cada chunk. Con @ref ARENA_OFF cada
+ * extensión es un mmap() propio, como antes, y valid_addr() recorre la lista.
+ * Todos los heaps, incluido el por defecto, empiezan con @ref ARENA_ON.
+ *
+ * @param mode @ref ARENA_OFF, @ref ARENA_ON o @ref ARENA_HUGEPAGES.
+ * @return 0 si se aplicó, -1 si el modo es inválido o todavía hay bloques en el heap.
+ */
+int set_arena_mode(int mode);
+
+/**
+ * @brief Obtiene el modo de arena actual.
+ *
+ * @return @ref ARENA_OFF, @ref ARENA_ON o @ref ARENA_HUGEPAGES.
+ */
+int get_arena_mode();
+
+/**
+ * @brief Crea un heap independiente para uso concurrente.
+ *
+ * El heap usa la arena, de modo que un bloque se puede liberar desde cualquier
+ * hilo y se devuelve a su dueño, y activa la caché por hilo: hasta
+ * @ref TCACHE_DEPTH bloques liberados de cada tamaño hasta @ref TCACHE_MAX_SIZE
+ * quedan en el hilo que los liberó y se reutilizan sin tomar el lock. Mientras
+ * están en la caché cuentan como ocupados. Con MEMORY_COMPACT_HEADER guardar un
+ * bloque en la caché toma el lock un instante para validarlo.
+ *
+ * @param method Política de asignación del heap, como en set_method().
+ * @return Heap nuevo, o NULL si no se pudo crear.
+ */
+struct mem_heap* mem_heap_create(int method);
+
+/**
+ * @brief Destruye un heap y devuelve toda su memoria al sistema.
+ *
+ * Ningún otro hilo debe seguir usándolo ni tener bloques suyos en su caché.
+ *
+ * @param h Heap creado con mem_heap_create().
+ */
+void mem_heap_destroy(struct mem_heap* h);
+
+/**
+ * @brief Elige el heap sobre el que opera el hilo que llama.
+ *
+ * Antes de cambiar de heap se vacía la caché del hilo.
+ *
+ * @param h Heap a usar, o NULL para el heap por defecto.
+ * @return Heap que usaba el hilo hasta ahora.
+ */
+struct mem_heap* mem_heap_use(struct mem_heap* h);
+
+/**
+ * @brief Devuelve al heap los bloques de la caché del hilo que llama.
+ */
+void mem_cache_flush();
+
 /**
  * @brief Reporta el uso de memoria actual.
  *
- * Esta función recorre todos los bloques de memoria gestionados por el
- * administrador de memoria personalizado y calcula el tamaño total de
- * memoria asignada y la cantidad de memoria libre. Luego, imprime un
- * informe detallado del uso de memoria.
+ * Esta función lee los contadores del heap del hilo, sin recorrer sus
+ * bloques, e imprime un informe del uso de memoria.
  *
  * El informe incluye:
  * - Total de memoria asignada en bytes.
  * - Total de memoria libre en bytes.
+ * - Cantidad de bloques ocupados y libres.
  *
  * Esta función es útil para monitorear la eficiencia del uso de memoria
  * y detectar posibles problemas de fragmentación o fugas de memoria.
@@ -208,45 +423,31 @@ void memory_usage();
 /**
  * @brief Finaliza y cierra los registros de depuración.
  *
- * Esta función limpia cualquier recurso relacionado con los registros
- * de depuración y finaliza su uso. Debe llamarse al terminar la ejecución
- * del programa.
+ * Detiene el escritor de la traza y vuelca los registros pendientes, ver
+ * mem_trace_close(). También se hace al terminar el proceso.
  */
 void log_close();
 
 /**
  * @brief Maneja el registro de una operación de memoria.
  *
- * Esta función registra información sobre una operación de asignación
- * o liberación de memoria, incluyendo el nombre de la función, tipo
- * de operación, puntero involucrado y tamaño del bloque.
+ * Agrega un registro binario a la traza del asignador sin bloquear ni hacer
+ * E/S; el nombre de la función ya no se guarda porque lo identifica el tipo
+ * de operación. Ver mem_trace.h.
  *
- * @param func_name Nombre de la función que realizó la operación.
+ * @param func_name Nombre de la función que realizó la operación; se ignora.
  * @param type Tipo de operación de memoria (malloc, calloc, realloc, free).
  * @param ptr Puntero a la memoria afectada.
  * @param size Tamaño de la memoria involucrada, en bytes.
  */
 void log_handler(const char* func_name, alloc_type type, void* ptr, size_t size);
 
-/**
- * @brief Registra la llamada a una función de gestión de memoria.
- *
- * Esta función almacena información sobre las funciones de gestión
- * de memoria que han sido llamadas, incluyendo el tipo de asignación,
- * el puntero de memoria y el tamaño solicitado o liberado.
- *
- * @param func_name Nombre de la función llamada.
- * @param type Tipo de asignación realizada.
- * @param ptr Puntero a la memoria afectada.
- * @param size Tamaño de la memoria afectada.
- */
-void log_function_call(const char* func_name, alloc_type type, void* ptr, size_t size);
-
 /**
  * @brief Reduce el tamaño del heap para recuperar memoria al sistema operativo.
  *
- * Esta función intenta reducir el tamaño del heap si existen bloques libres
- * al final de la memoria asignada, devolviendo esa memoria al sistema operativo.
+ * Esta función libera todos los bloques ocupados. En modo arena cada chunk se
+ * devuelve al sistema operativo al quedar libre; sin arena solo se devuelven
+ * los mapeos completos que quedan al final de la lista.
  */
 void mem_trim();
 
@@ -275,8 +476,17 @@ void custom_free(void* ptr);
  * @brief Calcula la fragmentación externa de la memoria.
  *
  * Esta función evalúa la cantidad de memoria que está libre pero no
- * disponible para nuevas asignaciones debido a la fragmentación.
+ * disponible para nuevas asignaciones debido a la fragmentación: los bytes
+ * libres en clases de tamaño menores a la del bloque ocupado más grande,
+ * sobre el total. Se calcula con los contadores del heap, sin recorrerlo.
  *
- * @return double Porcentaje de fragmentación externa.
+ * @return double Porcentaje de fragmentación externa; 0 si el heap está vacío.
  */
 double external_frag();
+
+/**
+ * @brief Lee los contadores del heap del hilo sin recorrer sus bloques.
+ *
+ * @param usage Resumen a completar.
+ */
+void memory_stats(struct mem_usage* usage);
@@ -0,0 +1,219 @@
+/**
+ * @file mem_hist.c
+ * @brief Implementación de los histogramas por hilo del asignador.
+ *
+ * Cada hilo escribe solo en sus propios histogramas, así que le basta con
+ * cargas y almacenamientos relajados. Los hilos se enlazan en una lista que se
+ * recorre al leer; al terminar un hilo sus cuentas se suman a un acumulado y
+ * su estructura queda para el próximo hilo que la necesite.
+ */
+
+#include <mem_hist.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+
+/**
+ * @brief Histograma que escribe un solo hilo y se lee desde cualquiera.
+ */
+struct hist_cells
+{
+    atomic_uint_least64_t buckets[MEM_HIST_BUCKETS + 1]; /**< Cuentas por cubeta. */
+    atomic_uint_least64_t sum;                           /**< Suma de los valores. */
+};
+
+/**
+ * @brief Histogramas de un hilo, mapeados con mmap para no depender de ningún asignador.
+ */
+struct hist_thread
+{
+    struct hist_cells cells[MEM_HIST_KINDS][MEM_HIST_METHODS]; /**< Un histograma por magnitud y política. */
+    struct hist_thread* next;                                  /**< Siguiente en su lista. */
+};
+
+/**
+ * @brief Histogramas del hilo, o NULL si todavía no registró nada.
+ */
+static _Thread_local struct hist_thread* local;
+
+/**
+ * @brief Hilos con histogramas.
+ */
+static struct hist_thread* live;
+
+/**
+ * @brief Estructuras de hilos terminados, en cero, para reutilizar.
+ */
+static struct hist_thread* spare;
+
+/**
+ * @brief Cuentas de los hilos que terminaron.
+ */
+static struct mem_histogram retired[MEM_HIST_KINDS][MEM_HIST_METHODS];
+
+/**
+ * @brief Protege `live`, `spare` y `retired`; los hilos nunca lo toman al registrar.
+ */
+static pthread_mutex_t hist_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @brief Clave cuyo destructor retira los histogramas de un hilo que termina.
+ */
+static pthread_key_t hist_key;
+
+/**
+ * @brief Lee @ref MEM_HIST_ENV y crea @ref hist_key una sola vez.
+ */
+static pthread_once_t hist_once = PTHREAD_ONCE_INIT;
+
+/**
+ * @brief Distinto de 0 si los histogramas están activos.
+ */
+static int enabled;
+
+/**
+ * @brief Suma los histogramas de un hilo que termina al acumulado y guarda su estructura.
+ */
+static void hist_retire(void* arg)
+{
+    struct hist_thread* t = arg;
+
+    pthread_mutex_lock(&hist_lock);
+    for (struct hist_thread** p = &live; *p; p = &(*p)->next)
+    {
+        if (*p == t)
+        {
+            *p = t->next;
+            break;
+        }
+    }
+    for (int k = 0; k < MEM_HIST_KINDS; k++)
+    {
+        for (int m = 0; m < MEM_HIST_METHODS; m++)
+        {
+            struct hist_cells* c = &t->cells[k][m];
+            for (int i = 0; i <= MEM_HIST_BUCKETS; i++)
+                retired[k][m].buckets[i] += atomic_load_explicit(&c->buckets[i], memory_order_relaxed);
+            retired[k][m].sum += atomic_load_explicit(&c->sum, memory_order_relaxed);
+        }
+    }
+    memset(t->cells, 0, sizeof(t->cells));
+    t->next = spare;
+    spare = t;
+    pthread_mutex_unlock(&hist_lock);
+    local = NULL;
+}
+
+/**
+ * @brief Configuración de los histogramas, una vez por proceso.
+ */
+static void hist_init()
+{
+    const char* env = getenv(MEM_HIST_ENV);
+    enabled = env == NULL || strcmp(env, "0") != 0;
+    pthread_key_create(&hist_key, hist_retire);
+}
+
+/**
+ * @brief Obtiene los histogramas del hilo, creándolos si es la primera vez.
+ * @return Histogramas del hilo, o NULL si no se pudieron mapear.
+ */
+static struct hist_thread* hist_local()
+{
+    if (local)
+        return local;
+
+    pthread_mutex_lock(&hist_lock);
+    struct hist_thread* t = spare;
+    if (t)
+        spare = t->next;
+    pthread_mutex_unlock(&hist_lock);
+
+    if (!t)
+    {
+        t = mmap(NULL, sizeof(*t), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (t == MAP_FAILED)
+            return NULL;
+    }
+    pthread_setspecific(hist_key, t);
+
+    pthread_mutex_lock(&hist_lock);
+    t->next = live;
+    live = t;
+    pthread_mutex_unlock(&hist_lock);
+    local = t;
+    return t;
+}
+
+/**
+ * @brief Cubeta de un valor: la menor i con valor <= 2^i.
+ */
+static int hist_bucket(uint64_t value)
+{
+    if (value <= 1)
+        return 0;
+    int b = 64 - __builtin_clzll(value - 1);
+    return b < MEM_HIST_BUCKETS ? b : MEM_HIST_BUCKETS;
+}
+
+int mem_hist_enabled()
+{
+    pthread_once(&hist_once, hist_init);
+    return enabled;
+}
+
+uint64_t mem_hist_now()
+{
+    if (!mem_hist_enabled())
+        return 0;
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+void mem_hist_record(enum mem_hist_kind kind, int method, uint64_t value)
+{
+    if (kind < 0 || kind >= MEM_HIST_KINDS || method < 0 || method >= MEM_HIST_METHODS || !mem_hist_enabled())
+        return;
+    struct hist_thread* t = hist_local();
+    if (!t)
+        return;
+
+    // Solo este hilo escribe sus celdas: alcanza con cargar y guardar, sin un add atómico
+    struct hist_cells* c = &t->cells[kind][method];
+    atomic_uint_least64_t* bucket = &c->buckets[hist_bucket(value)];
+    atomic_store_explicit(bucket, atomic_load_explicit(bucket, memory_order_relaxed) + 1, memory_order_relaxed);
+    atomic_store_explicit(&c->sum, atomic_load_explicit(&c->sum, memory_order_relaxed) + value,
+                          memory_order_relaxed);
+}
+
+uint64_t mem_hist_bound(int bucket)
+{
+    return 1ULL << bucket;
+}
+
+int mem_hist_snapshot(enum mem_hist_kind kind, int method, struct mem_histogram* out)
+{
+    if (kind < 0 || kind >= MEM_HIST_KINDS || method < 0 || method >= MEM_HIST_METHODS)
+        return -1;
+
+    pthread_mutex_lock(&hist_lock);
+    *out = retired[kind][method];
+    for (struct hist_thread* t = live; t; t = t->next)
+    {
+        struct hist_cells* c = &t->cells[kind][method];
+        for (int i = 0; i <= MEM_HIST_BUCKETS; i++)
+            out->buckets[i] += atomic_load_explicit(&c->buckets[i], memory_order_relaxed);
+        out->sum += atomic_load_explicit(&c->sum, memory_order_relaxed);
+    }
+    pthread_mutex_unlock(&hist_lock);
+
+    // La cuenta sale de las cubetas para que coincida con la cubeta +Inf aunque un hilo esté escribiendo
+    out->count = 0;
+    for (int i = 0; i <= MEM_HIST_BUCKETS; i++)
+        out->count += out->buckets[i];
+    return 0;
+}
@@ -0,0 +1,547 @@
+/**
+ * @file mem_trace.c
+ * @brief Implementación de la traza binaria del asignador.
+ *
+ * El buffer circular es una cola acotada de múltiples productores y un solo
+ * consumidor: cada celda tiene un número de secuencia que indica si está libre
+ * para la vuelta actual del productor o lista para el escritor. Los productores
+ * reservan celdas con un CAS sobre la cabeza y nunca esperan.
+ */
+
+#include <mem_trace.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+
+/**
+ * @brief Registros que el escritor copia en cada fwrite().
+ */
+#define MEM_TRACE_BATCH 1024
+
+/**
+ * @brief Capacidad inicial de la tabla de punteros de la reproducción; se duplica al llenarse a la mitad.
+ */
+#define REPLAY_MAP_INITIAL 1024
+
+/**
+ * @brief Celda del buffer circular.
+ */
+struct trace_slot
+{
+    atomic_size_t seq;              /**< Igual a la posición si está libre, posición + 1 si tiene un registro. */
+    struct mem_trace_record record; /**< Registro publicado. */
+};
+
+/**
+ * @brief Estado de la traza.
+ */
+enum trace_state
+{
+    TRACE_IDLE,    /**< Todavía no se registró nada. */
+    TRACE_RUNNING, /**< El escritor está vaciando el buffer. */
+    TRACE_CLOSED   /**< Cerrada, deshabilitada o sin archivo; se descarta todo. */
+};
+
+/**
+ * @brief Buffer circular, mapeado con mmap para no depender de ningún asignador.
+ */
+static struct trace_slot* ring;
+
+/**
+ * @brief Próxima posición a reservar por los productores.
+ */
+static atomic_size_t ring_head;
+
+/**
+ * @brief Próxima posición a leer por el escritor; solo la toca el escritor o quien cierra.
+ */
+static size_t ring_tail;
+
+/**
+ * @brief Registros descartados porque el buffer estaba lleno.
+ */
+static atomic_ullong dropped;
+
+/**
+ * @brief Valor de @ref trace_state.
+ */
+static atomic_int state = TRACE_IDLE;
+
+/**
+ * @brief Archivo de traza abierto.
+ */
+static FILE* trace_file;
+
+/**
+ * @brief Hilo escritor.
+ */
+static pthread_t writer;
+
+/**
+ * @brief Abre la traza una sola vez.
+ */
+static pthread_once_t trace_once = PTHREAD_ONCE_INIT;
+
+/**
+ * @brief Serializa mem_trace_close() con el vaciado final.
+ */
+static pthread_mutex_t close_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @brief Próximo número de hilo a asignar.
+ */
+static atomic_uint next_thread = 1;
+
+/**
+ * @brief Número de hilo en los registros; 0 hasta su primera llamada.
+ */
+static _Thread_local uint32_t thread_id;
+
+/**
+ * @brief Distinto de 0 si el hilo no registra sus llamadas, ver mem_trace_mute().
+ */
+static _Thread_local int muted;
+
+/**
+ * @brief Instante actual en CLOCK_MONOTONIC en nanosegundos.
+ */
+static uint64_t now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Copia al archivo los registros publicados; devuelve cuántos escribió.
+ */
+static size_t drain()
+{
+    static struct mem_trace_record batch[MEM_TRACE_BATCH];
+    size_t total = 0;
+    size_t n;
+
+    do
+    {
+        n = 0;
+        while (n < MEM_TRACE_BATCH)
+        {
+            struct trace_slot* slot = &ring[ring_tail & (MEM_TRACE_RING_SIZE - 1)];
+            if (atomic_load_explicit(&slot->seq, memory_order_acquire) != ring_tail + 1)
+                break;
+            batch[n++] = slot->record;
+            // La celda queda libre para la siguiente vuelta de los productores
+            atomic_store_explicit(&slot->seq, ring_tail + MEM_TRACE_RING_SIZE, memory_order_release);
+            ring_tail++;
+        }
+        if (n > 0 && fwrite(batch, sizeof(batch[0]), n, trace_file) != n)
+            printf("Error: no se pudo escribir la traza de memoria\n");
+        total += n;
+    } while (n == MEM_TRACE_BATCH);
+    return total;
+}
+
+/**
+ * @brief Bucle del hilo escritor.
+ */
+static void* writer_main(void* arg)
+{
+    (void)arg;
+    struct timespec pause = {0, MEM_TRACE_WRITER_SLEEP_MS * 1000000L};
+
+    while (atomic_load_explicit(&state, memory_order_acquire) == TRACE_RUNNING)
+    {
+        if (drain() == 0)
+        {
+            fflush(trace_file);
+            nanosleep(&pause, NULL);
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Mapea el buffer, abre el archivo y arranca el escritor.
+ *
+ * Si @ref MEM_TRACE_FILE_ENV está definida pero vacía la traza queda deshabilitada.
+ */
+static void trace_open()
+{
+    // mem_trace_close() antes del primer registro deja la traza cerrada
+    if (atomic_load(&state) != TRACE_IDLE)
+        return;
+
+    const char* path = getenv(MEM_TRACE_FILE_ENV);
+    if (path == NULL)
+        path = MEM_TRACE_DEFAULT_FILE;
+    if (path[0] == '\0')
+    {
+        atomic_store(&state, TRACE_CLOSED);
+        return;
+    }
+
+    ring = mmap(0, sizeof(struct trace_slot) * MEM_TRACE_RING_SIZE, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ring == MAP_FAILED)
+    {
+        ring = NULL;
+        printf("Error: no se pudo mapear el buffer de la traza de memoria\n");
+        atomic_store(&state, TRACE_CLOSED);
+        return;
+    }
+    for (size_t i = 0; i < MEM_TRACE_RING_SIZE; i++)
+        atomic_init(&ring[i].seq, i);
+
+    trace_file = fopen(path, "wb");
+    if (trace_file == NULL)
+    {
+        perror("Error al abrir el archivo de traza");
+        atomic_store(&state, TRACE_CLOSED);
+        return;
+    }
+    struct mem_trace_header header = {{0}, MEM_TRACE_VERSION, sizeof(struct mem_trace_record), 0};
+    memcpy(header.magic, MEM_TRACE_MAGIC, sizeof(header.magic));
+    fwrite(&header, sizeof(header), 1, trace_file);
+
+    atomic_store(&state, TRACE_RUNNING);
+    if (pthread_create(&writer, NULL, writer_main, NULL) != 0)
+    {
+        printf("Error: no se pudo crear el escritor de la traza de memoria\n");
+        atomic_store(&state, TRACE_CLOSED);
+        fclose(trace_file);
+        trace_file = NULL;
+        return;
+    }
+    // Lo que quede en el buffer al terminar el proceso también se escribe
+    atexit(mem_trace_close);
+}
+
+void mem_trace_log(alloc_type op, void* ptr, void* old_ptr, size_t size)
+{
+    if (muted)
+        return;
+    pthread_once(&trace_once, trace_open);
+    if (atomic_load_explicit(&state, memory_order_relaxed) != TRACE_RUNNING)
+    {
+        atomic_fetch_add_explicit(&dropped, 1, memory_order_relaxed);
+        return;
+    }
+    if (thread_id == 0)
+        thread_id = atomic_fetch_add_explicit(&next_thread, 1, memory_order_relaxed);
+
+    size_t pos = atomic_load_explicit(&ring_head, memory_order_relaxed);
+    struct trace_slot* slot;
+    while (1)
+    {
+        slot = &ring[pos & (MEM_TRACE_RING_SIZE - 1)];
+        size_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+        if (dif == 0)
+        {
+            if (atomic_compare_exchange_weak_explicit(&ring_head, &pos, pos + 1, memory_order_relaxed,
+                                                      memory_order_relaxed))
+                break;
+        }
+        else if (dif < 0)
+        {
+            // La celda todavía tiene un registro de la vuelta anterior: el buffer está lleno
+            atomic_fetch_add_explicit(&dropped, 1, memory_order_relaxed);
+            return;
+        }
+        else
+        {
+            pos = atomic_load_explicit(&ring_head, memory_order_relaxed);
+        }
+    }
+
+    slot->record.ts_ns = now_ns();
+    slot->record.ptr = (uint64_t)(uintptr_t)ptr;
+    slot->record.old_ptr = (uint64_t)(uintptr_t)old_ptr;
+    slot->record.size = size;
+    slot->record.thread = thread_id;
+    slot->record.op = (uint8_t)op;
+    slot->record.method = (uint8_t)get_method();
+    slot->record.reserved = 0;
+    atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+}
+
+int mem_trace_mute(int mute)
+{
+    int prev = muted;
+    muted = mute;
+    return prev;
+}
+
+unsigned long long mem_trace_dropped()
+{
+    return atomic_load_explicit(&dropped, memory_order_relaxed);
+}
+
+void mem_trace_close()
+{
+    pthread_mutex_lock(&close_lock);
+    int expected = TRACE_RUNNING;
+    if (atomic_compare_exchange_strong(&state, &expected, TRACE_CLOSED))
+    {
+        pthread_join(writer, NULL);
+        // Un productor que reservó su celda antes del cierre pudo no haberla publicado; se pierde
+        drain();
+        fclose(trace_file);
+        trace_file = NULL;
+    }
+    else if (expected == TRACE_IDLE)
+    {
+        // Nunca se abrió: que tampoco se abra después
+        atomic_store(&state, TRACE_CLOSED);
+    }
+    pthread_mutex_unlock(&close_lock);
+}
+
+int mem_trace_read(const char* path, int (*fn)(const struct mem_trace_record* record, void* ctx), void* ctx)
+{
+    FILE* f = fopen(path, "rb");
+    if (f == NULL)
+    {
+        perror("Error al abrir el archivo de traza");
+        return -1;
+    }
+
+    struct mem_trace_header header;
+    if (fread(&header, sizeof(header), 1, f) != 1 || memcmp(header.magic, MEM_TRACE_MAGIC, 4) != 0 ||
+        header.version != MEM_TRACE_VERSION || header.record_size != sizeof(struct mem_trace_record))
+    {
+        printf("Error: %s no es una traza de memoria válida\n", path);
+        fclose(f);
+        return -1;
+    }
+
+    struct mem_trace_record batch[MEM_TRACE_BATCH];
+    size_t n;
+    int stop = 0;
+    while (!stop && (n = fread(batch, sizeof(batch[0]), MEM_TRACE_BATCH, f)) > 0)
+    {
+        for (size_t i = 0; i < n && !stop; i++)
+            stop = fn(&batch[i], ctx);
+    }
+    fclose(f);
+    return 0;
+}
+
+/**
+ * @brief Escribe un registro como una línea de texto.
+ */
+static int print_record(const struct mem_trace_record* r, void* ctx)
+{
+    static const char* const ops[] = {"malloc", "calloc", "realloc", "free"};
+    const char* op = r->op <= ALLOC_TYPE_FREE ? ops[r->op] : "?";
+
+    fprintf((FILE*)ctx, "%llu.%09llu thread=%u method=%u %s ptr=0x%llx old=0x%llx size=%llu\n",
+            (unsigned long long)(r->ts_ns / 1000000000ULL), (unsigned long long)(r->ts_ns % 1000000000ULL), r->thread,
+            r->method, op, (unsigned long long)r->ptr, (unsigned long long)r->old_ptr, (unsigned long long)r->size);
+    return 0;
+}
+
+int mem_trace_print(const char* path, FILE* out)
+{
+    return mem_trace_read(path, print_record, out);
+}
+
+/**
+ * @brief Tabla hash de punteros de la traza a punteros del heap de la reproducción.
+ */
+struct replay_map
+{
+    uint64_t* keys; /**< Punteros de la traza; 0 es una celda vacía. */
+    void** values;  /**< Punteros del heap de la reproducción. */
+    size_t cap;     /**< Celdas, siempre potencia de dos. */
+    size_t count;   /**< Entradas ocupadas. */
+};
+
+/**
+ * @brief Estado de una reproducción.
+ */
+struct replay_ctx
+{
+    struct replay_map map;                /**< Bloques vivos. */
+    struct mem_trace_replay_stats* stats; /**< Resultado acumulado. */
+    uint64_t elapsed_ns;                  /**< Tiempo dentro del asignador. */
+    int error;                            /**< Distinto de 0 si no se pudo agrandar la tabla. */
+};
+
+/**
+ * @brief Celda inicial de un puntero en la tabla.
+ */
+static size_t map_slot(const struct replay_map* m, uint64_t key)
+{
+    return (size_t)((key * 0x9E3779B97F4A7C15ULL) >> 32) & (m->cap - 1);
+}
+
+/**
+ * @brief Busca la celda de un puntero; si no está, la celda vacía donde iría.
+ */
+static size_t map_find(const struct replay_map* m, uint64_t key)
+{
+    size_t i = map_slot(m, key);
+    while (m->keys[i] && m->keys[i] != key)
+        i = (i + 1) & (m->cap - 1);
+    return i;
+}
+
+/**
+ * @brief Registra o reemplaza un puntero, agrandando la tabla si hace falta.
+ * @return 0 si se registró, -1 si no hubo memoria.
+ */
+static int map_put(struct replay_map* m, uint64_t key, void* value)
+{
+    if ((m->count + 1) * 2 > m->cap)
+    {
+        struct replay_map grown = {NULL, NULL, m->cap ? m->cap * 2 : REPLAY_MAP_INITIAL, 0};
+        grown.keys = calloc(grown.cap, sizeof(uint64_t));
+        grown.values = calloc(grown.cap, sizeof(void*));
+        if (grown.keys == NULL || grown.values == NULL)
+        {
+            free(grown.keys);
+            free(grown.values);
+            return -1;
+        }
+        for (size_t i = 0; i < m->cap; i++)
+        {
+            if (m->keys[i])
+            {
+                size_t j = map_find(&grown, m->keys[i]);
+                grown.keys[j] = m->keys[i];
+                grown.values[j] = m->values[i];
+                grown.count++;
+            }
+        }
+        free(m->keys);
+        free(m->values);
+        *m = grown;
+    }
+    size_t i = map_find(m, key);
+    if (!m->keys[i])
+        m->count++;
+    m->keys[i] = key;
+    m->values[i] = value;
+    return 0;
+}
+
+/**
+ * @brief Quita un puntero de la tabla y devuelve su valor, o NULL si no estaba.
+ */
+static void* map_take(struct replay_map* m, uint64_t key)
+{
+    if (m->cap == 0)
+        return NULL;
+    size_t mask = m->cap - 1;
+    size_t i = map_find(m, key);
+    if (!m->keys[i])
+        return NULL;
+    void* value = m->values[i];
+
+    // Sin lápidas, igual que el índice de chunks del asignador
+    for (size_t j = (i + 1) & mask; m->keys[j]; j = (j + 1) & mask)
+    {
+        size_t home = map_slot(m, m->keys[j]);
+        if (((j - home) & mask) >= ((j - i) & mask))
+        {
+            m->keys[i] = m->keys[j];
+            m->values[i] = m->values[j];
+            i = j;
+        }
+    }
+    m->keys[i] = 0;
+    m->values[i] = NULL;
+    m->count--;
+    return value;
+}
+
+/**
+ * @brief Aplica un registro al heap de la reproducción.
+ */
+static int replay_record(const struct mem_trace_record* r, void* arg)
+{
+    struct replay_ctx* ctx = arg;
+    void* old = NULL;
+    void* p = NULL;
+    uint64_t start;
+
+    if (r->op == ALLOC_TYPE_FREE || (r->op == ALLOC_TYPE_REALLOC && r->old_ptr))
+    {
+        old = map_take(&ctx->map, r->op == ALLOC_TYPE_FREE ? r->ptr : r->old_ptr);
+        if (old == NULL)
+        {
+            // El bloque se asignó antes de empezar la traza o su registro se descartó
+            ctx->stats->failed++;
+            return 0;
+        }
+    }
+
+    start = now_ns();
+    switch (r->op)
+    {
+    case ALLOC_TYPE_MALLOC:
+        p = my_malloc(r->size);
+        break;
+    case ALLOC_TYPE_CALLOC:
+        p = my_calloc(1, r->size);
+        break;
+    case ALLOC_TYPE_REALLOC:
+        p = my_realloc(old, r->size);
+        break;
+    case ALLOC_TYPE_FREE:
+        my_free(old);
+        break;
+    default:
+        return 0;
+    }
+    ctx->elapsed_ns += now_ns() - start;
+    ctx->stats->ops++;
+
+    if (r->op == ALLOC_TYPE_FREE)
+        return 0;
+    if (p == NULL)
+    {
+        ctx->stats->failed++;
+        // Un realloc fallido conserva el bloque original
+        if (old != NULL && map_put(&ctx->map, r->old_ptr, old) != 0)
+            ctx->error = 1;
+        return ctx->error;
+    }
+    if (r->ptr && map_put(&ctx->map, r->ptr, p) != 0)
+        ctx->error = 1;
+    return ctx->error;
+}
+
+int mem_trace_replay(const char* path, int method, struct mem_trace_replay_stats* stats)
+{
+    struct replay_ctx ctx = {{NULL, NULL, 0, 0}, stats, 0, 0};
+    memset(stats, 0, sizeof(*stats));
+
+    struct mem_heap* h = mem_heap_create(method);
+    if (h == NULL)
+        return -1;
+    struct mem_heap* saved = mem_heap_use(h);
+    // La reproducción no debe volver a registrarse
+    int was_muted = mem_trace_mute(1);
+
+    int res = mem_trace_read(path, replay_record, &ctx);
+    if (ctx.error)
+    {
+        printf("Error: sin memoria para reproducir la traza\n");
+        res = -1;
+    }
+    stats->ns_per_op = stats->ops ? (double)ctx.elapsed_ns / (double)stats->ops : 0.0;
+    stats->frag = external_frag();
+
+    // mem_heap_destroy() libera los bloques que quedaron vivos
+    mem_heap_use(saved);
+    mem_heap_destroy(h);
+    mem_trace_mute(was_muted);
+    free(ctx.map.keys);
+    free(ctx.map.values);
+    return res;
+}
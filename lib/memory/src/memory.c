@@ -1,5 +1,10 @@
+#define _GNU_SOURCE
+#include <mem_hist.h>
+#include <mem_trace.h>
 #include <memory.h>
+#include <pthread.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 #include <sys/mman.h>
@@ -11,32 +16,541 @@
  */
 typedef struct s_block* t_block;
 
-void* base = NULL;
-int method = 0;
-int malloc_call = 0;
-FILE* log_file = NULL;
+// get_block() resta BLOCK_SIZE a la dirección de los datos, con cualquiera de las dos cabeceras
+_Static_assert(offsetof(struct s_block, data) == BLOCK_SIZE, "BLOCK_SIZE debe ser el tamaño de la cabecera");
 
 /**
- * @brief Busca un bloque de memoria adecuado según el tamaño requerido.
- * @return Puntero al bloque encontrado o NULL si no se encuentra ninguno.
+ * @brief Heap de los hilos que no eligieron otro; equivale al antiguo estado global.
+ *
+ * Usa la arena, como los heaps de mem_heap_create(), para que my_free() valide en O(1).
  */
-t_block find_block(t_block* last, size_t size)
+static struct mem_heap default_heap = {NULL, NULL, FIRST_FIT, ARENA_ON, 0, {NULL}, {0}, PTHREAD_MUTEX_INITIALIZER};
+
+/**
+ * @brief Heap sobre el que opera el hilo, ver mem_heap_use().
+ */
+static _Thread_local struct mem_heap* heap = &default_heap;
+
+/**
+ * @brief Distinto de 0 mientras my_calloc() o my_realloc() usan my_malloc() o my_free(); evita registros dobles.
+ */
+static _Thread_local int malloc_call = 0;
+
+/**
+ * @brief Distinto de 0 si el último my_malloc() del hilo devolvió memoria recién mapeada, que ya está en cero.
+ */
+static _Thread_local int fresh_block = 0;
+
+/**
+ * @brief Caché de bloques chicos liberados por un hilo.
+ *
+ * Los bloques siguen ocupados para su heap, así que solo los toca este hilo.
+ */
+struct tcache
+{
+    struct mem_heap* heap;                        /**< Heap de los bloques cacheados, o NULL. */
+    size_t count[TCACHE_CLASSES];                 /**< Bloques cacheados de cada clase. */
+    t_block blocks[TCACHE_CLASSES][TCACHE_DEPTH]; /**< Bloques de cada clase; la clase c tiene 8 * (c + 1) bytes. */
+};
+
+/**
+ * @brief Caché del hilo.
+ */
+static _Thread_local struct tcache tcache;
+
+/**
+ * @brief Clave para vaciar la caché cuando termina el hilo.
+ */
+static pthread_key_t tcache_key;
+
+/**
+ * @brief Crea @ref tcache_key una sola vez.
+ */
+static pthread_once_t tcache_once = PTHREAD_ONCE_INIT;
+
+/**
+ * @brief Bytes de la cabecera de un chunk antes de su primer bloque.
+ */
+#define CHUNK_HEADER_SIZE align(sizeof(struct s_chunk))
+
+/**
+ * @brief Capacidad inicial del índice de chunks; se duplica al llenarse a la mitad.
+ */
+#define CHUNK_INDEX_INITIAL 64
+
+/**
+ * @brief Tabla hash con direccionamiento abierto de los chunks mapeados; 0 es una celda vacía.
+ */
+static uintptr_t* chunk_index;
+
+/**
+ * @brief Celdas de @ref chunk_index, siempre potencia de dos.
+ */
+static size_t chunk_index_cap;
+
+/**
+ * @brief Chunks registrados en @ref chunk_index.
+ */
+static size_t chunk_index_count;
+
+/**
+ * @brief Protege el índice de chunks, compartido entre todos los heaps.
+ */
+static pthread_rwlock_t chunk_index_lock = PTHREAD_RWLOCK_INITIALIZER;
+
+/**
+ * @brief Devuelve los enlaces de lista libre guardados en los datos del bloque.
+ */
+static struct s_free_links* free_links(t_block b)
+{
+    return (struct s_free_links*)b->data;
+}
+
+/**
+ * @brief Devuelve la clase de tamaño de un bloque: floor(log2(size)).
+ */
+static int size_class(size_t size)
+{
+    int c = (int)(sizeof(unsigned long long) * 8 - 1) - __builtin_clzll((unsigned long long)size);
+    return c < SEG_CLASSES ? c : SEG_CLASSES - 1;
+}
+
+/**
+ * @brief Suma un bloque ocupado a los contadores del heap.
+ */
+static void stats_add_used(t_block b)
 {
-    t_block b = base;
-    switch (method)
+    heap->stats.used_bytes += b->size;
+    heap->stats.used_blocks++;
+    heap->stats.used_class_count[size_class(b->size)]++;
+}
+
+/**
+ * @brief Resta un bloque ocupado de los contadores antes de que cambie de tamaño o se libere.
+ */
+static void stats_remove_used(t_block b)
+{
+    heap->stats.used_bytes -= b->size;
+    heap->stats.used_blocks--;
+    heap->stats.used_class_count[size_class(b->size)]--;
+}
+
+/**
+ * @brief Agrega un bloque libre al comienzo de la lista de su clase.
+ *
+ * Los bloques demasiado chicos para guardar los enlaces no se indexan; vuelven
+ * a estar disponibles cuando se fusionan con un vecino. Todos se cuentan en
+ * los contadores del heap, ya que cada bloque libre pasa por aquí.
+ */
+static void seg_insert(t_block b)
+{
+    int c = size_class(b->size);
+    heap->stats.free_bytes += b->size;
+    heap->stats.free_blocks++;
+    heap->stats.free_class_bytes[c] += b->size;
+    heap->stats.free_class_count[c]++;
+    if (b->size < SEG_MIN_PAYLOAD)
+    {
+        return;
+    }
+    free_links(b)->prev_free = NULL;
+    free_links(b)->next_free = heap->seg_heads[c];
+    if (heap->seg_heads[c])
+    {
+        free_links(heap->seg_heads[c])->prev_free = b;
+    }
+    heap->seg_heads[c] = b;
+}
+
+/**
+ * @brief Quita un bloque libre de la lista de su clase.
+ */
+static void seg_remove(t_block b)
+{
+    int c = size_class(b->size);
+    heap->stats.free_bytes -= b->size;
+    heap->stats.free_blocks--;
+    heap->stats.free_class_bytes[c] -= b->size;
+    heap->stats.free_class_count[c]--;
+    if (b->size < SEG_MIN_PAYLOAD)
+    {
+        return;
+    }
+    struct s_free_links* l = free_links(b);
+    if (l->prev_free)
+    {
+        free_links(l->prev_free)->next_free = l->next_free;
+    }
+    else
+    {
+        heap->seg_heads[c] = l->next_free;
+    }
+    if (l->next_free)
+    {
+        free_links(l->next_free)->prev_free = l->prev_free;
+    }
+}
+
+/**
+ * @brief Vacía todas las listas libres y los contadores, cuando se descarta la lista de bloques.
+ */
+static void seg_reset()
+{
+    memset(heap->seg_heads, 0, sizeof(heap->seg_heads));
+    memset(&heap->stats, 0, sizeof(heap->stats));
+}
+
+/**
+ * @brief Devuelve el chunk de la arena que contiene un bloque.
+ */
+static struct s_chunk* chunk_of(t_block b)
+{
+    return (struct s_chunk*)((uintptr_t)b & ~(uintptr_t)(ARENA_CHUNK_SIZE - 1));
+}
+
+/**
+ * @brief Indica si `b` empieza justo donde terminan los datos de `a`.
+ */
+static int contiguous(t_block a, t_block b)
+{
+    return (char*)a->data + a->size == (char*)b;
+}
+
+/**
+ * @brief Primera celda donde buscar un chunk en el índice.
+ */
+static size_t chunk_slot(uintptr_t c)
+{
+    // Los bits bajos son siempre 0 por la alineación; se mezclan los altos
+    return (size_t)(((c / ARENA_CHUNK_SIZE) * 0x9E3779B97F4A7C15ULL) >> 32) & (chunk_index_cap - 1);
+}
+
+/**
+ * @brief Indica si un chunk está registrado en el índice.
+ */
+static int chunk_index_find(uintptr_t c)
+{
+    int found = 0;
+    pthread_rwlock_rdlock(&chunk_index_lock);
+    if (chunk_index)
+    {
+        for (size_t i = chunk_slot(c); chunk_index[i]; i = (i + 1) & (chunk_index_cap - 1))
+        {
+            if (chunk_index[i] == c)
+            {
+                found = 1;
+                break;
+            }
+        }
+    }
+    pthread_rwlock_unlock(&chunk_index_lock);
+    return found;
+}
+
+/**
+ * @brief Inserta un chunk en una tabla con lugar libre.
+ */
+static void chunk_index_put(uintptr_t c)
+{
+    size_t i = chunk_slot(c);
+    while (chunk_index[i])
+        i = (i + 1) & (chunk_index_cap - 1);
+    chunk_index[i] = c;
+}
+
+/**
+ * @brief Registra un chunk, agrandando el índice si hace falta.
+ *
+ * La tabla se mapea con mmap para no depender de otro asignador.
+ *
+ * @return 0 si se registró, -1 si no se pudo agrandar el índice.
+ */
+static int chunk_index_add(uintptr_t c)
+{
+    pthread_rwlock_wrlock(&chunk_index_lock);
+    if ((chunk_index_count + 1) * 2 > chunk_index_cap)
+    {
+        size_t old_cap = chunk_index_cap;
+        uintptr_t* old = chunk_index;
+        size_t cap = old_cap ? old_cap * 2 : CHUNK_INDEX_INITIAL;
+        uintptr_t* grown = mmap(0, cap * sizeof(uintptr_t), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (grown == MAP_FAILED)
+        {
+            pthread_rwlock_unlock(&chunk_index_lock);
+            return -1;
+        }
+        chunk_index = grown;
+        chunk_index_cap = cap;
+        for (size_t i = 0; i < old_cap; i++)
+        {
+            if (old[i])
+                chunk_index_put(old[i]);
+        }
+        if (old)
+            munmap(old, old_cap * sizeof(uintptr_t));
+    }
+    chunk_index_put(c);
+    chunk_index_count++;
+    pthread_rwlock_unlock(&chunk_index_lock);
+    return 0;
+}
+
+/**
+ * @brief Quita un chunk del índice, corriendo hacia atrás las entradas que le siguen.
+ */
+static void chunk_index_remove(uintptr_t c)
+{
+    pthread_rwlock_wrlock(&chunk_index_lock);
+    size_t mask = chunk_index_cap - 1;
+    size_t i = chunk_slot(c);
+    while (chunk_index[i] != c)
+    {
+        if (!chunk_index[i])
+        {
+            pthread_rwlock_unlock(&chunk_index_lock);
+            return;
+        }
+        i = (i + 1) & mask;
+    }
+    // Sin lápidas: cada entrada posterior se mueve al hueco si su celda inicial lo permite
+    for (size_t j = (i + 1) & mask; chunk_index[j]; j = (j + 1) & mask)
+    {
+        size_t home = chunk_slot(chunk_index[j]);
+        if (((j - home) & mask) >= ((j - i) & mask))
+        {
+            chunk_index[i] = chunk_index[j];
+            i = j;
+        }
+    }
+    chunk_index[i] = 0;
+    chunk_index_count--;
+    pthread_rwlock_unlock(&chunk_index_lock);
+}
+
+/**
+ * @brief Mapea `len` bytes alineados a @ref ARENA_CHUNK_SIZE.
+ *
+ * mmap solo garantiza alineación de página, así que se mapea un chunk de más y
+ * se devuelven los extremos sobrantes.
+ *
+ * @return Inicio del mapeo, o NULL en caso de error.
+ */
+static void* map_chunk(size_t len)
+{
+    char* raw = mmap(0, len + ARENA_CHUNK_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED)
+    {
+        return NULL;
+    }
+    char* start = (char*)(((uintptr_t)raw + ARENA_CHUNK_SIZE - 1) & ~(uintptr_t)(ARENA_CHUNK_SIZE - 1));
+    if (start > raw)
+    {
+        munmap(raw, (size_t)(start - raw));
+    }
+    munmap(start + len, ARENA_CHUNK_SIZE - (size_t)(start - raw));
+#ifdef MADV_HUGEPAGE
+    if (heap->arena_mode == ARENA_HUGEPAGES)
+    {
+        madvise(start, len, MADV_HUGEPAGE);
+    }
+#endif
+    return start;
+}
+
+/**
+ * @brief Quita de las listas todos los bloques de un chunk libre y lo desmapea.
+ *
+ * Los bloques de un chunk son consecutivos en la lista, así que basta con
+ * saltear el tramo y unir sus extremos.
+ */
+static void release_chunk(struct s_chunk* c)
+{
+    char* end = (char*)c + c->size;
+    t_block first = (t_block)((char*)c + CHUNK_HEADER_SIZE);
+    t_block after = first;
+
+    while (after && (char*)after > (char*)c && (char*)after < end)
+    {
+        seg_remove(after);
+        after = after->next;
+    }
+    if (first->prev)
+        first->prev->next = after;
+    else
+        heap->base = after;
+    if (after)
+        after->prev = first->prev;
+    else
+        heap->tail = first->prev;
+    if (!heap->base)
+        seg_reset();
+    chunk_index_remove((uintptr_t)c);
+    munmap(c, c->size);
+}
+
+/**
+ * @brief Completa la cabecera de un bloque recién armado con la dirección de sus datos.
+ *
+ * La cabecera compacta no guarda esa dirección, así que no hace nada.
+ */
+static void tag_block(t_block b)
+{
+#ifdef MEMORY_COMPACT_HEADER
+    (void)b;
+#else
+    b->ptr = b->data;
+#endif
+}
+
+/**
+ * @brief Extiende el heap con un chunk nuevo de la arena.
+ *
+ * El chunk entero queda como un solo bloque ocupado; lo que sobra del pedido
+ * se separa como bloque libre para los próximos my_malloc().
+ */
+static t_block extend_arena(t_block last, size_t s)
+{
+    size_t len = (CHUNK_HEADER_SIZE + BLOCK_SIZE + s + ARENA_CHUNK_SIZE - 1) & ~(ARENA_CHUNK_SIZE - 1);
+    struct s_chunk* c = map_chunk(len);
+    if (!c)
+    {
+        return NULL;
+    }
+    if (chunk_index_add((uintptr_t)c) != 0)
+    {
+        munmap(c, len);
+        return NULL;
+    }
+    c->size = len;
+    c->used = 1;
+    c->heap = heap;
+
+    t_block b = (t_block)((char*)c + CHUNK_HEADER_SIZE);
+    b->size = len - CHUNK_HEADER_SIZE - BLOCK_SIZE;
+    b->next = NULL;
+    b->prev = last;
+    tag_block(b);
+    b->free = 0;
+    if (last)
+        last->next = b;
+    heap->tail = b;
+    if ((b->size - s) >= (BLOCK_SIZE + 4))
+        split_block(b, s);
+    return b;
+}
+
+/**
+ * @brief Indica si un bloque es el primero de su mmap cuando no hay arena.
+ *
+ * Los bloques solo nacen al inicio de un mapeo o al dividir al anterior, así
+ * que si no es contiguo al previo de la lista empieza un mapeo.
+ */
+static int starts_mapping(t_block b)
+{
+    return !b->prev || !contiguous(b->prev, b);
+}
+
+/**
+ * @brief Indica si `p` son los datos de un bloque de algún chunk registrado.
+ *
+ * No toca ninguna lista, así que no necesita el lock del heap. La cabecera
+ * compacta no tiene ptr para confirmar que `b` es un bloque; solo se comprueba
+ * que cae entero dentro del chunk y el resto lo hace arena_linked().
+ */
+static int arena_block(void* p)
+{
+    if (p == NULL || ((uintptr_t)p & 7))
+        return 0;
+    t_block b = get_block(p);
+    struct s_chunk* c = chunk_of(b);
+    if ((char*)b < (char*)c + CHUNK_HEADER_SIZE || !chunk_index_find((uintptr_t)c))
+        return 0;
+#ifdef MEMORY_COMPACT_HEADER
+    return b->data + b->size <= (char*)c + c->size;
+#else
+    return b->ptr == p;
+#endif
+}
+
+/**
+ * @brief Confirma que un bloque de la arena está en la lista de su heap; el lock del heap debe estar tomado.
+ *
+ * Con la cabecera clásica ya lo confirmó ptr en arena_block(). Con la compacta
+ * el bloque debe ser la base del heap o el siguiente de su anterior, que a su
+ * vez tiene que estar en un chunk registrado antes de leerlo.
+ */
+static int arena_linked(t_block b)
+{
+#ifdef MEMORY_COMPACT_HEADER
+    t_block prev = b->prev;
+    if (!prev)
+        return heap->base == b;
+    struct s_chunk* c = chunk_of(prev);
+    if (c != chunk_of(b) && !chunk_index_find((uintptr_t)c))
+        return 0;
+    return (char*)prev >= (char*)c + CHUNK_HEADER_SIZE && prev->next == b;
+#else
+    (void)b;
+    return 1;
+#endif
+}
+
+/**
+ * @brief Busca un bloque libre en las listas segregadas.
+ *
+ * En la clase del tamaño pedido hay que comparar tamaños, pero cualquier bloque
+ * de una clase mayor alcanza, así que basta con tomar la primera no vacía.
+ */
+static t_block seg_find(size_t size, size_t* steps)
+{
+    int c = size_class(size);
+    for (t_block b = heap->seg_heads[c]; b; b = free_links(b)->next_free)
+    {
+        (*steps)++;
+        if (b->size >= size)
+        {
+            return b;
+        }
+    }
+    for (c++; c < SEG_CLASSES; c++)
+    {
+        if (heap->seg_heads[c])
+        {
+            (*steps)++;
+            return heap->seg_heads[c];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Busca un bloque libre como find_block() y cuenta los bloques que examina.
+ *
+ * Con listas segregadas solo cuentan los bloques de las listas libres; el
+ * último bloque, que hace falta para extender el heap, sale de la cola del heap
+ * sin recorrer la lista.
+ */
+static t_block find_block_counted(t_block* last, size_t size, size_t* steps)
+{
+    t_block b = heap->base;
+    switch (heap->method)
     {
     case 0:
         while (b && !(b->free && b->size >= size))
         {
+            (*steps)++;
             *last = b;
             b = b->next;
         }
+        *steps += b != NULL;
         return b;
     case 1: {
-        size_t dif = PAGESIZE;
+        // Sin tope: con la arena los restos de un chunk son mucho más grandes que una página
+        size_t dif = SIZE_MAX;
         t_block best = NULL;
         while (b)
         {
+            (*steps)++;
             if (b->free)
             {
                 if (b->size == size)
@@ -57,6 +571,7 @@ t_block find_block(t_block* last, size_t size)
         t_block best = NULL;
         while (b)
         {
+            (*steps)++;
             if (b->free)
             {
                 if (b->size == size)
@@ -72,11 +587,27 @@ t_block find_block(t_block* last, size_t size)
         }
         return best;
     }
+    case 3:
+        // El último bloque solo hace falta si no hay ninguno libre y se extiende el heap
+        b = seg_find(size, steps);
+        if (!b)
+            *last = heap->tail;
+        return b;
     default:
         return NULL;
     }
 }
 
+/**
+ * @brief Busca un bloque de memoria adecuado según el tamaño requerido.
+ * @return Puntero al bloque encontrado o NULL si no se encuentra ninguno.
+ */
+t_block find_block(t_block* last, size_t size)
+{
+    size_t steps = 0;
+    return find_block_counted(last, size, &steps);
+}
+
 /**
  * @brief Divide un bloque en dos, si es lo suficientemente grande.
  */
@@ -86,155 +617,473 @@ void split_block(t_block b, size_t s)
     {
         return;
     }
+    // En un chunk de varias unidades el chunk se obtiene enmascarando, y eso solo vale en la primera
+    if (heap->arena_mode != ARENA_OFF && chunk_of((t_block)(b->data + s)) != chunk_of(b))
+    {
+        return;
+    }
     t_block new;
     new = (t_block)(b->data + s);
     new->size = b->size - s - BLOCK_SIZE;
     new->next = b->next;
+    new->prev = b;
+    tag_block(new);
     new->free = 1;
+    if (new->next)
+        new->next->prev = new;
+    else
+        heap->tail = new;
     b->size = s;
     b->next = new;
+    seg_insert(new);
+}
+
+/**
+ * @brief Copia los datos de un bloque a otro.
+ */
+void copy_block(t_block src, t_block dst)
+{
+    if (!src || !dst)
+    {
+        return;
+    }
+    // memcpy ya usa las instrucciones vectoriales disponibles
+    memcpy(dst->data, src->data, src->size < dst->size ? src->size : dst->size);
+}
+
+/**
+ * @brief Obtiene el bloque de memoria asociado a un puntero.
+ * @return Puntero al bloque correspondiente.
+ */
+t_block get_block(void* p)
+{
+    char* tmp;
+    tmp = p;
+    tmp -= BLOCK_SIZE;
+    return (t_block)(tmp);
+}
+
+/**
+ * @brief Verifica si una dirección de memoria es válida.
+ *
+ * En modo arena basta con buscar el chunk del bloque en el índice, en tiempo
+ * constante; sin arena los mapeos no están indexados y se recorre la lista.
+ *
+ * @return 1 si es válida, 0 si no lo es.
+ */
+int valid_addr(void* p)
+{
+    if (p == NULL || heap->base == NULL)
+    {
+
+        return 0;
+    }
+    t_block b = get_block(p);
+    if (heap->arena_mode != ARENA_OFF)
+        return arena_block(p) && chunk_of(b)->heap == heap && arena_linked(b);
+    t_block current = heap->base;
+    while (current)
+    {
+        if (current == b)
+        {
+#ifdef MEMORY_COMPACT_HEADER
+            return 1;
+#else
+            return (current->ptr == p);
+#endif
+        }
+        current = current->next;
+    }
+    return INVALID_ADDR;
+}
+
+/**
+ * @brief Fusiona bloques libres adyacentes para reducir fragmentación.
+ * @return Puntero al bloque fusionado.
+ */
+t_block fusion(t_block b)
+{
+    if (b == NULL)
+        return NULL; // Retorna NULL si el bloque inicial es inválido
+
+    // Un bloque libre cambia de tamaño y por lo tanto de clase
+    if (b->free)
+        seg_remove(b);
+
+    // Solo se fusionan bloques contiguos en memoria: cada extend_heap es un mmap distinto
+    while (b->next && b->next->free && contiguous(b, b->next))
+    {
+        seg_remove(b->next);
+        b->size += BLOCK_SIZE + b->next->size;
+        b->next = b->next->next;
+
+        if (b->next)
+            b->next->prev = b;
+        else
+            heap->tail = b;
+    }
+
+    if (b->free)
+        seg_insert(b);
+    return b;
+}
+
+/**
+ * @brief Extiende el heap asignando un nuevo bloque.
+ * @return Puntero al nuevo bloque o NULL en caso de error.
+ */
+t_block extend_heap(t_block last, size_t s)
+{
+    if (heap->arena_mode != ARENA_OFF)
+        return extend_arena(last, s);
+
+    t_block b;
+    b = mmap(0, s + BLOCK_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (b == MAP_FAILED)
+    {
+        return NULL;
+    }
+    b->size = s;
+    b->next = NULL;
+    b->prev = last;
+    tag_block(b);
+    if (last)
+        last->next = b;
+    heap->tail = b;
+
+    b->free = 0;
+    return b;
+}
+
+/**
+ * @brief Obtiene el método de asignación actual.
+ * @return El método actual (0 a 3).
+ */
+int get_method()
+{
+    return heap->method;
+}
+
+/**
+ * @brief Establece el método de asignación del heap del hilo.
+ */
+void set_method(int m)
+{
+    pthread_mutex_lock(&heap->lock);
+    heap->method = m;
+    pthread_mutex_unlock(&heap->lock);
+}
+
+/**
+ * @brief Elige si el heap se extiende con chunks de la arena o con un mmap por bloque.
+ * @return 0 si se aplicó, -1 si el modo es inválido o el heap no está vacío.
+ */
+int set_arena_mode(int mode)
+{
+    if (mode != ARENA_OFF && mode != ARENA_ON && mode != ARENA_HUGEPAGES)
+    {
+        printf("Error: invalid arena mode\n");
+        return -1;
+    }
+    pthread_mutex_lock(&heap->lock);
+    // Los bloques existentes no están en chunks alineados, así que no se pueden mezclar
+    if (heap->base)
+    {
+        pthread_mutex_unlock(&heap->lock);
+        printf("Error: arena mode can only change on an empty heap\n");
+        return -1;
+    }
+    heap->arena_mode = mode;
+    pthread_mutex_unlock(&heap->lock);
+    return 0;
+}
+
+/**
+ * @brief Obtiene el modo de arena actual.
+ */
+int get_arena_mode()
+{
+    return heap->arena_mode;
+}
+
+/**
+ * @brief Controla el método de asignación basado en un valor entero.
+ */
+void malloc_control(int m)
+{
+    if (m == 0)
+    {
+        set_method(0);
+    }
+    else if (m == 1)
+    {
+        set_method(1);
+    }
+    else if (m == 2)
+    {
+        set_method(2);
+    }
+    else if (m == 3)
+    {
+        set_method(3);
+    }
+    else
+    {
+        printf("Error: invalid method\n");
+    }
+}
+
+/**
+ * @brief Crea un heap independiente con arena y caché por hilo.
+ * @return Heap nuevo, o NULL en caso de error.
+ */
+struct mem_heap* mem_heap_create(int method)
+{
+    if (method < FIRST_FIT || method > SEGREGATED_FIT)
+    {
+        printf("Error: invalid method\n");
+        return NULL;
+    }
+    // mmap devuelve memoria en cero: lista y listas segregadas vacías
+    struct mem_heap* h = mmap(0, sizeof(*h), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (h == MAP_FAILED)
+    {
+        printf("Error: cannot create heap\n");
+        return NULL;
+    }
+    h->method = method;
+    h->arena_mode = ARENA_ON;
+    h->thread_cache = 1;
+    pthread_mutex_init(&h->lock, NULL);
+    return h;
+}
+
+/**
+ * @brief Libera todos los bloques de un heap y lo destruye.
+ */
+void mem_heap_destroy(struct mem_heap* h)
+{
+    struct mem_heap* saved = mem_heap_use(h);
+    mem_trim();
+    mem_heap_use(saved == h ? NULL : saved);
+    pthread_mutex_destroy(&h->lock);
+    munmap(h, sizeof(*h));
+}
+
+/**
+ * @brief Cambia el heap del hilo, vaciando antes su caché si era de otro heap.
+ * @return Heap anterior del hilo.
+ */
+struct mem_heap* mem_heap_use(struct mem_heap* h)
+{
+    struct mem_heap* prev = heap;
+    if (!h)
+        h = &default_heap;
+    if (tcache.heap && tcache.heap != h)
+        mem_cache_flush();
+    heap = h;
+    return prev;
+}
+
+/**
+ * @brief Busca un bloque libre o extiende el heap; el lock del heap debe estar tomado.
+ * @param steps Bloques que examinó la búsqueda; 0 si el heap estaba vacío.
+ * @return Bloque ocupado de al menos `s` bytes, o NULL en caso de error.
+ */
+static t_block malloc_locked(size_t s, size_t* steps)
+{
+    t_block b, last;
+
+    *steps = 0;
+    if (heap->base)
+    {
+        last = heap->base;
+        b = find_block_counted(&last, s, steps);
+        if (b)
+        {
+            seg_remove(b);
+            if ((b->size - s) >= (BLOCK_SIZE + 4))
+                split_block(b, s);
+            b->free = 0;
+            if (heap->arena_mode != ARENA_OFF)
+                chunk_of(b)->used++;
+            fresh_block = 0;
+        }
+        else
+        {
+            b = extend_heap(last, s);
+            fresh_block = 1;
+        }
+    }
+    else
+    {
+        b = extend_heap(NULL, s);
+        if (b)
+            heap->base = b;
+        fresh_block = 1;
+    }
+    if (b)
+        stats_add_used(b);
+    return b;
+}
+
+/**
+ * @brief Marca libre un bloque ocupado, lo fusiona con sus vecinos y devuelve la
+ * memoria que queda sin uso; el lock del heap debe estar tomado.
+ */
+static void free_block(t_block b)
+{
+    stats_remove_used(b);
+    fusion(b);
+    b->free = 1;
+    seg_insert(b);
+    // El anterior en la lista es el vecino físico si es contiguo: fusionar hacia atrás es O(1)
+    if (b->prev && b->prev->free && contiguous(b->prev, b))
+        b = fusion(b->prev);
+    if (heap->arena_mode != ARENA_OFF)
+    {
+        struct s_chunk* c = chunk_of(b);
+        if (--c->used == 0)
+            release_chunk(c);
+    }
+    else if (!b->next && starts_mapping(b))
+    {
+        // Un mapeo completo al final de la lista se devuelve al sistema
+        seg_remove(b);
+        if (!b->prev)
+        {
+            heap->base = NULL;
+            seg_reset();
+        }
+        else
+            b->prev->next = NULL;
+        heap->tail = b->prev;
+        munmap(b, BLOCK_SIZE + b->size);
+    }
 }
 
 /**
- * @brief Copia los datos de un bloque a otro.
+ * @brief Vacía la caché al terminar el hilo.
  */
-void copy_block(t_block src, t_block dst)
+static void tcache_destructor(void* arg)
 {
-    int *sdata, *ddata;
-    size_t i;
-    if (!src->ptr || !dst->ptr)
-    {
-        return;
-    }
-    sdata = src->ptr;
-    ddata = dst->ptr;
-
-    for (i = 0; (i * 4) < src->size && (i * 4) < dst->size; i++)
-        ddata[i] = sdata[i];
+    (void)arg;
+    mem_cache_flush();
 }
 
 /**
- * @brief Obtiene el bloque de memoria asociado a un puntero.
- * @return Puntero al bloque correspondiente.
+ * @brief Crea la clave que dispara @ref tcache_destructor.
  */
-t_block get_block(void* p)
+static void tcache_key_init()
 {
-    char* tmp;
-    tmp = p;
-    tmp -= BLOCK_SIZE;
-    return (t_block)(tmp);
+    pthread_key_create(&tcache_key, tcache_destructor);
 }
 
 /**
- * @brief Verifica si una dirección de memoria es válida.
- * @return 1 si es válida, 0 si no lo es.
+ * @brief Clase de la caché para un tamaño de datos.
+ * @return Clase, o -1 si el heap no usa caché o el tamaño no se cachea.
  */
-int valid_addr(void* p)
+static int tcache_class(size_t size)
 {
-    if (p == NULL || base == NULL)
-    {
-
-        return 0;
-    }
-    t_block b = get_block(p);
-    t_block current = base;
-    while (current)
-    {
-        if (current == b)
-        {
-            return (current->ptr == p);
-        }
-        current = current->next;
-    }
-    return INVALID_ADDR;
+    if (!heap->thread_cache || size == 0 || size > TCACHE_MAX_SIZE)
+        return -1;
+    return (int)(size / 8) - 1;
 }
 
 /**
- * @brief Fusiona bloques libres adyacentes para reducir fragmentación.
- * @return Puntero al bloque fusionado.
+ * @brief Toma de la caché un bloque de exactamente `s` bytes del heap del hilo.
+ * @return Bloque ocupado, o NULL si no hay.
  */
-t_block fusion(t_block b)
+static t_block tcache_pop(size_t s)
 {
-    if (b == NULL)
-        return NULL; // Retorna NULL si el bloque inicial es inválido
-
-    while (b->next && b->next->free)
-    {
-        // Validar que b->next y b->next->next sean válidos
-        if (b->next == NULL || b->next->next == NULL)
-            break;
-
-        b->size += b->next->size;
-        b->next = b->next->next;
-
-        if (b->next)
-            b->next->prev = b;
-    }
-    return b;
+    int c = tcache_class(s);
+    if (c < 0 || tcache.heap != heap || tcache.count[c] == 0)
+        return NULL;
+    return tcache.blocks[c][--tcache.count[c]];
 }
 
 /**
- * @brief Extiende el heap asignando un nuevo bloque.
- * @return Puntero al nuevo bloque o NULL en caso de error.
+ * @brief Indica si un bloque ya está en la caché del hilo.
+ *
+ * Los bloques de la caché siguen ocupados para el heap, así que `free` no
+ * alcanza para detectar que se liberan dos veces.
  */
-t_block extend_heap(t_block last, size_t s)
+static int tcache_holds(t_block b)
 {
-    t_block b;
-    b = mmap(0, s, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
-
-    if (b == MAP_FAILED)
+    int c = tcache_class(b->size);
+    if (c < 0 || tcache.heap != heap)
+        return 0;
+    for (size_t i = 0; i < tcache.count[c]; i++)
     {
-        return NULL;
+        if (tcache.blocks[c][i] == b)
+            return 1;
     }
-    b->size = s;
-    b->next = NULL;
-    b->prev = last;
-    b->ptr = b->data;
-    if (last)
-        last->next = b;
-
-    b->free = 0;
-    return b;
+    return 0;
 }
 
 /**
- * @brief Obtiene el método de asignación actual.
- * @return El método actual (0, 1 o 2).
+ * @brief Confirma que un bloque del heap del hilo está ocupado y puede ir a la caché, sin el lock tomado.
+ *
+ * Con la cabecera compacta arena_linked() lee el bloque anterior, que otro hilo
+ * puede estar dividiendo, fusionando o desmapeando con release_chunk(), así que
+ * esa comprobación se hace con el lock. La clásica solo lee la propia cabecera.
  */
-int get_method()
+static int tcache_accepts(t_block b)
 {
-    return method;
+#ifdef MEMORY_COMPACT_HEADER
+    pthread_mutex_lock(&heap->lock);
+    int ok = !b->free && arena_linked(b);
+    pthread_mutex_unlock(&heap->lock);
+    return ok;
+#else
+    return !b->free;
+#endif
 }
 
 /**
- * @brief Establece el método de asignación.
+ * @brief Guarda en la caché un bloque ocupado del heap del hilo.
+ * @return 1 si se guardó, 0 si el bloque no se cachea o la clase está llena.
  */
-void set_method(int m)
+static int tcache_push(t_block b)
 {
-    method = m;
+    int c = tcache_class(b->size);
+    if (c < 0)
+        return 0;
+    if (tcache.heap != heap)
+    {
+        mem_cache_flush();
+        pthread_once(&tcache_once, tcache_key_init);
+        // Cualquier valor no nulo hace que el destructor se llame al terminar el hilo
+        pthread_setspecific(tcache_key, &tcache);
+        tcache.heap = heap;
+    }
+    if (tcache.count[c] == TCACHE_DEPTH)
+        return 0;
+    tcache.blocks[c][tcache.count[c]++] = b;
+    return 1;
 }
 
 /**
- * @brief Controla el método de asignación basado en un valor entero.
+ * @brief Devuelve al heap dueño los bloques de la caché del hilo.
  */
-void malloc_control(int m)
+void mem_cache_flush()
 {
-    if (m == 0)
-    {
-        set_method(0);
-    }
-    else if (m == 1)
-    {
-        set_method(1);
-    }
-    else if (m == 2)
-    {
-        set_method(2);
-    }
-    else
+    struct mem_heap* h = tcache.heap;
+    if (!h)
+        return;
+
+    struct mem_heap* saved = heap;
+    heap = h;
+    pthread_mutex_lock(&h->lock);
+    for (int c = 0; c < TCACHE_CLASSES; c++)
     {
-        printf("Error: invalid method\n");
+        while (tcache.count[c] > 0)
+            free_block(tcache.blocks[c][--tcache.count[c]]);
     }
+    pthread_mutex_unlock(&h->lock);
+    heap = saved;
+    tcache.heap = NULL;
 }
 
 /**
@@ -243,61 +1092,92 @@ void malloc_control(int m)
  */
 void* my_malloc(size_t size)
 {
-    t_block b, last;
-    size_t s;
+    t_block b;
+    size_t s, steps = 0;
+    int searched = 0;
+    uint64_t start = mem_hist_now();
     s = align(size);
 
-    if (base)
-    {
-        last = base;
-        b = find_block(&last, s);
-        if (b)
-        {
-            if ((b->size - s) >= (BLOCK_SIZE + 4))
-                split_block(b, s);
-            b->free = 0;
-        }
-        else
-        {
-            b = extend_heap(last, s);
-            if (!b)
-                return (NULL);
-        }
-    }
-    else
+    // Con listas segregadas todo bloque debe poder guardar sus enlaces cuando se libere
+    if (heap->method == SEGREGATED_FIT && s < SEG_MIN_PAYLOAD)
+        s = SEG_MIN_PAYLOAD;
+
+    // Un bloque de la caché ya está ocupado para el heap, así que no hace falta el lock
+    b = tcache_pop(s);
+    fresh_block = 0;
+    if (!b)
     {
-        b = extend_heap(NULL, s);
+        pthread_mutex_lock(&heap->lock);
+        b = malloc_locked(s, &steps);
+        pthread_mutex_unlock(&heap->lock);
+        searched = 1;
         if (!b)
+        {
+            malloc_call = 0;
             return (NULL);
-        base = b;
+        }
     }
     if (!malloc_call)
-        log_handler("malloc", ALLOC_TYPE_MALLOC, b->data, size);
+        mem_trace_log(ALLOC_TYPE_MALLOC, b->data, NULL, size);
     malloc_call = 0;
+    if (start)
+    {
+        mem_hist_record(MEM_HIST_MALLOC_NS, heap->method, mem_hist_now() - start);
+        mem_hist_record(MEM_HIST_REQUEST_SIZE, heap->method, size);
+        if (searched)
+            mem_hist_record(MEM_HIST_SEARCH_LEN, heap->method, steps);
+    }
     return (b->data);
 }
 
 /**
  * @brief Libera un bloque de memoria previamente asignado.
+ *
+ * Un bloque de la arena se libera en su heap dueño aunque el hilo use otro.
  */
 void my_free(void* ptr)
 {
-    t_block b;
-    if (valid_addr(ptr))
+    if (!ptr)
+        return;
+
+    uint64_t start = mem_hist_now();
+    struct mem_heap* saved = heap;
+    int arena = arena_block(ptr);
+    t_block b = get_block(ptr);
+    int freed = 0;
+
+    if (arena && chunk_of(b)->heap == saved)
     {
-        b = get_block(ptr);
-        b->free = 1;
-        fusion(b);
-        if (!b->next)
+        // Liberar otra vez un bloque de la caché lo entregaría dos veces en my_malloc()
+        if (tcache_holds(b))
+            return;
+        // Un bloque chico del propio heap vuelve a la caché del hilo sin liberarlo en el heap
+        if (tcache_class(b->size) >= 0 && tcache_accepts(b) && tcache_push(b))
         {
-            if (!b->prev)
-                base = NULL;
-            else
-                b->prev->next = NULL;
-            brk((char*)b + b->size);
+            if (!malloc_call)
+                mem_trace_log(ALLOC_TYPE_FREE, ptr, NULL, 0);
+            if (start)
+                mem_hist_record(MEM_HIST_FREE_NS, saved->method, mem_hist_now() - start);
+            return;
         }
-        log_handler("free", ALLOC_TYPE_FREE, ptr, 0);
     }
+
+    if (arena)
+        heap = chunk_of(b)->heap;
+    int method = heap->method;
+    pthread_mutex_lock(&heap->lock);
+    // Liberar dos veces el mismo bloque lo insertaría dos veces en su lista libre
+    if (valid_addr(ptr) && !b->free)
+    {
+        free_block(b);
+        freed = 1;
+    }
+    pthread_mutex_unlock(&heap->lock);
+    heap = saved;
+    if (freed && !malloc_call)
+        mem_trace_log(ALLOC_TYPE_FREE, ptr, NULL, 0);
+    if (freed && start)
+        mem_hist_record(MEM_HIST_FREE_NS, method, mem_hist_now() - start);
 }
 
 /**
@@ -306,23 +1186,59 @@ void my_free(void* ptr)
  */
 void* my_calloc(size_t number, size_t size)
 {
-    size_t* new;
-    size_t s4, i;
+    void* new;
+    size_t total;
 
-    if (!number || !size)
+    if (!number || !size || __builtin_mul_overflow(number, size, &total))
     {
         return (NULL);
     }
     malloc_call = 1;
-    new = my_malloc(number * size);
-    if (new)
+    new = my_malloc(total);
+    if (!new)
+        return (NULL);
+    // Un bloque recién mapeado ya viene en cero
+    if (!fresh_block)
+        memset(new, 0, total);
+    mem_trace_log(ALLOC_TYPE_CALLOC, new, NULL, total);
+    return (new);
+}
+
+/**
+ * @brief Agranda con mremap() un bloque que ocupa todo su mapeo; el lock del heap debe estar tomado.
+ *
+ * El kernel mueve las páginas sin copiarlas. Solo se usa sin arena: un chunk
+ * debe conservar su alineación y su lugar en el índice.
+ *
+ * @return Bloque agrandado, posiblemente en otra dirección, o NULL si no se pudo.
+ */
+static t_block remap_block(t_block b, size_t s)
+{
+    if (heap->arena_mode != ARENA_OFF || s < MREMAP_THRESHOLD || !starts_mapping(b) ||
+        (b->next && contiguous(b, b->next)))
+        return NULL;
+
+    // Después del mremap la dirección vieja ya no es válida
+    stats_remove_used(b);
+    t_block moved = mremap(b, BLOCK_SIZE + b->size, BLOCK_SIZE + s, MREMAP_MAYMOVE);
+    if (moved == MAP_FAILED)
     {
-        s4 = align(number * size) << 2;
-        for (i = 0; i < s4; i++)
-            new[i] = 0;
+        stats_add_used(b);
+        return NULL;
     }
-    log_handler("calloc", ALLOC_TYPE_CALLOC, new, 0);
-    return (new);
+    // La cabecera se mueve con los datos; solo hay que actualizar a los vecinos
+    moved->size = s;
+    tag_block(moved);
+    if (moved->prev)
+        moved->prev->next = moved;
+    else
+        heap->base = moved;
+    if (moved->next)
+        moved->next->prev = moved;
+    else
+        heap->tail = moved;
+    stats_add_used(moved);
+    return moved;
 }
 
 /**
@@ -340,44 +1256,67 @@ void* my_realloc(void* ptr, size_t size)
     if (!ptr)
     {
         newp = my_malloc(size);
-        log_handler("realloc", ALLOC_TYPE_REALLOC, newp, 0);
+        mem_trace_log(ALLOC_TYPE_REALLOC, newp, NULL, size);
         return newp;
     }
 
-    if (valid_addr(ptr))
+    struct mem_heap* saved = heap;
+    if (arena_block(ptr))
+        heap = chunk_of(get_block(ptr))->heap;
+    pthread_mutex_lock(&heap->lock);
+
+    if (!valid_addr(ptr))
     {
-        s = align(size);
-        b = get_block(ptr);
+        pthread_mutex_unlock(&heap->lock);
+        heap = saved;
+        malloc_call = 0;
+        return (NULL);
+    }
 
-        if (b->size >= s)
-        {
-            if (b->size - s >= (BLOCK_SIZE + 4))
-                split_block(b, s);
-        }
-        else
-        {
-            if (b->next && b->next->free && (b->size + BLOCK_SIZE + b->next->size) >= s)
-            {
-                fusion(b);
-                if (b->size - s >= (BLOCK_SIZE + 4))
-                    split_block(b, s);
-            }
-            else
-            {
-                newp = my_malloc(s);
-                if (!newp)
-                    return (NULL);
-                new = get_block(newp);
-                copy_block(b, new);
-                my_free(ptr);
-                log_handler("realloc", ALLOC_TYPE_REALLOC, newp, 0);
-                return (newp);
-            }
-        }
-        log_handler("realloc", ALLOC_TYPE_REALLOC, ptr, 0);
-        return (ptr);
+    s = align(size);
+    b = get_block(ptr);
+
+    if (b->size >= s)
+    {
+        stats_remove_used(b);
+        if (b->size - s >= (BLOCK_SIZE + 4))
+            split_block(b, s);
+        stats_add_used(b);
+    }
+    else if (b->next && b->next->free && contiguous(b, b->next) && (b->size + BLOCK_SIZE + b->next->size) >= s)
+    {
+        stats_remove_used(b);
+        fusion(b);
+        if (b->size - s >= (BLOCK_SIZE + 4))
+            split_block(b, s);
+        stats_add_used(b);
+    }
+    else if ((new = remap_block(b, s)) != NULL)
+    {
+        b = new;
+    }
+    else
+    {
+        // El bloque viejo sigue ocupado por el llamador, así que se puede copiar sin el lock
+        pthread_mutex_unlock(&heap->lock);
+        heap = saved;
+        newp = my_malloc(s);
+        if (!newp)
+            return (NULL);
+        new = get_block(newp);
+        copy_block(b, new);
+        // El bloque viejo queda implícito en el registro del realloc
+        malloc_call = 1;
+        my_free(ptr);
+        malloc_call = 0;
+        mem_trace_log(ALLOC_TYPE_REALLOC, newp, ptr, size);
+        return (newp);
     }
-    return (NULL);
+    pthread_mutex_unlock(&heap->lock);
+    heap = saved;
+    malloc_call = 0;
+    mem_trace_log(ALLOC_TYPE_REALLOC, b->data, ptr, size);
+    return (b->data);
 }
 
 /**
@@ -400,7 +1339,7 @@ void check_heap(void* data)
     }
 
     printf("\033[1;33mHeap check\033[0m\n");
-    printf("Size: %zu\n", block->size);
+    printf("Size: %zu\n", (size_t)block->size);
 
     if (block->next != NULL)
     {
@@ -422,36 +1361,128 @@ void check_heap(void* data)
 
     printf("Free: %d\n", block->free);
 
-    if (block->ptr != NULL)
-    {
-        printf("Beginning data address: %p\n", block->ptr);
-        printf("Last data address: %p\n", (void*)((char*)(block->ptr) + block->size));
-    }
-    else
-    {
-        printf("Data address: NULL\n");
-    }
+    printf("Beginning data address: %p\n", (void*)block->data);
+    printf("Last data address: %p\n", (void*)(block->data + block->size));
 
     printf("Heap address: %p\n", sbrk(0));
 
+#ifndef NDEBUG
+    pthread_mutex_lock(&heap->lock);
     // Check for inconsistencies
-    t_block current = base;
+    size_t errors = 0;
+    size_t indexed = 0;
+    struct s_chunk* chunk = NULL;
+    size_t chunk_used = 0;
+    struct mem_stats counted = {0};
+    t_block current = heap->base;
     while (current)
     {
+        // Check list links and the data pointer
+        if (current->next && current->next->prev != current)
+        {
+            printf("Error: Broken prev link after block %p\n", (void*)current);
+            errors++;
+        }
+#ifndef MEMORY_COMPACT_HEADER
+        if (current->ptr != current->data)
+        {
+            printf("Error: Data pointer mismatch at %p\n", (void*)current);
+            errors++;
+        }
+#endif
+
         // Check for adjacent free blocks
-        if (current->free && current->next && current->next->free)
+        if (current->free && current->next && current->next->free && contiguous(current, current->next))
         {
             printf("Warning: Adjacent free blocks detected at %p and %p\n", (void*)current, (void*)current->next);
         }
 
         // Check for invalid block sizes
-        if (current->size <= 0)
+        if (current->size == 0)
         {
             printf("Error: Invalid block size detected at %p\n", (void*)current);
+            errors++;
+        }
+
+        if (current->free && current->size >= SEG_MIN_PAYLOAD)
+            indexed++;
+        if (current->free)
+        {
+            counted.free_bytes += current->size;
+            counted.free_blocks++;
+        }
+        else
+        {
+            counted.used_bytes += current->size;
+            counted.used_blocks++;
+        }
+
+        // Blocks of a chunk are consecutive, so its used count can be checked when it ends
+        if (heap->arena_mode != ARENA_OFF)
+        {
+            if (chunk_of(current) != chunk)
+            {
+                if (chunk && chunk->used != chunk_used)
+                {
+                    printf("Error: Chunk %p counts %zu used blocks, found %zu\n", (void*)chunk, chunk->used,
+                           chunk_used);
+                    errors++;
+                }
+                chunk = chunk_of(current);
+                chunk_used = 0;
+                if (!chunk_index_find((uintptr_t)chunk))
+                {
+                    printf("Error: Chunk %p is not in the chunk index\n", (void*)chunk);
+                    errors++;
+                }
+            }
+            chunk_used += !current->free;
         }
 
         current = current->next;
     }
+    if (chunk && chunk->used != chunk_used)
+    {
+        printf("Error: Chunk %p counts %zu used blocks, found %zu\n", (void*)chunk, chunk->used, chunk_used);
+        errors++;
+    }
+
+    // Every listed block must be free and in its class; together they must cover every indexed block
+    size_t listed = 0;
+    for (int c = 0; c < SEG_CLASSES; c++)
+    {
+        for (t_block b = heap->seg_heads[c]; b && listed <= indexed; b = free_links(b)->next_free)
+        {
+            if (!b->free || size_class(b->size) != c)
+            {
+                printf("Error: Block %p does not belong to free list %d\n", (void*)b, c);
+                errors++;
+            }
+            listed++;
+        }
+    }
+    if (listed != indexed)
+    {
+        printf("Error: Free lists hold %zu blocks, expected %zu\n", listed, indexed);
+        errors++;
+    }
+
+    // The running counters must match the walk
+    if (counted.free_bytes != heap->stats.free_bytes || counted.free_blocks != heap->stats.free_blocks)
+    {
+        printf("Error: Counters report %zu free bytes in %zu blocks, found %zu in %zu\n", heap->stats.free_bytes,
+               heap->stats.free_blocks, counted.free_bytes, counted.free_blocks);
+        errors++;
+    }
+    if (counted.used_bytes != heap->stats.used_bytes || counted.used_blocks != heap->stats.used_blocks)
+    {
+        printf("Error: Counters report %zu used bytes in %zu blocks, found %zu in %zu\n", heap->stats.used_bytes,
+               heap->stats.used_blocks, counted.used_bytes, counted.used_blocks);
+        errors++;
+    }
+    pthread_mutex_unlock(&heap->lock);
+    printf("Heap integrity: %zu errors\n", errors);
+#endif
 }
 
 /**
@@ -459,30 +1490,35 @@ void check_heap(void* data)
  */
 void memory_usage()
 {
-    size_t total_allocated = 0;
-    size_t total_free = 0;
+    struct mem_usage usage;
+    memory_stats(&usage);
 
-    t_block current = base;
-    while (current)
+    printf("\033[1;34mMemory Usage Report:\033[0m\n");
+    printf("total memory used: %zu bytes\n", usage.used_bytes + usage.free_bytes);
+    printf("Total allocated memory: %zu bytes in %zu blocks\n", usage.used_bytes, usage.used_blocks);
+    printf("Total free memory: %zu bytes in %zu blocks\n", usage.free_bytes, usage.free_blocks);
+}
+
+/**
+ * @brief Copia los contadores del heap y busca las clases más grandes con bloques.
+ */
+void memory_stats(struct mem_usage* usage)
+{
+    pthread_mutex_lock(&heap->lock);
+    usage->free_bytes = heap->stats.free_bytes;
+    usage->used_bytes = heap->stats.used_bytes;
+    usage->free_blocks = heap->stats.free_blocks;
+    usage->used_blocks = heap->stats.used_blocks;
+    usage->largest_free_class = -1;
+    usage->largest_used_class = -1;
+    for (int c = SEG_CLASSES - 1; c >= 0 && (usage->largest_free_class < 0 || usage->largest_used_class < 0); c--)
     {
-        if (current->free)
-        {
-            total_free += current->size;
-        }
-        else
-        {
-            total_allocated += current->size;
-        }
-        printf("bloque de memoria reservado de: %ld bytes\n", current->size);
-        printf("prev: %p\n", (void*)current->prev);
-        printf("next: %p\n", (void*)current->next);
-        current = current->next;
+        if (usage->largest_free_class < 0 && heap->stats.free_class_count[c])
+            usage->largest_free_class = c;
+        if (usage->largest_used_class < 0 && heap->stats.used_class_count[c])
+            usage->largest_used_class = c;
     }
-
-    printf("\033[1;34mMemory Usage Report:\033[0m\n");
-    printf("total memory used: %zu bytes\n", total_allocated + total_free);
-    printf("Total allocated memory: %zu bytes\n", total_allocated);
-    printf("Total free memory: %zu bytes\n", total_free);
+    pthread_mutex_unlock(&heap->lock);
 }
 
 /**
@@ -490,67 +1526,58 @@ void memory_usage()
  */
 void mem_trim()
 {
-    t_block current = base;
+    // Los bloques de la caché están ocupados para el heap y se liberarían dos veces
+    if (tcache.heap == heap)
+        mem_cache_flush();
+
+    pthread_mutex_lock(&heap->lock);
+    t_block current = heap->base;
     while (current)
     {
         if (!current->free)
         {
-            my_free(current->ptr); // Libera el bloque si no está marcado como libre
+            // Liberar puede fusionar o desmapear bloques, así que se vuelve a recorrer desde el inicio
+            mem_trace_log(ALLOC_TYPE_FREE, current->data, NULL, 0);
+            free_block(current);
+            current = heap->base;
         }
-        fusion(current);
-        if (!current->next)
+        else
         {
-            base = NULL;
+            current = current->next;
         }
-        current = current->next;
     }
-}
-
-/**
- * @brief Maneja el registro de llamadas a funciones de asignación de memoria.
- */
-void log_handler(const char* func_name, alloc_type type, void* ptr, size_t size)
-{
-    if (log_file == NULL)
-        log_file = fopen("log.txt", "a");
 
-    if (log_file == NULL)
+    // Sin arena quedan bloques libres; cada uno fusionado es uno o más mapeos completos
+    for (current = heap->base; current; current = current->next)
     {
-        perror("Error al abrir el archivo de log");
-        return;
+        fusion(current);
     }
-    log_function_call(func_name, type, ptr, size);
+    while (heap->base)
+    {
+        current = heap->base;
+        heap->base = current->next;
+        munmap(current, BLOCK_SIZE + current->size);
+    }
+    heap->tail = NULL;
+    seg_reset();
+    pthread_mutex_unlock(&heap->lock);
 }
 
 /**
- * @brief Registra en un archivo de log una llamada a una función relacionada con la memoria.
- *
- * Esta función escribe información detallada sobre una llamada a funciones de asignación
- * o liberación de memoria, incluyendo la hora del evento, el tipo de asignación, el puntero afectado
- * y el tamaño involucrado.
- *
- * @note La función asume que el archivo de log `log_file` está correctamente inicializado y abierto.
+ * @brief Maneja el registro de llamadas a funciones de asignación de memoria.
  */
-void log_function_call(const char* func_name, alloc_type type, void* ptr, size_t size)
+void log_handler(const char* func_name, alloc_type type, void* ptr, size_t size)
 {
-    // Obtener la hora actual para incluirla en el log
-    time_t now = time(NULL);
-    struct tm* t = localtime(&now);
-
-    // Escribir el nombre de la función y la fecha/hora en el archivo
-    fprintf(log_file, "[%04d-%02d-%02d %02d:%02d:%02d] Llamada a %s\n", t->tm_year + 1900, t->tm_mon + 1, t->tm_mday,
-            t->tm_hour, t->tm_min, t->tm_sec, func_name);
-
-    // Agregar información adicional sobre la asignación
-    fprintf(log_file, "Tipo de asignación: %d, Puntero: %p, Tamaño: %zu\n", type, ptr, size);
+    (void)func_name;
+    mem_trace_log(type, ptr, NULL, size);
 }
 
 /**
- * @brief Cierra el archivo de log.
+ * @brief Cierra la traza de memoria.
  */
 void log_close()
 {
-    fclose(log_file);
+    mem_trace_close();
 }
 
 /**
@@ -559,26 +1586,22 @@ void log_close()
  */
 double external_frag()
 {
-    t_block current = base;
+    // Los bloques de la caché del hilo se devuelven para que cuenten como libres
+    if (tcache.heap == heap)
+        mem_cache_flush();
+
+    pthread_mutex_lock(&heap->lock);
+    // Un bloque libre de una clase menor que la del mayor ocupado no alcanza para repetir ese pedido
+    int top = SEG_CLASSES - 1;
+    while (top >= 0 && !heap->stats.used_class_count[top])
+        top--;
     double total_free = 0;
-    double total = 0;
-    size_t maxs = 0;
-    while (current)
-    {
-        if (!current->free && maxs < current->size)
-            maxs = current->size;
-        current = current->next;
-    }
-    current = base;
-    while (current)
-    {
-        if (current->free && current->size < maxs)
-        {
-            total_free += current->size;
-        }
-        total += current->size;
-        current = current->next;
-    }
+    for (int c = 0; c < top; c++)
+        total_free += heap->stats.free_class_bytes[c];
+    double total = (double)heap->stats.free_bytes + (double)heap->stats.used_bytes;
+    pthread_mutex_unlock(&heap->lock);
+    if (total == 0)
+        return 0;
     double frag = (total_free / total) * 100;
     return frag;
 }
@@ -0,0 +1,65 @@
+/**
+ * @file mem_trace_replay.c
+ * @brief Convierte una traza del asignador a texto o la reproduce con cada política.
+ *
+ * Uso:
+ *   mem_trace_replay text ARCHIVO
+ *   mem_trace_replay sim ARCHIVO [METODO]
+ *
+ * Sin METODO, "sim" reproduce la traza con las cuatro políticas de set_method().
+ */
+
+#include <mem_trace.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Nombres de las políticas en el orden de set_method().
+ */
+static const char* const method_names[] = {"first_fit", "best_fit", "worst_fit", "segregated_fit"};
+
+/**
+ * @brief Reproduce la traza con una política y escribe el resultado.
+ */
+static int replay(const char* path, int method)
+{
+    struct mem_trace_replay_stats stats;
+    if (mem_trace_replay(path, method, &stats) != 0)
+        return -1;
+    printf("%-15s ops=%llu failed=%llu ns_per_op=%.1f frag=%.4f\n", method_names[method], stats.ops, stats.failed,
+           stats.ns_per_op, stats.frag);
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 3 || (strcmp(argv[1], "text") != 0 && strcmp(argv[1], "sim") != 0))
+    {
+        fprintf(stderr, "Uso: %s text ARCHIVO | sim ARCHIVO [METODO]\n", argv[0]);
+        return 2;
+    }
+
+    // Esta herramienta no debe pisar la traza que está leyendo
+    setenv(MEM_TRACE_FILE_ENV, "", 1);
+
+    if (strcmp(argv[1], "text") == 0)
+        return mem_trace_print(argv[2], stdout) == 0 ? 0 : 1;
+
+    if (argc > 3)
+    {
+        int method = atoi(argv[3]);
+        if (method < FIRST_FIT || method > SEGREGATED_FIT)
+        {
+            fprintf(stderr, "Método inválido: %s\n", argv[3]);
+            return 2;
+        }
+        return replay(argv[2], method) == 0 ? 0 : 1;
+    }
+    for (int m = FIRST_FIT; m <= SEGREGATED_FIT; m++)
+    {
+        if (replay(argv[2], m) != 0)
+            return 1;
+    }
+    return 0;
+}
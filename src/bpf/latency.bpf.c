@@ -0,0 +1,201 @@
+/**
+ * @file latency.bpf.c
+ * @brief Programa eBPF que mide la latencia de la cola de ejecución y de los fallos de página.
+ *
+ * Se compila con clang para el destino bpf contra el vmlinux.h del kernel
+ * (CO-RE), así que el mismo objeto carga en kernels con otra disposición de
+ * task_struct. Los histogramas son un arreglo por CPU: cada evento actualiza
+ * la copia de su CPU sin operaciones atómicas y bpf_latency.c las suma.
+ */
+
+#include "vmlinux.h"
+#include <bpf/bpf_core_read.h>
+#include <bpf/bpf_helpers.h>
+#include <bpf/bpf_tracing.h>
+
+#include "bpf_latency.h"
+
+/**
+ * @brief Estado de una tarea que sigue lista para ejecutarse.
+ */
+#define TASK_RUNNING 0
+
+/**
+ * @brief Tareas o hilos en espera seguidos a la vez.
+ */
+#define PENDING_MAX 10240
+
+char LICENSE[] SEC("license") = "GPL";
+
+/**
+ * @brief Instante en que cada tarea quedó lista, por pid.
+ */
+struct
+{
+    __uint(type, BPF_MAP_TYPE_HASH);
+    __uint(max_entries, PENDING_MAX);
+    __type(key, u32);
+    __type(value, u64);
+} runqueue_start SEC(".maps");
+
+/**
+ * @brief Instante en que cada hilo entró al manejo de un fallo de página, por tid.
+ */
+struct
+{
+    __uint(type, BPF_MAP_TYPE_HASH);
+    __uint(max_entries, PENDING_MAX);
+    __type(key, u32);
+    __type(value, u64);
+} fault_start SEC(".maps");
+
+/**
+ * @brief Histogramas por CPU, indexados por @ref bpf_latency_kind.
+ */
+struct
+{
+    __uint(type, BPF_MAP_TYPE_PERCPU_ARRAY);
+    __uint(max_entries, BPF_LATENCY_KIND_COUNT);
+    __type(key, u32);
+    __type(value, struct bpf_latency_slots);
+} histograms SEC(".maps");
+
+/**
+ * @brief task_struct antes de 5.14, cuando `__state` se llamaba `state`.
+ */
+struct task_struct___pre514
+{
+    long state;
+} __attribute__((preserve_access_index));
+
+/**
+ * @brief Estado de una tarea en cualquier versión del kernel.
+ */
+static __always_inline long task_state(struct task_struct* t)
+{
+    if (bpf_core_field_exists(t->__state))
+    {
+        return BPF_CORE_READ(t, __state);
+    }
+    return BPF_CORE_READ((struct task_struct___pre514*)t, state);
+}
+
+/**
+ * @brief Logaritmo en base 2 truncado, sin bucles para el verificador.
+ */
+static __always_inline u32 log2_u64(u64 v)
+{
+    u32 r = (v > 0xffffffffULL) << 5;
+    v >>= r;
+    u32 shift = (v > 0xffff) << 4;
+    v >>= shift;
+    r |= shift;
+    shift = (v > 0xff) << 3;
+    v >>= shift;
+    r |= shift;
+    shift = (v > 0xf) << 2;
+    v >>= shift;
+    r |= shift;
+    shift = (v > 0x3) << 1;
+    v >>= shift;
+    r |= shift;
+    return r | (u32)(v >> 1);
+}
+
+/**
+ * @brief Cuenta una latencia en el histograma de esta CPU.
+ */
+static __always_inline void record(u32 kind, u64 delta_ns)
+{
+    struct bpf_latency_slots* h = bpf_map_lookup_elem(&histograms, &kind);
+    if (h == NULL)
+    {
+        return;
+    }
+    u64 us = delta_ns / 1000;
+    u32 slot = us > 1 ? log2_u64(us) : 0;
+    if (slot >= BPF_LATENCY_SLOTS)
+    {
+        slot = BPF_LATENCY_SLOTS - 1;
+    }
+    h->slots[slot]++;
+    h->sum_ns += delta_ns;
+}
+
+/**
+ * @brief Anota el instante en que una tarea quedó lista.
+ */
+static __always_inline int enqueue(u32 pid)
+{
+    // El pid 0 es la tarea ociosa de cada CPU
+    if (pid == 0)
+    {
+        return 0;
+    }
+    u64 ts = bpf_ktime_get_ns();
+    bpf_map_update_elem(&runqueue_start, &pid, &ts, BPF_ANY);
+    return 0;
+}
+
+SEC("tp_btf/sched_wakeup")
+int BPF_PROG(handle_sched_wakeup, struct task_struct* p)
+{
+    return enqueue(p->pid);
+}
+
+SEC("tp_btf/sched_wakeup_new")
+int BPF_PROG(handle_sched_wakeup_new, struct task_struct* p)
+{
+    return enqueue(p->pid);
+}
+
+SEC("tp_btf/sched_switch")
+int BPF_PROG(handle_sched_switch, bool preempt, struct task_struct* prev, struct task_struct* next)
+{
+    // Una tarea desalojada sigue lista: vuelve a la cola sin pasar por sched_wakeup
+    if (task_state(prev) == TASK_RUNNING)
+    {
+        enqueue(prev->pid);
+    }
+
+    u32 pid = next->pid;
+    u64* start = bpf_map_lookup_elem(&runqueue_start, &pid);
+    if (start == NULL)
+    {
+        return 0;
+    }
+    u64 now = bpf_ktime_get_ns();
+    if (now > *start)
+    {
+        record(BPF_LATENCY_RUNQUEUE, now - *start);
+    }
+    bpf_map_delete_elem(&runqueue_start, &pid);
+    return 0;
+}
+
+SEC("fentry/handle_mm_fault")
+int BPF_PROG(handle_fault_entry)
+{
+    u32 tid = (u32)bpf_get_current_pid_tgid();
+    u64 ts = bpf_ktime_get_ns();
+    bpf_map_update_elem(&fault_start, &tid, &ts, BPF_ANY);
+    return 0;
+}
+
+SEC("fexit/handle_mm_fault")
+int BPF_PROG(handle_fault_exit)
+{
+    u32 tid = (u32)bpf_get_current_pid_tgid();
+    u64* start = bpf_map_lookup_elem(&fault_start, &tid);
+    if (start == NULL)
+    {
+        return 0;
+    }
+    u64 now = bpf_ktime_get_ns();
+    if (now > *start)
+    {
+        record(BPF_LATENCY_PAGE_FAULT, now - *start);
+    }
+    bpf_map_delete_elem(&fault_start, &tid);
+    return 0;
+}
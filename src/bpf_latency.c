@@ -0,0 +1,140 @@
+/**
+ * @file bpf_latency.c
+ * @brief Carga del programa eBPF de latencias y lectura de sus histogramas.
+ *
+ * Sin MONITOR_WITH_BPF solo se compilan las funciones que dejan el colector
+ * desactivado, de modo que el resto del agente no necesita libbpf.
+ */
+
+#include "bpf_latency.h"
+#include <stdio.h>
+
+double bpf_latency_bound(int slot)
+{
+    return (double)(1ULL << (slot + 1)) / 1e6;
+}
+
+#ifdef MONITOR_WITH_BPF
+
+#include "latency.skel.h"
+#include <bpf/bpf.h>
+#include <bpf/libbpf.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Programa cargado, o NULL si el colector no está activo.
+ */
+static struct latency_bpf* skel;
+
+/**
+ * @brief Copia de cada CPU de un histograma, para bpf_map_lookup_elem().
+ */
+static struct bpf_latency_slots* percpu;
+
+/**
+ * @brief CPUs posibles; los mapas por CPU tienen una copia para cada una.
+ */
+static int cpu_count;
+
+int bpf_latency_init()
+{
+    cpu_count = libbpf_num_possible_cpus();
+    if (cpu_count <= 0)
+    {
+        fprintf(stderr, "Error al obtener la cantidad de CPUs para eBPF\n");
+        return -1;
+    }
+    percpu = calloc((size_t)cpu_count, sizeof(*percpu));
+    if (percpu == NULL)
+    {
+        fprintf(stderr, "Error al reservar los histogramas de eBPF\n");
+        return -1;
+    }
+
+    // Falla sin CAP_BPF y CAP_PERFMON o si el kernel no expone BTF en /sys/kernel/btf/vmlinux
+    skel = latency_bpf__open_and_load();
+    if (skel == NULL)
+    {
+        fprintf(stderr, "Error al cargar el programa eBPF de latencias\n");
+        bpf_latency_close();
+        return -1;
+    }
+    if (latency_bpf__attach(skel) != 0)
+    {
+        fprintf(stderr, "Error al enganchar el programa eBPF de latencias\n");
+        bpf_latency_close();
+        return -1;
+    }
+    return 0;
+}
+
+int bpf_latency_enabled()
+{
+    return skel != NULL;
+}
+
+int bpf_latency_update(struct bpf_latency* out)
+{
+    if (skel == NULL)
+    {
+        return -1;
+    }
+
+    int fd = bpf_map__fd(skel->maps.histograms);
+    for (unsigned int kind = 0; kind < BPF_LATENCY_KIND_COUNT; kind++)
+    {
+        if (bpf_map_lookup_elem(fd, &kind, percpu) != 0)
+        {
+            return -1;
+        }
+
+        // El total sale de las cubetas para que coincida con la última aunque una CPU escriba mientras se lee
+        struct bpf_latency_histogram* h = &out->hist[kind];
+        unsigned long long sum_ns = 0;
+        memset(h, 0, sizeof(*h));
+        for (int cpu = 0; cpu < cpu_count; cpu++)
+        {
+            for (int i = 0; i < BPF_LATENCY_SLOTS; i++)
+            {
+                h->buckets[i] += percpu[cpu].slots[i];
+                h->count += percpu[cpu].slots[i];
+            }
+            sum_ns += percpu[cpu].sum_ns;
+        }
+        h->sum = (double)sum_ns / 1e9;
+    }
+    return 0;
+}
+
+void bpf_latency_close()
+{
+    latency_bpf__destroy(skel);
+    skel = NULL;
+    free(percpu);
+    percpu = NULL;
+}
+
+#else
+
+int bpf_latency_init()
+{
+    return -1;
+}
+
+int bpf_latency_enabled()
+{
+    return 0;
+}
+
+int bpf_latency_update(struct bpf_latency* out)
+{
+    (void)out;
+    return -1;
+}
+
+void bpf_latency_close()
+{
+}
+
+#endif
@@ -0,0 +1,542 @@
+/**
+ * @file cgroup.c
+ * @brief Implementación del colector de cgroups v2.
+ *
+ * Los cgroups seguidos se guardan en un arreglo con sus lectores abiertos. Al
+ * recorrer el árbol otra vez, los que siguen existiendo conservan sus
+ * descriptores y sus contadores anteriores; solo se abren los nuevos y se
+ * cierran los que desaparecieron.
+ */
+
+#include "cgroup.h"
+#include "proc_parse.h"
+#include "proc_reader.h"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * @brief Archivos que se leen de cada cgroup.
+ */
+enum cgroup_file
+{
+    CGROUP_FILE_CPU_STAT,       /**< cpu.stat */
+    CGROUP_FILE_MEMORY_CURRENT, /**< memory.current */
+    CGROUP_FILE_MEMORY_STAT,    /**< memory.stat */
+    CGROUP_FILE_IO_STAT,        /**< io.stat */
+    CGROUP_FILE_COUNT           /**< Cantidad de archivos. */
+};
+
+/**
+ * @brief Nombre de cada archivo, indexado por @ref cgroup_file.
+ */
+static const char* const file_names[CGROUP_FILE_COUNT] = {
+    [CGROUP_FILE_CPU_STAT] = "cpu.stat",
+    [CGROUP_FILE_MEMORY_CURRENT] = "memory.current",
+    [CGROUP_FILE_MEMORY_STAT] = "memory.stat",
+    [CGROUP_FILE_IO_STAT] = "io.stat",
+};
+
+/**
+ * @brief Contadores acumulados de los que se calculan tasas.
+ */
+enum cgroup_counter
+{
+    CGROUP_COUNTER_USAGE,     /**< usage_usec de cpu.stat. */
+    CGROUP_COUNTER_THROTTLED, /**< throttled_usec de cpu.stat. */
+    CGROUP_COUNTER_RBYTES,    /**< Suma de rbytes de io.stat. */
+    CGROUP_COUNTER_WBYTES,    /**< Suma de wbytes de io.stat. */
+    CGROUP_COUNTER_COUNT      /**< Cantidad de contadores. */
+};
+
+/**
+ * @brief Un cgroup seguido, con sus archivos abiertos.
+ */
+struct cgroup_entry
+{
+    char name[CGROUP_NAME_LEN];                        /**< Ruta relativa a la raíz; vacía si la celda está libre. */
+    struct proc_reader files[CGROUP_FILE_COUNT];       /**< Lectores; fd es -1 si el controlador no está habilitado. */
+    char* paths[CGROUP_FILE_COUNT];                    /**< Rutas absolutas de los lectores. */
+    unsigned long long counters[CGROUP_COUNTER_COUNT]; /**< Contadores de la lectura anterior. */
+    int primed;                                        /**< Distinto de 0 si `counters` tiene una lectura. */
+    int stale;                                         /**< Distinto de 0 si el cgroup se borró; no se reutiliza. */
+};
+
+/**
+ * @brief Raíz de la jerarquía, o vacía si el colector no está iniciado.
+ */
+static char root[PATH_MAX];
+
+/**
+ * @brief Cgroups seguidos.
+ */
+static struct cgroup_entry entries[CGROUP_MAX];
+
+/**
+ * @brief Cgroups encontrados en el recorrido en curso.
+ */
+static struct cgroup_entry scratch[CGROUP_MAX];
+
+/**
+ * @brief Cgroups válidos en `entries`.
+ */
+static size_t entry_count;
+
+/**
+ * @brief Cgroups que el último recorrido encontró pero no sigue.
+ */
+static size_t dropped_count;
+
+/**
+ * @brief Distinto de 0 si ya se avisó que se omitieron cgroups.
+ */
+static int dropped_warned;
+
+/**
+ * @brief Descriptor de inotify, o -1 si se recorre el árbol cada @ref CGROUP_RESCAN_TICKS.
+ */
+static int inotify_fd = -1;
+
+/**
+ * @brief Distinto de 0 si hay que recorrer el árbol antes de la próxima lectura.
+ */
+static int dirty;
+
+/**
+ * @brief Lecturas desde el último recorrido.
+ */
+static unsigned ticks_since_scan;
+
+/**
+ * @brief Instante de la lectura anterior en CLOCK_MONOTONIC, o 0 si no hubo.
+ */
+static unsigned long long previous_ns;
+
+/**
+ * @brief Devuelve el tiempo de CLOCK_MONOTONIC en nanosegundos.
+ */
+static unsigned long long now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + (unsigned long long)ts.tv_nsec;
+}
+
+/**
+ * @brief Indica si un directorio es la raíz de una jerarquía cgroup v2.
+ */
+static int is_cgroup2_root(const char* path)
+{
+    char controllers[PATH_MAX];
+    snprintf(controllers, sizeof(controllers), "%s/cgroup.controllers", path);
+    return access(controllers, R_OK) == 0;
+}
+
+/**
+ * @brief Abre los archivos de un cgroup nuevo.
+ *
+ * Los archivos de un controlador que no está habilitado en el cgroup no
+ * existen; su lector queda cerrado y su valor en 0.
+ */
+static void entry_open(struct cgroup_entry* e)
+{
+    for (int f = 0; f < CGROUP_FILE_COUNT; f++)
+    {
+        size_t len = strlen(root) + strlen(e->name) + strlen(file_names[f]) + 3;
+        e->paths[f] = malloc(len);
+        e->files[f] = (struct proc_reader){.path = e->paths[f], .fd = -1};
+        if (e->paths[f] == NULL)
+        {
+            fprintf(stderr, "Error al reservar la ruta de %s\n", e->name);
+            continue;
+        }
+        snprintf(e->paths[f], len, "%s/%s/%s", root, e->name, file_names[f]);
+        if (access(e->paths[f], R_OK) == 0)
+        {
+            proc_reader_open(&e->files[f], e->paths[f]);
+        }
+    }
+    e->primed = 0;
+    e->stale = 0;
+}
+
+/**
+ * @brief Cierra los archivos de un cgroup y libera la celda.
+ */
+static void entry_close(struct cgroup_entry* e)
+{
+    for (int f = 0; f < CGROUP_FILE_COUNT; f++)
+    {
+        proc_reader_close(&e->files[f]);
+        free(e->paths[f]);
+        e->paths[f] = NULL;
+    }
+    e->name[0] = '\0';
+}
+
+/**
+ * @brief Recorre un directorio de la jerarquía, agregando sus subdirectorios a `scratch`.
+ *
+ * @param fd Descriptor del directorio; se cierra aquí.
+ * @param rel Ruta del directorio relativa a la raíz, vacía para la raíz.
+ * Pasado @ref CGROUP_MAX el recorrido sigue, pero los cgroups solo se cuentan
+ * en @ref dropped_count, de modo que la cantidad omitida se exporta.
+ *
+ * @param depth Nivel del directorio; la raíz es 0.
+ * @param found Cgroups agregados hasta ahora.
+ */
+static void walk(int fd, const char* rel, int depth, size_t* found)
+{
+    DIR* dir = fdopendir(fd);
+    if (dir == NULL)
+    {
+        close(fd);
+        return;
+    }
+
+    if (inotify_fd >= 0)
+    {
+        char path[PATH_MAX];
+        int len = snprintf(path, sizeof(path), "%s/%s", root, rel);
+        // Una ruta truncada vigilaría otro directorio: se deja este sin vigilar
+        if (len >= 0 && (size_t)len < sizeof(path))
+        {
+            inotify_add_watch(inotify_fd, path, IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR);
+        }
+    }
+
+    struct dirent* de;
+    while ((de = readdir(dir)) != NULL)
+    {
+        if (de->d_name[0] == '.')
+        {
+            continue;
+        }
+        if (de->d_type != DT_DIR)
+        {
+            struct stat st;
+            if (de->d_type != DT_UNKNOWN || fstatat(dirfd(dir), de->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0 ||
+                !S_ISDIR(st.st_mode))
+            {
+                continue;
+            }
+        }
+
+        char name[CGROUP_NAME_LEN];
+        int len = snprintf(name, sizeof(name), "%s%s%s", rel, rel[0] ? "/" : "", de->d_name);
+        if (len < 0 || (size_t)len >= sizeof(name))
+        {
+            // CGROUP_NAME_LEN alcanza para cualquier ruta de CGROUP_MAX_DEPTH niveles; no debería pasar
+            dropped_count++;
+            continue;
+        }
+        if (*found < CGROUP_MAX)
+        {
+            memcpy(scratch[*found].name, name, (size_t)len + 1);
+            (*found)++;
+        }
+        else
+        {
+            dropped_count++;
+        }
+
+        if (depth + 1 < CGROUP_MAX_DEPTH)
+        {
+            int child = openat(dirfd(dir), de->d_name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+            if (child >= 0)
+            {
+                walk(child, name, depth + 1, found);
+            }
+        }
+    }
+    closedir(dir);
+}
+
+/**
+ * @brief Recorre el árbol y actualiza los cgroups seguidos, reutilizando los que siguen existiendo.
+ */
+static void rescan()
+{
+    size_t found = 0;
+
+    // Las vigilancias se crean de nuevo sobre los directorios de este recorrido
+    if (inotify_fd >= 0)
+    {
+        close(inotify_fd);
+    }
+    inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+    dropped_count = 0;
+    int fd = open(root, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        fprintf(stderr, "Error al abrir %s: %s\n", root, strerror(errno));
+    }
+    else
+    {
+        walk(fd, "", 0, &found);
+    }
+    if (dropped_count > 0 && !dropped_warned)
+    {
+        fprintf(stderr, "Se omiten %zu cgroups: solo se siguen los primeros %d del recorrido\n", dropped_count,
+                CGROUP_MAX);
+        dropped_warned = 1;
+    }
+
+    for (size_t i = 0; i < found; i++)
+    {
+        struct cgroup_entry* e = &scratch[i];
+        size_t j = 0;
+        while (j < entry_count && (entries[j].stale || strcmp(entries[j].name, e->name) != 0))
+        {
+            j++;
+        }
+        if (j < entry_count)
+        {
+            *e = entries[j];
+            entries[j].name[0] = '\0';
+        }
+        else
+        {
+            entry_open(e);
+        }
+    }
+    for (size_t j = 0; j < entry_count; j++)
+    {
+        if (entries[j].name[0] != '\0')
+        {
+            entry_close(&entries[j]);
+        }
+    }
+
+    memcpy(entries, scratch, found * sizeof(entries[0]));
+    entry_count = found;
+    dirty = 0;
+    ticks_since_scan = 0;
+}
+
+/**
+ * @brief Consume los eventos de inotify pendientes.
+ *
+ * @return Distinto de 0 si se creó o se borró algún cgroup.
+ */
+static int tree_changed()
+{
+    if (inotify_fd < 0)
+    {
+        return ++ticks_since_scan >= CGROUP_RESCAN_TICKS;
+    }
+
+    char events[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    int changed = 0;
+    while (read(inotify_fd, events, sizeof(events)) > 0)
+    {
+        changed = 1;
+    }
+    return changed;
+}
+
+/**
+ * @brief Lee un archivo de un cgroup.
+ *
+ * @return Contenido, o NULL si el controlador no está habilitado o el cgroup se borró.
+ */
+static const char* entry_read(struct cgroup_entry* e, enum cgroup_file f)
+{
+    if (e->files[f].fd < 0)
+    {
+        return NULL;
+    }
+    if (proc_reader_read(&e->files[f]) < 0)
+    {
+        // Un cgroup borrado devuelve ENODEV: se vuelve a recorrer el árbol en la próxima lectura
+        e->stale = 1;
+        dirty = 1;
+        return NULL;
+    }
+    return e->files[f].buf;
+}
+
+/**
+ * @brief Suma los campos "key=valor" de todos los dispositivos de io.stat.
+ */
+static void parse_io_stat(const char* p, unsigned long long* rbytes, unsigned long long* wbytes)
+{
+    *rbytes = 0;
+    *wbytes = 0;
+    for (; p != NULL; p = parse_next_line(p))
+    {
+        // Cada línea es "MAYOR:MENOR rbytes=... wbytes=... rios=... ..."
+        const char* field = parse_skip_fields(p, 1);
+        while (field != NULL && *(field = parse_skip_spaces(field)) != '\0' && *field != '\n')
+        {
+            unsigned long long value;
+            const char* v;
+            if ((v = PARSE_KEY(field, "rbytes=")) != NULL && (field = parse_u64(v, &value)) != NULL)
+            {
+                *rbytes += value;
+            }
+            else if ((v = PARSE_KEY(field, "wbytes=")) != NULL && (field = parse_u64(v, &value)) != NULL)
+            {
+                *wbytes += value;
+            }
+            else
+            {
+                field = parse_skip_fields(field, 1);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Lee los archivos de un cgroup y calcula sus valores.
+ *
+ * @param e Cgroup a leer.
+ * @param elapsed Segundos desde la lectura anterior, o 0 si no hubo.
+ * @param out Recibe los valores.
+ */
+static void entry_sample(struct cgroup_entry* e, double elapsed, struct cgroup_sample* out)
+{
+    unsigned long long counters[CGROUP_COUNTER_COUNT] = {0};
+    unsigned long long value;
+    const char* text;
+
+    memset(out->value, 0, sizeof(out->value));
+    memcpy(out->name, e->name, strlen(e->name) + 1);
+
+    if ((text = entry_read(e, CGROUP_FILE_CPU_STAT)) != NULL)
+    {
+        for (const char* line = text; line != NULL; line = parse_next_line(line))
+        {
+            const char* v;
+            if ((v = PARSE_KEY(line, "usage_usec ")) != NULL && parse_u64(v, &value) != NULL)
+            {
+                counters[CGROUP_COUNTER_USAGE] = value;
+            }
+            else if ((v = PARSE_KEY(line, "throttled_usec ")) != NULL && parse_u64(v, &value) != NULL)
+            {
+                counters[CGROUP_COUNTER_THROTTLED] = value;
+            }
+        }
+    }
+    if ((text = entry_read(e, CGROUP_FILE_MEMORY_CURRENT)) != NULL && parse_u64(text, &value) != NULL)
+    {
+        out->value[CGROUP_MEMORY_BYTES] = (double)value;
+    }
+    if ((text = entry_read(e, CGROUP_FILE_MEMORY_STAT)) != NULL)
+    {
+        for (const char* line = text; line != NULL; line = parse_next_line(line))
+        {
+            const char* v;
+            if ((v = PARSE_KEY(line, "anon ")) != NULL && parse_u64(v, &value) != NULL)
+            {
+                out->value[CGROUP_MEMORY_ANON] = (double)value;
+            }
+            else if ((v = PARSE_KEY(line, "file ")) != NULL && parse_u64(v, &value) != NULL)
+            {
+                out->value[CGROUP_MEMORY_FILE] = (double)value;
+            }
+        }
+    }
+    if ((text = entry_read(e, CGROUP_FILE_IO_STAT)) != NULL)
+    {
+        parse_io_stat(text, &counters[CGROUP_COUNTER_RBYTES], &counters[CGROUP_COUNTER_WBYTES]);
+    }
+
+    if (e->primed && elapsed > 0)
+    {
+        double delta[CGROUP_COUNTER_COUNT];
+        for (int c = 0; c < CGROUP_COUNTER_COUNT; c++)
+        {
+            // Un contador que baja solo puede ser un cgroup recreado con el mismo nombre
+            delta[c] = counters[c] >= e->counters[c] ? (double)(counters[c] - e->counters[c]) : 0.0;
+        }
+        out->value[CGROUP_CPU_USAGE] = delta[CGROUP_COUNTER_USAGE] / 1e6 / elapsed * 100.0;
+        out->value[CGROUP_CPU_THROTTLED] = delta[CGROUP_COUNTER_THROTTLED] / 1e6 / elapsed * 100.0;
+        out->value[CGROUP_IO_READ] = delta[CGROUP_COUNTER_RBYTES] / elapsed;
+        out->value[CGROUP_IO_WRITE] = delta[CGROUP_COUNTER_WBYTES] / elapsed;
+    }
+    memcpy(e->counters, counters, sizeof(counters));
+    e->primed = 1;
+}
+
+int cgroup_init()
+{
+    const char* env = getenv(CGROUP_ROOT_ENV);
+    const char* path = env != NULL ? env : CGROUP_DEFAULT_ROOT;
+
+    if (!is_cgroup2_root(path) && env == NULL && is_cgroup2_root(CGROUP_HYBRID_ROOT))
+    {
+        path = CGROUP_HYBRID_ROOT;
+    }
+    if (!is_cgroup2_root(path))
+    {
+        fprintf(stderr, "No hay una jerarquía cgroup v2 en %s\n", path);
+        return -1;
+    }
+
+    snprintf(root, sizeof(root), "%s", path);
+    rescan();
+    return 0;
+}
+
+int cgroup_enabled()
+{
+    return root[0] != '\0';
+}
+
+int cgroup_update(struct cgroup_stats* out)
+{
+    if (!cgroup_enabled())
+    {
+        return -1;
+    }
+    if (tree_changed() || dirty)
+    {
+        rescan();
+    }
+
+    unsigned long long ts = now_ns();
+    double elapsed = previous_ns != 0 ? (double)(ts - previous_ns) / 1e9 : 0.0;
+
+    out->count = 0;
+    out->dropped = dropped_count;
+    for (size_t i = 0; i < entry_count; i++)
+    {
+        entry_sample(&entries[i], elapsed, &out->cgroups[out->count]);
+        if (!entries[i].stale)
+        {
+            out->count++;
+        }
+    }
+    previous_ns = ts;
+    return 0;
+}
+
+void cgroup_close()
+{
+    for (size_t i = 0; i < entry_count; i++)
+    {
+        entry_close(&entries[i]);
+    }
+    entry_count = 0;
+    dropped_count = 0;
+    dropped_warned = 0;
+    if (inotify_fd >= 0)
+    {
+        close(inotify_fd);
+        inotify_fd = -1;
+    }
+    root[0] = '\0';
+    previous_ns = 0;
+    dirty = 0;
+    ticks_since_scan = 0;
+}
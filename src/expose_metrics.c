@@ -11,401 +11,1347 @@
 #include "expose_metrics.h"
 
 /**
- * @brief Mutex para sincronización de hilos.
+ * @brief Contador de ticks salteados por el planificador, etiquetado por colector.
  */
-pthread_mutex_t lock;
+static prom_counter_t* skipped_ticks_metric;
 
 /**
- * @brief Métrica de Prometheus para el uso de CPU.
+ * @brief Duración de la última ejecución de cada colector, etiquetada por colector.
  */
-static prom_gauge_t* cpu_usage_metric;
+static prom_gauge_t* collector_latency_metric;
 
 /**
- * @brief Métrica de Prometheus para el uso de memoria.
+ * @brief Duración de la última lectura de cada fuente de /proc, etiquetada por fuente.
  */
-static prom_gauge_t* memory_usage_metric;
+static prom_gauge_t* source_latency_metric;
 
 /**
- * @brief Métrica de Prometheus para el uso de disco.
+ * @brief Etiquetas "source", indexadas por @ref proc_source.
  */
-static prom_gauge_t* disk_usage_metric;
+static const char* const source_labels[PROC_SOURCE_COUNT] = {
+    [PROC_STAT] = "stat",
+    [PROC_MEMINFO] = "meminfo",
+    [PROC_VMSTAT] = "vmstat",
+    [PROC_DISKSTATS] = "diskstats",
+    [PROC_NET_DEV] = "net_dev",
+};
 
 /**
- * @brief Métrica de Prometheus para el uso de red.
+ * @brief Métrica de Prometheus para el uso de cada CPU por modo.
  */
-static prom_gauge_t* network_usage_metric;
+static prom_gauge_t* cpu_mode_usage_metric;
 
 /**
- * @brief Métrica de Prometheus que representa el uso de ancho de banda en la
- * red.
+ * @brief Etiquetas "cpu" precalculadas para no formatearlas en cada tick.
  */
-static prom_gauge_t* bandwidth_usage_metric;
+static char cpu_labels[MAX_CPUS][8];
 
 /**
- * @brief Métrica de Prometheus para los fallos de página mayores.
+ * @brief Etiquetas "mode", indexadas por @ref cpu_mode.
  */
-static prom_gauge_t* major_page_faults_metric;
+static const char* const cpu_mode_labels[CPU_MODE_COUNT] = {
+    [CPU_MODE_USER] = "user",
+    [CPU_MODE_SYSTEM] = "system",
+    [CPU_MODE_IOWAIT] = "iowait",
+    [CPU_MODE_STEAL] = "steal",
+};
 
 /**
- * @brief Métrica de Prometheus para los fallos de página menores.
+ * @brief Métrica de Prometheus para los sectores leídos por segundo de cada disco.
  */
-static prom_gauge_t* minor_page_faults_metric;
+static prom_gauge_t* disk_read_sectors_metric;
 
 /**
- * @brief Métrica de Prometheus para los cambios de contexto.
+ * @brief Métrica de Prometheus para los sectores escritos por segundo de cada disco.
  */
-static prom_gauge_t* change_context_metric;
+static prom_gauge_t* disk_write_sectors_metric;
 
 /**
- * @brief Métrica de Prometheus para el total de procesos.
+ * @brief Latencia por operación de cada política del simulador, etiquetada por método.
  */
-static prom_gauge_t* total_processes_metric;
+static prom_gauge_t* alloc_latency_metric;
 
 /**
- * @brief Métrica de Prometheus para estadísticas del disco.
+ * @brief Operaciones por segundo de cada política del simulador, etiquetada por método.
  */
-static prom_gauge_t* disk_stats_metric;
+static prom_gauge_t* alloc_throughput_metric;
 
 /**
- * @brief Métrica de Prometheus para la memoria total.
+ * @brief Etiquetas "method", en el orden de las políticas de malloc_control().
  */
-static prom_gauge_t* memory_total_metric;
+static const char* const alloc_method_labels[SIM_METHOD_COUNT] = {"first_fit", "best_fit", "worst_fit",
+                                                                  "segregated_fit"};
 
 /**
- * @brief Métrica de Prometheus para la memoria disponible.
+ * @brief Nombre y texto de ayuda de una familia de métricas.
+ *
+ * Se comparten entre las métricas de libprom y la exposición pre-renderizada.
  */
-static prom_gauge_t* memory_avalible_metric;
+struct metric_info
+{
+    const char* name; /**< Nombre de la familia. */
+    const char* help; /**< Texto de ayuda. */
+};
 
 /**
- * @brief Métrica de Prometheus para el uso alternativo de memoria.
+ * @brief Convierte un contador de metrics.h, que indica un error con -1, al valor de un gauge.
  */
-static prom_gauge_t* memory_usage_2_metric;
+static double counter_value(unsigned long long value)
+{
+    return value == (unsigned long long)-1 ? -1.0 : (double)value;
+}
 
 /**
- * @brief Métrica de Prometheus para la fragmentación externa con First Fit.
- *
- * Representa un indicador de tipo "gauge" que monitorea la fragmentación externa
- * calculada para el método de asignación de memoria First Fit. La fragmentación
- * externa mide el espacio inutilizable entre bloques asignados.
+ * @brief Lee los cambios de contexto como valor de gauge.
+ */
+static double read_change_context()
+{
+    return counter_value(get_change_context());
+}
+
+/**
+ * @brief Lee los procesos creados como valor de gauge.
+ */
+static double read_total_processes()
+{
+    return counter_value(get_total_processes());
+}
+
+/**
+ * @brief Lee los fallos de página mayores como valor de gauge.
+ */
+static double read_major_page_faults()
+{
+    return counter_value(get_major_page_faults());
+}
+
+/**
+ * @brief Lee los fallos de página menores como valor de gauge.
+ */
+static double read_minor_page_faults()
+{
+    return counter_value(get_minor_page_faults());
+}
+
+/**
+ * @brief Entrada del registro de métricas escalares.
  */
-static prom_gauge_t* external_frag_first_fit_metric;
+struct scalar_metric
+{
+    const char* name;                /**< Nombre de la familia; no lleva etiquetas. */
+    const char* help;                /**< Texto de ayuda. */
+    enum scalar_collector collector; /**< Colector del planificador que la actualiza. */
+    double (*read)();                /**< Devuelve el valor actual, o un valor negativo si falló. */
+    const char* what;                /**< Qué se intentó obtener, para el mensaje de error. */
+};
 
 /**
- * @brief Métrica de Prometheus para la fragmentación externa con Best Fit.
+ * @brief Registro de las métricas escalares, indexado por @ref metric_id.
  *
- * Representa un indicador de tipo "gauge" que monitorea la fragmentación externa
- * calculada para el método de asignación de memoria Best Fit. La fragmentación
- * externa mide el espacio inutilizable entre bloques asignados.
+ * Cada entrada se crea y registra en libprom en init_metrics() y se actualiza
+ * con update_scalar_gauges() cuando corre su colector; el intervalo de cada
+ * colector se configura en la tabla del planificador de main.c.
+ */
+static const struct scalar_metric scalar_registry[METRIC_SCALAR_COUNT] = {
+    [METRIC_CPU_USAGE] = {"cpu_usage_percentage", "Porcentaje de uso de CPU", SCALAR_COLLECT_CPU, get_cpu_usage,
+                          "el uso de CPU"},
+    [METRIC_MEMORY_USAGE] = {"memory_usage_percentage", "Porcentaje de uso de memoria", SCALAR_COLLECT_MEMORY,
+                             get_memory_usage, "el uso de memoria"},
+    [METRIC_DISK_USAGE] = {"disk_usage_percentage", "MB por segundo leídos y escritos en disco", SCALAR_COLLECT_DISK,
+                           get_disk_usage, "el uso del disco"},
+    [METRIC_NETWORK_USAGE] = {"network_usage", "Uso de la red", SCALAR_COLLECT_NETWORK, get_network_usage,
+                              "el uso de la red"},
+    [METRIC_BANDWIDTH_USAGE] = {"bandwidth_usage", "Ancho de banda en uso en MB por segundo", SCALAR_COLLECT_NETWORK,
+                                get_average_bandwidth, "el ancho de banda en uso"},
+    [METRIC_MAJOR_PAGE_FAULTS] = {"major_page_faults", "Número de fallos de página mayores",
+                                  SCALAR_COLLECT_PAGE_FAULTS, read_major_page_faults, "los fallos de página mayores"},
+    [METRIC_MINOR_PAGE_FAULTS] = {"minor_page_faults", "Número de fallos de página menores",
+                                  SCALAR_COLLECT_PAGE_FAULTS, read_minor_page_faults, "los fallos de página menores"},
+    [METRIC_CHANGE_CONTEXT] = {"change_contexts", "Número de cambios de contexto", SCALAR_COLLECT_PROCESSES,
+                               read_change_context, "el número de cambios de contexto"},
+    [METRIC_TOTAL_PROCESSES] = {"total_processes", "Número total de procesos", SCALAR_COLLECT_PROCESSES,
+                                read_total_processes, "el número total de procesos"},
+    [METRIC_DISK_STATS] = {"disk_stats", "Estadísticas del disco", SCALAR_COLLECT_DISK, get_disk_stats,
+                           "las estadísticas del disco"},
+    [METRIC_MEMORY_TOTAL] = {"memory_total", "Memoria total del sistema", SCALAR_COLLECT_MEMORY, get_memory_total,
+                             "la memoria total"},
+    [METRIC_MEMORY_AVALIBLE] = {"memory_available", "Memoria disponible del sistema", SCALAR_COLLECT_MEMORY,
+                                get_memory_avalible, "la memoria disponible"},
+    [METRIC_MEMORY_USAGE_2] = {"memory_usage_2", "Uso de memoria (otra métrica)", SCALAR_COLLECT_MEMORY,
+                               get_memory_usage_2, "el uso de memoria (métrica alternativa)"},
+    [METRIC_FRAG_FIRST_FIT] = {"frag_first_fit", "Fragmentacion de first fit", SCALAR_COLLECT_FRAGMENTATION,
+                               get_external_frag_first_fit, "la fragmentación de first fit"},
+    [METRIC_FRAG_BEST_FIT] = {"frag_best_fit", "Fragmentacion de best fit", SCALAR_COLLECT_FRAGMENTATION,
+                              get_external_frag_best_fit, "la fragmentación de best fit"},
+    [METRIC_FRAG_WORST_FIT] = {"frag_worst_fit", "Fragmentacion de worst fit", SCALAR_COLLECT_FRAGMENTATION,
+                               get_external_frag_worst_fit, "la fragmentación de worst fit"},
+    [METRIC_FRAG_SEGREGATED_FIT] = {"frag_segregated_fit", "Fragmentacion de segregated fit",
+                                    SCALAR_COLLECT_FRAGMENTATION, get_external_frag_segregated_fit,
+                                    "la fragmentación de segregated fit"},
+};
+
+/**
+ * @brief Gauge de libprom de cada entrada de @ref scalar_registry.
+ */
+static prom_gauge_t* scalar_gauges[METRIC_SCALAR_COUNT];
+
+/**
+ * @brief Métricas de cada colector, contiguas, armadas desde @ref scalar_registry en init_metrics().
+ */
+static enum metric_id collector_scalars[SCALAR_COLLECTOR_COUNT][METRIC_SCALAR_COUNT];
+
+/**
+ * @brief Métricas válidas en cada fila de @ref collector_scalars.
+ */
+static size_t collector_scalar_count[SCALAR_COLLECTOR_COUNT];
+
+/**
+ * @brief Nombre y ayuda de la métrica de uso de cada CPU por modo.
+ */
+static const struct metric_info cpu_mode_usage_info = {"cpu_mode_usage_percentage",
+                                                       "Porcentaje de uso de cada CPU por modo"};
+
+/**
+ * @brief Nombre y ayuda de la métrica de sectores leídos por segundo de cada disco.
+ */
+static const struct metric_info disk_read_sectors_info = {"disk_read_sectors_per_second",
+                                                          "Sectores leídos por segundo por disco"};
+
+/**
+ * @brief Nombre y ayuda de la métrica de sectores escritos por segundo de cada disco.
  */
-static prom_gauge_t* external_frag_best_fit_metric;
+static const struct metric_info disk_write_sectors_info = {"disk_write_sectors_per_second",
+                                                           "Sectores escritos por segundo por disco"};
 
 /**
- * @brief Métrica de Prometheus para la fragmentación externa con Worst Fit.
+ * @brief Familias de las métricas de cada interfaz de red.
  *
- * Representa un indicador de tipo "gauge" que monitorea la fragmentación externa
- * calculada para el método de asignación de memoria Worst Fit. La fragmentación
- * externa mide el espacio inutilizable entre bloques asignados.
+ * Cada familia tiene la etiqueta "direction": el contador rx es el de la
+ * misma posición en @ref net_counter y el tx el de la familia más
+ * NET_FAMILY_COUNT.
+ */
+enum net_family
+{
+    NET_FAMILY_BYTES,   /**< Bytes por segundo. */
+    NET_FAMILY_PACKETS, /**< Paquetes por segundo. */
+    NET_FAMILY_ERRORS,  /**< Errores por segundo. */
+    NET_FAMILY_DROPS,   /**< Descartes por segundo. */
+    NET_FAMILY_COUNT    /**< Cantidad de familias. */
+};
+
+_Static_assert(NET_TX_BYTES == NET_RX_BYTES + NET_FAMILY_COUNT && NET_COUNTER_COUNT == 2 * NET_FAMILY_COUNT,
+               "los contadores tx deben seguir a los rx en el mismo orden que las familias");
+
+/**
+ * @brief Nombre y ayuda de cada familia de red, indexados por @ref net_family.
+ */
+static const struct metric_info net_info[NET_FAMILY_COUNT] = {
+    [NET_FAMILY_BYTES] = {"network_interface_bytes_per_second", "Bytes por segundo por interfaz y sentido"},
+    [NET_FAMILY_PACKETS] = {"network_interface_packets_per_second", "Paquetes por segundo por interfaz y sentido"},
+    [NET_FAMILY_ERRORS] = {"network_interface_errors_per_second", "Errores por segundo por interfaz y sentido"},
+    [NET_FAMILY_DROPS] = {"network_interface_drops_per_second", "Descartes por segundo por interfaz y sentido"},
+};
+
+/**
+ * @brief Valores de la etiqueta "direction", el índice es 0 para rx y 1 para tx.
+ */
+static const char* const net_direction_labels[2] = {"receive", "transmit"};
+
+/**
+ * @brief Métricas de Prometheus de cada interfaz, indexadas por @ref net_family.
+ */
+static prom_gauge_t* net_metrics[NET_FAMILY_COUNT];
+
+/**
+ * @brief Nombre y ayuda de la métrica de ticks salteados por el planificador.
+ */
+static const struct metric_info skipped_ticks_info = {"monitor_scheduler_skipped_ticks_total",
+                                                      "Ticks salteados porque el colector se atrasó"};
+
+/**
+ * @brief Nombre y ayuda de la métrica de duración de cada colector.
+ */
+static const struct metric_info collector_latency_info = {"monitor_collector_latency_seconds",
+                                                          "Duración de la última ejecución del colector"};
+
+/**
+ * @brief Nombre y ayuda de la métrica de ticks enviados o descartados por el envío.
+ */
+static const struct metric_info push_samples_info = {"monitor_push_samples_total",
+                                                     "Ticks enviados o descartados por el envío al colector remoto"};
+
+/**
+ * @brief Nombre y ayuda de la métrica de ticks esperando en la cola de envío.
+ */
+static const struct metric_info push_queue_info = {"monitor_push_queue_length", "Ticks esperando en la cola de envío"};
+
+/**
+ * @brief Nombre y ayuda del histograma de duración de cada colector.
+ */
+static const struct metric_info collector_duration_info = {"monitor_collector_duration_seconds",
+                                                           "Duración de las ejecuciones de cada colector"};
+
+/**
+ * @brief Límite superior en segundos de cada cubeta de @ref collector_duration_info.
+ */
+static const double collector_duration_bounds[COLLECTOR_DURATION_BUCKETS] = {
+    0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 1.0,
+};
+
+/**
+ * @brief Nombre y ayuda de la CPU usada por el agente.
+ */
+static const struct metric_info self_cpu_info = {"monitor_cpu_seconds_total",
+                                                 "Segundos de CPU de usuario y de sistema usados por el agente"};
+
+/**
+ * @brief Nombre y ayuda de la memoria residente del agente.
+ */
+static const struct metric_info self_rss_info = {"monitor_resident_memory_bytes", "Memoria residente del agente"};
+
+/**
+ * @brief Nombre y ayuda de las llamadas al sistema de lectura por tick.
+ */
+static const struct metric_info self_syscalls_info = {"monitor_proc_syscalls_per_tick",
+                                                      "Llamadas al sistema para leer /proc y /sys en el último tick"};
+
+/**
+ * @brief Nombre y ayuda de los bytes leídos de /proc.
+ */
+static const struct metric_info self_read_bytes_info = {"monitor_proc_read_bytes_total",
+                                                        "Bytes leídos de /proc y /sys por el agente"};
+
+/**
+ * @brief Nombre y ayuda de la duración del render de /metrics.
+ */
+static const struct metric_info scrape_render_info = {"monitor_scrape_render_seconds",
+                                                      "Duración del render del /metrics anterior"};
+
+/**
+ * @brief Nombre y ayuda del tamaño de la respuesta de /metrics.
  */
-static prom_gauge_t* external_frag_worst_fit_metric;
+static const struct metric_info scrape_size_info = {"monitor_scrape_response_bytes",
+                                                    "Bytes de la respuesta del /metrics anterior"};
 
 /**
- * @brief Actualiza la métrica de fragmentación externa para el método First Fit.
+ * @brief Duración del último render de /metrics en segundos.
  *
- * Obtiene el valor actual de la fragmentación externa calculada para el método
- * de asignación de memoria First Fit y actualiza la métrica correspondiente
- * en Prometheus.
+ * En el modo pre-renderizado la escribe y la lee el hilo de los colectores; si
+ * no, el hilo del servidor HTTP. Nunca se comparte entre hilos.
+ */
+static double scrape_render_seconds;
+
+/**
+ * @brief Bytes de la última respuesta de /metrics, con el mismo dueño que @ref scrape_render_seconds.
+ */
+static double scrape_response_bytes;
+
+/**
+ * @brief Nombre de cada métrica escalar, para el envío al colector remoto.
+ */
+static const char* scalar_names[METRIC_SCALAR_COUNT];
+
+/**
+ * @brief Nombre y ayuda de la métrica de duración de cada lectura de /proc.
+ */
+static const struct metric_info source_latency_info = {"monitor_source_read_latency_seconds",
+                                                       "Duración de la última lectura de la fuente de /proc"};
+
+/**
+ * @brief Nombre y ayuda de la métrica de latencia de cada política de asignación.
+ */
+static const struct metric_info alloc_latency_info = {"alloc_latency_nanoseconds",
+                                                      "Nanosegundos por malloc o free en el simulador"};
+
+/**
+ * @brief Nombre y ayuda de la métrica de rendimiento de cada política de asignación.
+ */
+static const struct metric_info alloc_throughput_info = {"alloc_throughput_ops_per_second",
+                                                         "Operaciones de malloc o free por segundo en el simulador"};
+
+/**
+ * @brief Nombre y ayuda del histograma de duración de my_malloc() y my_free().
+ */
+static const struct metric_info alloc_call_latency_info = {"alloc_call_latency_nanoseconds",
+                                                           "Duración de cada my_malloc o my_free por política"};
+
+/**
+ * @brief Nombre y ayuda del histograma de tamaños pedidos a my_malloc().
+ */
+static const struct metric_info alloc_request_size_info = {"alloc_request_size_bytes",
+                                                           "Bytes pedidos en cada my_malloc por política"};
+
+/**
+ * @brief Nombre y ayuda del histograma de bloques examinados por find_block().
+ */
+static const struct metric_info alloc_search_length_info = {"alloc_search_length_blocks",
+                                                            "Bloques examinados para encontrar uno libre por política"};
+
+/**
+ * @brief Nombre y ayuda de cada ranking de procesos, indexados por @ref proc_top_rank.
+ */
+static const struct metric_info process_top_info[PROC_TOP_RANK_COUNT] = {
+    [PROC_TOP_CPU] = {"process_cpu_usage_percentage", "Porcentaje de una CPU usado por los procesos que más consumen"},
+    [PROC_TOP_RSS] = {"process_resident_memory_bytes", "Memoria residente de los procesos que más usan"},
+    [PROC_TOP_FAULTS] = {"process_page_faults_per_second", "Fallos de página por segundo de los procesos con más"},
+};
+
+/**
+ * @brief Nombre y ayuda de cada histograma de eBPF, indexados por @ref bpf_latency_kind.
+ */
+static const struct metric_info bpf_latency_info[BPF_LATENCY_KIND_COUNT] = {
+    [BPF_LATENCY_RUNQUEUE] = {"scheduler_runqueue_latency_seconds",
+                              "Espera de las tareas listas en la cola de ejecución hasta ejecutarse"},
+    [BPF_LATENCY_PAGE_FAULT] = {"page_fault_latency_seconds", "Duración del manejo de los fallos de página"},
+};
+
+/**
+ * @brief Nombre y ayuda de cada métrica de los cgroups, indexados por @ref cgroup_metric.
+ */
+static const struct metric_info cgroup_info[CGROUP_METRIC_COUNT] = {
+    [CGROUP_CPU_USAGE] = {"cgroup_cpu_usage_percentage", "Porcentaje de una CPU usado por el cgroup"},
+    [CGROUP_CPU_THROTTLED] = {"cgroup_cpu_throttled_percentage", "Porcentaje del tiempo limitado por cpu.max"},
+    [CGROUP_MEMORY_BYTES] = {"cgroup_memory_usage_bytes", "Memoria en uso por el cgroup"},
+    [CGROUP_MEMORY_ANON] = {"cgroup_memory_anon_bytes", "Memoria anónima del cgroup"},
+    [CGROUP_MEMORY_FILE] = {"cgroup_memory_file_bytes", "Caché de archivos del cgroup"},
+    [CGROUP_IO_READ] = {"cgroup_io_read_bytes_per_second", "Bytes leídos por segundo por el cgroup"},
+    [CGROUP_IO_WRITE] = {"cgroup_io_write_bytes_per_second", "Bytes escritos por segundo por el cgroup"},
+};
+
+/**
+ * @brief Cgroups que no se exportan por superar CGROUP_MAX.
+ */
+static const struct metric_info cgroup_dropped_info = {"cgroup_dropped",
+                                                       "Cgroups encontrados que no se exportan por superar el máximo"};
+
+/**
+ * @brief Actualiza las métricas escalares de un colector.
  */
-void update_external_frag_first_fit()
+void update_scalar_gauges(enum scalar_collector collector)
 {
-    double usage = get_external_frag_first_fit();
-    if (usage >= 0)
+    double* scalar = metric_store_stage()->scalar;
+    for (size_t i = 0; i < collector_scalar_count[collector]; i++)
     {
-        pthread_mutex_lock(&lock);
-        prom_gauge_set(external_frag_first_fit_metric, usage, NULL);
-        pthread_mutex_unlock(&lock);
+        enum metric_id id = collector_scalars[collector][i];
+        double value = scalar_registry[id].read();
+        if (value >= 0)
+        {
+            scalar[id] = value;
+        }
+        else
+        {
+            fprintf(stderr, "Error al obtener %s\n", scalar_registry[id].what);
+        }
     }
-    else
+}
+
+/**
+ * @brief Actualiza la latencia por operación de cada política de asignación.
+ */
+void update_alloc_latency_gauge()
+{
+    struct metric_values* stage = metric_store_stage();
+    for (int m = 0; m < SIM_METHOD_COUNT; m++)
     {
-        fprintf(stderr, "Error al obtener la memoria disponible\n");
+        double ns = get_alloc_latency(m);
+        if (ns >= 0)
+        {
+            stage->alloc_latency[m] = ns;
+        }
     }
 }
 
 /**
- * @brief Actualiza la métrica de fragmentación externa para el método Best Fit.
- *
- * Obtiene el valor actual de la fragmentación externa calculada para el método
- * de asignación de memoria Best Fit y actualiza la métrica correspondiente
- * en Prometheus.
+ * @brief Actualiza las operaciones por segundo de cada política de asignación.
  */
-void update_external_frag_best_fit()
+void update_alloc_throughput_gauge()
 {
-    double usage = get_external_frag_best_fit();
-    if (usage >= 0)
+    struct metric_values* stage = metric_store_stage();
+    for (int m = 0; m < SIM_METHOD_COUNT; m++)
     {
-        pthread_mutex_lock(&lock);
-        prom_gauge_set(external_frag_best_fit_metric, usage, NULL);
-        pthread_mutex_unlock(&lock);
+        double ops = get_alloc_throughput(m);
+        if (ops >= 0)
+        {
+            stage->alloc_throughput[m] = ops;
+        }
     }
-    else
+}
+
+/**
+ * @brief Actualiza las métricas de sectores por segundo de cada disco.
+ */
+void update_disk_devices_gauge()
+{
+    struct metric_values* stage = metric_store_stage();
+    const struct disk_rate* rates;
+    size_t count = get_disk_device_rates(&rates);
+
+    memcpy(stage->disks, rates, count * sizeof(rates[0]));
+    stage->disk_count = count;
+}
+
+/**
+ * @brief Actualiza los rankings de procesos por CPU, memoria residente y fallos de página.
+ */
+void update_process_top_gauge()
+{
+    // Desactivado, la copia de trabajo conserva los rankings vacíos
+    if (proc_top_enabled() && proc_top_update(&metric_store_stage()->top) != 0)
+    {
+        fprintf(stderr, "Error al obtener los procesos que más recursos consumen\n");
+    }
+}
+
+/**
+ * @brief Actualiza las métricas de cada cgroup v2.
+ */
+void update_cgroup_gauge()
+{
+    // Sin cgroup v2 la copia de trabajo conserva la lista vacía
+    if (cgroup_enabled() && cgroup_update(&metric_store_stage()->cgroups) != 0)
     {
-        fprintf(stderr, "Error al obtener la memoria disponible\n");
+        fprintf(stderr, "Error al obtener las métricas de los cgroups\n");
     }
 }
 
 /**
- * @brief Actualiza la métrica de fragmentación externa para el método Worst Fit.
+ * @brief Actualiza los histogramas de latencia medidos con eBPF.
+ */
+void update_bpf_latency_gauge()
+{
+    // Sin eBPF la copia de trabajo conserva los histogramas vacíos
+    if (bpf_latency_enabled() && bpf_latency_update(&metric_store_stage()->latency) != 0)
+    {
+        fprintf(stderr, "Error al leer los histogramas de eBPF\n");
+    }
+}
+
+/**
+ * @brief Actualiza las métricas de bytes, paquetes, errores y descartes de cada interfaz.
+ */
+void update_network_interfaces_gauge()
+{
+    struct metric_values* stage = metric_store_stage();
+    const struct net_rate* rates;
+    size_t count = get_net_interface_rates(&rates);
+
+    memcpy(stage->nets, rates, count * sizeof(rates[0]));
+    stage->net_count = count;
+}
+
+/**
+ * @brief Busca las estadísticas de un colector, agregándolo si es nuevo.
  *
- * Obtiene el valor actual de la fragmentación externa calculada para el método
- * de asignación de memoria Worst Fit y actualiza la métrica correspondiente
- * en Prometheus.
+ * @return Estadísticas en la copia de trabajo, o NULL si no hay lugar.
  */
-void update_external_frag_worst_fit()
+static struct collector_stats* find_collector_stats(const char* collector)
 {
-    double usage = get_external_frag_worst_fit();
-    if (usage >= 0)
+    struct metric_values* stage = metric_store_stage();
+
+    for (size_t i = 0; i < stage->collector_count; i++)
     {
-        pthread_mutex_lock(&lock);
-        prom_gauge_set(external_frag_worst_fit_metric, usage, NULL);
-        pthread_mutex_unlock(&lock);
+        if (strcmp(stage->collectors[i].name, collector) == 0)
+        {
+            return &stage->collectors[i];
+        }
     }
-    else
+    if (stage->collector_count == METRIC_MAX_COLLECTORS)
     {
-        fprintf(stderr, "Error al obtener la memoria disponible\n");
+        fprintf(stderr, "Demasiados colectores para registrar sus estadísticas\n");
+        return NULL;
     }
+
+    struct collector_stats* stats = &stage->collectors[stage->collector_count++];
+    memset(stats, 0, sizeof(*stats));
+    stats->name = collector;
+    return stats;
 }
 
 /**
- * @brief Actualiza la métrica de memoria disponible.
+ * @brief Suma ticks salteados al contador del colector.
  */
-void update_memory_avalible_gauge()
+void add_skipped_ticks(const char* collector, unsigned long long ticks)
 {
-    double usage = get_memory_avalible();
-    if (usage >= 0)
+    struct collector_stats* stats = find_collector_stats(collector);
+    if (stats != NULL)
     {
-        pthread_mutex_lock(&lock);
-        prom_gauge_set(memory_avalible_metric, usage, NULL);
-        pthread_mutex_unlock(&lock);
+        stats->skipped += ticks;
     }
-    else
+}
+
+/**
+ * @brief Registra la duración de la última ejecución de un colector.
+ */
+void set_collector_latency(const char* collector, double seconds)
+{
+    struct collector_stats* stats = find_collector_stats(collector);
+    if (stats == NULL)
+    {
+        return;
+    }
+    stats->latency = seconds;
+
+    // Las duraciones mayores a la última cubeta solo cuentan en "+Inf"
+    for (int i = 0; i < COLLECTOR_DURATION_BUCKETS; i++)
     {
-        fprintf(stderr, "Error al obtener la memoria disponible\n");
+        if (seconds <= collector_duration_bounds[i])
+        {
+            stats->duration_buckets[i]++;
+            break;
+        }
     }
+    stats->duration_count++;
+    stats->duration_sum += seconds;
+}
+
+/**
+ * @brief Registra la duración de la última lectura de una fuente de /proc.
+ */
+void set_source_latency(enum proc_source source, double seconds)
+{
+    metric_store_stage()->source_latency[source] = seconds;
 }
 
 /**
- * @brief Actualiza la métrica de memoria total.
+ * @brief Actualiza la métrica de uso de cada CPU por modo.
  */
-void update_memory_total_gauge()
+void update_percpu_gauge()
 {
-    double usage = get_memory_total();
-    if (usage >= 0)
+    const struct percpu_usage* usage = get_percpu_usage();
+    if (usage == NULL)
     {
-        pthread_mutex_lock(&lock);
-        prom_gauge_set(memory_total_metric, usage, NULL);
-        pthread_mutex_unlock(&lock);
+        fprintf(stderr, "Error al obtener el uso por CPU\n");
+        return;
     }
-    else
+
+    struct percpu_usage* staged = &metric_store_stage()->percpu;
+    for (int m = 0; m < CPU_MODE_COUNT; m++)
     {
-        fprintf(stderr, "Error al obtener la memoria total\n");
+        memcpy(staged->percent[m], usage->percent[m], usage->count * sizeof(usage->percent[m][0]));
     }
+    memcpy(staged->online, usage->online, usage->count);
+    staged->count = usage->count;
 }
 
 /**
- * @brief Actualiza la métrica alternativa de uso de memoria.
+ * @brief Agrega las series de un histograma del asignador para una política.
+ *
+ * @param b Buffer en construcción.
+ * @param name Nombre de la familia.
+ * @param kind Magnitud a leer.
+ * @param method Política.
+ * @param op Valor de la etiqueta "op", o NULL si la familia no la tiene.
  */
-void update_memory_2_gauge()
+static void render_alloc_histogram(struct expo_buffer** b, const char* name, enum mem_hist_kind kind, int method,
+                                   const char* op)
 {
-    double usage = get_memory_usage_2();
-    if (usage >= 0)
+    struct mem_histogram h;
+    if (mem_hist_snapshot(kind, method, &h) != 0)
     {
-        pthread_mutex_lock(&lock);
-        prom_gauge_set(memory_usage_2_metric, usage, NULL);
-        pthread_mutex_unlock(&lock);
+        return;
     }
-    else
+
+    char series[128];
+    char le[24];
+    const char* keys[3] = {"method"};
+    const char* values[3] = {alloc_method_labels[method]};
+    size_t count = 1;
+    uint64_t cumulative = 0;
+
+    if (op != NULL)
     {
-        fprintf(stderr, "Error al obtener el uso de memoria (métrica alternativa)\n");
+        keys[count] = "op";
+        values[count++] = op;
     }
+    // "le" va última y solo en las cubetas
+    keys[count] = "le";
+    values[count] = le;
+
+    snprintf(series, sizeof(series), "%s_bucket", name);
+    for (int i = 0; i < MEM_HIST_BUCKETS; i++)
+    {
+        cumulative += h.buckets[i];
+        snprintf(le, sizeof(le), "%llu", (unsigned long long)mem_hist_bound(i));
+        expo_sample(b, series, keys, values, count + 1, (double)cumulative);
+    }
+    snprintf(le, sizeof(le), "+Inf");
+    expo_sample(b, series, keys, values, count + 1, (double)h.count);
+
+    snprintf(series, sizeof(series), "%s_sum", name);
+    expo_sample(b, series, keys, values, count, (double)h.sum);
+    snprintf(series, sizeof(series), "%s_count", name);
+    expo_sample(b, series, keys, values, count, (double)h.count);
 }
 
 /**
- * @brief Actualiza la métrica de estadísticas del disco.
+ * @brief Agrega los histogramas del asignador, sumando los de todos los hilos en este momento.
+ *
+ * libprom no permite cargar cubetas ya contadas, así que los dos modos de
+ * exposición usan este render.
  */
-void update_disk_stats_gauge()
+static void render_alloc_histograms(struct expo_buffer** b)
 {
-    double usage = get_disk_stats();
-    if (usage >= 0)
+    expo_family(b, alloc_call_latency_info.name, alloc_call_latency_info.help, "histogram");
+    for (int m = 0; m < SIM_METHOD_COUNT; m++)
     {
-        pthread_mutex_lock(&lock);
-        prom_gauge_set(disk_stats_metric, usage, NULL);
-        pthread_mutex_unlock(&lock);
+        render_alloc_histogram(b, alloc_call_latency_info.name, MEM_HIST_MALLOC_NS, m, "malloc");
+        render_alloc_histogram(b, alloc_call_latency_info.name, MEM_HIST_FREE_NS, m, "free");
     }
-    else
+    expo_family(b, alloc_request_size_info.name, alloc_request_size_info.help, "histogram");
+    for (int m = 0; m < SIM_METHOD_COUNT; m++)
     {
-        fprintf(stderr, "Error al obtener las estadísticas del disco\n");
+        render_alloc_histogram(b, alloc_request_size_info.name, MEM_HIST_REQUEST_SIZE, m, NULL);
+    }
+    expo_family(b, alloc_search_length_info.name, alloc_search_length_info.help, "histogram");
+    for (int m = 0; m < SIM_METHOD_COUNT; m++)
+    {
+        render_alloc_histogram(b, alloc_search_length_info.name, MEM_HIST_SEARCH_LEN, m, NULL);
     }
 }
 
 /**
- * @brief Actualiza la métrica del número total de procesos.
+ * @brief Agrega los rankings de procesos, etiquetados por pid y nombre.
+ *
+ * Los procesos de un ranking cambian de un tick al otro y libprom no permite
+ * borrar una serie, así que los dos modos de exposición usan este render.
  */
-void update_total_processes_gauge()
+static void render_process_top(struct expo_buffer** b, const struct proc_top* top)
 {
-    double usage = get_total_processes();
-    if (usage >= 0)
+    const char* keys[] = {"pid", "comm"};
+    for (int r = 0; r < PROC_TOP_RANK_COUNT; r++)
     {
-        pthread_mutex_lock(&lock);
-        prom_gauge_set(total_processes_metric, usage, NULL);
-        pthread_mutex_unlock(&lock);
+        expo_family(b, process_top_info[r].name, process_top_info[r].help, "gauge");
+        for (size_t i = 0; i < top->count[r]; i++)
+        {
+            const struct proc_top_entry* e = &top->entries[r][i];
+            const char* labels[] = {e->pid, e->comm};
+            expo_sample(b, process_top_info[r].name, keys, labels, 2, e->value);
+        }
     }
-    else
+}
+
+/**
+ * @brief Agrega las métricas de cada cgroup, etiquetadas por su ruta.
+ *
+ * Los cgroups aparecen y desaparecen con los contenedores, así que como los
+ * rankings de procesos se renderizan aquí en los dos modos de exposición.
+ */
+static void render_cgroups(struct expo_buffer** b, const struct cgroup_stats* stats)
+{
+    const char* keys[] = {"cgroup"};
+    for (int m = 0; m < CGROUP_METRIC_COUNT; m++)
     {
-        fprintf(stderr, "Error al obtener el número total de procesos\n");
+        expo_family(b, cgroup_info[m].name, cgroup_info[m].help, "gauge");
+        for (size_t i = 0; i < stats->count; i++)
+        {
+            const char* labels[] = {stats->cgroups[i].name};
+            expo_sample(b, cgroup_info[m].name, keys, labels, 1, stats->cgroups[i].value[m]);
+        }
     }
+    expo_family(b, cgroup_dropped_info.name, cgroup_dropped_info.help, "gauge");
+    expo_sample(b, cgroup_dropped_info.name, NULL, NULL, 0, (double)stats->dropped);
 }
 
 /**
- * @brief Actualiza la métrica de cambios de contexto.
+ * @brief Agrega los histogramas de latencia de eBPF, si el colector está activo.
+ *
+ * Como los del asignador, llegan con las cubetas ya contadas y libprom no
+ * puede cargarlas, así que los dos modos de exposición usan este render.
  */
-void update_change_context_gauge()
+static void render_bpf_latency(struct expo_buffer** b, const struct bpf_latency* latency)
 {
-    double usage = get_change_context();
-    if (usage >= 0)
+    if (!bpf_latency_enabled())
     {
-        pthread_mutex_lock(&lock);
-        prom_gauge_set(change_context_metric, usage, NULL);
-        pthread_mutex_unlock(&lock);
+        return;
     }
-    else
+
+    char series[128];
+    char le[24];
+    const char* keys[] = {"le"};
+    const char* values[] = {le};
+    for (int k = 0; k < BPF_LATENCY_KIND_COUNT; k++)
+    {
+        const struct bpf_latency_histogram* h = &latency->hist[k];
+        unsigned long long cumulative = 0;
+
+        expo_family(b, bpf_latency_info[k].name, bpf_latency_info[k].help, "histogram");
+        snprintf(series, sizeof(series), "%s_bucket", bpf_latency_info[k].name);
+        // La última cubeta no tiene límite: queda incluida en "+Inf"
+        for (int i = 0; i < BPF_LATENCY_SLOTS - 1; i++)
+        {
+            cumulative += h->buckets[i];
+            snprintf(le, sizeof(le), "%g", bpf_latency_bound(i));
+            expo_sample(b, series, keys, values, 1, (double)cumulative);
+        }
+        snprintf(le, sizeof(le), "+Inf");
+        expo_sample(b, series, keys, values, 1, (double)h->count);
+
+        snprintf(series, sizeof(series), "%s_sum", bpf_latency_info[k].name);
+        expo_sample(b, series, NULL, NULL, 0, h->sum);
+        snprintf(series, sizeof(series), "%s_count", bpf_latency_info[k].name);
+        expo_sample(b, series, NULL, NULL, 0, (double)h->count);
+    }
+}
+
+/**
+ * @brief Segundos transcurridos en CLOCK_MONOTONIC desde un instante.
+ */
+static double elapsed_seconds(const struct timespec* start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) + (double)(now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/**
+ * @brief Agrega las métricas del costo del propio agente.
+ *
+ * Los histogramas llegan con las cubetas ya contadas y el render y la
+ * respuesta de /metrics se miden fuera de libprom, así que los dos modos de
+ * exposición usan este render. Los valores del scrape son los del anterior:
+ * el actual todavía no terminó.
+ */
+static void render_self(struct expo_buffer** b, const struct metric_values* v)
+{
+    char bucket[128], sum[128], count[128];
+    char le[24];
+    const char* keys[] = {"collector", "le"};
+    snprintf(bucket, sizeof(bucket), "%s_bucket", collector_duration_info.name);
+    snprintf(sum, sizeof(sum), "%s_sum", collector_duration_info.name);
+    snprintf(count, sizeof(count), "%s_count", collector_duration_info.name);
+
+    expo_family(b, collector_duration_info.name, collector_duration_info.help, "histogram");
+    for (size_t c = 0; c < v->collector_count; c++)
     {
-        fprintf(stderr, "Error al obtener el número de cambios de contexto\n");
+        const struct collector_stats* stats = &v->collectors[c];
+        const char* values[] = {stats->name, le};
+        unsigned long long cumulative = 0;
+        for (int i = 0; i < COLLECTOR_DURATION_BUCKETS; i++)
+        {
+            cumulative += stats->duration_buckets[i];
+            snprintf(le, sizeof(le), "%g", collector_duration_bounds[i]);
+            expo_sample(b, bucket, keys, values, 2, (double)cumulative);
+        }
+        snprintf(le, sizeof(le), "+Inf");
+        expo_sample(b, bucket, keys, values, 2, (double)stats->duration_count);
+        expo_sample(b, sum, keys, values, 1, stats->duration_sum);
+        expo_sample(b, count, keys, values, 1, (double)stats->duration_count);
     }
+
+    expo_family(b, self_cpu_info.name, self_cpu_info.help, "counter");
+    expo_sample(b, self_cpu_info.name, NULL, NULL, 0, v->self.cpu_seconds);
+    expo_family(b, self_rss_info.name, self_rss_info.help, "gauge");
+    expo_sample(b, self_rss_info.name, NULL, NULL, 0, v->self.rss_bytes);
+    expo_family(b, self_syscalls_info.name, self_syscalls_info.help, "gauge");
+    expo_sample(b, self_syscalls_info.name, NULL, NULL, 0, v->self.syscalls_per_tick);
+    expo_family(b, self_read_bytes_info.name, self_read_bytes_info.help, "counter");
+    expo_sample(b, self_read_bytes_info.name, NULL, NULL, 0, (double)v->self.proc_read_bytes);
+    expo_family(b, scrape_render_info.name, scrape_render_info.help, "gauge");
+    expo_sample(b, scrape_render_info.name, NULL, NULL, 0, scrape_render_seconds);
+    expo_family(b, scrape_size_info.name, scrape_size_info.help, "gauge");
+    expo_sample(b, scrape_size_info.name, NULL, NULL, 0, scrape_response_bytes);
 }
 
 /**
- * @brief Actualiza la métrica de uso de CPU.
+ * @brief Agrega los contadores del envío al colector remoto, si está activo.
+ *
+ * Los contadores viven en push.c y no tienen métrica de libprom, así que se
+ * renderizan aquí en los dos modos de exposición.
  */
-void update_cpu_gauge()
+static void render_push(struct expo_buffer** b)
 {
-    double usage = get_cpu_usage();
-    if (usage >= 0)
+    if (!push_enabled())
     {
-        pthread_mutex_lock(&lock);
-        prom_gauge_set(cpu_usage_metric, usage, NULL);
-        pthread_mutex_unlock(&lock);
+        return;
     }
-    else
+    struct push_stats stats;
+    push_get_stats(&stats);
+
+    const char* keys[] = {"result"};
+    const char* results[] = {"sent", "queue_full", "send_failed"};
+    unsigned long long counts[] = {stats.sent, stats.queue_full, stats.send_failed};
+    expo_family(b, push_samples_info.name, push_samples_info.help, "counter");
+    for (int i = 0; i < 3; i++)
     {
-        fprintf(stderr, "Error al obtener el uso de CPU\n");
+        const char* labels[] = {results[i]};
+        expo_sample(b, push_samples_info.name, keys, labels, 1, (double)counts[i]);
     }
+    expo_family(b, push_queue_info.name, push_queue_info.help, "gauge");
+    expo_sample(b, push_queue_info.name, NULL, NULL, 0, (double)stats.queued);
 }
 
 /**
- * @brief Actualiza la métrica de uso de memoria.
+ * @brief Distinto de 0 si /metrics se sirve desde la exposición pre-renderizada.
+ */
+static int prerendered;
+
+/**
+ * @brief Renderiza la exposición de texto de todas las métricas en un buffer.
+ *
+ * Se llama una vez por tick desde el hilo de los colectores; el servidor HTTP
+ * entrega el resultado sin volver a renderizarlo.
  */
-void update_memory_gauge()
+static void render_exposition(const struct metric_values* v)
 {
-    double usage = get_memory_usage();
-    if (usage >= 0)
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    struct expo_buffer* b = expo_begin();
+    if (b == NULL)
     {
-        pthread_mutex_lock(&lock);
-        prom_gauge_set(memory_usage_metric, usage, NULL);
-        pthread_mutex_unlock(&lock);
+        // Todos los buffers se están enviando: se sigue sirviendo el anterior
+        return;
     }
-    else
+
+    for (int id = 0; id < METRIC_SCALAR_COUNT; id++)
+    {
+        expo_family(&b, scalar_registry[id].name, scalar_registry[id].help, "gauge");
+        expo_sample(&b, scalar_registry[id].name, NULL, NULL, 0, v->scalar[id]);
+    }
+
+    const char* cpu_keys[] = {"cpu", "mode"};
+    expo_family(&b, cpu_mode_usage_info.name, cpu_mode_usage_info.help, "gauge");
+    for (size_t i = 0; i < v->percpu.count; i++)
     {
-        fprintf(stderr, "Error al obtener el uso de memoria\n");
+        if (!v->percpu.online[i])
+        {
+            continue;
+        }
+        for (int m = 0; m < CPU_MODE_COUNT; m++)
+        {
+            const char* labels[] = {cpu_labels[i], cpu_mode_labels[m]};
+            expo_sample(&b, cpu_mode_usage_info.name, cpu_keys, labels, 2, v->percpu.percent[m][i]);
+        }
     }
+
+    const char* disk_keys[] = {"device"};
+    expo_family(&b, disk_read_sectors_info.name, disk_read_sectors_info.help, "gauge");
+    for (size_t i = 0; i < v->disk_count; i++)
+    {
+        const char* labels[] = {v->disks[i].name};
+        expo_sample(&b, disk_read_sectors_info.name, disk_keys, labels, 1, v->disks[i].read_sectors_per_sec);
+    }
+    expo_family(&b, disk_write_sectors_info.name, disk_write_sectors_info.help, "gauge");
+    for (size_t i = 0; i < v->disk_count; i++)
+    {
+        const char* labels[] = {v->disks[i].name};
+        expo_sample(&b, disk_write_sectors_info.name, disk_keys, labels, 1, v->disks[i].write_sectors_per_sec);
+    }
+
+    const char* net_keys[] = {"interface", "direction"};
+    for (int f = 0; f < NET_FAMILY_COUNT; f++)
+    {
+        expo_family(&b, net_info[f].name, net_info[f].help, "gauge");
+        for (size_t i = 0; i < v->net_count; i++)
+        {
+            for (int d = 0; d < 2; d++)
+            {
+                const char* labels[] = {v->nets[i].name, net_direction_labels[d]};
+                expo_sample(&b, net_info[f].name, net_keys, labels, 2, v->nets[i].per_sec[f + d * NET_FAMILY_COUNT]);
+            }
+        }
+    }
+
+    const char* collector_keys[] = {"collector"};
+    expo_family(&b, skipped_ticks_info.name, skipped_ticks_info.help, "counter");
+    for (size_t i = 0; i < v->collector_count; i++)
+    {
+        const char* labels[] = {v->collectors[i].name};
+        expo_sample(&b, skipped_ticks_info.name, collector_keys, labels, 1, (double)v->collectors[i].skipped);
+    }
+    expo_family(&b, collector_latency_info.name, collector_latency_info.help, "gauge");
+    for (size_t i = 0; i < v->collector_count; i++)
+    {
+        const char* labels[] = {v->collectors[i].name};
+        expo_sample(&b, collector_latency_info.name, collector_keys, labels, 1, v->collectors[i].latency);
+    }
+
+    const char* source_keys[] = {"source"};
+    expo_family(&b, source_latency_info.name, source_latency_info.help, "gauge");
+    for (int src = 0; src < PROC_SOURCE_COUNT; src++)
+    {
+        const char* labels[] = {source_labels[src]};
+        expo_sample(&b, source_latency_info.name, source_keys, labels, 1, v->source_latency[src]);
+    }
+
+    const char* method_keys[] = {"method"};
+    expo_family(&b, alloc_latency_info.name, alloc_latency_info.help, "gauge");
+    for (int m = 0; m < SIM_METHOD_COUNT; m++)
+    {
+        const char* labels[] = {alloc_method_labels[m]};
+        expo_sample(&b, alloc_latency_info.name, method_keys, labels, 1, v->alloc_latency[m]);
+    }
+
+    expo_family(&b, alloc_throughput_info.name, alloc_throughput_info.help, "gauge");
+    for (int m = 0; m < SIM_METHOD_COUNT; m++)
+    {
+        const char* labels[] = {alloc_method_labels[m]};
+        expo_sample(&b, alloc_throughput_info.name, method_keys, labels, 1, v->alloc_throughput[m]);
+    }
+
+    render_alloc_histograms(&b);
+    render_process_top(&b, &v->top);
+    render_cgroups(&b, &v->cgroups);
+    render_bpf_latency(&b, &v->latency);
+    render_self(&b, v);
+    render_push(&b);
+
+    scrape_response_bytes = (double)b->len;
+    scrape_render_seconds = elapsed_seconds(&start);
+    expo_commit(b);
 }
 
 /**
- * @brief Actualiza la métrica de uso del disco.
+ * @brief Publica los valores actualizados en el tick para el servidor HTTP.
  */
-void update_disk_gauge()
+void publish_metrics()
 {
-    double usage = get_disk_usage();
-    if (usage >= 0)
+    // Después de todos los colectores, así las lecturas de /proc contadas son las de este tick
+    self_stats_update(&metric_store_stage()->self);
+    metric_store_publish();
+    history_append(metric_store_stage()->scalar);
+    // El envío toma la misma publicación que lee el servidor HTTP
+    push_enqueue(metric_store_stage());
+    if (prerendered)
     {
-        pthread_mutex_lock(&lock);
-        prom_gauge_set(disk_usage_metric, usage, NULL);
-        pthread_mutex_unlock(&lock);
+        render_exposition(metric_store_stage());
     }
-    else
+}
+
+/**
+ * @brief Última publicación leída por el servidor HTTP.
+ *
+ * El servidor atiende con un único hilo interno, así que alcanza con una copia estática.
+ */
+static struct metric_values view;
+
+/**
+ * @brief Copia la última publicación del colector a las métricas de Prometheus.
+ *
+ * Solo se llama desde el hilo del servidor HTTP, que es el único que toca las
+ * métricas de libprom, por lo que no hace falta ningún mutex.
+ */
+static void apply_published_values()
+{
+    static unsigned long long applied_skipped[METRIC_MAX_COLLECTORS];
+
+    metric_store_read(&view);
+
+    for (int id = 0; id < METRIC_SCALAR_COUNT; id++)
+    {
+        prom_gauge_set(scalar_gauges[id], view.scalar[id], NULL);
+    }
+
+    for (size_t i = 0; i < view.percpu.count; i++)
+    {
+        if (!view.percpu.online[i])
+        {
+            continue;
+        }
+        for (int m = 0; m < CPU_MODE_COUNT; m++)
+        {
+            const char* labels[] = {cpu_labels[i], cpu_mode_labels[m]};
+            prom_gauge_set(cpu_mode_usage_metric, view.percpu.percent[m][i], labels);
+        }
+    }
+
+    for (size_t i = 0; i < view.disk_count; i++)
+    {
+        const char* labels[] = {view.disks[i].name};
+        prom_gauge_set(disk_read_sectors_metric, view.disks[i].read_sectors_per_sec, labels);
+        prom_gauge_set(disk_write_sectors_metric, view.disks[i].write_sectors_per_sec, labels);
+    }
+
+    for (size_t i = 0; i < view.net_count; i++)
+    {
+        for (int f = 0; f < NET_FAMILY_COUNT; f++)
+        {
+            for (int d = 0; d < 2; d++)
+            {
+                const char* labels[] = {view.nets[i].name, net_direction_labels[d]};
+                prom_gauge_set(net_metrics[f], view.nets[i].per_sec[f + d * NET_FAMILY_COUNT], labels);
+            }
+        }
+    }
+
+    for (int src = 0; src < PROC_SOURCE_COUNT; src++)
+    {
+        const char* labels[] = {source_labels[src]};
+        prom_gauge_set(source_latency_metric, view.source_latency[src], labels);
+    }
+
+    for (int m = 0; m < SIM_METHOD_COUNT; m++)
+    {
+        const char* labels[] = {alloc_method_labels[m]};
+        prom_gauge_set(alloc_latency_metric, view.alloc_latency[m], labels);
+        prom_gauge_set(alloc_throughput_metric, view.alloc_throughput[m], labels);
+    }
+
+    // Los colectores solo se agregan al final, así que el índice identifica al colector
+    for (size_t i = 0; i < view.collector_count; i++)
     {
-        fprintf(stderr, "Error al obtener el uso del disco\n");
+        const char* labels[] = {view.collectors[i].name};
+        prom_gauge_set(collector_latency_metric, view.collectors[i].latency, labels);
+        if (view.collectors[i].skipped > applied_skipped[i])
+        {
+            prom_counter_add(skipped_ticks_metric, (double)(view.collectors[i].skipped - applied_skipped[i]), labels);
+            applied_skipped[i] = view.collectors[i].skipped;
+        }
     }
 }
 
 /**
- * @brief Actualiza la métrica de uso de la red.
+ * @brief Encola una respuesta de texto.
  */
-void update_network_gauge()
+static enum MHD_Result send_text(struct MHD_Connection* connection, unsigned int status, const char* text,
+                                 enum MHD_ResponseMemoryMode mode)
 {
-    double usage = get_network_usage();
-    if (usage >= 0)
+    struct MHD_Response* response = MHD_create_response_from_buffer(strlen(text), (void*)text, mode);
+    if (response == NULL)
     {
-        pthread_mutex_lock(&lock);
-        prom_gauge_set(network_usage_metric, usage, NULL);
-        pthread_mutex_unlock(&lock);
+        return MHD_NO;
     }
-    else
+    enum MHD_Result ret = MHD_queue_response(connection, status, response);
+    MHD_destroy_response(response);
+    return ret;
+}
+
+/**
+ * @brief Responde el texto de libprom seguido de las familias que libprom no puede exportar.
+ *
+ * Agrega los histogramas del asignador, los rankings de procesos y los
+ * cgroups y las latencias de eBPF de la publicación que leyó
+ * apply_published_values(), y los contadores del envío.
+ *
+ * @param body Texto de prom_collector_registry_bridge(); se libera aquí.
+ * @param start Instante en que empezó el scrape, para medir el render.
+ */
+static enum MHD_Result send_with_rendered(struct MHD_Connection* connection, const char* body,
+                                         const struct timespec* start)
+{
+    struct expo_buffer* b = expo_alloc();
+    if (b == NULL)
+    {
+        return send_text(connection, MHD_HTTP_OK, body, MHD_RESPMEM_MUST_FREE);
+    }
+    expo_printf(&b, "%s", body);
+    free((void*)body);
+    render_alloc_histograms(&b);
+    render_process_top(&b, &view.top);
+    render_cgroups(&b, &view.cgroups);
+    render_bpf_latency(&b, &view.latency);
+    render_self(&b, &view);
+    render_push(&b);
+    if (b->failed)
+    {
+        free(b);
+        return send_text(connection, MHD_HTTP_SERVICE_UNAVAILABLE, "Error al exportar las métricas\n",
+                         MHD_RESPMEM_PERSISTENT);
+    }
+
+    scrape_response_bytes = (double)b->len;
+    scrape_render_seconds = elapsed_seconds(start);
+    struct MHD_Response* response = MHD_create_response_from_buffer_with_free_callback(b->len, b->data, expo_free_data);
+    if (response == NULL)
     {
-        fprintf(stderr, "Error al obtener el uso de la red\n");
+        free(b);
+        return MHD_NO;
     }
+    enum MHD_Result ret = MHD_queue_response(connection, MHD_HTTP_OK, response);
+    MHD_destroy_response(response);
+    return ret;
 }
 
 /**
- * @brief Actualiza la métrica de uso de ancho de banda.
+ * @brief Entrega la exposición pre-renderizada sin copiarla.
+ *
+ * Si el cliente ya tiene el contenido actual (If-None-Match coincide con el
+ * ETag) se responde 304 sin cuerpo. Si no, la respuesta apunta directamente al
+ * buffer publicado, que queda referenciado hasta que MHD termina de enviarlo.
  */
-void update_bandwidth_gauge()
+static enum MHD_Result serve_prerendered(struct MHD_Connection* connection)
 {
-    double usage = get_average_bandwidth();
-    if (usage >= 0)
+    char etag[EXPO_ETAG_LEN];
+    struct MHD_Response* response;
+    unsigned int status;
+
+    struct expo_buffer* b = expo_acquire();
+    if (b == NULL)
+    {
+        return send_text(connection, MHD_HTTP_SERVICE_UNAVAILABLE, "Métricas todavía no disponibles\n",
+                         MHD_RESPMEM_PERSISTENT);
+    }
+    memcpy(etag, b->etag, sizeof(etag));
+
+    const char* if_none_match =
+        MHD_lookup_connection_value(connection, MHD_HEADER_KIND, MHD_HTTP_HEADER_IF_NONE_MATCH);
+    if (if_none_match != NULL && strstr(if_none_match, etag) != NULL)
     {
-        pthread_mutex_lock(&lock);
-        prom_gauge_set(bandwidth_usage_metric, usage, NULL);
-        pthread_mutex_unlock(&lock);
+        expo_release(b);
+        status = MHD_HTTP_NOT_MODIFIED;
+        response = MHD_create_response_from_buffer(0, "", MHD_RESPMEM_PERSISTENT);
     }
     else
     {
-        fprintf(stderr, "Error al obtener el ancho de banda en uso\n");
+        status = MHD_HTTP_OK;
+        response = MHD_create_response_from_buffer_with_free_callback(b->len, b->data, expo_release_data);
+        if (response == NULL)
+        {
+            expo_release(b);
+        }
+    }
+    if (response == NULL)
+    {
+        return MHD_NO;
     }
+
+    MHD_add_response_header(response, MHD_HTTP_HEADER_ETAG, etag);
+    MHD_add_response_header(response, MHD_HTTP_HEADER_CONTENT_TYPE, "text/plain; version=0.0.4");
+    enum MHD_Result ret = MHD_queue_response(connection, status, response);
+    MHD_destroy_response(response);
+    return ret;
 }
 
 /**
- * @brief Actualiza la métrica de fallos de página mayores.
+ * @brief Agrega una muestra del historial al arreglo JSON en construcción.
+ *
+ * @param ctx Puntero al buffer de la respuesta.
  */
-void update_major_page_faults_gauge()
+static void append_history_sample(void* ctx, uint64_t ts_ms, double value)
 {
-    int faults = get_major_page_faults();
-    if (faults >= 0)
+    struct expo_buffer** b = ctx;
+    const char* sep = (*b)->len > 0 && (*b)->data[(*b)->len - 1] == '[' ? "" : ",";
+
+    // JSON no admite NaN ni infinitos
+    if (isfinite(value))
     {
-        pthread_mutex_lock(&lock);
-        prom_gauge_set(major_page_faults_metric, faults, NULL);
-        pthread_mutex_unlock(&lock);
+        expo_printf(b, "%s[%llu,%.17g]", sep, (unsigned long long)ts_ms, value);
     }
     else
     {
-        fprintf(stderr, "Error al obtener los fallos de página mayores\n");
+        expo_printf(b, "%s[%llu,null]", sep, (unsigned long long)ts_ms);
     }
 }
 
 /**
- * @brief Actualiza la métrica de fallos de página menores.
+ * @brief Responde las muestras de los últimos segundos de cada métrica escalar en JSON.
+ *
+ * Acepta `seconds` (por defecto @ref HISTORY_DEFAULT_SECONDS) y `metric` para
+ * devolver una sola métrica. La respuesta es un objeto con un arreglo de pares
+ * [milisegundos desde la época Unix, valor] por métrica. Un `seconds` que no
+ * es un entero sin signo se responde con 400.
  */
-void update_minor_page_faults_gauge()
+static enum MHD_Result serve_history(struct MHD_Connection* connection)
 {
-    int faults = get_minor_page_faults();
-    if (faults >= 0)
+    const char* seconds_arg = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "seconds");
+    const char* metric = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "metric");
+    unsigned long long seconds = HISTORY_DEFAULT_SECONDS;
+    if (seconds_arg != NULL)
     {
-        pthread_mutex_lock(&lock);
-        prom_gauge_set(minor_page_faults_metric, faults, NULL);
-        pthread_mutex_unlock(&lock);
+        char* end;
+        seconds = strtoull(seconds_arg, &end, 10);
+        // strtoull() acepta signos y espacios y devuelve 0 si no hay dígitos: se exigen solo dígitos
+        if (*seconds_arg < '0' || *seconds_arg > '9' || *end != '\0')
+        {
+            return send_text(connection, MHD_HTTP_BAD_REQUEST, "Parámetro seconds inválido\n", MHD_RESPMEM_PERSISTENT);
+        }
     }
-    else
+    uint64_t now = history_now_ms();
+    // Más segundos que los transcurridos desde la época es todo el historial; así no desborda la multiplicación
+    if (seconds > now / 1000)
+    {
+        seconds = now / 1000;
+    }
+    uint64_t since = now - seconds * 1000ULL;
+
+    struct expo_buffer* b = expo_alloc();
+    if (b == NULL)
+    {
+        return send_text(connection, MHD_HTTP_SERVICE_UNAVAILABLE, "Error al exportar el historial\n",
+                         MHD_RESPMEM_PERSISTENT);
+    }
+
+    int found = 0;
+    expo_printf(&b, "{");
+    for (int id = 0; id < METRIC_SCALAR_COUNT; id++)
+    {
+        if (metric != NULL && strcmp(metric, scalar_registry[id].name) != 0)
+        {
+            continue;
+        }
+        expo_printf(&b, "%s\"%s\":[", found++ ? "," : "", scalar_registry[id].name);
+        history_read(id, since, append_history_sample, &b);
+        expo_printf(&b, "]");
+    }
+    expo_printf(&b, "}\n");
+
+    if (b->failed || found == 0)
+    {
+        free(b);
+        return found == 0 ? send_text(connection, MHD_HTTP_NOT_FOUND, "Métrica desconocida\n", MHD_RESPMEM_PERSISTENT)
+                          : send_text(connection, MHD_HTTP_SERVICE_UNAVAILABLE, "Error al exportar el historial\n",
+                                      MHD_RESPMEM_PERSISTENT);
+    }
+
+    struct MHD_Response* response = MHD_create_response_from_buffer_with_free_callback(b->len, b->data, expo_free_data);
+    if (response == NULL)
+    {
+        free(b);
+        return MHD_NO;
+    }
+    MHD_add_response_header(response, MHD_HTTP_HEADER_CONTENT_TYPE, "application/json");
+    enum MHD_Result ret = MHD_queue_response(connection, MHD_HTTP_OK, response);
+    MHD_destroy_response(response);
+    return ret;
+}
+
+/**
+ * @brief Atiende las peticiones HTTP con las mismas rutas que promhttp.
+ *
+ * "/" responde que el servicio está vivo y "/metrics" exporta el registro por
+ * defecto tras aplicar la última publicación de los colectores, o la
+ * exposición pre-renderizada si se eligió con @ref EXPO_MODE_ENV. Además
+ * "/history" devuelve las muestras recientes guardadas en history.h.
+ */
+static enum MHD_Result handle_request(void* cls, struct MHD_Connection* connection, const char* url,
+                                      const char* method, const char* version, const char* upload_data,
+                                      size_t* upload_data_size, void** con_cls)
+{
+    (void)cls;
+    (void)version;
+    (void)upload_data;
+    (void)upload_data_size;
+    (void)con_cls;
+
+    if (strcmp(method, "GET") != 0)
+    {
+        return send_text(connection, MHD_HTTP_BAD_REQUEST, "Invalid HTTP Method\n", MHD_RESPMEM_PERSISTENT);
+    }
+    if (strcmp(url, "/") == 0)
+    {
+        return send_text(connection, MHD_HTTP_OK, "I AM HEALTHY\n", MHD_RESPMEM_PERSISTENT);
+    }
+    if (strcmp(url, "/history") == 0)
+    {
+        return serve_history(connection);
+    }
+    if (strcmp(url, "/metrics") == 0 && prerendered)
+    {
+        return serve_prerendered(connection);
+    }
+    if (strcmp(url, "/metrics") == 0)
     {
-        fprintf(stderr, "Error al obtener los fallos de página menores\n");
+        struct timespec start;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        apply_published_values();
+        const char* body = prom_collector_registry_bridge(PROM_COLLECTOR_REGISTRY_DEFAULT);
+        if (body == NULL)
+        {
+            return send_text(connection, MHD_HTTP_SERVICE_UNAVAILABLE, "Error al exportar las métricas\n",
+                             MHD_RESPMEM_PERSISTENT);
+        }
+        return send_with_rendered(connection, body, &start);
     }
+    return send_text(connection, MHD_HTTP_BAD_REQUEST, "Bad Request\n", MHD_RESPMEM_PERSISTENT);
 }
 
 /**
@@ -416,11 +1362,9 @@ void* expose_metrics(void* arg)
 {
     (void)arg; // Argumento no utilizado
 
-    // Aseguramos que el manejador HTTP esté adjunto al registro por defecto
-    promhttp_set_active_collector_registry(NULL);
-
     // Iniciamos el servidor HTTP en el puerto 8000
-    struct MHD_Daemon* daemon = promhttp_start_daemon(MHD_USE_SELECT_INTERNALLY, 8000, NULL, NULL);
+    struct MHD_Daemon* daemon =
+        MHD_start_daemon(MHD_USE_SELECT_INTERNALLY, 8000, NULL, NULL, handle_request, NULL, MHD_OPTION_END);
     if (daemon == NULL)
     {
         fprintf(stderr, "Error al iniciar el servidor HTTP\n");
@@ -440,8 +1384,8 @@ void* expose_metrics(void* arg)
  * @brief Inicializa las métricas del sistema y registra las métricas de
  * Prometheus.
  *
- * Esta función inicializa el mutex utilizado para proteger el acceso a las
- * métricas, configura el registro de coleccionistas de Prometheus, y crea
+ * Esta función abre las fuentes de /proc, configura el registro de
+ * coleccionistas de Prometheus, y crea
  * métricas para el uso de CPU, memoria, disco y red, así como otros indicadores
  * de rendimiento.
  *
@@ -450,165 +1394,155 @@ void* expose_metrics(void* arg)
  */
 void init_metrics()
 {
-    // Inicializamos el mutex
-    if (pthread_mutex_init(&lock, NULL) != 0)
-    {
-        fprintf(stderr, "Error al inicializar el mutex\n");
-        // return EXIT_FAILURE;
-    }
+    // Elegimos si /metrics se renderiza una vez por tick o en cada scrape
+    const char* mode = getenv(EXPO_MODE_ENV);
+    prerendered = mode != NULL && strcmp(mode, EXPO_MODE_PRERENDERED) == 0;
 
-    // Inicializamos el registro de coleccionistas de Prometheus
-    if (prom_collector_registry_default_init() != 0)
+    // Abrimos una sola vez los archivos de /proc que se releen en cada tick
+    if (init_proc_sources() != 0)
     {
-        fprintf(stderr, "Error al inicializar el registro de Prometheus\n");
-        // return EXIT_FAILURE;
+        fprintf(stderr, "Error al abrir las fuentes de /proc\n");
     }
-
-    // Creamos la métrica para el uso de CPU
-    cpu_usage_metric = prom_gauge_new("cpu_usage_percentage", "Porcentaje de uso de CPU", 0, NULL);
-    if (cpu_usage_metric == NULL)
+    if (proc_top_init() != 0)
     {
-        fprintf(stderr, "Error al crear la métrica de uso de CPU\n");
-        // return EXIT_FAILURE;
+        fprintf(stderr, "Error al iniciar el colector de procesos\n");
     }
-
-    // Creamos la métrica para el uso de memoria
-    memory_usage_metric = prom_gauge_new("memory_usage_percentage", "Porcentaje de uso de memoria", 0, NULL);
-    if (memory_usage_metric == NULL)
+    // Sin cgroup v2 cgroup_init() avisa y el colector queda desactivado
+    cgroup_init();
+    if (self_stats_init() != 0)
     {
-        fprintf(stderr, "Error al crear la métrica de uso de memoria\n");
-        // return EXIT_FAILURE;
+        fprintf(stderr, "Error al abrir /proc/self/statm\n");
     }
+    // Sin MONITOR_WITH_BPF o sin permisos para cargarlo, el colector de eBPF queda desactivado
+    bpf_latency_init();
 
-    // Creamos la métrica para el uso de disco
-    disk_usage_metric = prom_gauge_new("disk_usage_percentage", "Porcentaje de uso de disco", 0, NULL);
-    if (disk_usage_metric == NULL)
+    // Sin MONITOR_PUSH_URL el envío queda desactivado y solo se sirve /metrics
+    for (int id = 0; id < METRIC_SCALAR_COUNT; id++)
     {
-        fprintf(stderr, "Error al crear la métrica de uso de disco\n");
-        // return EXIT_FAILURE;
+        scalar_names[id] = scalar_registry[id].name;
     }
-
-    // Creamos la métrica para el uso de la red
-    network_usage_metric = prom_gauge_new("network_usage", "Uso de la red", 0, NULL);
-    if (network_usage_metric == NULL)
+    if (push_init(scalar_names) != 0)
     {
-        fprintf(stderr, "Error al crear la métrica de uso de la red\n");
-        // return EXIT_FAILURE;
+        fprintf(stderr, "Error al iniciar el envío al colector remoto\n");
     }
 
-    // Creamos la métrica para el ancho de banda de la red
-    bandwidth_usage_metric = prom_gauge_new("bandwidth_usage", "Ancho de banda en uso", 0, NULL);
-    if (bandwidth_usage_metric == NULL)
+    // Inicializamos el registro de coleccionistas de Prometheus
+    if (prom_collector_registry_default_init() != 0)
     {
-        fprintf(stderr, "Error al crear la métrica de uso de ancho de banda\n");
+        fprintf(stderr, "Error al inicializar el registro de Prometheus\n");
         // return EXIT_FAILURE;
     }
 
-    // Creamos la métrica para los fallos de página mayores
-    major_page_faults_metric = prom_gauge_new("major_page_faults", "Número de fallos de página mayores", 0, NULL);
-    if (major_page_faults_metric == NULL)
+    // Un gauge por entrada del registro; los índices por colector se arman aunque libprom falle
+    for (int id = 0; id < METRIC_SCALAR_COUNT; id++)
     {
-        fprintf(stderr, "Error al crear la métrica de fallos de página mayores\n");
+        const struct scalar_metric* m = &scalar_registry[id];
+        collector_scalars[m->collector][collector_scalar_count[m->collector]++] = id;
     }
-
-    // Creamos la métrica para los fallos de página menores
-    minor_page_faults_metric = prom_gauge_new("minor_page_faults", "Número de fallos de página menores", 0, NULL);
-    if (minor_page_faults_metric == NULL)
+    for (int id = 0; id < METRIC_SCALAR_COUNT; id++)
     {
-        fprintf(stderr, "Error al crear la métrica de fallos de página menores\n");
+        scalar_gauges[id] = prom_gauge_new(scalar_registry[id].name, scalar_registry[id].help, 0, NULL);
+        if (scalar_gauges[id] == NULL || prom_collector_registry_must_register_metric(scalar_gauges[id]) == NULL)
+        {
+            fprintf(stderr, "Error al crear la métrica %s\n", scalar_registry[id].name);
+            return;
+        }
     }
 
-    // Ejemplo de métricas adicionales (asegúrate de definirlas en tu código)
-    change_context_metric = prom_gauge_new("change_contexts", "Número de cambios de contexto", 0, NULL);
-    if (change_context_metric == NULL)
+    // Creamos la métrica para el uso de cada CPU por modo
+    const char* cpu_mode_label_keys[] = {"cpu", "mode"};
+    cpu_mode_usage_metric =
+        prom_gauge_new(cpu_mode_usage_info.name, cpu_mode_usage_info.help, 2, cpu_mode_label_keys);
+    if (cpu_mode_usage_metric == NULL)
     {
-        fprintf(stderr, "Error al crear la métrica de cambios de contexto\n");
-        return; // Salimos si hay un error
+        fprintf(stderr, "Error al crear la métrica de uso por CPU\n");
+        return; // Manejo de errores
     }
-
-    total_processes_metric = prom_gauge_new("total_processes", "Número total de procesos", 0, NULL);
-    if (total_processes_metric == NULL)
+    for (int i = 0; i < MAX_CPUS; i++)
     {
-        fprintf(stderr, "Error al crear la métrica de total de procesos\n");
-        return; // Salimos si hay un error
+        snprintf(cpu_labels[i], sizeof(cpu_labels[i]), "%d", i);
     }
 
-    memory_total_metric = prom_gauge_new("memory_total", "Memoria total del sistema", 0, NULL);
-    if (memory_total_metric == NULL)
+    // Métricas por disco, etiquetadas con el nombre del dispositivo
+    const char* disk_labels[] = {"device"};
+    disk_read_sectors_metric =
+        prom_gauge_new(disk_read_sectors_info.name, disk_read_sectors_info.help, 1, disk_labels);
+    if (disk_read_sectors_metric == NULL)
     {
-        fprintf(stderr, "Error al crear la métrica de memoria total\n");
-        return; // Salimos si hay un error
+        fprintf(stderr, "Error al crear la métrica de sectores leídos por disco\n");
+        return; // Manejo de errores
     }
-
-    memory_avalible_metric = prom_gauge_new("memory_available", "Memoria disponible del sistema", 0, NULL);
-    if (memory_avalible_metric == NULL)
+    disk_write_sectors_metric =
+        prom_gauge_new(disk_write_sectors_info.name, disk_write_sectors_info.help, 1, disk_labels);
+    if (disk_write_sectors_metric == NULL)
     {
-        fprintf(stderr, "Error al crear la métrica de memoria disponible\n");
-        return; // Salimos si hay un error
+        fprintf(stderr, "Error al crear la métrica de sectores escritos por disco\n");
+        return; // Manejo de errores
     }
 
-    memory_usage_2_metric = prom_gauge_new("memory_usage_2", "Uso de memoria (otra métrica)", 0, NULL);
-    if (memory_usage_2_metric == NULL)
+    // Métricas por interfaz de red, etiquetadas con el nombre y el sentido
+    const char* net_labels[] = {"interface", "direction"};
+    for (int f = 0; f < NET_FAMILY_COUNT; f++)
     {
-        fprintf(stderr, "Error al crear la métrica de uso de memoria (otra)\n");
-        return; // Salimos si hay un error
+        net_metrics[f] = prom_gauge_new(net_info[f].name, net_info[f].help, 2, net_labels);
+        if (net_metrics[f] == NULL)
+        {
+            fprintf(stderr, "Error al crear las métricas por interfaz de red\n");
+            return; // Manejo de errores
+        }
     }
-
-    // Agregamos la métrica para los disk stats
-    disk_stats_metric = prom_gauge_new("disk_stats", "Estadísticas del disco", 0, NULL);
-    if (disk_stats_metric == NULL)
+    const char* method_label_keys[] = {"method"};
+    alloc_latency_metric = prom_gauge_new(alloc_latency_info.name, alloc_latency_info.help, 1, method_label_keys);
+    if (alloc_latency_metric == NULL)
     {
-        fprintf(stderr, "Error al crear la métrica de estadísticas del disco\n");
+        fprintf(stderr, "Error al crear la métrica de latencia de asignación\n");
         return; // Manejo de errores
     }
-    external_frag_first_fit_metric = prom_gauge_new("frag_first_fit", "Fragmentacion de first fit", 0, NULL);
-    if (external_frag_first_fit_metric == NULL)
+    alloc_throughput_metric =
+        prom_gauge_new(alloc_throughput_info.name, alloc_throughput_info.help, 1, method_label_keys);
+    if (alloc_throughput_metric == NULL)
     {
-        fprintf(stderr, "Error al crear la métrica de fragmentacion first fit\n");
+        fprintf(stderr, "Error al crear la métrica de rendimiento de asignación\n");
         return; // Manejo de errores
     }
-    external_frag_best_fit_metric = prom_gauge_new("frag_best_fit", "Fragmentacion de best fit", 0, NULL);
-    if (external_frag_best_fit_metric == NULL)
+
+    // Creamos el contador de ticks salteados por el planificador
+    const char* collector_label_keys[] = {"collector"};
+    skipped_ticks_metric =
+        prom_counter_new(skipped_ticks_info.name, skipped_ticks_info.help, 1, collector_label_keys);
+    if (skipped_ticks_metric == NULL)
     {
-        fprintf(stderr, "Error al crear la métrica de fragmentacion best fit\n");
-        return; // Manejo de errores
+        fprintf(stderr, "Error al crear la métrica de ticks salteados\n");
+        return;
     }
-    external_frag_worst_fit_metric = prom_gauge_new("frag_worst_fit", "Fragmentacion de worst fit", 0, NULL);
-    if (external_frag_worst_fit_metric == NULL)
+
+    // Creamos las métricas de duración de los colectores y de las lecturas de /proc
+    collector_latency_metric =
+        prom_gauge_new(collector_latency_info.name, collector_latency_info.help, 1, collector_label_keys);
+    const char* source_label_keys[] = {"source"};
+    source_latency_metric =
+        prom_gauge_new(source_latency_info.name, source_latency_info.help, 1, source_label_keys);
+    if (collector_latency_metric == NULL || source_latency_metric == NULL)
     {
-        fprintf(stderr, "Error al crear la métrica de fragmentacion worst fit\n");
-        return; // Manejo de errores
+        fprintf(stderr, "Error al crear las métricas de duración de los colectores\n");
+        return;
     }
 
     // Registramos las métricas en el registro por defecto
-    if (prom_collector_registry_must_register_metric(cpu_usage_metric) == NULL ||
-        prom_collector_registry_must_register_metric(memory_usage_metric) == NULL ||
-        prom_collector_registry_must_register_metric(disk_usage_metric) == NULL ||
-        prom_collector_registry_must_register_metric(network_usage_metric) == NULL ||
-        prom_collector_registry_must_register_metric(bandwidth_usage_metric) == NULL ||
-        prom_collector_registry_must_register_metric(major_page_faults_metric) == NULL ||
-        prom_collector_registry_must_register_metric(minor_page_faults_metric) == NULL ||
-        prom_collector_registry_must_register_metric(change_context_metric) == NULL ||
-        prom_collector_registry_must_register_metric(total_processes_metric) == NULL ||
-        prom_collector_registry_must_register_metric(memory_total_metric) == NULL ||
-        prom_collector_registry_must_register_metric(memory_avalible_metric) == NULL ||
-        prom_collector_registry_must_register_metric(memory_usage_2_metric) == NULL ||
-        prom_collector_registry_must_register_metric(external_frag_first_fit_metric) == NULL ||
-        prom_collector_registry_must_register_metric(external_frag_best_fit_metric) == NULL ||
-        prom_collector_registry_must_register_metric(external_frag_worst_fit_metric) == NULL)
+    if (prom_collector_registry_must_register_metric(cpu_mode_usage_metric) == NULL ||
+        prom_collector_registry_must_register_metric(disk_read_sectors_metric) == NULL ||
+        prom_collector_registry_must_register_metric(disk_write_sectors_metric) == NULL ||
+        prom_collector_registry_must_register_metric(net_metrics[NET_FAMILY_BYTES]) == NULL ||
+        prom_collector_registry_must_register_metric(net_metrics[NET_FAMILY_PACKETS]) == NULL ||
+        prom_collector_registry_must_register_metric(net_metrics[NET_FAMILY_ERRORS]) == NULL ||
+        prom_collector_registry_must_register_metric(net_metrics[NET_FAMILY_DROPS]) == NULL ||
+        prom_collector_registry_must_register_metric(alloc_latency_metric) == NULL ||
+        prom_collector_registry_must_register_metric(alloc_throughput_metric) == NULL ||
+        prom_collector_registry_must_register_metric(skipped_ticks_metric) == NULL ||
+        prom_collector_registry_must_register_metric(collector_latency_metric) == NULL ||
+        prom_collector_registry_must_register_metric(source_latency_metric) == NULL)
     {
         fprintf(stderr, "Error al registrar las métricas\n");
         // return EXIT_FAILURE;
     }
 }
-
-/**
- * @brief Destruye el mutex utilizado para proteger el acceso a las métricas.
- *
- * Esta función libera los recursos asociados al mutex creado en la función
- * @ref init_metrics.
- */
-void destroy_mutex()
-{
-    pthread_mutex_destroy(&lock);
-}
@@ -0,0 +1,292 @@
+/**
+ * @file exposition.c
+ * @brief Implementación de los buffers de exposición pre-renderizados.
+ */
+
+#include "exposition.h"
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** Base del hash FNV-1a de 64 bits. */
+#define FNV_OFFSET_BASIS 0xcbf29ce484222325ULL
+
+/** Primo del hash FNV-1a de 64 bits. */
+#define FNV_PRIME 0x100000001b3ULL
+
+/**
+ * @brief Buffers que rotan entre publicaciones.
+ */
+static struct expo_buffer* buffers[EXPO_BUFFER_COUNT];
+
+/**
+ * @brief Buffer publicado, o NULL.
+ */
+static struct expo_buffer* current;
+
+/**
+ * @brief Protege `current`, los contadores de referencias y el arreglo de buffers.
+ *
+ * Solo se toma para intercambiar punteros y contadores, nunca mientras se
+ * renderiza o se envía una respuesta.
+ */
+static pthread_mutex_t expo_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @brief Hash FNV-1a de 64 bits.
+ */
+static uint64_t fnv1a(const char* data, size_t len)
+{
+    uint64_t hash = FNV_OFFSET_BASIS;
+    for (size_t i = 0; i < len; i++)
+    {
+        hash ^= (unsigned char)data[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+/**
+ * @brief Suelta una referencia; el llamador debe tener tomado `expo_lock`.
+ */
+static void release_locked(struct expo_buffer* b)
+{
+    b->refs--;
+}
+
+struct expo_buffer* expo_begin()
+{
+    struct expo_buffer* b = NULL;
+
+    pthread_mutex_lock(&expo_lock);
+    for (int i = 0; i < EXPO_BUFFER_COUNT && b == NULL; i++)
+    {
+        if (buffers[i] == NULL)
+        {
+            buffers[i] = malloc(sizeof(struct expo_buffer) + EXPO_INITIAL_SIZE);
+            if (buffers[i] == NULL)
+            {
+                break;
+            }
+            buffers[i]->cap = EXPO_INITIAL_SIZE;
+            buffers[i]->refs = 0;
+            buffers[i]->slot = i;
+        }
+        if (buffers[i]->refs == 0)
+        {
+            b = buffers[i];
+            b->refs = 1;
+        }
+    }
+    pthread_mutex_unlock(&expo_lock);
+
+    if (b != NULL)
+    {
+        b->len = 0;
+        b->failed = 0;
+        b->data[0] = '\0';
+    }
+    return b;
+}
+
+struct expo_buffer* expo_alloc()
+{
+    struct expo_buffer* b = malloc(sizeof(struct expo_buffer) + EXPO_INITIAL_SIZE);
+    if (b != NULL)
+    {
+        b->len = 0;
+        b->cap = EXPO_INITIAL_SIZE;
+        b->refs = 1;
+        b->slot = -1;
+        b->failed = 0;
+        b->data[0] = '\0';
+    }
+    return b;
+}
+
+void expo_free_data(void* data)
+{
+    free((char*)data - offsetof(struct expo_buffer, data));
+}
+
+/**
+ * @brief Garantiza lugar para `extra` bytes más el '\0'.
+ *
+ * @return 0 si hay lugar, -1 si no se pudo agrandar el buffer.
+ */
+static int reserve(struct expo_buffer** b, size_t extra)
+{
+    struct expo_buffer* old = *b;
+    size_t cap = old->cap;
+
+    if (old->failed)
+    {
+        return -1;
+    }
+    while (old->len + extra + 1 > cap)
+    {
+        cap *= 2;
+    }
+    if (cap == old->cap)
+    {
+        return 0;
+    }
+
+    // Solo el escritor tiene referencias a este buffer, así que puede moverse
+    pthread_mutex_lock(&expo_lock);
+    struct expo_buffer* grown = realloc(old, sizeof(struct expo_buffer) + cap);
+    if (grown != NULL)
+    {
+        grown->cap = cap;
+        if (grown->slot >= 0)
+        {
+            buffers[grown->slot] = grown;
+        }
+        *b = grown;
+    }
+    pthread_mutex_unlock(&expo_lock);
+
+    if (grown == NULL)
+    {
+        fprintf(stderr, "Error al agrandar el buffer de exposición\n");
+        old->failed = 1;
+        return -1;
+    }
+    return 0;
+}
+
+void expo_printf(struct expo_buffer** b, const char* fmt, ...)
+{
+    va_list args;
+
+    va_start(args, fmt);
+    int n = vsnprintf((*b)->data + (*b)->len, (*b)->cap - (*b)->len, fmt, args);
+    va_end(args);
+    if (n < 0)
+    {
+        (*b)->failed = 1;
+        return;
+    }
+
+    // Si no entró, agrandar y volver a formatear
+    if ((*b)->len + (size_t)n >= (*b)->cap)
+    {
+        if (reserve(b, (size_t)n) != 0)
+        {
+            return;
+        }
+        va_start(args, fmt);
+        vsnprintf((*b)->data + (*b)->len, (*b)->cap - (*b)->len, fmt, args);
+        va_end(args);
+    }
+    (*b)->len += (size_t)n;
+}
+
+void expo_family(struct expo_buffer** b, const char* name, const char* help, const char* type)
+{
+    expo_printf(b, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+/**
+ * @brief Agrega el valor de una etiqueta escapando '\\', '"' y los saltos de línea.
+ */
+static void append_label_value(struct expo_buffer** b, const char* value)
+{
+    // En el peor caso cada carácter se duplica
+    if (reserve(b, strlen(value) * 2) != 0)
+    {
+        return;
+    }
+
+    char* out = (*b)->data + (*b)->len;
+    for (const char* p = value; *p != '\0'; p++)
+    {
+        if (*p == '\\' || *p == '"')
+        {
+            *out++ = '\\';
+            *out++ = *p;
+        }
+        else if (*p == '\n')
+        {
+            *out++ = '\\';
+            *out++ = 'n';
+        }
+        else
+        {
+            *out++ = *p;
+        }
+    }
+    *out = '\0';
+    (*b)->len = (size_t)(out - (*b)->data);
+}
+
+void expo_sample(struct expo_buffer** b, const char* name, const char* const* keys, const char* const* values,
+                 size_t count, double value)
+{
+    expo_printf(b, "%s", name);
+    for (size_t i = 0; i < count; i++)
+    {
+        expo_printf(b, "%s%s=\"", i == 0 ? "{" : ",", keys[i]);
+        append_label_value(b, values[i]);
+        expo_printf(b, "\"");
+    }
+    expo_printf(b, "%s %.17g\n", count > 0 ? "}" : "", value);
+}
+
+void expo_commit(struct expo_buffer* b)
+{
+    if (b->failed)
+    {
+        pthread_mutex_lock(&expo_lock);
+        release_locked(b);
+        pthread_mutex_unlock(&expo_lock);
+        return;
+    }
+
+    b->hash = fnv1a(b->data, b->len);
+    snprintf(b->etag, sizeof(b->etag), "\"%016llx\"", (unsigned long long)b->hash);
+
+    pthread_mutex_lock(&expo_lock);
+    if (current != NULL && current->hash == b->hash && current->len == b->len &&
+        memcmp(current->data, b->data, b->len) == 0)
+    {
+        // Contenido idéntico: se conserva el publicado para que su ETag siga valiendo
+        release_locked(b);
+    }
+    else
+    {
+        // La referencia del escritor pasa a ser la de la publicación
+        if (current != NULL)
+        {
+            release_locked(current);
+        }
+        current = b;
+    }
+    pthread_mutex_unlock(&expo_lock);
+}
+
+struct expo_buffer* expo_acquire()
+{
+    pthread_mutex_lock(&expo_lock);
+    struct expo_buffer* b = current;
+    if (b != NULL)
+    {
+        b->refs++;
+    }
+    pthread_mutex_unlock(&expo_lock);
+    return b;
+}
+
+void expo_release(struct expo_buffer* b)
+{
+    pthread_mutex_lock(&expo_lock);
+    release_locked(b);
+    pthread_mutex_unlock(&expo_lock);
+}
+
+void expo_release_data(void* data)
+{
+    expo_release((struct expo_buffer*)((char*)data - offsetof(struct expo_buffer, data)));
+}
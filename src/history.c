@@ -0,0 +1,401 @@
+/**
+ * @file history.c
+ * @brief Implementación del historial comprimido de las métricas escalares.
+ *
+ * Los instantes se guardan en milisegundos de CLOCK_MONOTONIC, así que un
+ * ajuste del reloj no desordena las muestras; se pasan a la época Unix al
+ * leerlos. La codificación sigue a Gorilla:
+ *
+ * - Instante: diferencia de la diferencia D con la muestra anterior. '0' si
+ *   D es 0; '10' y 7 bits, '110' y 9 bits o '1110' y 12 bits según su rango;
+ *   '1111' y 32 bits si no.
+ * - Valor: XOR con el anterior. '0' si es 0; '10' y los bits significativos si
+ *   entran en la ventana de la muestra anterior; '11', 5 bits de ceros a la
+ *   izquierda, 6 bits de largo menos uno y los bits significativos si no.
+ */
+
+#include "history.h"
+#include <sched.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * @brief Bits de datos de un bloque.
+ */
+#define HISTORY_BLOCK_BITS (HISTORY_BLOCK_WORDS * 64)
+
+/**
+ * @brief Bits que puede ocupar una muestra en el peor caso: 4 + 32 del instante y 2 + 5 + 6 + 64 del valor.
+ */
+#define HISTORY_SAMPLE_MAX_BITS 113
+
+/**
+ * @brief Un bloque del anillo.
+ */
+struct history_block
+{
+    atomic_ulong sequence;              /**< Impar mientras el escritor lo modifica. */
+    uint64_t first_ts;                  /**< Instante de la primera muestra, en ms de CLOCK_MONOTONIC. */
+    uint64_t first_value;               /**< Bits de la primera muestra. */
+    uint64_t last_ts;                   /**< Instante de la última muestra. */
+    uint32_t count;                     /**< Muestras guardadas; 0 si el bloque está vacío. */
+    uint32_t bits;                      /**< Bits usados de `data`. */
+    uint64_t data[HISTORY_BLOCK_WORDS]; /**< Muestras siguientes a la primera, empaquetadas. */
+};
+
+/**
+ * @brief Anillo de una métrica y el estado del codificador, que solo usa el escritor.
+ */
+struct history_series
+{
+    struct history_block blocks[HISTORY_BLOCKS]; /**< Bloques del anillo. */
+    atomic_uint head;                            /**< Bloque donde se escribe. */
+    atomic_uint filled;                          /**< Bloques usados, hasta @ref HISTORY_BLOCKS. */
+    uint64_t prev_ts;                            /**< Instante de la muestra anterior. */
+    int64_t prev_delta;                          /**< Diferencia entre los dos instantes anteriores. */
+    uint64_t prev_value;                         /**< Bits del valor anterior. */
+    int prev_leading;                            /**< Ceros a la izquierda del XOR anterior. */
+    int prev_trailing;                           /**< Ceros a la derecha del XOR anterior. */
+};
+
+/**
+ * @brief Historial de cada métrica escalar, indexado por @ref metric_id.
+ */
+static struct history_series series[METRIC_SCALAR_COUNT];
+
+/**
+ * @brief Cursor de lectura dentro de una copia de un bloque.
+ */
+struct bit_reader
+{
+    const uint64_t* data; /**< Palabras del bloque. */
+    uint32_t pos;         /**< Próximo bit a leer. */
+    uint32_t end;         /**< Bits válidos. */
+};
+
+/**
+ * @brief Devuelve el tiempo de CLOCK_MONOTONIC en milisegundos.
+ */
+static uint64_t monotonic_ms()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000ULL + (uint64_t)ts.tv_nsec / 1000000ULL;
+}
+
+uint64_t history_now_ms()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000ULL + (uint64_t)ts.tv_nsec / 1000000ULL;
+}
+
+/**
+ * @brief Agrega los `n` bits menos significativos de `value` al bloque.
+ */
+static void put_bits(struct history_block* b, uint64_t value, int n)
+{
+    while (n > 0)
+    {
+        int offset = (int)(b->bits % 64);
+        int take = n < 64 - offset ? n : 64 - offset;
+        uint64_t chunk = (value >> (n - take)) & (take == 64 ? ~0ULL : (1ULL << take) - 1);
+        b->data[b->bits / 64] |= chunk << (64 - offset - take);
+        b->bits += (uint32_t)take;
+        n -= take;
+    }
+}
+
+/**
+ * @brief Lee `n` bits; devuelve 0 si se pasa del final.
+ */
+static uint64_t get_bits(struct bit_reader* r, int n)
+{
+    uint64_t value = 0;
+
+    if (r->pos + (uint32_t)n > r->end)
+    {
+        r->pos = r->end + 1;
+        return 0;
+    }
+    while (n > 0)
+    {
+        int offset = (int)(r->pos % 64);
+        int take = n < 64 - offset ? n : 64 - offset;
+        uint64_t chunk = (r->data[r->pos / 64] >> (64 - offset - take)) & (take == 64 ? ~0ULL : (1ULL << take) - 1);
+        value = take == 64 ? chunk : (value << take) | chunk;
+        r->pos += (uint32_t)take;
+        n -= take;
+    }
+    return value;
+}
+
+/**
+ * @brief Extiende el signo de un entero de `n` bits.
+ */
+static int64_t sign_extend(uint64_t value, int n)
+{
+    uint64_t sign = 1ULL << (n - 1);
+    return (int64_t)((value ^ sign) - sign);
+}
+
+/**
+ * @brief Empieza un bloque nuevo con una muestra completa, pisando el más viejo si el anillo está lleno.
+ */
+static void start_block(struct history_series* s, uint64_t ts, uint64_t value)
+{
+    unsigned head = atomic_load_explicit(&s->head, memory_order_relaxed);
+    unsigned filled = atomic_load_explicit(&s->filled, memory_order_relaxed);
+
+    if (filled != 0)
+    {
+        head = (head + 1) % HISTORY_BLOCKS;
+    }
+    struct history_block* b = &s->blocks[head];
+    unsigned long seq = atomic_load_explicit(&b->sequence, memory_order_relaxed);
+
+    atomic_store_explicit(&b->sequence, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    b->first_ts = ts;
+    b->first_value = value;
+    b->last_ts = ts;
+    b->count = 1;
+    b->bits = 0;
+    memset(b->data, 0, sizeof(b->data));
+    atomic_store_explicit(&b->sequence, seq + 2, memory_order_release);
+
+    atomic_store_explicit(&s->head, head, memory_order_release);
+    if (filled < HISTORY_BLOCKS)
+    {
+        atomic_store_explicit(&s->filled, filled + 1, memory_order_release);
+    }
+    s->prev_ts = ts;
+    s->prev_delta = 0;
+    s->prev_value = value;
+    s->prev_leading = 64;
+    s->prev_trailing = 0;
+}
+
+/**
+ * @brief Codifica una muestra en el bloque actual, o empieza uno nuevo si no entra.
+ */
+static void append_sample(struct history_series* s, uint64_t ts, uint64_t value)
+{
+    struct history_block* b = &s->blocks[atomic_load_explicit(&s->head, memory_order_relaxed)];
+    int64_t delta = (int64_t)(ts - s->prev_ts);
+    int64_t dod = delta - s->prev_delta;
+
+    if (atomic_load_explicit(&s->filled, memory_order_relaxed) == 0 || ts < s->prev_ts ||
+        b->bits + HISTORY_SAMPLE_MAX_BITS > HISTORY_BLOCK_BITS || dod < INT32_MIN || dod > INT32_MAX)
+    {
+        start_block(s, ts, value);
+        return;
+    }
+
+    unsigned long seq = atomic_load_explicit(&b->sequence, memory_order_relaxed);
+    atomic_store_explicit(&b->sequence, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    if (dod == 0)
+    {
+        put_bits(b, 0x0, 1);
+    }
+    else if (dod >= -64 && dod <= 63)
+    {
+        put_bits(b, 0x2, 2);
+        put_bits(b, (uint64_t)dod, 7);
+    }
+    else if (dod >= -256 && dod <= 255)
+    {
+        put_bits(b, 0x6, 3);
+        put_bits(b, (uint64_t)dod, 9);
+    }
+    else if (dod >= -2048 && dod <= 2047)
+    {
+        put_bits(b, 0xE, 4);
+        put_bits(b, (uint64_t)dod, 12);
+    }
+    else
+    {
+        put_bits(b, 0xF, 4);
+        put_bits(b, (uint64_t)dod, 32);
+    }
+
+    uint64_t xor = value ^ s->prev_value;
+    if (xor == 0)
+    {
+        put_bits(b, 0x0, 1);
+    }
+    else
+    {
+        int leading = __builtin_clzll(xor);
+        int trailing = __builtin_ctzll(xor);
+        if (leading > 31)
+        {
+            leading = 31;
+        }
+        if (leading >= s->prev_leading && trailing >= s->prev_trailing)
+        {
+            // Los bits significativos entran en la ventana anterior
+            put_bits(b, 0x2, 2);
+            put_bits(b, xor >> s->prev_trailing, 64 - s->prev_leading - s->prev_trailing);
+        }
+        else
+        {
+            int length = 64 - leading - trailing;
+            put_bits(b, 0x3, 2);
+            put_bits(b, (uint64_t)leading, 5);
+            put_bits(b, (uint64_t)(length - 1), 6);
+            put_bits(b, xor >> trailing, length);
+            s->prev_leading = leading;
+            s->prev_trailing = trailing;
+        }
+    }
+    b->last_ts = ts;
+    b->count++;
+    atomic_store_explicit(&b->sequence, seq + 2, memory_order_release);
+
+    s->prev_delta = delta;
+    s->prev_ts = ts;
+    s->prev_value = value;
+}
+
+void history_append(const double values[METRIC_SCALAR_COUNT])
+{
+    uint64_t ts = monotonic_ms();
+
+    for (int id = 0; id < METRIC_SCALAR_COUNT; id++)
+    {
+        uint64_t bits;
+        memcpy(&bits, &values[id], sizeof(bits));
+        append_sample(&series[id], ts, bits);
+    }
+}
+
+/**
+ * @brief Copia un bloque sin bloquear al escritor, reintentando si cambió durante la copia.
+ */
+static void copy_block(const struct history_block* b, struct history_block* out)
+{
+    unsigned long before, after;
+
+    do
+    {
+        before = atomic_load_explicit(&b->sequence, memory_order_acquire);
+        if (before & 1)
+        {
+            // El escritor está modificando el bloque: ceder el procesador en lugar de girar
+            sched_yield();
+            continue;
+        }
+        out->first_ts = b->first_ts;
+        out->first_value = b->first_value;
+        out->last_ts = b->last_ts;
+        out->count = b->count;
+        out->bits = b->bits;
+        memcpy(out->data, b->data, ((size_t)out->bits + 63) / 64 * sizeof(out->data[0]));
+        atomic_thread_fence(memory_order_acquire);
+        after = atomic_load_explicit(&b->sequence, memory_order_relaxed);
+    } while ((before & 1) || before != after);
+}
+
+/**
+ * @brief Decodifica un bloque y entrega las muestras no anteriores a `*last` ni a `since`.
+ *
+ * @return Muestras entregadas.
+ */
+static int decode_block(const struct history_block* b, uint64_t since, uint64_t offset, uint64_t* last,
+                        history_visit visit, void* ctx)
+{
+    struct bit_reader r = {b->data, 0, b->bits};
+    uint64_t ts = b->first_ts, value = b->first_value;
+    int64_t delta = 0;
+    int leading = 64, trailing = 0, visited = 0;
+
+    for (uint32_t i = 0; i < b->count && r.pos <= r.end; i++)
+    {
+        if (i > 0)
+        {
+            int64_t dod;
+            if (get_bits(&r, 1) == 0)
+            {
+                dod = 0;
+            }
+            else if (get_bits(&r, 1) == 0)
+            {
+                dod = sign_extend(get_bits(&r, 7), 7);
+            }
+            else if (get_bits(&r, 1) == 0)
+            {
+                dod = sign_extend(get_bits(&r, 9), 9);
+            }
+            else if (get_bits(&r, 1) == 0)
+            {
+                dod = sign_extend(get_bits(&r, 12), 12);
+            }
+            else
+            {
+                dod = sign_extend(get_bits(&r, 32), 32);
+            }
+            delta += dod;
+            ts += (uint64_t)delta;
+
+            if (get_bits(&r, 1) != 0)
+            {
+                if (get_bits(&r, 1) != 0)
+                {
+                    leading = (int)get_bits(&r, 5);
+                    trailing = 64 - leading - ((int)get_bits(&r, 6) + 1);
+                }
+                value ^= get_bits(&r, 64 - leading - trailing) << trailing;
+            }
+            if (r.pos > r.end)
+            {
+                break;
+            }
+        }
+
+        // Un bloque que se reutilizó mientras se leía trae muestras más nuevas que las de los
+        // bloques siguientes: se descartan las que retroceden para que la salida quede ordenada
+        uint64_t wall = ts + offset;
+        if (wall >= since && wall >= *last)
+        {
+            double v;
+            memcpy(&v, &value, sizeof(v));
+            visit(ctx, wall, v);
+            *last = wall;
+            visited++;
+        }
+    }
+    return visited;
+}
+
+int history_read(enum metric_id id, uint64_t since_ms, history_visit visit, void* ctx)
+{
+    struct history_block copy;
+
+    if (id < 0 || id >= METRIC_SCALAR_COUNT)
+    {
+        return -1;
+    }
+
+    const struct history_series* s = &series[id];
+    unsigned filled = atomic_load_explicit(&s->filled, memory_order_acquire);
+    unsigned head = atomic_load_explicit(&s->head, memory_order_acquire);
+    unsigned oldest = filled < HISTORY_BLOCKS ? 0 : (head + 1) % HISTORY_BLOCKS;
+    uint64_t offset = history_now_ms() - monotonic_ms();
+    uint64_t last = 0;
+    int visited = 0;
+
+    for (unsigned i = 0; i < filled; i++)
+    {
+        copy_block(&s->blocks[(oldest + i) % HISTORY_BLOCKS], &copy);
+        if (copy.count == 0 || copy.last_ts + offset < since_ms)
+        {
+            continue;
+        }
+        visited += decode_block(&copy, since_ms, offset, &last, visit, ctx);
+    }
+    return visited;
+}
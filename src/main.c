@@ -4,26 +4,160 @@
  *
  * Este archivo contiene la función principal que inicializa las métricas y
  * comienza un hilo para exponer las métricas a través de HTTP. Actualiza
- * continuamente varios indicadores relacionados con el rendimiento del sistema
- * cada segundo.
+ * continuamente varios indicadores relacionados con el rendimiento del sistema,
+ * cada grupo con su propio intervalo (ver scheduler.h).
  */
 
 #include "expose_metrics.h"
+#include "scheduler.h"
 #include "sim_alloc.h"
 #include <pthread.h>
-#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <unistd.h>
 
-#define SLEEP_TIME 1 /**< Tiempo de espera en segundos. */
+#define DEFAULT_INTERVAL_MS 1000 /**< Intervalo por defecto de cada colector en milisegundos. */
+
+/**
+ * @brief Actualiza las métricas de fragmentación de los tres métodos de asignación.
+ */
+static void collect_fragmentation(void)
+{
+    update_scalar_gauges(SCALAR_COLLECT_FRAGMENTATION);
+    update_alloc_latency_gauge();
+    update_alloc_throughput_gauge();
+}
+
+/**
+ * @brief Actualiza las métricas de uso de CPU.
+ */
+static void collect_cpu(void)
+{
+    update_scalar_gauges(SCALAR_COLLECT_CPU); /**< Actualiza el indicador de uso de CPU. */
+    update_percpu_gauge();                    /**< Actualiza el uso de cada CPU por modo. */
+}
+
+/**
+ * @brief Actualiza las métricas de procesos y cambios de contexto.
+ */
+static void collect_processes(void)
+{
+    update_scalar_gauges(SCALAR_COLLECT_PROCESSES); /**< Actualiza los procesos totales y los cambios de contexto. */
+}
+
+/**
+ * @brief Actualiza las métricas de memoria.
+ */
+static void collect_memory(void)
+{
+    update_scalar_gauges(SCALAR_COLLECT_MEMORY); /**< Actualiza el uso, el total y la memoria disponible. */
+}
+
+/**
+ * @brief Actualiza las métricas de fallos de página.
+ */
+static void collect_page_faults(void)
+{
+    update_scalar_gauges(SCALAR_COLLECT_PAGE_FAULTS); /**< Actualiza los fallos de página mayores y menores. */
+}
+
+/**
+ * @brief Actualiza las métricas de disco.
+ */
+static void collect_disk(void)
+{
+    update_scalar_gauges(SCALAR_COLLECT_DISK); /**< Actualiza el uso y las estadísticas del disco. */
+    update_disk_devices_gauge();               /**< Actualiza las tasas de cada disco. */
+}
+
+/**
+ * @brief Actualiza las métricas de red.
+ */
+static void collect_network(void)
+{
+    update_scalar_gauges(SCALAR_COLLECT_NETWORK); /**< Actualiza el uso de red y el ancho de banda. */
+    update_network_interfaces_gauge();            /**< Actualiza las tasas de cada interfaz. */
+}
+
+/**
+ * @brief Actualiza los rankings de procesos.
+ */
+static void collect_process_top(void)
+{
+    update_process_top_gauge(); /**< Actualiza los procesos que más recursos consumen. */
+}
+
+/**
+ * @brief Actualiza las métricas de cada cgroup.
+ */
+static void collect_cgroups(void)
+{
+    update_cgroup_gauge(); /**< Actualiza los valores de cada contenedor. */
+}
+
+/**
+ * @brief Actualiza los histogramas de latencia medidos con eBPF.
+ */
+static void collect_bpf_latency(void)
+{
+    update_bpf_latency_gauge(); /**< Lee los histogramas del kernel. */
+}
+
+/**
+ * @brief Tabla de colectores; los intervalos se pueden cambiar con @ref SCHED_INTERVALS_ENV.
+ */
+static struct sched_task tasks[] = {
+    {"fragmentation", DEFAULT_INTERVAL_MS, 0, collect_fragmentation, 0, 0, 0},
+    {"cpu", DEFAULT_INTERVAL_MS, SCHED_SOURCE(PROC_STAT), collect_cpu, 0, 0, 0},
+    {"processes", DEFAULT_INTERVAL_MS, SCHED_SOURCE(PROC_STAT), collect_processes, 0, 0, 0},
+    {"memory", DEFAULT_INTERVAL_MS, SCHED_SOURCE(PROC_MEMINFO), collect_memory, 0, 0, 0},
+    {"page_faults", DEFAULT_INTERVAL_MS, SCHED_SOURCE(PROC_VMSTAT), collect_page_faults, 0, 0, 0},
+    {"disk", DEFAULT_INTERVAL_MS, SCHED_SOURCE(PROC_DISKSTATS), collect_disk, 0, 0, 0},
+    {"network", DEFAULT_INTERVAL_MS, SCHED_SOURCE(PROC_NET_DEV), collect_network, 0, 0, 0},
+    {"process_top", DEFAULT_INTERVAL_MS, 0, collect_process_top, 0, 0, 0},
+    {"cgroups", DEFAULT_INTERVAL_MS, 0, collect_cgroups, 0, 0, 0},
+    {"bpf_latency", DEFAULT_INTERVAL_MS, 0, collect_bpf_latency, 0, 0, 0},
+};
+
+/**
+ * @brief Informa los ticks salteados de un colector atrasado.
+ */
+static void report_skipped_ticks(const struct sched_task* task, unsigned long long ticks)
+{
+    add_skipped_ticks(task->name, ticks);
+}
+
+/**
+ * @brief Informa la duración de la última ejecución de un colector.
+ */
+static void report_collector_latency(const struct sched_task* task)
+{
+    set_collector_latency(task->name, (double)task->latency_ns / 1e9);
+}
+
+/**
+ * @brief Informa la duración de la última lectura de una fuente de /proc.
+ */
+static void report_source_latency(enum proc_source source, long long latency_ns)
+{
+    set_source_latency(source, (double)latency_ns / 1e9);
+}
+
+/**
+ * @brief Funciones que el planificador llama al terminar los trabajos de cada tick.
+ */
+static const struct sched_hooks hooks = {
+    .on_skip = report_skipped_ticks,
+    .on_collected = report_collector_latency,
+    .on_source_read = report_source_latency,
+    .on_tick = publish_metrics,
+};
 
 /**
  * @brief Función principal de la aplicación.
  *
  * Esta función inicializa la recolección de métricas, crea un hilo para exponer
- * las métricas a través de HTTP y entra en un bucle para actualizar varios
- * indicadores del sistema cada segundo.
+ * las métricas a través de HTTP y entrega el control al planificador, que
+ * actualiza cada grupo de indicadores en sus propios plazos.
  *
  * @param argc Número de argumentos de la línea de comandos.
  * @param argv Array de cadenas de argumentos de la línea de comandos.
@@ -51,36 +185,18 @@ int main(int argc, char* argv[])
         return EXIT_FAILURE; /**< Retorna fallo si la creación del hilo falla. */
     }
 
-    // Bucle principal para actualizar las métricas cada segundo
-    while (true)
+    // Los colectores independientes de cada tick se reparten entre los hilos del pool
+    const char* workers = getenv(WORKER_POOL_SIZE_ENV);
+    struct worker_pool pool;
+    if (worker_pool_init(&pool, workers != NULL ? strtoul(workers, NULL, 10) : WORKER_POOL_DEFAULT_SIZE) != 0)
     {
-        update_external_frag_first_fit();
-        update_external_frag_best_fit();
-        update_external_frag_worst_fit();
-        update_cpu_gauge();               /**< Actualiza el indicador de uso de CPU. */
-        update_memory_gauge();            /**< Actualiza el indicador de uso de memoria. */
-        update_disk_gauge();              /**< Actualiza el indicador de uso de disco. */
-        update_network_gauge();           /**< Actualiza el indicador de uso de red. */
-        update_bandwidth_gauge();         /**< Actualiza el indicador de ancho de banda. */
-        update_major_page_faults_gauge(); /**< Actualiza el indicador de fallos de
-                                             página mayores. */
-        update_minor_page_faults_gauge(); /**< Actualiza el indicador de fallos de
-                                             página menores. */
-        update_memory_avalible_gauge();   /**< Actualiza el indicador de memoria
-                                             disponible. */
-        update_memory_total_gauge();      /**< Actualiza el indicador de memoria total.
-                                           */
-        update_memory_2_gauge();          /**< Actualiza el segundo indicador de memoria. */
-        update_disk_stats_gauge();        /**< Actualiza el indicador de estadísticas del
-                                             disco. */
-        update_total_processes_gauge();   /**< Actualiza el indicador de procesos
-                                             totales. */
-        update_change_context_gauge();    /**< Actualiza el indicador de cambios de
-                                             contexto. */
-
-        sleep(SLEEP_TIME); /**< Duerme durante un periodo definido antes de
-                              actualizar nuevamente. */
+        fprintf(stderr, "Error al crear el pool de colectores\n");
+        return EXIT_FAILURE;
     }
 
+    // Cada colector se ejecuta en sus propios plazos
+    sched_configure(tasks, sizeof(tasks) / sizeof(tasks[0]), getenv(SCHED_INTERVALS_ENV));
+    sched_run(tasks, sizeof(tasks) / sizeof(tasks[0]), &pool, &hooks);
+
     return EXIT_SUCCESS; /**< Retorna éxito si la aplicación finaliza. */
 }
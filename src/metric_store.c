@@ -0,0 +1,58 @@
+/**
+ * @file metric_store.c
+ * @brief Implementación del seqlock de valores de métricas.
+ */
+
+#include "metric_store.h"
+#include <sched.h>
+#include <stdatomic.h>
+#include <string.h>
+
+/**
+ * @brief Contador de secuencia; es impar mientras se escribe la publicación.
+ */
+static atomic_ulong sequence;
+
+/**
+ * @brief Copia de trabajo del escritor.
+ */
+static struct metric_values staged;
+
+/**
+ * @brief Última publicación completa.
+ */
+static struct metric_values published;
+
+struct metric_values* metric_store_stage()
+{
+    return &staged;
+}
+
+void metric_store_publish()
+{
+    unsigned long seq = atomic_load_explicit(&sequence, memory_order_relaxed);
+
+    atomic_store_explicit(&sequence, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    memcpy(&published, &staged, sizeof(published));
+    atomic_store_explicit(&sequence, seq + 2, memory_order_release);
+}
+
+void metric_store_read(struct metric_values* out)
+{
+    unsigned long before, after = 0;
+
+    do
+    {
+        before = atomic_load_explicit(&sequence, memory_order_acquire);
+        if (before & 1)
+        {
+            // El escritor está copiando: ceder el procesador en lugar de girar
+            sched_yield();
+            continue;
+        }
+        memcpy(out, &published, sizeof(*out));
+        atomic_thread_fence(memory_order_acquire);
+        after = atomic_load_explicit(&sequence, memory_order_relaxed);
+    } while ((before & 1) || before != after);
+}
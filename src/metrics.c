@@ -7,6 +7,10 @@
  * Las métricas se recolectan desde los archivos del sistema en /proc y se
  * exponen a través de Prometheus para su visualización en Grafana.
  *
+ * Cada archivo de /proc se abre una sola vez en init_proc_sources() y se relee
+ * con pread() una vez por tick mediante update_proc_snapshot(); las funciones
+ * get_* solo derivan sus valores del snapshot resultante.
+ *
  * Funciones incluidas:
  * - get_average_bandwidth(): Calcula el ancho de banda promedio de red.
  * - get_minor_page_faults(): Obtiene la cantidad de fallos de página menores.
@@ -14,7 +18,12 @@
  */
 
 #include "metrics.h"
+#include "proc_parse.h"
+#include "proc_reader.h"
+#include "rate.h"
 #include "sim_alloc.h"
+#include <fnmatch.h>
+#include <limits.h>
 #include <stdio.h>
 #include <string.h>
 #include <time.h>
@@ -59,273 +68,718 @@ double get_external_frag_worst_fit()
 }
 
 /**
- * @brief Obtiene el número total de cambios de contexto desde /proc/stat.
+ * @brief Obtiene la fragmentación externa para el método Segregated Fit.
  *
- * Lee el archivo /proc/stat y busca la línea que contiene el número
- * de cambios de contexto (línea que comienza con 'ctxt').
+ * Esta función es un wrapper que llama a `get_frag_segregated_fit()` para recuperar
+ * el valor actual de la fragmentación externa calculada con listas segregadas.
  *
- * @return El número total de cambios de contexto como un valor unsigned long
- * long. Si ocurre un error, devuelve -1.
+ * @return El valor de la fragmentación externa para Segregated Fit.
  */
-unsigned long long get_change_context()
+double get_external_frag_segregated_fit()
+{
+    return get_frag_segregated_fit();
+}
+
+/**
+ * @brief Obtiene la latencia media por operación del simulador de asignación.
+ *
+ * @param method Política de asignación, entre 0 y @ref SIM_METHOD_COUNT - 1.
+ * @return Nanosegundos por operación, o -1 si el método es inválido.
+ */
+double get_alloc_latency(int method)
+{
+    return get_alloc_latency_ns(method);
+}
+
+/**
+ * @brief Obtiene las operaciones por segundo del simulador de asignación.
+ *
+ * @param method Política de asignación, entre 0 y @ref SIM_METHOD_COUNT - 1.
+ * @return Operaciones por segundo, o -1 si el método es inválido.
+ */
+double get_alloc_throughput(int method)
 {
-    FILE* fp;
-    char buffer[BUFFER_SIZE];
-    unsigned long long cambios = 0;
+    return get_alloc_throughput_ops(method);
+}
+
+/**
+ * @brief Snapshot compartido con los valores leídos en el último tick.
+ */
+static struct proc_snapshot snapshot;
 
-    // Abrir el archivo /proc/stat
-    fp = fopen("/proc/stat", "r");
-    if (fp == NULL)
+/**
+ * @brief Archivo de cada fuente relativo a la raíz de /proc, indexado por @ref proc_source.
+ */
+static const char* const proc_files[PROC_SOURCE_COUNT] = {
+    [PROC_STAT] = "stat",
+    [PROC_MEMINFO] = "meminfo",
+    [PROC_VMSTAT] = "vmstat",
+    [PROC_DISKSTATS] = "diskstats",
+    [PROC_NET_DEV] = "net/dev",
+};
+
+/**
+ * @brief Ruta completa de cada fuente, armada por set_proc_root().
+ */
+static char proc_paths[PROC_SOURCE_COUNT][PATH_MAX];
+
+/**
+ * @brief Lectores persistentes de cada fuente, abiertos en init_proc_sources().
+ */
+static struct proc_reader readers[PROC_SOURCE_COUNT] = {
+    [PROC_STAT] = {.fd = -1},
+    [PROC_MEMINFO] = {.fd = -1},
+    [PROC_VMSTAT] = {.fd = -1},
+    [PROC_DISKSTATS] = {.fd = -1},
+    [PROC_NET_DEV] = {.fd = -1},
+};
+
+/**
+ * @brief Parsea una línea 'cpuN' de /proc/stat en el arreglo por CPU.
+ *
+ * @param p Cursor tras el prefijo "cpu".
+ */
+static void parse_percpu_line(const char* p)
+{
+    struct percpu_times* t = &snapshot.percpu;
+    unsigned long long cpu, value;
+
+    if ((p = parse_u64(p, &cpu)) == NULL || cpu >= MAX_CPUS)
     {
-        perror("Error al abrir /proc/stat");
-        return -1;
+        return;
     }
 
-    // Leer el archivo línea por línea
-    while (fgets(buffer, sizeof(buffer), fp) != NULL)
+    for (int i = 0; i < CPU_STATE_COUNT; i++)
     {
-        // Buscar la línea que comienza con 'ctxt'
-        if (sscanf(buffer, "ctxt %llu", &cambios) == 1)
+        if ((p = parse_u64(p, &value)) == NULL)
         {
-            break;
+            return;
         }
+        t->times[i][cpu] = value;
     }
 
-    fclose(fp);
+    t->online[cpu] = 1;
+    if (cpu + 1 > t->count)
+    {
+        t->count = cpu + 1;
+    }
+}
 
-    if (cambios == 0)
+/**
+ * @brief Parsea /proc/stat en una sola pasada.
+ *
+ * Obtiene los tiempos agregados de CPU, los cambios de contexto y los procesos
+ * creados.
+ */
+static int parse_stat(const char* buf)
+{
+    int found = 0;
+
+    memset(snapshot.percpu.online, 0, snapshot.percpu.count);
+    snapshot.percpu.count = 0;
+
+    for (const char* line = buf; line != NULL; line = parse_next_line(line))
     {
-        fprintf(stderr, "No se encontró el número de cambios en /proc/stat\n");
-        return -1;
+        const char* p;
+        if ((p = PARSE_KEY(line, "cpu ")) != NULL)
+        {
+            int i = 0;
+            while (i < CPU_STATE_COUNT && (p = parse_u64(p, &snapshot.cpu[i])) != NULL)
+            {
+                i++;
+            }
+            found += i == CPU_STATE_COUNT;
+        }
+        else if ((p = PARSE_KEY(line, "cpu")) != NULL)
+        {
+            parse_percpu_line(p);
+        }
+        else if ((p = PARSE_KEY(line, "ctxt ")) != NULL)
+        {
+            found += parse_u64(p, &snapshot.ctxt) != NULL;
+        }
+        else if ((p = PARSE_KEY(line, "processes ")) != NULL)
+        {
+            found += parse_u64(p, &snapshot.processes) != NULL;
+        }
     }
+    return found == 3 ? 0 : -1;
+}
 
-    return cambios;
+/**
+ * @brief Parsea /proc/meminfo en una sola pasada.
+ */
+static int parse_meminfo(const char* buf)
+{
+    int found = 0;
+
+    for (const char* line = buf; found < 2 && line != NULL; line = parse_next_line(line))
+    {
+        const char* p;
+        if ((p = PARSE_KEY(line, "MemTotal:")) != NULL)
+        {
+            found += parse_u64(p, &snapshot.mem_total) != NULL;
+        }
+        else if ((p = PARSE_KEY(line, "MemAvailable:")) != NULL)
+        {
+            found += parse_u64(p, &snapshot.mem_available) != NULL;
+        }
+    }
+    return found == 2 ? 0 : -1;
 }
 
 /**
- * @brief Obtiene el número total de procesos creados desde el inicio del
- * sistema.
+ * @brief Parsea /proc/vmstat en una sola pasada.
+ */
+static int parse_vmstat(const char* buf)
+{
+    int found = 0;
+
+    for (const char* line = buf; found < 2 && line != NULL; line = parse_next_line(line))
+    {
+        const char* p;
+        if ((p = PARSE_KEY(line, "pgfault ")) != NULL)
+        {
+            found += parse_u64(p, &snapshot.pgfault) != NULL;
+        }
+        else if ((p = PARSE_KEY(line, "pgmajfault ")) != NULL)
+        {
+            found += parse_u64(p, &snapshot.pgmajfault) != NULL;
+        }
+    }
+    return found == 2 ? 0 : -1;
+}
+
+/**
+ * @brief Cantidad máxima de patrones de discos.
+ */
+#define MAX_DISK_PATTERNS 16
+
+/**
+ * @brief Cantidad de líneas de /proc/diskstats cuyo resultado de fnmatch se
+ * recuerda entre ticks.
+ */
+#define DISK_MATCH_CACHE_LINES 128
+
+/**
+ * @brief Copia de la lista de patrones; `disk_patterns` apunta dentro de ella.
+ */
+static char disk_patterns_buf[BUFFER_SIZE];
+
+/**
+ * @brief Patrones fnmatch(3) de los discos seguidos.
+ */
+static const char* disk_patterns[MAX_DISK_PATTERNS];
+
+/**
+ * @brief Cantidad de patrones válidos en `disk_patterns`.
+ */
+static size_t disk_pattern_count;
+
+/**
+ * @brief Resultado de fnmatch recordado para una línea de /proc/diskstats.
  *
- * Lee el archivo /proc/stat y busca la línea que contiene el número de procesos
- * (línea que comienza con 'processes').
+ * La lista de dispositivos casi nunca cambia entre ticks, así que si la línea
+ * i tiene el mismo nombre que en el tick anterior se reutiliza el resultado.
+ */
+struct disk_match
+{
+    char name[DISK_NAME_LEN]; /**< Nombre visto en esa línea. */
+    int match;                /**< 1 si coincide con algún patrón. */
+};
+
+/**
+ * @brief Cache de coincidencias indexada por número de línea.
+ */
+static struct disk_match disk_match_cache[DISK_MATCH_CACHE_LINES];
+
+void set_disk_devices(const char* patterns)
+{
+    if (patterns == NULL || *patterns == '\0')
+    {
+        patterns = DISK_DEVICES_DEFAULT;
+    }
+
+    snprintf(disk_patterns_buf, sizeof(disk_patterns_buf), "%s", patterns);
+    disk_pattern_count = 0;
+
+    char* save = NULL;
+    for (char* tok = strtok_r(disk_patterns_buf, ", ", &save); tok != NULL && disk_pattern_count < MAX_DISK_PATTERNS;
+         tok = strtok_r(NULL, ", ", &save))
+    {
+        disk_patterns[disk_pattern_count++] = tok;
+    }
+
+    // Los resultados anteriores ya no son válidos
+    memset(disk_match_cache, 0, sizeof(disk_match_cache));
+}
+
+/**
+ * @brief Indica si un dispositivo coincide con alguno de los patrones.
  *
- * @return El número total de procesos creados como un valor unsigned long long.
- * Si ocurre un error, devuelve -1.
+ * @param line Número de línea en /proc/diskstats, usado como clave de la cache.
+ * @param name Nombre del dispositivo.
  */
-unsigned long long get_total_processes()
+static int disk_matches(size_t line, const char* name)
 {
-    FILE* fp;
-    char buffer[BUFFER_SIZE];
-    unsigned long long processes = 0;
+    struct disk_match* cached = line < DISK_MATCH_CACHE_LINES ? &disk_match_cache[line] : NULL;
 
-    // Abrir el archivo /proc/stat
-    fp = fopen("/proc/stat", "r");
-    if (fp == NULL)
+    if (cached != NULL && cached->name[0] != '\0' && strcmp(cached->name, name) == 0)
     {
-        perror("Error al abrir /proc/stat");
-        return -1;
+        return cached->match;
+    }
+
+    int match = 0;
+    for (size_t i = 0; i < disk_pattern_count && !match; i++)
+    {
+        match = fnmatch(disk_patterns[i], name, 0) == 0;
+    }
+
+    if (cached != NULL)
+    {
+        snprintf(cached->name, sizeof(cached->name), "%s", name);
+        cached->match = match;
+    }
+    return match;
+}
+
+/**
+ * @brief Parsea /proc/diskstats guardando los discos que coinciden con los
+ * patrones configurados.
+ */
+static int parse_diskstats(const char* buf)
+{
+    size_t count = 0, index = 0;
+
+    if (disk_pattern_count == 0)
+    {
+        set_disk_devices(getenv(DISK_DEVICES_ENV));
     }
 
-    // Leer el archivo línea por línea
-    while (fgets(buffer, sizeof(buffer), fp) != NULL)
+    for (const char* line = buf; line != NULL && count < MAX_DISK_DEVICES; line = parse_next_line(line), index++)
     {
-        // Buscar la línea que comienza con 'processes'
-        if (sscanf(buffer, "processes %llu", &processes) == 1)
+        struct disk_device* d = &snapshot.disks[count];
+
+        // major minor nombre lecturas - sectores_leídos - escrituras - sectores_escritos
+        const char* p = parse_skip_fields(line, 2);
+        if (p == NULL || (p = parse_name(p, d->name, sizeof(d->name), '\0')) == NULL || !disk_matches(index, d->name))
         {
-            break;
+            continue;
+        }
+        if ((p = parse_u64(p, &d->reads)) != NULL && (p = parse_skip_fields(p, 1)) != NULL &&
+            (p = parse_u64(p, &d->read_sectors)) != NULL && (p = parse_skip_fields(p, 1)) != NULL &&
+            (p = parse_u64(p, &d->writes)) != NULL && (p = parse_skip_fields(p, 1)) != NULL &&
+            parse_u64(p, &d->write_sectors) != NULL)
+        {
+            count++;
         }
     }
 
-    fclose(fp);
+    snapshot.disk_count = count;
+    return 0;
+}
 
-    if (processes == 0)
+/**
+ * @brief Cantidad máxima de patrones de interfaces, incluyendo los que excluyen.
+ */
+#define MAX_NET_PATTERNS 16
+
+/**
+ * @brief Cantidad de líneas de /proc/net/dev cuyo resultado de fnmatch se
+ * recuerda entre ticks.
+ */
+#define NET_MATCH_CACHE_LINES 64
+
+/**
+ * @brief Copia de la lista de patrones; `net_patterns` apunta dentro de ella.
+ */
+static char net_patterns_buf[BUFFER_SIZE];
+
+/**
+ * @brief Patrones fnmatch(3) de las interfaces, sin el '!' de los que excluyen.
+ */
+static const char* net_patterns[MAX_NET_PATTERNS];
+
+/**
+ * @brief 1 si el patrón de la misma posición en `net_patterns` excluye.
+ */
+static unsigned char net_pattern_excludes[MAX_NET_PATTERNS];
+
+/**
+ * @brief Cantidad de patrones válidos en `net_patterns`.
+ */
+static size_t net_pattern_count;
+
+/**
+ * @brief 1 si algún patrón incluye; si no, se siguen todas las interfaces no excluidas.
+ */
+static int net_has_includes;
+
+/**
+ * @brief Resultado de fnmatch recordado para una línea de /proc/net/dev, como @ref disk_match.
+ */
+struct net_match
+{
+    char name[NET_NAME_LEN]; /**< Nombre visto en esa línea. */
+    int match;               /**< 1 si la interfaz se sigue. */
+};
+
+/**
+ * @brief Cache de coincidencias indexada por número de línea.
+ */
+static struct net_match net_match_cache[NET_MATCH_CACHE_LINES];
+
+void set_net_interfaces(const char* patterns)
+{
+    if (patterns == NULL || *patterns == '\0')
     {
-        fprintf(stderr, "No se encontró el número de procesos en /proc/stat\n");
-        return -1;
+        patterns = NET_INTERFACES_DEFAULT;
     }
 
-    return processes;
+    snprintf(net_patterns_buf, sizeof(net_patterns_buf), "%s", patterns);
+    net_pattern_count = 0;
+    net_has_includes = 0;
+
+    char* save = NULL;
+    for (char* tok = strtok_r(net_patterns_buf, ", ", &save); tok != NULL && net_pattern_count < MAX_NET_PATTERNS;
+         tok = strtok_r(NULL, ", ", &save))
+    {
+        int excludes = tok[0] == '!';
+        net_pattern_excludes[net_pattern_count] = (unsigned char)excludes;
+        net_patterns[net_pattern_count++] = tok + excludes;
+        net_has_includes |= !excludes;
+    }
+
+    // Los resultados anteriores ya no son válidos
+    memset(net_match_cache, 0, sizeof(net_match_cache));
 }
 
 /**
- * @brief Obtiene las estadísticas de lectura y escritura del disco desde
- * /proc/diskstats.
- *
- * Lee el archivo /proc/diskstats y obtiene los valores de lectura y escritura
- * correspondientes al dispositivo 'sda'. Retorna la suma de los bytes leídos y
- * escritos.
+ * @brief Indica si una interfaz se sigue según los patrones.
  *
- * @return El total de lecturas y escrituras en el disco como un valor double.
- * Si ocurre un error, devuelve -1.0.
+ * @param line Número de línea en /proc/net/dev, usado como clave de la cache.
+ * @param name Nombre de la interfaz.
  */
-double get_disk_stats()
+static int net_matches(size_t line, const char* name)
 {
-    FILE* fp;
-    char buffer[BUFFER_SIZE];
-    unsigned long long read = 0, write = 0, total = 0;
+    struct net_match* cached = line < NET_MATCH_CACHE_LINES ? &net_match_cache[line] : NULL;
 
-    // Abrir el archivo /proc/diskstats
-    fp = fopen("/proc/diskstats", "r");
-    if (fp == NULL)
+    if (cached != NULL && cached->name[0] != '\0' && strcmp(cached->name, name) == 0)
     {
-        perror("\nError de apertura del archivo");
-        return -1.0;
+        return cached->match;
     }
 
-    // Leer los valores de lectura y escritura del dispositivo 'sda'
-    while (fgets(buffer, sizeof(buffer), fp) != NULL)
+    int included = !net_has_includes, excluded = 0;
+    for (size_t i = 0; i < net_pattern_count && !excluded; i++)
     {
-        if (sscanf(buffer, "%*u %*u sda %llu %*u %*u %*u %llu", &read, &write) == 1)
+        if (fnmatch(net_patterns[i], name, 0) == 0)
         {
-            break; // Valores encontrados
+            excluded = net_pattern_excludes[i];
+            included |= !net_pattern_excludes[i];
         }
     }
 
-    fclose(fp);
+    if (cached != NULL)
+    {
+        snprintf(cached->name, sizeof(cached->name), "%s", name);
+        cached->match = included && !excluded;
+    }
+    return included && !excluded;
+}
 
-    // Verificar si se encontraron los valores
-    if (read == 0)
+/**
+ * @brief Parsea /proc/net/dev en una sola pasada.
+ *
+ * Suma rx/tx de todas las interfaces, guarda los bytes de cada una y los
+ * contadores de las que coinciden con los patrones configurados.
+ */
+static int parse_net_dev(const char* buf)
+{
+    unsigned long long rx_bytes = 0, tx_bytes = 0;
+    size_t count = 0, index = 0, totals = 0;
+
+    if (net_pattern_count == 0)
     {
-        fprintf(stderr, "Error al leer la información del disco desde /proc/diskstats\n");
-        return -1.0;
+        set_net_interfaces(getenv(NET_INTERFACES_ENV));
     }
 
-    total = read + write;
+    // Saltar las primeras dos líneas que son encabezados
+    const char* line = parse_next_line(buf);
+    line = line != NULL ? parse_next_line(line) : NULL;
 
-    return total;
+    // Leer las estadísticas de las interfaces de red
+    for (; line != NULL; line = parse_next_line(line), index++)
+    {
+        struct net_interface tmp;
+        struct net_interface* n = count < MAX_NET_INTERFACES ? &snapshot.nets[count] : &tmp;
+        unsigned long long* c = n->counters;
+
+        // nombre: bytes paquetes errores descartes fifo frame compressed multicast, y lo mismo para tx
+        const char* p = parse_name(line, n->name, sizeof(n->name), ':');
+        if (p != NULL && (p = parse_u64(p, &c[NET_RX_BYTES])) != NULL &&
+            (p = parse_u64(p, &c[NET_RX_PACKETS])) != NULL && (p = parse_u64(p, &c[NET_RX_ERRORS])) != NULL &&
+            (p = parse_u64(p, &c[NET_RX_DROPS])) != NULL && (p = parse_skip_fields(p, 4)) != NULL &&
+            (p = parse_u64(p, &c[NET_TX_BYTES])) != NULL && (p = parse_u64(p, &c[NET_TX_PACKETS])) != NULL &&
+            (p = parse_u64(p, &c[NET_TX_ERRORS])) != NULL && parse_u64(p, &c[NET_TX_DROPS]) != NULL)
+        {
+            rx_bytes += c[NET_RX_BYTES];
+            tx_bytes += c[NET_TX_BYTES];
+            if (totals < MAX_NET_INTERFACES)
+            {
+                struct net_total* t = &snapshot.net_totals[totals++];
+                memcpy(t->name, n->name, sizeof(t->name));
+                t->rx_bytes = c[NET_RX_BYTES];
+                t->tx_bytes = c[NET_TX_BYTES];
+            }
+            if (n != &tmp && net_matches(index, n->name))
+            {
+                count++;
+            }
+        }
+    }
+
+    snapshot.net_rx_bytes = rx_bytes;
+    snapshot.net_tx_bytes = tx_bytes;
+    snapshot.net_count = count;
+    snapshot.net_total_count = totals;
+    return 0;
+}
+
+void set_proc_root(const char* root)
+{
+    if (root == NULL || *root == '\0')
+    {
+        root = PROC_ROOT_DEFAULT;
+    }
+    // Los lectores abiertos apuntan a la raíz anterior: se reabren en la próxima lectura
+    close_proc_sources();
+    for (int i = 0; i < PROC_SOURCE_COUNT; i++)
+    {
+        snprintf(proc_paths[i], sizeof(proc_paths[i]), "%s/%s", root, proc_files[i]);
+    }
 }
 
 /**
- * @brief Obtiene el total de memoria disponible en el sistema desde
- * /proc/meminfo.
- *
- * Lee el archivo /proc/meminfo y busca la línea que contiene el valor de
- * 'MemTotal'.
- *
- * @return El valor total de memoria disponible en kilobytes como un valor
- * double. Si ocurre un error, devuelve -1.0.
+ * @brief Arma las rutas desde @ref PROC_ROOT_ENV si todavía no se eligió una raíz.
  */
-double get_memory_total()
+static void ensure_proc_root()
 {
-    FILE* fp;
-    char buffer[BUFFER_SIZE];
-    unsigned long long total_mem = 0;
+    if (proc_paths[0][0] == '\0')
+    {
+        set_proc_root(getenv(PROC_ROOT_ENV));
+    }
+}
 
-    // Abrir el archivo /proc/meminfo
-    fp = fopen("/proc/meminfo", "r");
-    if (fp == NULL)
+int init_proc_sources()
+{
+    int ret = 0;
+    ensure_proc_root();
+    for (int i = 0; i < PROC_SOURCE_COUNT; i++)
     {
-        perror("Error al abrir /proc/meminfo");
-        return -1.0;
+        if (readers[i].fd < 0 && proc_reader_open(&readers[i], proc_paths[i]) != 0)
+        {
+            ret = -1;
+        }
     }
+    return ret;
+}
 
-    // Leer el valor de MemTotal
-    while (fgets(buffer, sizeof(buffer), fp) != NULL)
+void close_proc_sources()
+{
+    for (int i = 0; i < PROC_SOURCE_COUNT; i++)
     {
-        if (sscanf(buffer, "MemTotal: %llu kB", &total_mem) == 1)
+        proc_reader_close(&readers[i]);
+    }
+}
+
+int parse_proc_source(enum proc_source source, const char* buf)
+{
+    static int (*const parsers[PROC_SOURCE_COUNT])(const char*) = {
+        [PROC_STAT] = parse_stat,
+        [PROC_MEMINFO] = parse_meminfo,
+        [PROC_VMSTAT] = parse_vmstat,
+        [PROC_DISKSTATS] = parse_diskstats,
+        [PROC_NET_DEV] = parse_net_dev,
+    };
+
+    return parsers[source](buf);
+}
+
+int update_proc_source(enum proc_source source)
+{
+    struct proc_reader* r = &readers[source];
+
+    snapshot.valid[source] = 0;
+
+    // Reintentar la apertura si init_proc_sources() no pudo abrir la fuente
+    ensure_proc_root();
+    if (r->fd < 0 && proc_reader_open(r, proc_paths[source]) != 0)
+    {
+        return -1;
+    }
+
+    if (proc_reader_read(r) < 0)
+    {
+        return -1;
+    }
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    if (parse_proc_source(source, r->buf) != 0)
+    {
+        fprintf(stderr, "Error al parsear %s\n", proc_paths[source]);
+        return -1;
+    }
+
+    snapshot.ts_ns[source] = (unsigned long long)ts.tv_sec * 1000000000ULL + (unsigned long long)ts.tv_nsec;
+    snapshot.valid[source] = 1;
+    return 0;
+}
+
+int update_proc_snapshot()
+{
+    int ret = 0;
+    for (int i = 0; i < PROC_SOURCE_COUNT; i++)
+    {
+        if (update_proc_source(i) != 0)
         {
-            break; // MemTotal encontrado
+            ret = -1;
         }
     }
+    return ret;
+}
 
-    fclose(fp);
+const struct proc_snapshot* get_proc_snapshot()
+{
+    return &snapshot;
+}
 
-    // Verificar si se encontró el valor
-    if (total_mem == 0)
+/**
+ * @brief Obtiene el número total de cambios de contexto desde /proc/stat.
+ *
+ * Devuelve el valor de la línea 'ctxt' leído en el último snapshot.
+ *
+ * @return El número total de cambios de contexto como un valor unsigned long
+ * long. Si ocurre un error, devuelve -1.
+ */
+unsigned long long get_change_context()
+{
+    if (!snapshot.valid[PROC_STAT] || snapshot.ctxt == 0)
     {
-        fprintf(stderr, "Error al leer la información de memoria desde /proc/meminfo\n");
-        return -1.0;
+        fprintf(stderr, "No se encontró el número de cambios en /proc/stat\n");
+        return -1;
     }
 
-    return total_mem;
+    return snapshot.ctxt;
 }
 
 /**
- * @brief Obtiene la cantidad de memoria disponible en el sistema desde
- * /proc/meminfo.
+ * @brief Obtiene el número total de procesos creados desde el inicio del
+ * sistema.
  *
- * Lee el archivo /proc/meminfo y busca la línea que contiene el valor de
- * 'MemAvailable'.
+ * Devuelve el valor de la línea 'processes' leído en el último snapshot.
  *
- * @return El valor de memoria disponible en kilobytes como un valor double.
+ * @return El número total de procesos creados como un valor unsigned long long.
+ * Si ocurre un error, devuelve -1.
+ */
+unsigned long long get_total_processes()
+{
+    if (!snapshot.valid[PROC_STAT] || snapshot.processes == 0)
+    {
+        fprintf(stderr, "No se encontró el número de procesos en /proc/stat\n");
+        return -1;
+    }
+
+    return snapshot.processes;
+}
+
+/**
+ * @brief Obtiene las estadísticas de lectura y escritura de los discos desde
+ * /proc/diskstats.
+ *
+ * Suma las lecturas y escrituras completadas de todos los discos seguidos en
+ * el snapshot de /proc/diskstats.
+ *
+ * @return El total de lecturas y escrituras en los discos como un valor double.
  * Si ocurre un error, devuelve -1.0.
  */
-double get_memory_avalible()
+double get_disk_stats()
 {
-    FILE* fp;
-    char buffer[BUFFER_SIZE];
-    unsigned long long free_mem = 0;
+    unsigned long long total = 0;
 
-    // Abrir el archivo /proc/meminfo
-    fp = fopen("/proc/meminfo", "r");
-    if (fp == NULL)
+    // Verificar si se encontraron discos
+    if (!snapshot.valid[PROC_DISKSTATS] || snapshot.disk_count == 0)
     {
-        perror("Error al abrir /proc/meminfo");
+        fprintf(stderr, "Error al leer la información del disco desde /proc/diskstats\n");
         return -1.0;
     }
 
-    // Leer el valor de MemAvailable
-    while (fgets(buffer, sizeof(buffer), fp) != NULL)
+    for (size_t i = 0; i < snapshot.disk_count; i++)
     {
-        if (sscanf(buffer, "MemAvailable: %llu kB", &free_mem) == 1)
-        {
-            break; // MemAvailable encontrado
-        }
+        total += snapshot.disks[i].reads + snapshot.disks[i].writes;
     }
 
-    fclose(fp);
+    return total;
+}
 
+/**
+ * @brief Obtiene el total de memoria disponible en el sistema desde
+ * /proc/meminfo.
+ *
+ * Devuelve el valor de 'MemTotal' leído en el último snapshot.
+ *
+ * @return El valor total de memoria disponible en kilobytes como un valor
+ * double. Si ocurre un error, devuelve -1.0.
+ */
+double get_memory_total()
+{
     // Verificar si se encontró el valor
-    if (free_mem == 0)
+    if (!snapshot.valid[PROC_MEMINFO] || snapshot.mem_total == 0)
     {
         fprintf(stderr, "Error al leer la información de memoria desde /proc/meminfo\n");
         return -1.0;
     }
 
-    return free_mem;
+    return snapshot.mem_total;
 }
 
 /**
- * @brief Calcula el porcentaje de uso de memoria en el sistema.
+ * @brief Obtiene la cantidad de memoria disponible en el sistema desde
+ * /proc/meminfo.
  *
- * Lee el archivo /proc/meminfo para obtener los valores de 'MemTotal' y
- * 'MemAvailable', y calcula el porcentaje de memoria usada en base a estos
- * valores.
+ * Devuelve el valor de 'MemAvailable' leído en el último snapshot.
  *
- * @return El porcentaje de uso de memoria como un valor double.
+ * @return El valor de memoria disponible en kilobytes como un valor double.
  * Si ocurre un error, devuelve -1.0.
  */
-double get_memory_usage()
+double get_memory_avalible()
 {
-    FILE* fp;
-    char buffer[BUFFER_SIZE];
-    unsigned long long total_mem = 0, free_mem = 0;
-
-    // Abrir el archivo /proc/meminfo
-    fp = fopen("/proc/meminfo", "r");
-    if (fp == NULL)
+    // Verificar si se encontró el valor
+    if (!snapshot.valid[PROC_MEMINFO] || snapshot.mem_available == 0)
     {
-        perror("Error al abrir /proc/meminfo");
+        fprintf(stderr, "Error al leer la información de memoria desde /proc/meminfo\n");
         return -1.0;
     }
 
-    // Leer los valores de MemTotal y MemAvailable
-    while (fgets(buffer, sizeof(buffer), fp) != NULL)
-    {
-        if (sscanf(buffer, "MemTotal: %llu kB", &total_mem) == 1)
-        {
-            continue; // MemTotal encontrado
-        }
-        if (sscanf(buffer, "MemAvailable: %llu kB", &free_mem) == 1)
-        {
-            break; // MemAvailable encontrado, podemos dejar de leer
-        }
-    }
+    return snapshot.mem_available;
+}
 
-    fclose(fp);
+/**
+ * @brief Calcula el porcentaje de uso de memoria en el sistema.
+ *
+ * Usa los valores de 'MemTotal' y 'MemAvailable' del último snapshot y
+ * calcula el porcentaje de memoria usada en base a estos valores.
+ *
+ * @return El porcentaje de uso de memoria como un valor double.
+ * Si ocurre un error, devuelve -1.0.
+ */
+double get_memory_usage()
+{
+    unsigned long long total_mem = snapshot.mem_total, free_mem = snapshot.mem_available;
 
     // Verificar si se encontraron ambos valores
-    if (total_mem == 0 || free_mem == 0)
+    if (!snapshot.valid[PROC_MEMINFO] || total_mem == 0 || free_mem == 0)
     {
         fprintf(stderr, "Error al leer la información de memoria desde /proc/meminfo\n");
         return -1.0;
@@ -352,188 +806,330 @@ double get_memory_usage_2()
 /**
  * @brief Calcula el porcentaje de uso de CPU en el sistema.
  *
- * Lee el archivo /proc/stat para obtener los tiempos de CPU y calcula el
- * porcentaje de uso en base a las diferencias de tiempos entre lecturas
- * consecutivas.
+ * Usa los tiempos de CPU del snapshot de /proc/stat y calcula el porcentaje
+ * de uso en base a las diferencias de tiempos entre lecturas consecutivas.
+ * Los tiempos ocupado y total se guardan como muestras con marca de tiempo, de
+ * modo que una caída de los contadores (por ejemplo al desconectar una CPU) se
+ * detecta como reinicio en lugar de producir un valor absurdo.
  *
- * @return El porcentaje de uso de CPU como un valor double. Si ocurre un error,
- * devuelve -1.0.
+ * @return El porcentaje de uso de CPU como un valor double, 0.0 si todavía no
+ * hay dos lecturas válidas, o -1.0 si ocurre un error.
  */
 double get_cpu_usage()
 {
-    static unsigned long long prev_user = 0, prev_nice = 0, prev_system = 0, prev_idle = 0, prev_iowait = 0,
-                              prev_irq = 0, prev_softirq = 0, prev_steal = 0;
-    unsigned long long user, nice, system, idle, iowait, irq, softirq, steal;
-    unsigned long long totald, idled;
-    double cpu_usage_percent;
+    static struct rate_sample busy_sample, total_sample;
+    unsigned long long busy_delta = 0, total_delta = 0, elapsed_ns;
 
-    // Abrir el archivo /proc/stat
-    FILE* fp = fopen("/proc/stat", "r");
-    if (fp == NULL)
+    if (!snapshot.valid[PROC_STAT])
     {
-        perror("Error al abrir /proc/stat");
+        fprintf(stderr, "Error al parsear /proc/stat\n");
         return -1.0;
     }
 
-    char buffer[BUFFER_SIZE * 4];
-    if (fgets(buffer, sizeof(buffer), fp) == NULL)
+    // Tiempo ocupado y total a partir de los tiempos de CPU del snapshot
+    const unsigned long long* cpu = snapshot.cpu;
+    unsigned long long busy =
+        cpu[CPU_USER] + cpu[CPU_NICE] + cpu[CPU_SYSTEM] + cpu[CPU_IRQ] + cpu[CPU_SOFTIRQ] + cpu[CPU_STEAL];
+    unsigned long long total = busy + cpu[CPU_IDLE] + cpu[CPU_IOWAIT];
+    unsigned long long ts = snapshot.ts_ns[PROC_STAT];
+
+    // Se actualizan ambas muestras aunque una falle, para que la próxima lectura tenga base
+    int busy_status = rate_sample_update(&busy_sample, busy, ts, &busy_delta, &elapsed_ns);
+    int total_status = rate_sample_update(&total_sample, total, ts, &total_delta, &elapsed_ns);
+    if (busy_status != 0 || total_status != 0 || total_delta == 0 || busy_delta > total_delta)
     {
-        perror("Error al leer /proc/stat");
-        fclose(fp);
-        return -1.0;
+        return 0.0;
     }
-    fclose(fp);
 
-    // Analizar los valores de tiempo de CPU
-    int ret = sscanf(buffer, "cpu  %llu %llu %llu %llu %llu %llu %llu %llu", &user, &nice, &system, &idle, &iowait,
-                     &irq, &softirq, &steal);
-    if (ret < 8)
-    {
-        fprintf(stderr, "Error al parsear /proc/stat\n");
-        return -1.0;
-    }
+    return ((double)busy_delta / (double)total_delta) * 100.0;
+}
 
-    // Calcular las diferencias entre las lecturas actuales y anteriores
-    unsigned long long prev_idle_total = prev_idle + prev_iowait;
-    unsigned long long idle_total = idle + iowait;
+const struct percpu_usage* get_percpu_usage()
+{
+    static unsigned long long prev[CPU_STATE_COUNT][MAX_CPUS];
+    static unsigned char prev_online[MAX_CPUS];
+    static struct percpu_usage usage;
 
-    unsigned long long prev_non_idle = prev_user + prev_nice + prev_system + prev_irq + prev_softirq + prev_steal;
-    unsigned long long non_idle = user + nice + system + irq + softirq + steal;
+    const struct percpu_times* t = &snapshot.percpu;
+    if (!snapshot.valid[PROC_STAT] || t->count == 0)
+    {
+        return NULL;
+    }
 
-    unsigned long long prev_total = prev_idle_total + prev_non_idle;
-    unsigned long long total = idle_total + non_idle;
+    const unsigned long long(*cur)[MAX_CPUS] = t->times;
+    size_t n = t->count;
 
-    totald = total - prev_total;
-    idled = idle_total - prev_idle_total;
+    // Un único bucle sin saltos sobre arreglos contiguos: el compilador puede
+    // vectorizarlo y cada iteración es independiente de las demás.
+    for (size_t i = 0; i < n; i++)
+    {
+        unsigned long long user = (cur[CPU_USER][i] - prev[CPU_USER][i]) + (cur[CPU_NICE][i] - prev[CPU_NICE][i]);
+        unsigned long long system = (cur[CPU_SYSTEM][i] - prev[CPU_SYSTEM][i]) + (cur[CPU_IRQ][i] - prev[CPU_IRQ][i]) +
+                                    (cur[CPU_SOFTIRQ][i] - prev[CPU_SOFTIRQ][i]);
+        unsigned long long iowait = cur[CPU_IOWAIT][i] - prev[CPU_IOWAIT][i];
+        unsigned long long steal = cur[CPU_STEAL][i] - prev[CPU_STEAL][i];
+        unsigned long long idle = cur[CPU_IDLE][i] - prev[CPU_IDLE][i];
+        unsigned long long total = user + system + iowait + steal + idle;
+        double scale = total != 0 ? 100.0 / (double)total : 0.0;
+
+        usage.percent[CPU_MODE_USER][i] = (double)user * scale;
+        usage.percent[CPU_MODE_SYSTEM][i] = (double)system * scale;
+        usage.percent[CPU_MODE_IOWAIT][i] = (double)iowait * scale;
+        usage.percent[CPU_MODE_STEAL][i] = (double)steal * scale;
+        // Una CPU solo tiene valor válido si estaba presente en ambas lecturas
+        usage.online[i] = t->online[i] & prev_online[i];
+    }
+    usage.count = n;
 
-    if (totald == 0)
+    for (int s = 0; s < CPU_STATE_COUNT; s++)
     {
-        fprintf(stderr, "Totald es cero, no se puede calcular el uso de CPU!\n");
-        return -1.0;
+        memcpy(prev[s], cur[s], n * sizeof(prev[s][0]));
     }
+    memcpy(prev_online, t->online, n);
+
+    return &usage;
+}
+
+/**
+ * @brief Muestra de un contador identificado por el nombre de su disco o interfaz.
+ */
+struct named_sample
+{
+    char name[DISK_NAME_LEN];  /**< Nombre del dispositivo o la interfaz. */
+    struct rate_sample sample; /**< Última lectura del contador. */
+};
+
+/**
+ * @brief Suma los incrementos de un contador en varios dispositivos.
+ *
+ * Cada dispositivo se compara con su propia lectura anterior, buscada por
+ * nombre, así que una vuelta de 32 bits o un reinicio se detecta en el
+ * contador que lo sufrió: el reiniciado y el que aparece por primera vez no
+ * suman nada en esta lectura y el resto sí.
+ *
+ * @param prev Lecturas anteriores; se reemplazan por las actuales.
+ * @param prev_count Cantidad de lecturas en `prev`; se actualiza.
+ * @param cur Nombre y valor actual de cada dispositivo, en `sample.value`.
+ * @param count Cantidad de dispositivos en `cur`.
+ * @param ts_ns Instante de la lectura actual.
+ * @return Suma de los incrementos válidos.
+ */
+static unsigned long long sum_named_deltas(struct named_sample* prev, size_t* prev_count, struct named_sample* cur,
+                                           size_t count, unsigned long long ts_ns)
+{
+    unsigned long long total = 0;
 
-    // Calcular el porcentaje de uso de CPU
-    cpu_usage_percent = ((double)(totald - idled) / totald) * 100.0;
+    for (size_t i = 0; i < count; i++)
+    {
+        unsigned long long value = cur[i].sample.value, delta, elapsed_ns;
 
-    // Actualizar los valores anteriores para la siguiente lectura
-    prev_user = user;
-    prev_nice = nice;
-    prev_system = system;
-    prev_idle = idle;
-    prev_iowait = iowait;
-    prev_irq = irq;
-    prev_softirq = softirq;
-    prev_steal = steal;
+        // Buscar el mismo dispositivo en la lectura anterior; normalmente está en la misma posición
+        cur[i].sample = (struct rate_sample){0};
+        for (size_t j = 0; j < *prev_count; j++)
+        {
+            size_t k = (i + j) % *prev_count;
+            if (strcmp(prev[k].name, cur[i].name) == 0)
+            {
+                cur[i].sample = prev[k].sample;
+                break;
+            }
+        }
+        if (rate_sample_update(&cur[i].sample, value, ts_ns, &delta, &elapsed_ns) == 0)
+        {
+            total += delta;
+        }
+    }
 
-    return cpu_usage_percent;
+    memcpy(prev, cur, count * sizeof(prev[0]));
+    *prev_count = count;
+    return total;
 }
 
 /**
  * @brief Calcula el uso del disco.
  *
- * Lee las estadísticas del disco desde /proc/diskstats y calcula el número
- * total de sectores leídos y escritos, devolviendo el valor total en MB.
+ * Suma los sectores leídos y escritos por los discos seguidos en el snapshot
+ * de /proc/diskstats desde la llamada anterior, con el incremento de cada
+ * contador por separado, y devuelve la tasa en MB/s usando el tiempo real
+ * transcurrido entre ambas lecturas.
  *
- * @return El uso de disco en MB como valor double. Si ocurre un error, devuelve
- * -1.0.
+ * @return El uso de disco en MB/s como valor double, 0.0 si todavía no hay dos
+ * lecturas válidas, o -1.0 si ocurre un error.
  */
 double get_disk_usage()
 {
-    char buffer[BUFFER_SIZE * 2];
-    static unsigned long long prev_read_sectors = 0, prev_write_sectors = 0;
-    unsigned long long read_sectors = 0, write_sectors = 0;
+    static struct named_sample read_prev[MAX_DISK_DEVICES], write_prev[MAX_DISK_DEVICES];
+    static size_t read_count = 0, write_count = 0;
+    static unsigned long long prev_ts = 0;
+    struct named_sample reads[MAX_DISK_DEVICES], writes[MAX_DISK_DEVICES];
 
-    // Abrir el archivo /proc/diskstats
-    FILE* fp = popen("cat /proc/diskstats|  grep -w 'sda'", "r");
-    if (fp == NULL)
+    if (!snapshot.valid[PROC_DISKSTATS])
     {
-        perror("Error al abrir /proc/diskstats");
+        fprintf(stderr, "Error al leer /proc/diskstats\n");
         return -1.0;
     }
 
-    // Leer las estadísticas del disco
-    while (fgets(buffer, sizeof(buffer), fp) != NULL)
+    for (size_t i = 0; i < snapshot.disk_count; i++)
     {
-        unsigned int major, minor;
-        char device_name[32];
-        unsigned long reads, writes;
+        memcpy(reads[i].name, snapshot.disks[i].name, sizeof(reads[i].name));
+        memcpy(writes[i].name, snapshot.disks[i].name, sizeof(writes[i].name));
+        reads[i].sample.value = snapshot.disks[i].read_sectors;
+        writes[i].sample.value = snapshot.disks[i].write_sectors;
+    }
+
+    unsigned long long ts = snapshot.ts_ns[PROC_DISKSTATS];
+    unsigned long long sectors = sum_named_deltas(read_prev, &read_count, reads, snapshot.disk_count, ts) +
+                                 sum_named_deltas(write_prev, &write_count, writes, snapshot.disk_count, ts);
+    unsigned long long elapsed_ns = prev_ts != 0 && ts > prev_ts ? ts - prev_ts : 0;
+    prev_ts = ts;
+    if (elapsed_ns == 0)
+    {
+        return 0.0;
+    }
+
+    // Convertir los sectores a MB
+    return (double)sectors * 1e9 / (double)elapsed_ns * SECTOR_SIZE / (1024.0 * 1024.0);
+}
+
+/**
+ * @brief Muestras de los contadores de un disco para get_disk_device_rates().
+ */
+struct disk_samples
+{
+    char name[DISK_NAME_LEN]; /**< Nombre del dispositivo. */
+    struct rate_sample read;  /**< Sectores leídos. */
+    struct rate_sample write; /**< Sectores escritos. */
+};
 
-        // Parsear los valores de lecturas y escrituras
-        if (sscanf(buffer, "%u %u %s %*u %*u %lu %*u %*u %*u %lu", &major, &minor, device_name, &reads, &writes) == 5)
+size_t get_disk_device_rates(const struct disk_rate** rates)
+{
+    static struct disk_samples prev[MAX_DISK_DEVICES];
+    static size_t prev_count = 0;
+    static struct disk_rate current[MAX_DISK_DEVICES];
+    struct disk_samples next[MAX_DISK_DEVICES];
+
+    *rates = current;
+    if (!snapshot.valid[PROC_DISKSTATS])
+    {
+        return 0;
+    }
+
+    unsigned long long ts = snapshot.ts_ns[PROC_DISKSTATS];
+    for (size_t i = 0; i < snapshot.disk_count; i++)
+    {
+        const struct disk_device* d = &snapshot.disks[i];
+        struct disk_samples* n = &next[i];
+        struct disk_rate* r = &current[i];
+
+        // Buscar el mismo disco en la lectura anterior; normalmente está en la misma posición
+        memset(n, 0, sizeof(*n));
+        for (size_t j = 0; j < prev_count; j++)
         {
-            read_sectors += reads;
-            write_sectors += writes;
+            size_t k = (i + j) % prev_count;
+            if (strcmp(prev[k].name, d->name) == 0)
+            {
+                *n = prev[k];
+                break;
+            }
+        }
+        memcpy(n->name, d->name, sizeof(n->name));
+        memcpy(r->name, d->name, sizeof(r->name));
+
+        // Un disco nuevo o con contadores reiniciados reporta 0 hasta la siguiente lectura
+        if (rate_per_second(&n->read, d->read_sectors, ts, &r->read_sectors_per_sec) != 0)
+        {
+            r->read_sectors_per_sec = 0.0;
+        }
+        if (rate_per_second(&n->write, d->write_sectors, ts, &r->write_sectors_per_sec) != 0)
+        {
+            r->write_sectors_per_sec = 0.0;
         }
     }
 
-    // Cerrar el proceso usando pclose en lugar de fclose
-    if (pclose(fp) == -1)
+    memcpy(prev, next, snapshot.disk_count * sizeof(prev[0]));
+    prev_count = snapshot.disk_count;
+
+    return snapshot.disk_count;
+}
+
+/**
+ * @brief Muestras de los contadores de una interfaz para get_net_interface_rates().
+ */
+struct net_samples
+{
+    char name[NET_NAME_LEN];                        /**< Nombre de la interfaz. */
+    struct rate_sample counters[NET_COUNTER_COUNT]; /**< Una muestra por contador. */
+};
+
+size_t get_net_interface_rates(const struct net_rate** rates)
+{
+    static struct net_samples prev[MAX_NET_INTERFACES];
+    static size_t prev_count = 0;
+    static struct net_rate current[MAX_NET_INTERFACES];
+    struct net_samples next[MAX_NET_INTERFACES];
+
+    *rates = current;
+    if (!snapshot.valid[PROC_NET_DEV])
     {
-        perror("Error al cerrar el proceso");
-        return -1.0;
+        return 0;
     }
 
-    // Calcular el delta en sectores desde la última lectura
-    unsigned long long delta_reads = read_sectors - prev_read_sectors;
-    unsigned long long delta_writes = write_sectors - prev_write_sectors;
-    unsigned long long total_sectors = delta_reads + delta_writes;
+    unsigned long long ts = snapshot.ts_ns[PROC_NET_DEV];
+    for (size_t i = 0; i < snapshot.net_count; i++)
+    {
+        const struct net_interface* d = &snapshot.nets[i];
+        struct net_samples* n = &next[i];
+        struct net_rate* r = &current[i];
+
+        // Buscar la misma interfaz en la lectura anterior; normalmente está en la misma posición
+        memset(n, 0, sizeof(*n));
+        for (size_t j = 0; j < prev_count; j++)
+        {
+            size_t k = (i + j) % prev_count;
+            if (strcmp(prev[k].name, d->name) == 0)
+            {
+                *n = prev[k];
+                break;
+            }
+        }
+        memcpy(n->name, d->name, sizeof(n->name));
+        memcpy(r->name, d->name, sizeof(r->name));
 
-    // Actualizar los valores anteriores para la siguiente llamada
-    prev_read_sectors = read_sectors;
-    prev_write_sectors = write_sectors;
+        for (int c = 0; c < NET_COUNTER_COUNT; c++)
+        {
+            if (rate_per_second(&n->counters[c], d->counters[c], ts, &r->per_sec[c]) != 0)
+            {
+                r->per_sec[c] = 0.0;
+            }
+        }
+    }
 
-    // Convertir los sectores a bytes y calcular el porcentaje (simplificado)
-    double disk_usage_percent = (double)(total_sectors * SECTOR_SIZE) / (1024.0 * 1024.0); // Convertir a MB
+    memcpy(prev, next, snapshot.net_count * sizeof(prev[0]));
+    prev_count = snapshot.net_count;
 
-    return disk_usage_percent;
+    return snapshot.net_count;
 }
 
 /**
  * @brief Calcula el uso de red total (envío y recepción de bytes).
  *
- * Lee las estadísticas de las interfaces de red desde /proc/net/dev y devuelve
- * el uso total de red en MB.
+ * Usa las estadísticas de las interfaces de red del snapshot de /proc/net/dev
+ * y devuelve el uso total de red en MB.
  *
  * @return El uso de red total en MB como valor double. Si ocurre un error,
  * devuelve -1.0.
  */
 double get_network_usage()
 {
-    char buffer[BUFFER_SIZE * 2];
-    unsigned long long rx_bytes = 0, tx_bytes = 0;
-
-    // Abrir el archivo /proc/net/dev
-    FILE* fp = fopen("/proc/net/dev", "r");
-    if (fp == NULL)
+    if (!snapshot.valid[PROC_NET_DEV])
     {
-        perror("Error al abrir /proc/net/dev");
+        fprintf(stderr, "Error al leer /proc/net/dev\n");
         return -1.0;
     }
 
-    // Saltar las primeras dos líneas que son encabezados
-    char* unused;
-    unused = fgets(buffer, sizeof(buffer), fp);
-    unused = fgets(buffer, sizeof(buffer), fp);
-    (void)unused;
-
-    // Leer las estadísticas de las interfaces de red
-    while (fgets(buffer, sizeof(buffer), fp) != NULL)
-    {
-        char interface[32];
-        unsigned long long rx, tx;
-
-        // Parsear los bytes recibidos y transmitidos por cada interfaz
-        if (sscanf(buffer, "%s %llu %*u %*u %*u %*u %*u %*u %*u %llu", interface, &rx, &tx) == 3)
-        {
-            rx_bytes += rx;
-            tx_bytes += tx;
-        }
-    }
-
-    fclose(fp);
-
     // Calcular el tráfico de red total (simplificado)
-    double network_usage = ((double)(rx_bytes + tx_bytes)) / (1024.0 * 1024.0); // Convertir a MB
+    double network_usage =
+        ((double)(snapshot.net_rx_bytes + snapshot.net_tx_bytes)) / (1024.0 * 1024.0); // Convertir a MB
 
     return network_usage;
 }
@@ -541,141 +1137,82 @@ double get_network_usage()
 /**
  * @brief Calculates the average network bandwidth usage.
  *
- * This function reads the network statistics from the file `/proc/net/dev`
- * and calculates the average bandwidth usage in MB/s since the last call.
- * It tracks the total number of bytes received and transmitted across all
- * interfaces and computes the difference from the previous reading.
+ * This function uses the network statistics from the `/proc/net/dev`
+ * snapshot and calculates the average bandwidth usage in MB/s since the last
+ * call. It adds up the bytes received and transmitted by each interface since
+ * its own previous reading, so a wrapped 32-bit counter or a reset interface
+ * is detected per counter, and divides the total by the CLOCK_MONOTONIC time
+ * elapsed between both snapshots. A new or reset interface contributes
+ * nothing until its next reading.
  *
- * @return The average network bandwidth usage in MB/s. Returns -1.0 on error.
+ * @return The average network bandwidth usage in MB/s, 0.0 until two valid
+ * readings exist. Returns -1.0 on error.
  */
 double get_average_bandwidth()
 {
-    char buffer[BUFFER_SIZE * 2];
-    unsigned long long rx_bytes = 0, tx_bytes = 0;
-    static unsigned long long prev_rx_bytes = 0, prev_tx_bytes = 0;
-
-    // Variables para el cálculo del tiempo
-    static clock_t last_time = 0;   // Almacena el tiempo de la última llamada
-    clock_t current_time = clock(); // Obtiene el tiempo actual
-
-    // Calcular el tiempo transcurrido en segundos
-    double elapsed_time = (double)(current_time - last_time) / CLOCKS_PER_SEC;
+    static struct named_sample rx_prev[MAX_NET_INTERFACES], tx_prev[MAX_NET_INTERFACES];
+    static size_t rx_count = 0, tx_count = 0;
+    static unsigned long long prev_ts = 0;
+    struct named_sample rx[MAX_NET_INTERFACES], tx[MAX_NET_INTERFACES];
 
-    // Abrir el archivo /proc/net/dev
-    FILE* fp = fopen("/proc/net/dev", "r");
-    if (fp == NULL)
+    if (!snapshot.valid[PROC_NET_DEV])
     {
-        perror("Error al abrir /proc/net/dev");
+        fprintf(stderr, "Error al leer /proc/net/dev\n");
         return -1.0;
     }
 
-    // Saltar las primeras dos líneas que son encabezados
-    char* unused;
-    unused = fgets(buffer, sizeof(buffer), fp);
-    unused = fgets(buffer, sizeof(buffer), fp);
-    (void)unused;
-
-    // Leer las estadísticas de las interfaces de red
-    while (fgets(buffer, sizeof(buffer), fp) != NULL)
+    for (size_t i = 0; i < snapshot.net_total_count; i++)
     {
-        char interface[32];
-        unsigned long long rx, tx;
-
-        // Parsear los bytes recibidos y transmitidos por cada interfaz
-        if (sscanf(buffer, "%s %llu %*u %*u %*u %*u %*u %*u %*u %llu", interface, &rx, &tx) == 3)
-        {
-            rx_bytes += rx;
-            tx_bytes += tx;
-        }
+        const struct net_total* t = &snapshot.net_totals[i];
+        memcpy(rx[i].name, t->name, sizeof(t->name));
+        memcpy(tx[i].name, t->name, sizeof(t->name));
+        rx[i].sample.value = t->rx_bytes;
+        tx[i].sample.value = t->tx_bytes;
     }
 
-    fclose(fp);
-
-    // Calcular el delta de bytes recibidos y transmitidos
-    unsigned long long delta_rx = rx_bytes - prev_rx_bytes;
-    unsigned long long delta_tx = tx_bytes - prev_tx_bytes;
-    unsigned long long total_bytes = delta_rx + delta_tx;
-
-    // Actualizar los valores anteriores para la siguiente llamada
-    prev_rx_bytes = rx_bytes;
-    prev_tx_bytes = tx_bytes;
-
-    // Calcular el tráfico de red total (simplificado)
-    double network_usage = ((double)total_bytes) / (1024.0 * 1024.0); // Convertir a MB
-    double bandwidth = network_usage / elapsed_time;                  // Calcular el ancho de banda promedio
-
-    // Actualizar el tiempo de la última llamada
-    last_time = current_time;
+    unsigned long long ts = snapshot.ts_ns[PROC_NET_DEV];
+    unsigned long long bytes = sum_named_deltas(rx_prev, &rx_count, rx, snapshot.net_total_count, ts) +
+                               sum_named_deltas(tx_prev, &tx_count, tx, snapshot.net_total_count, ts);
+    unsigned long long elapsed_ns = prev_ts != 0 && ts > prev_ts ? ts - prev_ts : 0;
+    prev_ts = ts;
+    if (elapsed_ns == 0)
+    {
+        return 0.0;
+    }
 
-    return bandwidth;
+    return (double)bytes * 1e9 / (double)elapsed_ns / (1024.0 * 1024.0); // Convertir a MB/s
 }
 
 /**
  * @brief Retrieves the number of minor page faults.
  *
- * This function reads the `/proc/vmstat` file to get the current number of
- * minor page faults.
+ * This function returns the `pgfault` counter from the `/proc/vmstat`
+ * snapshot.
  *
  * @return The number of minor page faults. Returns -1 on error.
  */
 unsigned long long get_minor_page_faults()
 {
-    FILE* fp;
-    char buffer[BUFFER_SIZE];
-    unsigned long long minor_faults = 0;
-
-    // Abrir el archivo /proc/vmstat
-    fp = fopen("/proc/vmstat", "r");
-    if (fp == NULL)
+    if (!snapshot.valid[PROC_VMSTAT])
     {
-        perror("Error al abrir /proc/vmstat");
         return -1;
     }
-
-    // Leer las métricas de fallos menores
-    while (fgets(buffer, sizeof(buffer), fp) != NULL)
-    {
-        if (sscanf(buffer, "pgfault %llu", &minor_faults) == 1)
-        {
-            break;
-        }
-    }
-
-    fclose(fp);
-    return minor_faults;
+    return snapshot.pgfault;
 }
 
 /**
  * @brief Retrieves the number of major page faults.
  *
- * This function reads the `/proc/vmstat` file to get the current number of
- * major page faults.
+ * This function returns the `pgmajfault` counter from the `/proc/vmstat`
+ * snapshot.
  *
  * @return The number of major page faults. Returns -1 on error.
  */
 unsigned long long get_major_page_faults()
 {
-    FILE* fp;
-    char line[BUFFER_SIZE];
-    unsigned long long major_faults = 0;
-
-    // Abrir el archivo /proc/vmstat
-    fp = fopen("/proc/vmstat", "r");
-    if (fp == NULL)
+    if (!snapshot.valid[PROC_VMSTAT])
     {
-        perror("Error al abrir /proc/vmstat");
         return -1;
     }
-
-    // Leer las métricas de fallos mayores
-    while (fgets(line, sizeof(line), fp) != NULL)
-    {
-        if (sscanf(line, "pgmajfault %llu", &major_faults) == 1)
-        {
-            break;
-        }
-    }
-
-    fclose(fp);
-    return major_faults;
+    return snapshot.pgmajfault;
 }
@@ -0,0 +1,90 @@
+/**
+ * @file proc_parse.c
+ * @brief Implementación del tokenizador para los formatos de /proc.
+ */
+
+#include "proc_parse.h"
+#include <string.h>
+
+const char* parse_skip_spaces(const char* p)
+{
+    while (*p == ' ' || *p == '\t')
+    {
+        p++;
+    }
+    return p;
+}
+
+const char* parse_u64(const char* p, unsigned long long* out)
+{
+    unsigned long long value = 0;
+
+    p = parse_skip_spaces(p);
+    if ((unsigned)(*p - '0') > 9)
+    {
+        return NULL;
+    }
+
+    while ((unsigned)(*p - '0') <= 9)
+    {
+        value = value * 10 + (unsigned)(*p - '0');
+        p++;
+    }
+
+    *out = value;
+    return p;
+}
+
+const char* parse_skip_fields(const char* p, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        p = parse_skip_spaces(p);
+        if (*p == '\0' || *p == '\n')
+        {
+            return NULL;
+        }
+        while (*p != ' ' && *p != '\t' && *p != '\n' && *p != '\0')
+        {
+            p++;
+        }
+    }
+    return p;
+}
+
+const char* parse_key(const char* line, const char* key, size_t key_len)
+{
+    if (line[0] != key[0] || strncmp(line, key, key_len) != 0)
+    {
+        return NULL;
+    }
+    return line + key_len;
+}
+
+const char* parse_name(const char* p, char* out, size_t out_len, char stop)
+{
+    size_t len = 0;
+
+    p = parse_skip_spaces(p);
+    while (*p != ' ' && *p != '\t' && *p != '\n' && *p != '\0' && *p != stop)
+    {
+        if (len + 1 < out_len)
+        {
+            out[len++] = *p;
+        }
+        p++;
+    }
+    if (stop != '\0' && *p == stop)
+    {
+        p++;
+    }
+
+    out[len] = '\0';
+    return len > 0 ? p : NULL;
+}
+
+const char* parse_next_line(const char* p)
+{
+    const char* nl = strchr(p, '\n');
+    return (nl != NULL && nl[1] != '\0') ? nl + 1 : NULL;
+}
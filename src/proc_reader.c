@@ -0,0 +1,131 @@
+/**
+ * @file proc_reader.c
+ * @brief Implementación del lector de /proc con descriptores persistentes.
+ */
+
+#include "proc_reader.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * @brief Llamadas al sistema de todos los lectores; los colectores corren en varios hilos.
+ */
+static atomic_ullong total_syscalls;
+
+/**
+ * @brief Bytes leídos por todos los lectores.
+ */
+static atomic_ullong total_bytes;
+
+void proc_reader_account(unsigned long long syscalls, unsigned long long bytes)
+{
+    atomic_fetch_add_explicit(&total_syscalls, syscalls, memory_order_relaxed);
+    atomic_fetch_add_explicit(&total_bytes, bytes, memory_order_relaxed);
+}
+
+void proc_reader_get_stats(struct proc_reader_stats* out)
+{
+    out->syscalls = atomic_load_explicit(&total_syscalls, memory_order_relaxed);
+    out->bytes = atomic_load_explicit(&total_bytes, memory_order_relaxed);
+}
+
+int proc_reader_open(struct proc_reader* r, const char* path)
+{
+    r->path = path;
+    r->len = 0;
+    r->fd = open(path, O_RDONLY | O_CLOEXEC);
+    proc_reader_account(1, 0);
+    if (r->fd < 0)
+    {
+        fprintf(stderr, "Error al abrir %s: %s\n", path, strerror(errno));
+        r->buf = NULL;
+        r->cap = 0;
+        return -1;
+    }
+
+    r->buf = malloc(PROC_READER_INITIAL_SIZE);
+    if (r->buf == NULL)
+    {
+        fprintf(stderr, "Error al reservar el buffer de %s\n", path);
+        close(r->fd);
+        proc_reader_account(1, 0);
+        r->fd = -1;
+        r->cap = 0;
+        return -1;
+    }
+    r->cap = PROC_READER_INITIAL_SIZE;
+    r->buf[0] = '\0';
+    return 0;
+}
+
+ssize_t proc_reader_read(struct proc_reader* r)
+{
+    size_t len = 0;
+    unsigned long long syscalls = 0;
+
+    if (r->fd < 0)
+    {
+        return -1;
+    }
+
+    // Los archivos seq_file de /proc pueden entregar el contenido en varias
+    // lecturas cortas, así que se lee hasta obtener 0 (EOF).
+    while (1)
+    {
+        // Reservar siempre un byte para el terminador
+        if (r->cap - len <= 1)
+        {
+            char* grown = realloc(r->buf, r->cap * 2);
+            if (grown == NULL)
+            {
+                fprintf(stderr, "Error al agrandar el buffer de %s\n", r->path);
+                proc_reader_account(syscalls, len);
+                return -1;
+            }
+            r->buf = grown;
+            r->cap *= 2;
+        }
+
+        ssize_t n = pread(r->fd, r->buf + len, r->cap - len - 1, (off_t)len);
+        syscalls++;
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            fprintf(stderr, "Error al leer %s: %s\n", r->path, strerror(errno));
+            proc_reader_account(syscalls, len);
+            return -1;
+        }
+        if (n == 0)
+        {
+            break;
+        }
+        len += (size_t)n;
+    }
+
+    proc_reader_account(syscalls, len);
+    r->buf[len] = '\0';
+    r->len = len;
+    return (ssize_t)len;
+}
+
+void proc_reader_close(struct proc_reader* r)
+{
+    if (r->fd >= 0)
+    {
+        close(r->fd);
+        proc_reader_account(1, 0);
+    }
+    free(r->buf);
+    r->fd = -1;
+    r->buf = NULL;
+    r->cap = 0;
+    r->len = 0;
+}
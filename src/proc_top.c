@@ -0,0 +1,446 @@
+/**
+ * @file proc_top.c
+ * @brief Implementación de los rankings de procesos.
+ *
+ * Hay dos tablas de muestras con direccionamiento abierto: la de la lectura
+ * anterior, donde se buscan los valores previos, y la de la actual, que se
+ * llena durante el recorrido. Al terminar se intercambian, así los procesos
+ * que desaparecieron se descartan sin borrar entradas.
+ */
+
+#include "proc_top.h"
+#include "proc_parse.h"
+#include "proc_reader.h"
+#include <ctype.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * @brief Bytes leídos de cada /proc/[pid]/stat; la línea completa ronda los 300.
+ */
+#define PROC_STAT_LINE 1024
+
+/**
+ * @brief Última muestra de un proceso.
+ */
+struct pid_sample
+{
+    int pid;                       /**< Pid, o 0 si la celda está libre. */
+    unsigned long long start_time; /**< Instante de arranque, para detectar un pid reutilizado. */
+    unsigned long long cpu_ticks;  /**< utime + stime. */
+    unsigned long long faults;     /**< minflt + majflt. */
+};
+
+/**
+ * @brief Tabla de muestras indexada por pid.
+ */
+struct pid_table
+{
+    struct pid_sample* slots; /**< Celdas; la capacidad es potencia de dos. */
+    size_t cap;               /**< Cantidad de celdas. */
+    size_t count;             /**< Celdas ocupadas. */
+};
+
+/**
+ * @brief Min-heap con los mayores valores vistos de un ranking.
+ */
+struct top_heap
+{
+    struct proc_top_entry* entries; /**< Arreglo del ranking de salida. */
+    size_t count;                   /**< Elementos en el heap. */
+};
+
+/**
+ * @brief /proc abierto una sola vez; se rebobina en cada lectura.
+ */
+static DIR* proc_dir;
+
+/**
+ * @brief Muestras de la lectura anterior y de la actual.
+ */
+static struct pid_table tables[2];
+
+/**
+ * @brief Índice en `tables` de las muestras de la lectura anterior.
+ */
+static int previous;
+
+/**
+ * @brief Instante de la lectura anterior en CLOCK_MONOTONIC, o 0 si no hubo.
+ */
+static unsigned long long previous_ns;
+
+/**
+ * @brief Procesos por ranking; 0 si el colector está desactivado.
+ */
+static size_t top_n;
+
+/**
+ * @brief Ticks de reloj por segundo en que se miden utime y stime.
+ */
+static long clock_ticks;
+
+/**
+ * @brief Bytes de una página, la unidad del rss.
+ */
+static long page_size;
+
+/**
+ * @brief Devuelve el tiempo de CLOCK_MONOTONIC en nanosegundos.
+ */
+static unsigned long long now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + (unsigned long long)ts.tv_nsec;
+}
+
+/**
+ * @brief Celda de un pid: la suya si está, o la libre donde iría.
+ */
+static struct pid_sample* table_slot(const struct pid_table* t, int pid)
+{
+    size_t mask = t->cap - 1;
+    size_t i = ((size_t)(unsigned)pid * 0x9E3779B97F4A7C15ULL >> 16) & mask;
+    while (t->slots[i].pid != 0 && t->slots[i].pid != pid)
+    {
+        i = (i + 1) & mask;
+    }
+    return &t->slots[i];
+}
+
+/**
+ * @brief Reserva una tabla vacía de `cap` celdas.
+ *
+ * @return 0 si se reservó, -1 si no hubo memoria.
+ */
+static int table_init(struct pid_table* t, size_t cap)
+{
+    t->slots = calloc(cap, sizeof(*t->slots));
+    t->cap = t->slots != NULL ? cap : 0;
+    t->count = 0;
+    return t->slots != NULL ? 0 : -1;
+}
+
+/**
+ * @brief Agrega una muestra, duplicando la tabla si queda llena a la mitad.
+ *
+ * @return 0 si se agregó, -1 si no hubo memoria para agrandarla.
+ */
+static int table_put(struct pid_table* t, const struct pid_sample* s)
+{
+    if ((t->count + 1) * 2 > t->cap)
+    {
+        struct pid_table grown;
+        if (table_init(&grown, t->cap * 2) != 0)
+        {
+            fprintf(stderr, "Error al agrandar la tabla de procesos\n");
+            return -1;
+        }
+        for (size_t i = 0; i < t->cap; i++)
+        {
+            if (t->slots[i].pid != 0)
+            {
+                *table_slot(&grown, t->slots[i].pid) = t->slots[i];
+            }
+        }
+        grown.count = t->count;
+        free(t->slots);
+        *t = grown;
+    }
+
+    struct pid_sample* slot = table_slot(t, s->pid);
+    if (slot->pid == 0)
+    {
+        t->count++;
+    }
+    *slot = *s;
+    return 0;
+}
+
+/**
+ * @brief Intercambia dos elementos del heap.
+ */
+static void heap_swap(struct proc_top_entry* a, struct proc_top_entry* b)
+{
+    struct proc_top_entry tmp = *a;
+    *a = *b;
+    *b = tmp;
+}
+
+/**
+ * @brief Ofrece un proceso a un ranking; entra si hay lugar o supera al menor.
+ */
+static void heap_offer(struct top_heap* h, int pid, const char* comm, double value)
+{
+    size_t i;
+
+    if (value <= 0)
+    {
+        return;
+    }
+    if (h->count < top_n)
+    {
+        i = h->count++;
+        while (i > 0 && h->entries[(i - 1) / 2].value > value)
+        {
+            h->entries[i] = h->entries[(i - 1) / 2];
+            i = (i - 1) / 2;
+        }
+    }
+    else if (value > h->entries[0].value)
+    {
+        // Reemplaza la raíz, el menor del ranking, y la hunde
+        i = 0;
+        while (1)
+        {
+            size_t child = 2 * i + 1;
+            if (child >= h->count)
+            {
+                break;
+            }
+            if (child + 1 < h->count && h->entries[child + 1].value < h->entries[child].value)
+            {
+                child++;
+            }
+            if (h->entries[child].value >= value)
+            {
+                break;
+            }
+            h->entries[i] = h->entries[child];
+            i = child;
+        }
+    }
+    else
+    {
+        return;
+    }
+
+    struct proc_top_entry* e = &h->entries[i];
+    snprintf(e->pid, sizeof(e->pid), "%d", pid);
+    snprintf(e->comm, sizeof(e->comm), "%s", comm);
+    e->value = value;
+}
+
+/**
+ * @brief Ordena un heap de mayor a menor extrayendo la raíz; queda en el mismo arreglo.
+ */
+static void heap_sort_desc(struct top_heap* h)
+{
+    for (size_t n = h->count; n > 1; n--)
+    {
+        heap_swap(&h->entries[0], &h->entries[n - 1]);
+        size_t i = 0;
+        while (1)
+        {
+            size_t child = 2 * i + 1;
+            if (child >= n - 1)
+            {
+                break;
+            }
+            if (child + 1 < n - 1 && h->entries[child + 1].value < h->entries[child].value)
+            {
+                child++;
+            }
+            if (h->entries[child].value >= h->entries[i].value)
+            {
+                break;
+            }
+            heap_swap(&h->entries[i], &h->entries[child]);
+            i = child;
+        }
+    }
+}
+
+/**
+ * @brief Lee y parsea /proc/[pid]/stat.
+ *
+ * @param name Nombre de la entrada de /proc, el pid en decimal.
+ * @param comm Recibe el nombre del proceso.
+ * @param s Recibe los contadores; el pid ya debe estar cargado.
+ * @param rss Recibe las páginas residentes.
+ * @return 0 si se leyó, -1 si el proceso terminó o la línea no tiene la forma esperada.
+ */
+static int read_pid_stat(const char* name, char comm[PROC_COMM_LEN], struct pid_sample* s,
+                         unsigned long long* rss)
+{
+    char path[32];
+    char buf[PROC_STAT_LINE];
+
+    snprintf(path, sizeof(path), "%s/stat", name);
+    int fd = openat(dirfd(proc_dir), path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return -1;
+    }
+    ssize_t n = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    proc_reader_account(3, n > 0 ? (unsigned long long)n : 0);
+    if (n <= 0)
+    {
+        return -1;
+    }
+    buf[n] = '\0';
+
+    // El nombre puede tener espacios y paréntesis: termina en el último ')'
+    const char* open = strchr(buf, '(');
+    const char* close_paren = strrchr(buf, ')');
+    if (open == NULL || close_paren == NULL || close_paren < open)
+    {
+        return -1;
+    }
+    size_t len = (size_t)(close_paren - open - 1);
+    if (len >= PROC_COMM_LEN)
+    {
+        len = PROC_COMM_LEN - 1;
+    }
+    memcpy(comm, open + 1, len);
+    comm[len] = '\0';
+
+    // Campos 3 a 9 (state ... flags) antes de minflt, el 10
+    unsigned long long minflt, majflt, utime, stime;
+    const char* p = parse_skip_fields(close_paren + 1, 7);
+    p = p != NULL ? parse_u64(p, &minflt) : NULL;
+    p = p != NULL ? parse_skip_fields(p, 1) : NULL;
+    p = p != NULL ? parse_u64(p, &majflt) : NULL;
+    p = p != NULL ? parse_skip_fields(p, 1) : NULL;
+    p = p != NULL ? parse_u64(p, &utime) : NULL;
+    p = p != NULL ? parse_u64(p, &stime) : NULL;
+    // cutime ... itrealvalue, 16 a 21, antes de starttime, el 22
+    p = p != NULL ? parse_skip_fields(p, 6) : NULL;
+    p = p != NULL ? parse_u64(p, &s->start_time) : NULL;
+    // vsize, el 23, antes de rss, el 24
+    p = p != NULL ? parse_skip_fields(p, 1) : NULL;
+    p = p != NULL ? parse_u64(p, rss) : NULL;
+    if (p == NULL)
+    {
+        return -1;
+    }
+    s->cpu_ticks = utime + stime;
+    s->faults = minflt + majflt;
+    return 0;
+}
+
+int proc_top_init()
+{
+    const char* env = getenv(PROC_TOP_ENV);
+    unsigned long n = env != NULL ? strtoul(env, NULL, 10) : PROC_TOP_DEFAULT;
+    top_n = n < PROC_TOP_MAX ? n : PROC_TOP_MAX;
+    if (top_n == 0)
+    {
+        return 0;
+    }
+
+    clock_ticks = sysconf(_SC_CLK_TCK);
+    page_size = sysconf(_SC_PAGESIZE);
+    proc_dir = opendir("/proc");
+    if (proc_dir == NULL)
+    {
+        fprintf(stderr, "Error al abrir /proc: %s\n", strerror(errno));
+        top_n = 0;
+        return -1;
+    }
+    if (table_init(&tables[0], PROC_TOP_TABLE_INITIAL) != 0 || table_init(&tables[1], PROC_TOP_TABLE_INITIAL) != 0)
+    {
+        fprintf(stderr, "Error al reservar las tablas de procesos\n");
+        proc_top_close();
+        return -1;
+    }
+    return 0;
+}
+
+int proc_top_enabled()
+{
+    return top_n != 0;
+}
+
+int proc_top_update(struct proc_top* out)
+{
+    if (top_n == 0)
+    {
+        return -1;
+    }
+
+    const struct pid_table* prev = &tables[previous];
+    struct pid_table* cur = &tables[!previous];
+    struct top_heap heaps[PROC_TOP_RANK_COUNT];
+    unsigned long long ts = now_ns();
+    double elapsed = previous_ns != 0 ? (double)(ts - previous_ns) / 1e9 : 0.0;
+    struct dirent* de;
+    int status = 0;
+
+    memset(cur->slots, 0, cur->cap * sizeof(*cur->slots));
+    cur->count = 0;
+    for (int r = 0; r < PROC_TOP_RANK_COUNT; r++)
+    {
+        heaps[r].entries = out->entries[r];
+        heaps[r].count = 0;
+    }
+    out->scanned = 0;
+
+    rewinddir(proc_dir);
+    while ((de = readdir(proc_dir)) != NULL)
+    {
+        if (!isdigit((unsigned char)de->d_name[0]))
+        {
+            continue;
+        }
+
+        char comm[PROC_COMM_LEN];
+        struct pid_sample s = {.pid = atoi(de->d_name)};
+        unsigned long long rss;
+        if (s.pid <= 0 || read_pid_stat(de->d_name, comm, &s, &rss) != 0)
+        {
+            continue;
+        }
+        out->scanned++;
+        heap_offer(&heaps[PROC_TOP_RSS], s.pid, comm, (double)rss * (double)page_size);
+
+        const struct pid_sample* old = table_slot(prev, s.pid);
+        if (elapsed > 0 && old->pid == s.pid && old->start_time == s.start_time)
+        {
+            double cpu = (double)(s.cpu_ticks - old->cpu_ticks) / (double)clock_ticks / elapsed * 100.0;
+            heap_offer(&heaps[PROC_TOP_CPU], s.pid, comm, cpu);
+            heap_offer(&heaps[PROC_TOP_FAULTS], s.pid, comm, (double)(s.faults - old->faults) / elapsed);
+        }
+        if (table_put(cur, &s) != 0)
+        {
+            status = -1;
+            break;
+        }
+    }
+
+    for (int r = 0; r < PROC_TOP_RANK_COUNT; r++)
+    {
+        heap_sort_desc(&heaps[r]);
+        out->count[r] = heaps[r].count;
+    }
+    previous = !previous;
+    previous_ns = ts;
+    return status;
+}
+
+void proc_top_close()
+{
+    if (proc_dir != NULL)
+    {
+        closedir(proc_dir);
+        proc_dir = NULL;
+    }
+    for (int i = 0; i < 2; i++)
+    {
+        free(tables[i].slots);
+        tables[i].slots = NULL;
+        tables[i].cap = 0;
+        tables[i].count = 0;
+    }
+    top_n = 0;
+    previous_ns = 0;
+}
@@ -0,0 +1,833 @@
+/**
+ * @file push.c
+ * @brief Implementación del envío por lotes a StatsD, InfluxDB o remote-write.
+ *
+ * La cola es un anillo de registros de tamaño fijo protegido por un mutex que
+ * solo se toma para copiar registros. El hilo de envío codifica cada lote en
+ * buffers propios que se reutilizan entre envíos.
+ *
+ * Remote-write se arma a mano: el protobuf de WriteRequest tiene pocos campos y
+ * snappy se genera con un compresor simple de formato de bloque, sin
+ * dependencias nuevas. El POST es HTTP/1.1 sin TLS.
+ */
+
+#include "push.h"
+#include <errno.h>
+#include <math.h>
+#include <netdb.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * @brief Valor de la etiqueta "job" de remote-write y de la medición de InfluxDB.
+ */
+#define PUSH_JOB "metrics_monitor"
+
+/**
+ * @brief Longitud máxima del host y de la ruta del destino.
+ */
+#define PUSH_ADDR_LEN 256
+
+/**
+ * @brief Protocolos de envío.
+ */
+enum push_protocol
+{
+    PUSH_STATSD,      /**< Gauges de StatsD por UDP. */
+    PUSH_INFLUX,      /**< Protocolo de líneas de InfluxDB por UDP. */
+    PUSH_REMOTE_WRITE /**< Remote-write de Prometheus por HTTP. */
+};
+
+/**
+ * @brief Valores escalares de un tick.
+ */
+struct push_record
+{
+    uint64_t ts_ms;                     /**< Milisegundos desde la época Unix. */
+    double scalar[METRIC_SCALAR_COUNT]; /**< Valores indexados por @ref metric_id. */
+};
+
+/**
+ * @brief Buffer que crece según sea necesario.
+ */
+struct push_buf
+{
+    char* data; /**< Contenido. */
+    size_t len; /**< Bytes válidos. */
+    size_t cap; /**< Capacidad. */
+    int failed; /**< Distinto de 0 si no se pudo agrandar. */
+};
+
+/**
+ * @brief Anillo de ticks pendientes.
+ */
+static struct push_record queue[PUSH_QUEUE_LEN];
+
+/**
+ * @brief Posición del tick más viejo en `queue`.
+ */
+static size_t queue_head;
+
+/**
+ * @brief Ticks en `queue`.
+ */
+static size_t queue_count;
+
+/**
+ * @brief Contadores; solo se tocan con `queue_lock` tomado.
+ */
+static struct push_stats stats;
+
+/**
+ * @brief Protege la cola y los contadores.
+ */
+static pthread_mutex_t queue_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @brief Avisa al hilo de envío que llegó un tick.
+ */
+static pthread_cond_t queue_cond;
+
+/**
+ * @brief Distinto de 0 si el hilo de envío está corriendo.
+ */
+static int enabled;
+
+/**
+ * @brief Protocolo del destino.
+ */
+static enum push_protocol protocol;
+
+/**
+ * @brief Host del destino.
+ */
+static char host[PUSH_ADDR_LEN];
+
+/**
+ * @brief Puerto del destino.
+ */
+static char port[8];
+
+/**
+ * @brief Ruta del POST de remote-write.
+ */
+static char path[PUSH_ADDR_LEN];
+
+/**
+ * @brief Nombre de esta máquina, para la etiqueta "instance" y el tag "host".
+ */
+static char hostname[PUSH_ADDR_LEN];
+
+/**
+ * @brief Socket UDP conectado al destino, o -1.
+ */
+static int udp_fd = -1;
+
+/**
+ * @brief Ticks de cada envío.
+ */
+static size_t batch_size;
+
+/**
+ * @brief Nombres de las métricas escalares.
+ */
+static const char* const* metric_names;
+
+/**
+ * @brief Devuelve el tiempo de CLOCK_REALTIME en milisegundos.
+ */
+static uint64_t now_ms()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000ULL + (uint64_t)ts.tv_nsec / 1000000ULL;
+}
+
+/**
+ * @brief Reserva espacio para `extra` bytes más.
+ *
+ * @return 0 si hay lugar, -1 si no se pudo agrandar.
+ */
+static int buf_reserve(struct push_buf* b, size_t extra)
+{
+    if (b->len + extra <= b->cap)
+    {
+        return 0;
+    }
+    size_t cap = b->cap != 0 ? b->cap : 4096;
+    while (cap < b->len + extra)
+    {
+        cap *= 2;
+    }
+    char* grown = realloc(b->data, cap);
+    if (grown == NULL)
+    {
+        b->failed = 1;
+        return -1;
+    }
+    b->data = grown;
+    b->cap = cap;
+    return 0;
+}
+
+/**
+ * @brief Agrega bytes al buffer.
+ */
+static void buf_put(struct push_buf* b, const void* data, size_t len)
+{
+    if (buf_reserve(b, len) == 0)
+    {
+        memcpy(b->data + b->len, data, len);
+        b->len += len;
+    }
+}
+
+/**
+ * @brief Agrega texto con formato al buffer.
+ */
+static void buf_printf(struct push_buf* b, const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+
+static void buf_printf(struct push_buf* b, const char* fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(NULL, 0, fmt, ap);
+    va_end(ap);
+    if (n < 0 || buf_reserve(b, (size_t)n + 1) != 0)
+    {
+        return;
+    }
+    va_start(ap, fmt);
+    vsnprintf(b->data + b->len, (size_t)n + 1, fmt, ap);
+    va_end(ap);
+    b->len += (size_t)n;
+}
+
+/**
+ * @brief Separa un destino "esquema://host[:puerto][/ruta]".
+ *
+ * @return 0 si es válido, -1 si el esquema no se conoce o falta el host.
+ */
+static int parse_url(const char* url)
+{
+    static const struct
+    {
+        const char* scheme;
+        enum push_protocol protocol;
+        const char* port;
+    } schemes[] = {
+        {"statsd://", PUSH_STATSD, "8125"},
+        {"influx://", PUSH_INFLUX, "8089"},
+        {"http://", PUSH_REMOTE_WRITE, "80"},
+    };
+    const char* p = NULL;
+
+    for (size_t i = 0; i < sizeof(schemes) / sizeof(schemes[0]) && p == NULL; i++)
+    {
+        size_t len = strlen(schemes[i].scheme);
+        if (strncmp(url, schemes[i].scheme, len) == 0)
+        {
+            p = url + len;
+            protocol = schemes[i].protocol;
+            snprintf(port, sizeof(port), "%s", schemes[i].port);
+        }
+    }
+    if (p == NULL)
+    {
+        return -1;
+    }
+
+    // Un host IPv6 va entre corchetes para separarlo del puerto
+    const char* host_end = *p == '[' ? strchr(p, ']') : p + strcspn(p, ":/");
+    if (host_end == NULL)
+    {
+        return -1;
+    }
+    const char* host_start = *p == '[' ? p + 1 : p;
+    size_t host_len = (size_t)(host_end - host_start);
+    if (host_len == 0 || host_len >= sizeof(host))
+    {
+        return -1;
+    }
+    memcpy(host, host_start, host_len);
+    host[host_len] = '\0';
+    p = *p == '[' ? host_end + 1 : host_end;
+
+    if (*p == ':')
+    {
+        size_t port_len = strcspn(p + 1, "/");
+        if (port_len == 0 || port_len >= sizeof(port))
+        {
+            return -1;
+        }
+        memcpy(port, p + 1, port_len);
+        port[port_len] = '\0';
+        p += 1 + port_len;
+    }
+    snprintf(path, sizeof(path), "%s", *p == '/' ? p : "/api/v1/write");
+    return 0;
+}
+
+/**
+ * @brief Abre un socket conectado al destino.
+ *
+ * @param type SOCK_DGRAM o SOCK_STREAM.
+ * @return Descriptor, o -1 si no se pudo resolver o conectar.
+ */
+static int connect_to(int type)
+{
+    struct addrinfo hints = {.ai_family = AF_UNSPEC, .ai_socktype = type};
+    struct addrinfo* res;
+    int fd = -1;
+
+    if (getaddrinfo(host, port, &hints, &res) != 0)
+    {
+        return -1;
+    }
+    for (struct addrinfo* ai = res; ai != NULL && fd < 0; ai = ai->ai_next)
+    {
+        fd = socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC, ai->ai_protocol);
+        if (fd < 0)
+        {
+            continue;
+        }
+        struct timeval tv = {PUSH_TIMEOUT_MS / 1000, (PUSH_TIMEOUT_MS % 1000) * 1000};
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        if (connect(fd, ai->ai_addr, ai->ai_addrlen) != 0)
+        {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(res);
+    return fd;
+}
+
+/**
+ * @brief Envía un datagrama por el socket UDP.
+ *
+ * @return 0 si se envió, -1 en caso de error.
+ */
+static int send_datagram(const struct push_buf* b)
+{
+    if (b->len == 0)
+    {
+        return 0;
+    }
+    if (udp_fd < 0 && (udp_fd = connect_to(SOCK_DGRAM)) < 0)
+    {
+        return -1;
+    }
+    if (send(udp_fd, b->data, b->len, MSG_NOSIGNAL) < 0)
+    {
+        // El destino puede haber cambiado de dirección: se vuelve a resolver en el próximo envío
+        close(udp_fd);
+        udp_fd = -1;
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Agrega una línea al datagrama en curso, enviándolo antes si la línea no entra.
+ *
+ * @param datagram Datagrama en construcción.
+ * @param line Línea completa, con su '\n'.
+ * @return 0 si no hubo errores de envío, -1 si alguno falló.
+ */
+static int add_udp_line(struct push_buf* datagram, const struct push_buf* line)
+{
+    int status = 0;
+    if (datagram->len > 0 && datagram->len + line->len > PUSH_UDP_PAYLOAD)
+    {
+        status = send_datagram(datagram);
+        datagram->len = 0;
+    }
+    buf_put(datagram, line->data, line->len);
+    return status;
+}
+
+/**
+ * @brief Envía un lote como gauges de StatsD o líneas de InfluxDB.
+ *
+ * @return 0 si se enviaron todos los datagramas, -1 si alguno falló.
+ */
+static int send_udp(const struct push_record* batch, size_t n)
+{
+    static struct push_buf datagram, line;
+    int status = 0;
+
+    datagram.len = 0;
+    for (size_t r = 0; r < n; r++)
+    {
+        line.len = 0;
+        if (protocol == PUSH_STATSD)
+        {
+            for (int id = 0; id < METRIC_SCALAR_COUNT; id++)
+            {
+                double v = batch[r].scalar[id];
+                if (!isfinite(v))
+                {
+                    continue;
+                }
+                line.len = 0;
+                // Un gauge negativo se interpreta como una resta: se lleva a 0 antes
+                if (v < 0)
+                {
+                    buf_printf(&line, "%s:0|g\n", metric_names[id]);
+                }
+                buf_printf(&line, "%s:%.17g|g\n", metric_names[id], v);
+                status |= add_udp_line(&datagram, &line);
+            }
+            continue;
+        }
+
+        // medición,host=... campo=valor,... instante_en_ns
+        buf_printf(&line, PUSH_JOB ",host=%s", hostname);
+        char sep = ' ';
+        for (int id = 0; id < METRIC_SCALAR_COUNT; id++)
+        {
+            double v = batch[r].scalar[id];
+            if (isfinite(v))
+            {
+                buf_printf(&line, "%c%s=%.17g", sep, metric_names[id], v);
+                sep = ',';
+            }
+        }
+        if (sep == ',')
+        {
+            buf_printf(&line, " %llu000000\n", (unsigned long long)batch[r].ts_ms);
+            status |= add_udp_line(&datagram, &line);
+        }
+    }
+    status |= send_datagram(&datagram);
+    // Los buffers son estáticos: una falla de memoria no debe marcar los lotes siguientes
+    if (datagram.failed || line.failed)
+    {
+        datagram.failed = line.failed = 0;
+        fprintf(stderr, "Error al reservar el lote para UDP\n");
+        return -1;
+    }
+    return status;
+}
+
+/**
+ * @brief Bytes de un entero en varint de protobuf.
+ */
+static size_t varint_len(uint64_t v)
+{
+    size_t n = 1;
+    while (v >= 0x80)
+    {
+        v >>= 7;
+        n++;
+    }
+    return n;
+}
+
+/**
+ * @brief Agrega un entero en varint de protobuf.
+ */
+static void put_varint(struct push_buf* b, uint64_t v)
+{
+    unsigned char bytes[10];
+    size_t n = 0;
+    while (v >= 0x80)
+    {
+        bytes[n++] = (unsigned char)(v | 0x80);
+        v >>= 7;
+    }
+    bytes[n++] = (unsigned char)v;
+    buf_put(b, bytes, n);
+}
+
+/**
+ * @brief Agrega un campo de longitud delimitada: clave, largo y, si no es NULL, el contenido.
+ */
+static void put_bytes(struct push_buf* b, int field, const void* data, size_t len)
+{
+    put_varint(b, (uint64_t)field << 3 | 2);
+    put_varint(b, len);
+    if (data != NULL)
+    {
+        buf_put(b, data, len);
+    }
+}
+
+/**
+ * @brief Bytes de un mensaje Label con su clave y largo dentro de TimeSeries.
+ */
+static size_t label_len(const char* name, const char* value)
+{
+    size_t n = strlen(name), v = strlen(value);
+    size_t inner = 1 + varint_len(n) + n + 1 + varint_len(v) + v;
+    return 1 + varint_len(inner) + inner;
+}
+
+/**
+ * @brief Agrega un Label {name = 1, value = 2} como campo 1 de TimeSeries.
+ */
+static void put_label(struct push_buf* b, const char* name, const char* value)
+{
+    size_t n = strlen(name), v = strlen(value);
+    put_bytes(b, 1, NULL, 1 + varint_len(n) + n + 1 + varint_len(v) + v);
+    put_bytes(b, 1, name, n);
+    put_bytes(b, 2, value, v);
+}
+
+/**
+ * @brief Codifica un lote como WriteRequest de remote-write.
+ *
+ * WriteRequest {repeated TimeSeries timeseries = 1}, TimeSeries {repeated
+ * Label labels = 1; repeated Sample samples = 2} y Sample {double value = 1;
+ * int64 timestamp = 2}. Cada métrica escalar es una serie con una muestra por tick.
+ */
+static void encode_write_request(struct push_buf* b, const struct push_record* batch, size_t n)
+{
+    for (int id = 0; id < METRIC_SCALAR_COUNT; id++)
+    {
+        // Las etiquetas van ordenadas por nombre
+        size_t len = label_len("__name__", metric_names[id]) + label_len("instance", hostname) +
+                     label_len("job", PUSH_JOB);
+        for (size_t r = 0; r < n; r++)
+        {
+            size_t sample = 9 + 1 + varint_len(batch[r].ts_ms);
+            len += 1 + varint_len(sample) + sample;
+        }
+
+        put_bytes(b, 1, NULL, len);
+        put_label(b, "__name__", metric_names[id]);
+        put_label(b, "instance", hostname);
+        put_label(b, "job", PUSH_JOB);
+        for (size_t r = 0; r < n; r++)
+        {
+            unsigned char value[9] = {1 << 3 | 1};
+            memcpy(value + 1, &batch[r].scalar[id], 8);
+            put_bytes(b, 2, NULL, 9 + 1 + varint_len(batch[r].ts_ms));
+            buf_put(b, value, sizeof(value));
+            put_varint(b, 2 << 3 | 0);
+            put_varint(b, batch[r].ts_ms);
+        }
+    }
+}
+
+/**
+ * @brief Agrega un literal de snappy.
+ */
+static void snappy_literal(struct push_buf* out, const unsigned char* p, size_t len)
+{
+    while (len > 0)
+    {
+        // Con un byte de largo alcanza para 256; los literales más largos se parten
+        size_t chunk = len < 256 ? len : 256;
+        if (chunk <= 60)
+        {
+            unsigned char tag = (unsigned char)((chunk - 1) << 2);
+            buf_put(out, &tag, 1);
+        }
+        else
+        {
+            unsigned char tag[2] = {60 << 2, (unsigned char)(chunk - 1)};
+            buf_put(out, tag, 2);
+        }
+        buf_put(out, p, chunk);
+        p += chunk;
+        len -= chunk;
+    }
+}
+
+/**
+ * @brief Comprime en el formato de bloque de snappy.
+ *
+ * Busca coincidencias de 4 bytes con una tabla hash dentro de fragmentos de
+ * 64 KiB, como la implementación de referencia, y las emite como copias con
+ * desplazamiento de 2 bytes.
+ */
+static void snappy_compress(struct push_buf* out, const unsigned char* in, size_t len)
+{
+    static int32_t table[1 << 14];
+
+    put_varint(out, len);
+    for (size_t base = 0; base < len; base += 65536)
+    {
+        const unsigned char* p = in + base;
+        size_t n = len - base < 65536 ? len - base : 65536;
+        size_t i = 0, literal = 0;
+
+        memset(table, 0xff, sizeof(table));
+        while (i + 4 <= n)
+        {
+            uint32_t word;
+            memcpy(&word, p + i, 4);
+            uint32_t h = (word * 0x1e35a7bdU) >> 18;
+            int32_t candidate = table[h];
+            table[h] = (int32_t)i;
+
+            uint32_t previous;
+            if (candidate < 0 || (memcpy(&previous, p + candidate, 4), previous != word))
+            {
+                i++;
+                continue;
+            }
+
+            snappy_literal(out, p + literal, i - literal);
+            size_t match = 4;
+            while (i + match < n && match < 64 && p[candidate + match] == p[i + match])
+            {
+                match++;
+            }
+            size_t offset = i - (size_t)candidate;
+            unsigned char copy[3] = {(unsigned char)((match - 1) << 2 | 2), (unsigned char)offset,
+                                     (unsigned char)(offset >> 8)};
+            buf_put(out, copy, sizeof(copy));
+            i += match;
+            literal = i;
+        }
+        snappy_literal(out, p + literal, n - literal);
+    }
+}
+
+/**
+ * @brief Envía todos los bytes de un buffer por un socket TCP.
+ */
+static int send_all(int fd, const char* data, size_t len)
+{
+    while (len > 0)
+    {
+        ssize_t n = send(fd, data, len, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            return -1;
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+/**
+ * @brief Hace el POST de remote-write.
+ *
+ * @return Código de estado HTTP, o -1 si falló la conexión.
+ */
+static int post_remote_write(const struct push_buf* body)
+{
+    char header[1024];
+    char status_line[64];
+
+    int fd = connect_to(SOCK_STREAM);
+    if (fd < 0)
+    {
+        return -1;
+    }
+    int len = snprintf(header, sizeof(header),
+                       "POST %s HTTP/1.1\r\nHost: %s:%s\r\nContent-Type: application/x-protobuf\r\n"
+                       "Content-Encoding: snappy\r\nX-Prometheus-Remote-Write-Version: 0.1.0\r\n"
+                       "User-Agent: " PUSH_JOB "\r\nContent-Length: %zu\r\nConnection: close\r\n\r\n",
+                       path, host, port, body->len);
+    if (len < 0 || (size_t)len >= sizeof(header) || send_all(fd, header, (size_t)len) != 0 ||
+        send_all(fd, body->data, body->len) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+
+    // Solo interesa el código de la línea de estado, "HTTP/1.1 204 ..."
+    ssize_t n = recv(fd, status_line, sizeof(status_line) - 1, 0);
+    close(fd);
+    if (n < 12)
+    {
+        return -1;
+    }
+    status_line[n] = '\0';
+    const char* code = strchr(status_line, ' ');
+    return code != NULL ? atoi(code + 1) : -1;
+}
+
+/**
+ * @brief Envía un lote por remote-write, reintentando los errores de red y los 5xx.
+ *
+ * @return 0 si el destino lo aceptó, -1 si se descartó.
+ */
+static int send_remote_write(const struct push_record* batch, size_t n)
+{
+    static struct push_buf request, compressed;
+
+    request.len = 0;
+    compressed.len = 0;
+    encode_write_request(&request, batch, n);
+    snappy_compress(&compressed, (const unsigned char*)request.data, request.len);
+    if (request.failed || compressed.failed)
+    {
+        request.failed = compressed.failed = 0;
+        fprintf(stderr, "Error al reservar el lote de remote-write\n");
+        return -1;
+    }
+
+    for (int attempt = 0; attempt <= PUSH_RETRIES; attempt++)
+    {
+        if (attempt > 0)
+        {
+            usleep(100000U << attempt);
+        }
+        int status = post_remote_write(&compressed);
+        if (status >= 200 && status < 300)
+        {
+            return 0;
+        }
+        // Un 4xx no cambia al reintentar: el lote es inválido para el destino
+        if (status >= 400 && status < 500)
+        {
+            fprintf(stderr, "El destino de remote-write rechazó el lote con %d\n", status);
+            return -1;
+        }
+    }
+    fprintf(stderr, "Error al enviar el lote de remote-write a %s:%s\n", host, port);
+    return -1;
+}
+
+/**
+ * @brief Hilo de envío: espera un lote completo, o @ref PUSH_FLUSH_MS con alguno pendiente, y lo envía.
+ */
+static void* push_thread(void* arg)
+{
+    static struct push_record batch[PUSH_QUEUE_LEN];
+    (void)arg;
+
+    while (1)
+    {
+        pthread_mutex_lock(&queue_lock);
+        while (queue_count < batch_size)
+        {
+            struct timespec deadline;
+            clock_gettime(CLOCK_MONOTONIC, &deadline);
+            deadline.tv_sec += PUSH_FLUSH_MS / 1000;
+            deadline.tv_nsec += (PUSH_FLUSH_MS % 1000) * 1000000L;
+            if (deadline.tv_nsec >= 1000000000L)
+            {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000L;
+            }
+            if (pthread_cond_timedwait(&queue_cond, &queue_lock, &deadline) == ETIMEDOUT && queue_count > 0)
+            {
+                break;
+            }
+        }
+        size_t n = queue_count < batch_size ? queue_count : batch_size;
+        for (size_t i = 0; i < n; i++)
+        {
+            batch[i] = queue[(queue_head + i) % PUSH_QUEUE_LEN];
+        }
+        queue_head = (queue_head + n) % PUSH_QUEUE_LEN;
+        queue_count -= n;
+        pthread_mutex_unlock(&queue_lock);
+
+        int status = protocol == PUSH_REMOTE_WRITE ? send_remote_write(batch, n) : send_udp(batch, n);
+
+        pthread_mutex_lock(&queue_lock);
+        if (status == 0)
+        {
+            stats.sent += n;
+        }
+        else
+        {
+            stats.send_failed += n;
+        }
+        pthread_mutex_unlock(&queue_lock);
+    }
+    return NULL;
+}
+
+int push_init(const char* const names[METRIC_SCALAR_COUNT])
+{
+    const char* url = getenv(PUSH_URL_ENV);
+    if (url == NULL || *url == '\0')
+    {
+        return 0;
+    }
+    if (parse_url(url) != 0)
+    {
+        fprintf(stderr, "Destino de envío inválido: %s\n", url);
+        return -1;
+    }
+
+    const char* batch = getenv(PUSH_BATCH_ENV);
+    unsigned long ticks = batch != NULL ? strtoul(batch, NULL, 10) : PUSH_BATCH_DEFAULT;
+    batch_size = ticks == 0 ? 1 : ticks < PUSH_QUEUE_LEN ? ticks : PUSH_QUEUE_LEN;
+    metric_names = names;
+    if (gethostname(hostname, sizeof(hostname)) != 0)
+    {
+        snprintf(hostname, sizeof(hostname), "localhost");
+    }
+    hostname[sizeof(hostname) - 1] = '\0';
+
+    // La espera del hilo usa CLOCK_MONOTONIC para que un ajuste del reloj no demore los envíos
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&queue_cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    pthread_t tid;
+    if (pthread_create(&tid, NULL, push_thread, NULL) != 0)
+    {
+        fprintf(stderr, "Error al crear el hilo de envío\n");
+        return -1;
+    }
+    pthread_detach(tid);
+    enabled = 1;
+    return 0;
+}
+
+int push_enabled()
+{
+    return enabled;
+}
+
+void push_enqueue(const struct metric_values* v)
+{
+    if (!enabled)
+    {
+        return;
+    }
+
+    uint64_t ts = now_ms();
+    pthread_mutex_lock(&queue_lock);
+    if (queue_count == PUSH_QUEUE_LEN)
+    {
+        // El envío no da abasto: se descarta este tick en lugar de frenar al colector
+        stats.queue_full++;
+    }
+    else
+    {
+        struct push_record* r = &queue[(queue_head + queue_count) % PUSH_QUEUE_LEN];
+        r->ts_ms = ts;
+        memcpy(r->scalar, v->scalar, sizeof(r->scalar));
+        queue_count++;
+        if (queue_count >= batch_size)
+        {
+            pthread_cond_signal(&queue_cond);
+        }
+    }
+    pthread_mutex_unlock(&queue_lock);
+}
+
+void push_get_stats(struct push_stats* out)
+{
+    pthread_mutex_lock(&queue_lock);
+    *out = stats;
+    out->queued = queue_count;
+    pthread_mutex_unlock(&queue_lock);
+}
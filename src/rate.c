@@ -0,0 +1,52 @@
+/**
+ * @file rate.c
+ * @brief Implementación del cálculo de tasas sobre muestras con marca de tiempo.
+ */
+
+#include "rate.h"
+
+/** Rango de un contador de 32 bits. */
+#define RATE_WRAP32_RANGE 0x100000000ULL
+
+int rate_delta(unsigned long long prev, unsigned long long cur, unsigned long long* delta)
+{
+    if (cur >= prev)
+    {
+        *delta = cur - prev;
+        return 0;
+    }
+    if (prev >= RATE_WRAP32_THRESHOLD && prev < RATE_WRAP32_RANGE && cur < RATE_WRAP32_THRESHOLD)
+    {
+        *delta = RATE_WRAP32_RANGE - prev + cur;
+        return 0;
+    }
+    return -1;
+}
+
+int rate_sample_update(struct rate_sample* sample, unsigned long long value, unsigned long long ts_ns,
+                       unsigned long long* delta, unsigned long long* elapsed_ns)
+{
+    struct rate_sample prev = *sample;
+
+    sample->value = value;
+    sample->ts_ns = ts_ns;
+
+    if (prev.ts_ns == 0 || ts_ns <= prev.ts_ns)
+    {
+        return -1;
+    }
+    *elapsed_ns = ts_ns - prev.ts_ns;
+    return rate_delta(prev.value, value, delta);
+}
+
+int rate_per_second(struct rate_sample* sample, unsigned long long value, unsigned long long ts_ns, double* per_sec)
+{
+    unsigned long long delta, elapsed_ns;
+
+    if (rate_sample_update(sample, value, ts_ns, &delta, &elapsed_ns) != 0)
+    {
+        return -1;
+    }
+    *per_sec = (double)delta * 1e9 / (double)elapsed_ns;
+    return 0;
+}
@@ -0,0 +1,214 @@
+/**
+ * @file scheduler.c
+ * @brief Implementación del planificador de colectores.
+ */
+
+#include "scheduler.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/** Nanosegundos por milisegundo. */
+#define NS_PER_MS 1000000LL
+
+/** Nanosegundos por segundo. */
+#define NS_PER_SEC 1000000000LL
+
+/**
+ * @brief Devuelve el tiempo de CLOCK_MONOTONIC en nanosegundos.
+ */
+static long long now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * NS_PER_SEC + ts.tv_nsec;
+}
+
+/**
+ * @brief Duerme hasta un instante absoluto de CLOCK_MONOTONIC.
+ */
+static void sleep_until(long long deadline_ns)
+{
+    struct timespec ts = {.tv_sec = deadline_ns / NS_PER_SEC, .tv_nsec = deadline_ns % NS_PER_SEC};
+
+    // Con TIMER_ABSTIME basta con reintentar con el mismo plazo si llega una señal
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+    {
+    }
+}
+
+int sched_configure(struct sched_task* tasks, size_t count, const char* spec)
+{
+    char buf[BUFFER_SIZE * 4];
+    char* save = NULL;
+    int status = 0;
+
+    if (spec == NULL)
+    {
+        return 0;
+    }
+    snprintf(buf, sizeof(buf), "%s", spec);
+
+    for (char* entry = strtok_r(buf, ",", &save); entry != NULL; entry = strtok_r(NULL, ",", &save))
+    {
+        char* eq = strchr(entry, '=');
+        char* end = NULL;
+        unsigned long ms = 0;
+        size_t i = 0;
+
+        if (eq != NULL)
+        {
+            *eq = '\0';
+            ms = strtoul(eq + 1, &end, 10);
+        }
+        while (i < count && (eq == NULL || strcmp(tasks[i].name, entry) != 0))
+        {
+            i++;
+        }
+        if (i == count || end == eq + 1 || *end != '\0' || ms < SCHED_MIN_INTERVAL_MS)
+        {
+            if (eq != NULL)
+            {
+                *eq = '=';
+            }
+            fprintf(stderr, "Intervalo inválido en %s: %s\n", SCHED_INTERVALS_ENV, entry);
+            status = -1;
+            continue;
+        }
+        tasks[i].interval_ms = (unsigned int)ms;
+    }
+
+    return status;
+}
+
+/**
+ * @brief Trabajos de un tick, compartidos con los hilos del pool.
+ */
+struct sched_batch
+{
+    struct sched_task* tasks;                    /**< Tabla de colectores. */
+    size_t due[SCHED_MAX_TASKS];                 /**< Índices de los colectores vencidos. */
+    size_t due_count;                            /**< Colectores vencidos. */
+    enum proc_source sources[PROC_SOURCE_COUNT]; /**< Fuentes a releer. */
+    long long source_ns[PROC_SOURCE_COUNT];      /**< Duración de la lectura de cada fuente. */
+    size_t source_count;                         /**< Fuentes a releer. */
+};
+
+/**
+ * @brief Relee una de las fuentes del tick.
+ */
+static void read_source(void* ctx, size_t index)
+{
+    struct sched_batch* batch = ctx;
+    long long start = now_ns();
+
+    update_proc_source(batch->sources[index]);
+    batch->source_ns[index] = now_ns() - start;
+}
+
+/**
+ * @brief Ejecuta uno de los colectores vencidos del tick.
+ */
+static void run_task(void* ctx, size_t index)
+{
+    struct sched_batch* batch = ctx;
+    struct sched_task* t = &batch->tasks[batch->due[index]];
+    long long start = now_ns();
+
+    t->collect();
+    t->latency_ns = now_ns() - start;
+}
+
+void sched_run(struct sched_task* tasks, size_t count, struct worker_pool* pool, const struct sched_hooks* hooks)
+{
+    struct sched_batch batch = {.tasks = tasks};
+    long long start = now_ns();
+
+    if (count > SCHED_MAX_TASKS)
+    {
+        fprintf(stderr, "Demasiados colectores: se planifican solo %d\n", SCHED_MAX_TASKS);
+        count = SCHED_MAX_TASKS;
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        tasks[i].deadline_ns = start;
+        tasks[i].skipped = 0;
+        tasks[i].latency_ns = 0;
+    }
+
+    while (1)
+    {
+        long long next = tasks[0].deadline_ns;
+        for (size_t i = 1; i < count; i++)
+        {
+            if (tasks[i].deadline_ns < next)
+            {
+                next = tasks[i].deadline_ns;
+            }
+        }
+        sleep_until(next);
+
+        // Las fuentes compartidas entre colectores vencidos se leen una sola vez
+        long long now = now_ns();
+        unsigned int sources = 0;
+        batch.due_count = 0;
+        for (size_t i = 0; i < count; i++)
+        {
+            if (tasks[i].deadline_ns <= now)
+            {
+                batch.due[batch.due_count++] = i;
+                sources |= tasks[i].sources;
+            }
+        }
+        batch.source_count = 0;
+        for (int s = 0; s < PROC_SOURCE_COUNT; s++)
+        {
+            if (sources & SCHED_SOURCE(s))
+            {
+                batch.sources[batch.source_count++] = (enum proc_source)s;
+            }
+        }
+
+        // Cada fuente escribe su propia parte del snapshot, así que se pueden leer a la vez
+        worker_pool_run(pool, read_source, &batch, batch.source_count);
+        worker_pool_run(pool, run_task, &batch, batch.due_count);
+
+        long long after = now_ns();
+        for (size_t i = 0; i < batch.source_count; i++)
+        {
+            if (hooks->on_source_read != NULL)
+            {
+                hooks->on_source_read(batch.sources[i], batch.source_ns[i]);
+            }
+        }
+        for (size_t i = 0; i < batch.due_count; i++)
+        {
+            struct sched_task* t = &tasks[batch.due[i]];
+
+            // El próximo plazo se calcula desde el anterior para no acumular deriva
+            long long interval = (long long)t->interval_ms * NS_PER_MS;
+            t->deadline_ns += interval;
+            if (t->deadline_ns <= after)
+            {
+                unsigned long long missed = (unsigned long long)((after - t->deadline_ns) / interval) + 1;
+                t->deadline_ns += (long long)missed * interval;
+                t->skipped += missed;
+                if (hooks->on_skip != NULL)
+                {
+                    hooks->on_skip(t, missed);
+                }
+            }
+            if (hooks->on_collected != NULL)
+            {
+                hooks->on_collected(t);
+            }
+        }
+
+        if (hooks->on_tick != NULL)
+        {
+            hooks->on_tick();
+        }
+    }
+}
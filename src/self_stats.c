@@ -0,0 +1,49 @@
+/**
+ * @file self_stats.c
+ * @brief Implementación de las métricas del costo del propio agente.
+ */
+
+#include "self_stats.h"
+#include "proc_parse.h"
+#include "proc_reader.h"
+#include <sys/resource.h>
+#include <unistd.h>
+
+/**
+ * @brief Lector persistente de /proc/self/statm.
+ */
+static struct proc_reader statm = {.fd = -1};
+
+/**
+ * @brief Llamadas al sistema contadas hasta la actualización anterior.
+ */
+static unsigned long long previous_syscalls;
+
+int self_stats_init()
+{
+    return proc_reader_open(&statm, "/proc/self/statm");
+}
+
+void self_stats_update(struct self_stats* out)
+{
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+    {
+        out->cpu_seconds = (double)usage.ru_utime.tv_sec + (double)usage.ru_utime.tv_usec / 1e6 +
+                           (double)usage.ru_stime.tv_sec + (double)usage.ru_stime.tv_usec / 1e6;
+    }
+
+    // statm da en páginas el tamaño total, el residente y otros; el residente es el segundo campo
+    unsigned long long pages;
+    const char* p = proc_reader_read(&statm) > 0 ? parse_skip_fields(statm.buf, 1) : NULL;
+    if (p != NULL && parse_u64(p, &pages) != NULL)
+    {
+        out->rss_bytes = (double)pages * (double)sysconf(_SC_PAGESIZE);
+    }
+
+    struct proc_reader_stats io;
+    proc_reader_get_stats(&io);
+    out->syscalls_per_tick = previous_syscalls != 0 ? (double)(io.syscalls - previous_syscalls) : 0.0;
+    out->proc_read_bytes = io.bytes;
+    previous_syscalls = io.syscalls;
+}
@@ -1,30 +1,60 @@
+#include "sim_alloc.h"
+#include "mem_trace.h"
 #include "memory.h" // Tu biblioteca personalizada
-#include <semaphore.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <unistd.h> // Para sleep()
-// Definición de constantes
-#define SEMILLA_ALEATORIA 73        /**< Semilla para la generación de números aleatorios. */
-#define NUM_ITERACIONES 25          /**< Número de iteraciones por simulación. */
-#define TAMANO_MAXIMO_ASIGNACION 50 /**< Tamaño máximo de bloques de memoria a asignar. */
-#define MAX_PUNTEROS_ACTIVOS 10     /**< Máximo número de punteros activos simultáneamente. */
-#define TIEMPO_ESPERA_SEGUNDOS 5    /**< Tiempo de espera entre iteraciones en segundos. */
-
-sem_t sem; /**< Semáforo para sincronización en el acceso a métricas. */
-// Variables globales para fragmentación
-double frag0 = 0; /**< Fragmentación externa para First Fit. */
-double frag1 = 0; /**< Fragmentación externa para Best Fit. */
-double frag2 = 0; /**< Fragmentación externa para Worst Fit. */
+#include <string.h>
+#include <time.h>
+// Valores por defecto de la carga; se cambian con SIM_CONFIG_ENV
+#define SEMILLA_ALEATORIA 73             /**< Semilla para la generación de números aleatorios. */
+#define NUM_OPERACIONES 100000           /**< Operaciones por ronda. */
+#define MAX_PUNTEROS_ACTIVOS 1000        /**< Máximo número de punteros activos simultáneamente. */
+#define TAMANO_MINIMO_ASIGNACION 8       /**< Tamaño mínimo de bloques de memoria a asignar. */
+#define TAMANO_MAXIMO_ASIGNACION 65536   /**< Tamaño máximo de bloques de memoria a asignar. */
+#define LOGNORMAL_MU 4.0                 /**< Media de ln(tamaño): la mediana es de unos 55 bytes. */
+#define LOGNORMAL_SIGMA 1.2              /**< Desvío de ln(tamaño). */
+#define VIDA_MEDIA 500.0                 /**< Vida media de un bloque, en asignaciones. */
+#define TIEMPO_ESPERA_MS 5000            /**< Tiempo de espera entre rondas en milisegundos. */
+#define SIM_SIN_VENCIMIENTO (1ULL << 62) /**< Vida de un bloque que solo se libera cuando se llena el simulador. */
+
+/**
+ * @brief Resultado de la última ronda de cada política.
+ */
+static struct sim_result resultados[SIM_METHOD_COUNT];
+
+/**
+ * @brief Protege @ref resultados; inicializado estáticamente para poder leerlo antes de que arranque el simulador.
+ */
+static pthread_mutex_t resultados_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @brief Copia el resultado de una política bajo el lock.
+ * @return 0 si el método es válido, -1 si no.
+ */
+static int leer_resultado(int metodo, struct sim_result* res)
+{
+    if (metodo < 0 || metodo >= SIM_METHOD_COUNT)
+    {
+        return -1;
+    }
+    pthread_mutex_lock(&resultados_lock);
+    *res = resultados[metodo];
+    pthread_mutex_unlock(&resultados_lock);
+    return 0;
+}
+
 /**
  * @brief Obtiene la métrica de fragmentación externa utilizando el método First Fit.
  * @return El valor de la fragmentación externa calculada.
  */
 double get_frag_first_fit()
 {
-    sem_wait(&sem);
-    double f = frag0;
-    sem_post(&sem);
-    return f;
+    struct sim_result r;
+    leer_resultado(FIRST_FIT, &r);
+    return r.frag;
 }
 
 /**
@@ -33,10 +63,9 @@ double get_frag_first_fit()
  */
 double get_frag_best_fit()
 {
-    sem_wait(&sem);
-    double f = frag1;
-    sem_post(&sem);
-    return f;
+    struct sim_result r;
+    leer_resultado(BEST_FIT, &r);
+    return r.frag;
 }
 
 /**
@@ -45,62 +74,370 @@ double get_frag_best_fit()
  */
 double get_frag_worst_fit()
 {
-    sem_wait(&sem);
-    double f = frag2;
-    sem_post(&sem);
-    return f;
+    struct sim_result r;
+    leer_resultado(WORST_FIT, &r);
+    return r.frag;
 }
 
 /**
- * @brief Genera datos aleatorios para las acciones y tamaños de bloques de memoria.
+ * @brief Obtiene la métrica de fragmentación externa utilizando listas segregadas.
+ * @return El valor de la fragmentación externa calculada.
  */
-void generar_datos(int* acciones, size_t* tamanos)
+double get_frag_segregated_fit()
 {
-    for (int i = 0; i < NUM_ITERACIONES; i++)
+    struct sim_result r;
+    leer_resultado(SEGREGATED_FIT, &r);
+    return r.frag;
+}
+
+/**
+ * @brief Obtiene la latencia media de una operación con el método indicado.
+ * @return Nanosegundos por operación, o -1 si el método es inválido.
+ */
+double get_alloc_latency_ns(int metodo)
+{
+    struct sim_result r;
+    return leer_resultado(metodo, &r) == 0 ? r.ns_per_op : -1;
+}
+
+/**
+ * @brief Obtiene las operaciones por segundo del método indicado.
+ * @return Operaciones por segundo, o -1 si el método es inválido.
+ */
+double get_alloc_throughput_ops(int metodo)
+{
+    struct sim_result r;
+    return leer_resultado(metodo, &r) == 0 ? r.ops_per_sec : -1;
+}
+
+void sim_default_config(struct sim_config* cfg)
+{
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->distribution = SIM_DIST_LOGNORMAL;
+    cfg->operations = NUM_OPERACIONES;
+    cfg->max_live = MAX_PUNTEROS_ACTIVOS;
+    cfg->min_size = TAMANO_MINIMO_ASIGNACION;
+    cfg->max_size = TAMANO_MAXIMO_ASIGNACION;
+    cfg->mu = LOGNORMAL_MU;
+    cfg->sigma = LOGNORMAL_SIGMA;
+    cfg->mean_lifetime = VIDA_MEDIA;
+    cfg->seed = SEMILLA_ALEATORIA;
+    cfg->interval_ms = TIEMPO_ESPERA_MS;
+}
+
+/**
+ * @brief Aplica un par clave=valor a la configuración.
+ * @return 0 si es válido, -1 si no.
+ */
+static int aplicar_opcion(struct sim_config* cfg, const char* clave, const char* valor)
+{
+    char* end = NULL;
+
+    if (strcmp(clave, "dist") == 0)
+    {
+        if (strcmp(valor, "uniform") == 0)
+            cfg->distribution = SIM_DIST_UNIFORM;
+        else if (strcmp(valor, "lognormal") == 0)
+            cfg->distribution = SIM_DIST_LOGNORMAL;
+        else if (strcmp(valor, "trace") == 0)
+            cfg->distribution = SIM_DIST_TRACE;
+        else
+            return -1;
+        return 0;
+    }
+    if (strcmp(clave, "trace") == 0)
     {
-        acciones[i] = rand() % 2; // 0: malloc, 1: free
-        tamanos[i] = (rand() % TAMANO_MAXIMO_ASIGNACION) + 1;
+        if (valor[0] == '\0' || strlen(valor) >= sizeof(cfg->trace_path))
+            return -1;
+        snprintf(cfg->trace_path, sizeof(cfg->trace_path), "%s", valor);
+        cfg->distribution = SIM_DIST_TRACE;
+        return 0;
     }
+    if (strcmp(clave, "mu") == 0 || strcmp(clave, "sigma") == 0 || strcmp(clave, "lifetime") == 0)
+    {
+        double d = strtod(valor, &end);
+        if (end == valor || *end != '\0' || d < 0)
+            return -1;
+        if (clave[0] == 'm')
+            cfg->mu = d;
+        else if (clave[0] == 's')
+            cfg->sigma = d;
+        else
+            cfg->mean_lifetime = d;
+        return 0;
+    }
+
+    unsigned long long n = strtoull(valor, &end, 10);
+    if (end == valor || *end != '\0')
+        return -1;
+    if (strcmp(clave, "ops") == 0 && n > 0)
+        cfg->operations = n;
+    else if (strcmp(clave, "live") == 0 && n > 0)
+        cfg->max_live = (size_t)n;
+    else if (strcmp(clave, "min") == 0 && n > 0)
+        cfg->min_size = (size_t)n;
+    else if (strcmp(clave, "max") == 0 && n > 0)
+        cfg->max_size = (size_t)n;
+    else if (strcmp(clave, "seed") == 0)
+        cfg->seed = (unsigned int)n;
+    else if (strcmp(clave, "interval") == 0)
+        cfg->interval_ms = (unsigned int)n;
+    else
+        return -1;
+    return 0;
+}
+
+int sim_configure(struct sim_config* cfg, const char* spec)
+{
+    char buf[SIM_TRACE_PATH_MAX * 4];
+    char* save = NULL;
+    int status = 0;
+
+    if (spec == NULL)
+    {
+        return 0;
+    }
+    snprintf(buf, sizeof(buf), "%s", spec);
+
+    for (char* entry = strtok_r(buf, ",", &save); entry != NULL; entry = strtok_r(NULL, ",", &save))
+    {
+        char* eq = strchr(entry, '=');
+        if (eq == NULL)
+        {
+            fprintf(stderr, "Opción inválida en %s: %s\n", SIM_CONFIG_ENV, entry);
+            status = -1;
+            continue;
+        }
+        *eq = '\0';
+        if (aplicar_opcion(cfg, entry, eq + 1) != 0)
+        {
+            *eq = '=';
+            fprintf(stderr, "Opción inválida en %s: %s\n", SIM_CONFIG_ENV, entry);
+            status = -1;
+        }
+    }
+    if (cfg->min_size > cfg->max_size)
+    {
+        fprintf(stderr, "Rango de tamaños inválido en %s: %zu a %zu\n", SIM_CONFIG_ENV, cfg->min_size,
+                cfg->max_size);
+        cfg->max_size = cfg->min_size;
+        status = -1;
+    }
+    if (cfg->distribution == SIM_DIST_TRACE && cfg->trace_path[0] == '\0')
+    {
+        fprintf(stderr, "%s pide dist=trace sin trace=ARCHIVO\n", SIM_CONFIG_ENV);
+        cfg->distribution = SIM_DIST_LOGNORMAL;
+        status = -1;
+    }
+    return status;
+}
+
+/**
+ * @brief Siguiente número del generador xorshift64*; cada hilo lleva su estado.
+ */
+static uint64_t sim_rand(uint64_t* estado)
+{
+    uint64_t x = *estado;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *estado = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+/**
+ * @brief Número uniforme en (0, 1].
+ */
+static double sim_uniforme(uint64_t* estado)
+{
+    return ((double)(sim_rand(estado) >> 11) + 1.0) * 0x1.0p-53;
 }
 
 /**
- * @brief Simula la asignación y liberación de memoria para una política específica.
+ * @brief Tamaño del próximo pedido según la distribución configurada.
  */
-void simulador(int metodo, int* acciones, size_t* tamanos, double* frag)
+static size_t sim_tamano(const struct sim_config* cfg, uint64_t* estado)
 {
+    size_t rango = cfg->max_size - cfg->min_size + 1;
+    if (cfg->distribution == SIM_DIST_UNIFORM)
+    {
+        return cfg->min_size + (size_t)(sim_rand(estado) % rango);
+    }
+
+    // Box-Muller: una normal estándar a partir de dos uniformes
+    double z = sqrt(-2.0 * log(sim_uniforme(estado))) * cos(2.0 * M_PI * sim_uniforme(estado));
+    double t = exp(cfg->mu + cfg->sigma * z);
+    if (t < (double)cfg->min_size)
+        return cfg->min_size;
+    if (t > (double)cfg->max_size)
+        return cfg->max_size;
+    return (size_t)t;
+}
+
+/**
+ * @brief Bloque vivo del simulador.
+ */
+struct sim_vivo
+{
+    unsigned long long muerte; /**< Asignación en la que vence. */
+    void* ptr;                 /**< Bloque devuelto por my_malloc(). */
+};
+
+/**
+ * @brief Agrega un bloque al montículo ordenado por vencimiento.
+ */
+static void vivos_push(struct sim_vivo* vivos, size_t* n, struct sim_vivo v)
+{
+    size_t i = (*n)++;
+    while (i > 0 && vivos[(i - 1) / 2].muerte > v.muerte)
+    {
+        vivos[i] = vivos[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    vivos[i] = v;
+}
+
+/**
+ * @brief Quita y devuelve el bloque del montículo que vence primero.
+ */
+static struct sim_vivo vivos_pop(struct sim_vivo* vivos, size_t* n)
+{
+    struct sim_vivo top = vivos[0];
+    struct sim_vivo ultimo = vivos[--(*n)];
+    size_t i = 0;
+    while (2 * i + 1 < *n)
+    {
+        size_t hijo = 2 * i + 1;
+        if (hijo + 1 < *n && vivos[hijo + 1].muerte < vivos[hijo].muerte)
+            hijo++;
+        if (vivos[hijo].muerte >= ultimo.muerte)
+            break;
+        vivos[i] = vivos[hijo];
+        i = hijo;
+    }
+    vivos[i] = ultimo;
+    return top;
+}
+
+/**
+ * @brief Nanosegundos entre dos instantes.
+ */
+static double sim_ns(const struct timespec* inicio, const struct timespec* fin)
+{
+    return (double)(fin->tv_sec - inicio->tv_sec) * 1e9 + (double)(fin->tv_nsec - inicio->tv_nsec);
+}
+
+/**
+ * @brief Reproduce la traza configurada en un heap propio de la política.
+ */
+static int simular_traza(int metodo, const struct sim_config* cfg, struct sim_result* res)
+{
+    struct mem_trace_replay_stats stats;
+    if (mem_trace_replay(cfg->trace_path, metodo, &stats) != 0)
+    {
+        return -1;
+    }
+    res->frag = stats.frag;
+    res->ops = stats.ops;
+    res->failed = stats.failed;
+    res->ns_per_op = stats.ns_per_op;
+    res->ops_per_sec = stats.ns_per_op > 0 ? 1e9 / stats.ns_per_op : 0;
+    return 0;
+}
+
+int simulador(int metodo, const struct sim_config* cfg, struct sim_result* res)
+{
+    memset(res, 0, sizeof(*res));
+    if (cfg->distribution == SIM_DIST_TRACE)
+    {
+        return simular_traza(metodo, cfg, res);
+    }
+
+    // La contabilidad del simulador no debe pasar por el asignador que mide
+    struct sim_vivo* vivos = malloc(cfg->max_live * sizeof(*vivos));
+    if (vivos == NULL)
+    {
+        fprintf(stderr, "Error al reservar los bloques vivos del simulador\n");
+        return -1;
+    }
+
     set_method(metodo);
-    void* punteros[MAX_PUNTEROS_ACTIVOS];
-    size_t asignaciones_activas = 0;
+    int silenciado = mem_trace_mute(1);
+    // Cada política recibe exactamente la misma carga aunque corran en paralelo
+    uint64_t estado = ((uint64_t)cfg->seed << 1) | 1;
+    size_t n = 0;
+    unsigned long long reloj = 0;
+    struct timespec inicio, fin;
 
-    for (int i = 0; i < NUM_ITERACIONES; i++)
+    clock_gettime(CLOCK_MONOTONIC, &inicio);
+    while (res->ops < cfg->operations)
     {
-        if (acciones[i] == 0 && asignaciones_activas < MAX_PUNTEROS_ACTIVOS)
+        if (n > 0 && (vivos[0].muerte <= reloj || n == cfg->max_live))
+        {
+            my_free(vivos_pop(vivos, &n).ptr);
+        }
+        else
         {
-            void* bloque = my_malloc(tamanos[i]);
+            size_t tamano = sim_tamano(cfg, &estado);
+            // Vida exponencial; con vida media 0 nunca vencen y salen en orden de llegada cuando se llena
+            unsigned long long vida = cfg->mean_lifetime > 0
+                                          ? (unsigned long long)(-cfg->mean_lifetime * log(sim_uniforme(&estado))) + 1
+                                          : SIM_SIN_VENCIMIENTO;
+            void* bloque = my_malloc(tamano);
             if (bloque)
             {
-                punteros[asignaciones_activas++] = bloque;
+                vivos_push(vivos, &n, (struct sim_vivo){reloj + vida, bloque});
             }
+            else
+            {
+                res->failed++;
+            }
+            reloj++;
         }
-        else if (acciones[i] == 1 && asignaciones_activas > 0)
-        {
-            size_t indice = rand() % asignaciones_activas;
-            my_free(punteros[indice]);
-            punteros[indice] = punteros[--asignaciones_activas];
-        }
+        res->ops++;
     }
+    clock_gettime(CLOCK_MONOTONIC, &fin);
+
+    // La fragmentación se mide con la carga todavía viva
+    res->frag = external_frag();
+    double ns = sim_ns(&inicio, &fin);
+    res->ns_per_op = res->ops ? ns / (double)res->ops : 0;
+    res->ops_per_sec = ns > 0 ? (double)res->ops * 1e9 / ns : 0;
 
     // Liberar memoria restante
-    for (size_t i = 0; i < asignaciones_activas; i++)
+    for (size_t i = 0; i < n; i++)
     {
-        my_free(punteros[i]);
+        my_free(vivos[i].ptr);
     }
-
-    // Calcular y almacenar fragmentación
-    sem_wait(&sem);
-    *frag = external_frag();
-    sem_post(&sem);
     mem_trim();
+    mem_trace_mute(silenciado);
+    free(vivos);
+    return 0;
+}
+
+/**
+ * @brief Argumentos del hilo que simula una política.
+ */
+struct sim_tarea
+{
+    int metodo;                   /**< Política de asignación. */
+    struct mem_heap* heap;        /**< Heap propio de la política. */
+    const struct sim_config* cfg; /**< Carga de trabajo compartida. */
+    struct sim_result res;        /**< Resultado de la ronda. */
+    int ok;                       /**< Distinto de 0 si la ronda terminó. */
+};
+
+/**
+ * @brief Hilo que ejecuta una política sobre su propio heap.
+ * @return Siempre retorna NULL.
+ */
+static void* ejecutar_simulador(void* arg)
+{
+    struct sim_tarea* tarea = arg;
+    mem_heap_use(tarea->heap);
+    tarea->ok = simulador(tarea->metodo, tarea->cfg, &tarea->res) == 0;
+    mem_heap_use(NULL);
+    return NULL;
 }
 
 /**
@@ -110,25 +447,59 @@ void simulador(int metodo, int* acciones, size_t* tamanos, double* frag)
 void* init_sim(void* arg)
 {
     (void)arg;
-    srand(SEMILLA_ALEATORIA); // Semilla fija para reproducibilidad
-    sem_init(&sem, 0, 1);
-    // Arreglos para las iteraciones
-    int acciones[NUM_ITERACIONES];
-    size_t tamanos[NUM_ITERACIONES];
+    struct sim_config cfg;
+    sim_default_config(&cfg);
+    sim_configure(&cfg, getenv(SIM_CONFIG_ENV));
 
+    // Cada política tiene su heap, así que las cuatro pueden correr a la vez
+    struct sim_tarea tareas[SIM_METHOD_COUNT] = {
+        {.metodo = FIRST_FIT, .cfg = &cfg},
+        {.metodo = BEST_FIT, .cfg = &cfg},
+        {.metodo = WORST_FIT, .cfg = &cfg},
+        {.metodo = SEGREGATED_FIT, .cfg = &cfg},
+    };
+    for (int m = 0; m < SIM_METHOD_COUNT; m++)
+    {
+        tareas[m].heap = mem_heap_create(tareas[m].metodo);
+        if (tareas[m].heap == NULL)
+        {
+            fprintf(stderr, "Error al crear el heap del simulador\n");
+            return NULL;
+        }
+    }
+
+    struct timespec espera = {cfg.interval_ms / 1000, (long)(cfg.interval_ms % 1000) * 1000000L};
     while (1)
     {
-        // para habilitar la prueba , hay que descomentar la siguiente linea
-        break;
-        // nuestra lib no soporta mucho tiempo haciendo tanto malloc y free debido a la limitacion del sistema
-        //  Generar los mismos datos para las tres políticas
-        generar_datos(acciones, tamanos);
-
-        // Ejecutar simuladores con los mismos datos
-        simulador(0, acciones, tamanos, &frag0); // First Fit
-        simulador(1, acciones, tamanos, &frag1); // Best Fit
-        simulador(2, acciones, tamanos, &frag2); // Worst Fit
-        sleep(TIEMPO_ESPERA_SEGUNDOS);           // Espera para la próxima iteración
+        // Ejecutar simuladores con la misma carga, uno por hilo
+        pthread_t hilos[SIM_METHOD_COUNT];
+        int creado[SIM_METHOD_COUNT];
+        for (int m = 0; m < SIM_METHOD_COUNT; m++)
+        {
+            creado[m] = pthread_create(&hilos[m], NULL, ejecutar_simulador, &tareas[m]) == 0;
+            if (!creado[m])
+            {
+                ejecutar_simulador(&tareas[m]);
+            }
+        }
+        for (int m = 0; m < SIM_METHOD_COUNT; m++)
+        {
+            if (creado[m])
+            {
+                pthread_join(hilos[m], NULL);
+            }
+        }
+
+        pthread_mutex_lock(&resultados_lock);
+        for (int m = 0; m < SIM_METHOD_COUNT; m++)
+        {
+            if (tareas[m].ok)
+            {
+                resultados[m] = tareas[m].res;
+            }
+        }
+        pthread_mutex_unlock(&resultados_lock);
+        nanosleep(&espera, NULL); // Espera para la próxima ronda
     }
     return NULL;
 }
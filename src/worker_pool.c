@@ -0,0 +1,106 @@
+/**
+ * @file worker_pool.c
+ * @brief Implementación del pool de hilos de los colectores.
+ */
+
+#include "worker_pool.h"
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * @brief Toma trabajos del lote actual hasta agotarlo.
+ */
+static void drain(struct worker_pool* pool)
+{
+    size_t i;
+    while ((i = atomic_fetch_add_explicit(&pool->next, 1, memory_order_relaxed)) < pool->count)
+    {
+        pool->fn(pool->ctx, i);
+    }
+}
+
+/**
+ * @brief Bucle de cada hilo auxiliar.
+ */
+static void* worker_main(void* arg)
+{
+    struct worker_pool* pool = arg;
+
+    while (1)
+    {
+        // La barrera publica fn, ctx, count y stop escritos por el llamador
+        pthread_barrier_wait(&pool->start);
+        if (pool->stop)
+        {
+            return NULL;
+        }
+        drain(pool);
+        pthread_barrier_wait(&pool->done);
+    }
+}
+
+int worker_pool_init(struct worker_pool* pool, size_t size)
+{
+    memset(pool, 0, sizeof(*pool));
+    if (size == 0)
+    {
+        size = 1;
+    }
+    if (size > WORKER_POOL_MAX_SIZE)
+    {
+        size = WORKER_POOL_MAX_SIZE;
+    }
+
+    if (pthread_barrier_init(&pool->start, NULL, (unsigned)size) != 0 ||
+        pthread_barrier_init(&pool->done, NULL, (unsigned)size) != 0)
+    {
+        fprintf(stderr, "Error al inicializar las barreras del pool\n");
+        return -1;
+    }
+
+    for (size_t i = 0; i + 1 < size; i++)
+    {
+        if (pthread_create(&pool->threads[i], NULL, worker_main, pool) != 0)
+        {
+            // Los hilos ya creados quedan esperando una barrera que nunca se completa
+            fprintf(stderr, "Error al crear los hilos del pool\n");
+            return -1;
+        }
+        pool->thread_count++;
+    }
+    return 0;
+}
+
+void worker_pool_run(struct worker_pool* pool, worker_fn fn, void* ctx, size_t count)
+{
+    pool->fn = fn;
+    pool->ctx = ctx;
+    pool->count = count;
+    atomic_store_explicit(&pool->next, 0, memory_order_relaxed);
+
+    if (pool->thread_count == 0)
+    {
+        drain(pool);
+        return;
+    }
+
+    pthread_barrier_wait(&pool->start);
+    drain(pool);
+    pthread_barrier_wait(&pool->done);
+}
+
+void worker_pool_destroy(struct worker_pool* pool)
+{
+    if (pool->thread_count > 0)
+    {
+        pool->stop = 1;
+        pthread_barrier_wait(&pool->start);
+        for (size_t i = 0; i < pool->thread_count; i++)
+        {
+            pthread_join(pool->threads[i], NULL);
+        }
+    }
+    pthread_barrier_destroy(&pool->start);
+    pthread_barrier_destroy(&pool->done);
+    pool->thread_count = 0;
+}